@@ -0,0 +1,1419 @@
+//==============================================================================
+// blocked_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list_detail.h"
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+#include <iterator>   // for std::reverse_iterator
+#include <utility>    // for std::pair
+#include <algorithm>  // for std::copy et al
+
+#if !defined(SKIP_LIST_NO_SIMD) && defined(__AVX2__)
+#define SKIP_LIST_AVX2
+#include <immintrin.h>
+#endif
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - internal forward declarations
+
+namespace goodliffe {
+
+namespace detail
+{
+    template <typename T,typename C,typename A,typename LG,unsigned B>
+    class bsl_impl;
+
+    template <typename BSL_IMPL> class bsl_iterator;
+}
+}
+
+//==============================================================================
+#pragma mark - blocked_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// A skip list of unique, ordered elements, as skip_list, that keeps up to
+/// BlockSize of them, sorted, in each node (an "unrolled" skip list). Only
+/// these blocks have towers of links: a search finds the block by its
+/// first element and then binary searches within it, without branches
+/// (or, for arithmetic types ordered by std::less in an AVX2 build, counts
+/// the smaller elements with vector compares: see bsl_block_search). For
+/// small elements this takes a fraction of a skip_list's memory, a search
+/// touches fewer cache lines, and iterating is a walk along arrays.
+///
+/// The price is that elements move. Inserting into a full block splits it,
+/// moving half of its elements to a new block, and a block that erasing
+/// leaves less than a quarter full takes in its neighbour, if there is
+/// room. So, unlike the other containers, insert and erase invalidate
+/// iterators and references: to elements of the block they change, and of
+/// a block it splits or merges with. Treat every iterator as invalidated,
+/// as for a std::vector. Elements cannot be changed in place, so iterator
+/// is a const_iterator, as for a std::set.
+///
+/// @param T              Template type for kind of object held in the
+///                       container.
+/// @param Compare        Template type describing the ordering comparator.
+/// @param Allocator      Template type for memory allocator for the contents
+///                       of the container.
+/// @param LevelGenerator Template type for the block height generator.
+/// @param BlockSize      The most elements a block holds: at least 4. A few
+///                       cache lines' worth is best.
+///
+/// @see skip_list
+template <typename T,
+          typename Compare        = std::less<T>,
+          typename Allocator      = std::allocator<T>,
+          typename LevelGenerator = detail::skip_list_level_generator<32>,
+          unsigned BlockSize      = 32>
+class blocked_skip_list
+{
+protected:
+    typedef typename detail::bsl_impl<T,Compare,Allocator,LevelGenerator,BlockSize> impl_type;
+    typedef typename impl_type::block_type block_type;
+
+public:
+
+    //======================================================================
+    // types
+
+    typedef T                                           value_type;
+    typedef Allocator                                   allocator_type;
+    typedef typename impl_type::size_type               size_type;
+    typedef typename allocator_type::difference_type    difference_type;
+    typedef typename allocator_type::const_reference    reference;
+    typedef typename allocator_type::const_reference    const_reference;
+    typedef typename allocator_type::const_pointer      pointer;
+    typedef typename allocator_type::const_pointer      const_pointer;
+    typedef Compare                                     compare;
+
+    typedef typename detail::bsl_iterator<impl_type>    const_iterator;
+    typedef const_iterator                              iterator;
+    typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+    typedef const_reverse_iterator                      reverse_iterator;
+
+    static const unsigned block_size = BlockSize;
+
+    //======================================================================
+    // lifetime management
+
+    explicit blocked_skip_list(const Allocator &alloc = Allocator());
+
+    template <class InputIterator>
+    blocked_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator());
+
+    blocked_skip_list(const blocked_skip_list &other);
+    blocked_skip_list(const blocked_skip_list &other, const Allocator &alloc);
+
+    allocator_type get_allocator() const { return impl.get_allocator(); }
+
+    //======================================================================
+    // assignment
+
+    blocked_skip_list &operator=(const blocked_skip_list &other);
+
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last);
+
+    /// Replaces the contents of the list with the range [first,last), which
+    /// must already be sorted, with no repeats. This fills each block in
+    /// turn, in linear time.
+    template <typename InputIterator>
+    void assign_sorted(InputIterator first, InputIterator last) { impl.assign_sorted(first, last); }
+
+    //======================================================================
+    // element access
+
+    const_reference front() const;
+    const_reference back() const;
+
+    //======================================================================
+    // iterators
+
+    const_iterator begin() const            { return const_iterator(&impl, impl.front(), 0); }
+    const_iterator cbegin() const           { return begin(); }
+    const_iterator end() const              { return const_iterator(&impl, impl.one_past_end(), 0); }
+    const_iterator cend() const             { return end(); }
+
+    const_reverse_iterator rbegin() const   { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const  { return const_reverse_iterator(end()); }
+    const_reverse_iterator rend() const     { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const    { return const_reverse_iterator(begin()); }
+
+    //======================================================================
+    // capacity
+
+    bool      empty() const         { return impl.size() == 0; }
+    size_type size() const          { return impl.size(); }
+    size_type max_size() const      { return impl.get_allocator().max_size(); }
+
+    //======================================================================
+    // modifiers
+
+    void clear() { impl.remove_all(); }
+
+    typedef typename std::pair<iterator,bool> insert_by_value_result;
+
+    insert_by_value_result insert(const value_type &value);
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last);
+
+    size_type erase(const value_type &value);
+    iterator  erase(const_iterator position);
+
+    void swap(blocked_skip_list &other) { impl.swap(other.impl); }
+
+    friend void swap(blocked_skip_list &lhs, blocked_skip_list &rhs) { lhs.swap(rhs); }
+
+    //======================================================================
+    // lookup
+
+    bool           contains(const value_type &value) const { return count(value) != 0; }
+    size_type      count(const value_type &value) const    { return find(value) != end(); }
+
+    const_iterator find(const value_type &value) const;
+    const_iterator lower_bound(const value_type &value) const;
+    const_iterator upper_bound(const value_type &value) const;
+
+    //======================================================================
+    // other operations
+
+    template <typename STREAM>
+    void dump(STREAM &stream) const { impl.dump(stream); }
+
+protected:
+    impl_type impl;
+};
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - non-members
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator==(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator!=(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return !operator==(lhs, rhs);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator<(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator<=(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator>(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return rhs < lhs;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool operator>=(const blocked_skip_list<T,C,A,LG,B> &lhs, const blocked_skip_list<T,C,A,LG,B> &rhs)
+{
+    return !(lhs < rhs);
+}
+
+} // namespace goodliffe
+
+namespace std
+{
+    template <class T, class C, class A, class LG, unsigned B>
+    void swap(goodliffe::blocked_skip_list<T,C,A,LG,B> &lhs, goodliffe::blocked_skip_list<T,C,A,LG,B> &rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+//==============================================================================
+#pragma mark - iterators
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// An iterator is a block and a slot within it. The end is slot 0 of the
+/// tail, which never holds any elements.
+template <typename BSL_IMPL>
+class bsl_iterator
+    : public std::iterator<std::bidirectional_iterator_tag,
+                           typename BSL_IMPL::value_type,
+                           typename BSL_IMPL::difference_type,
+                           typename BSL_IMPL::const_pointer,
+                           typename BSL_IMPL::const_reference>
+{
+public:
+    typedef const BSL_IMPL                          impl_type;
+    typedef const typename impl_type::block_type    block_type;
+    typedef bsl_iterator<BSL_IMPL>                  self_type;
+
+    typedef typename impl_type::const_reference const_reference;
+    typedef typename impl_type::const_pointer   const_pointer;
+
+    bsl_iterator() :
+#ifdef SKIP_LIST_DIAGNOSTICS
+        impl(0),
+#endif
+        block(0), slot(0) {}
+    bsl_iterator(const impl_type *impl_, block_type *block_, unsigned slot_) :
+#ifdef SKIP_LIST_DIAGNOSTICS
+        impl(impl_),
+#endif
+        block(block_), slot(slot_) {}
+
+    self_type &operator++()
+        { increment(); return *this; }
+    self_type operator++(int) // postincrement
+        { self_type old(*this); increment(); return old; }
+
+    self_type &operator--()
+        { decrement(); return *this; }
+    self_type operator--(int) // postdecrement
+        { self_type old(*this); decrement(); return old; }
+
+    const_reference operator*() const  { return block->keys()[slot]; }
+    const_pointer   operator->() const { return &block->keys()[slot]; }
+
+    bool operator==(const self_type &other) const
+        { return block == other.block && slot == other.slot; }
+    bool operator!=(const self_type &other) const
+        { return !operator==(other); }
+
+#ifdef SKIP_LIST_DIAGNOSTICS
+    const impl_type *get_impl() const { return impl; } ///< @internal
+#endif
+    block_type *get_block() const { return block; } ///< @internal
+    unsigned    get_slot() const  { return slot; }  ///< @internal
+
+private:
+    void increment()
+    {
+        if (++slot == block->count)
+        {
+            block = block->next[0];
+            slot  = 0;
+        }
+    }
+
+    void decrement()
+    {
+        if (slot)
+        {
+            --slot;
+        }
+        else
+        {
+            block = block->prev;
+            slot  = block->count-1;
+        }
+    }
+
+#ifdef SKIP_LIST_DIAGNOSTICS
+    const impl_type *impl;
+#endif
+    block_type *block;
+    unsigned    slot;
+};
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - lifetime management
+//==============================================================================
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+blocked_skip_list<T,C,A,LG,B>::blocked_skip_list(const allocator_type &alloc_)
+:   impl(alloc_)
+{
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+template <class InputIterator>
+inline
+blocked_skip_list<T,C,A,LG,B>::blocked_skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
+:   impl(alloc_)
+{
+    assign(first, last);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+blocked_skip_list<T,C,A,LG,B>::blocked_skip_list(const blocked_skip_list &other)
+:   impl(other.get_allocator())
+{
+    assign_sorted(other.begin(), other.end());
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+blocked_skip_list<T,C,A,LG,B>::blocked_skip_list(const blocked_skip_list &other, const allocator_type &alloc_)
+:   impl(alloc_)
+{
+    assign_sorted(other.begin(), other.end());
+}
+
+//==============================================================================
+#pragma mark assignment
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+blocked_skip_list<T,C,A,LG,B> &
+blocked_skip_list<T,C,A,LG,B>::operator=(const blocked_skip_list &other)
+{
+    if (&other != this) assign_sorted(other.begin(), other.end());
+    return *this;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+template <typename InputIterator>
+inline
+void blocked_skip_list<T,C,A,LG,B>::assign(InputIterator first, InputIterator last)
+{
+    clear();
+    insert(first, last);
+}
+
+//==============================================================================
+#pragma mark element access
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::const_reference
+blocked_skip_list<T,C,A,LG,B>::front() const
+{
+    assert_that(!empty());
+    return impl.front()->keys()[0];
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::const_reference
+blocked_skip_list<T,C,A,LG,B>::back() const
+{
+    assert_that(!empty());
+    const block_type *last = impl.one_past_end()->prev;
+    return last->keys()[last->count-1];
+}
+
+//==============================================================================
+#pragma mark modifiers
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::insert_by_value_result
+blocked_skip_list<T,C,A,LG,B>::insert(const value_type &value)
+{
+    unsigned slot = 0;
+    bool     inserted = false;
+    block_type *block = impl.insert(value, slot, inserted);
+    return std::make_pair(iterator(&impl, block, slot), inserted);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+template <class InputIterator>
+inline
+void blocked_skip_list<T,C,A,LG,B>::insert(InputIterator first, InputIterator last)
+{
+    for (; first != last; ++first) insert(*first);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::size_type
+blocked_skip_list<T,C,A,LG,B>::erase(const value_type &value)
+{
+    const_iterator i = find(value);
+    if (i == end()) return 0;
+    erase(i);
+    return 1;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::iterator
+blocked_skip_list<T,C,A,LG,B>::erase(const_iterator position)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_block()));
+    unsigned slot = position.get_slot();
+    block_type *block = impl.erase(const_cast<block_type*>(position.get_block()), slot);
+    return iterator(&impl, block, slot);
+}
+
+//==============================================================================
+#pragma mark lookup
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::const_iterator
+blocked_skip_list<T,C,A,LG,B>::find(const value_type &value) const
+{
+    const_iterator i = lower_bound(value);
+    return i != end() && !impl.less(value, *i) ? i : end();
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::const_iterator
+blocked_skip_list<T,C,A,LG,B>::lower_bound(const value_type &value) const
+{
+    unsigned slot = 0;
+    const block_type *block = impl.lower_bound(value, slot);
+    return const_iterator(&impl, block, slot);
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename blocked_skip_list<T,C,A,LG,B>::const_iterator
+blocked_skip_list<T,C,A,LG,B>::upper_bound(const value_type &value) const
+{
+    unsigned slot = 0;
+    const block_type *block = impl.upper_bound(value, slot);
+    return const_iterator(&impl, block, slot);
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - bsl_impl
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// A block of up to BlockSize sorted elements, with a tower of links. The
+/// elements are constructed in place, in storage aligned for any type.
+template <typename T, unsigned BlockSize>
+struct bsl_block
+{
+    typedef bsl_block<T,BlockSize> self_type;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    unsigned    magic;
+#endif
+    unsigned    level;
+    unsigned    count;
+    self_type  *prev;
+    self_type **next; ///< effectively self_type *next[level+1];
+
+    T       *keys()       { return reinterpret_cast<T*>(storage.bytes); }
+    const T *keys() const { return reinterpret_cast<const T*>(storage.bytes); }
+
+private:
+    union
+    {
+        char        bytes[BlockSize*sizeof(T)];
+        long double align_float;
+        void       *align_pointer;
+        long        align_int;
+    } storage;
+};
+
+/// Searches within a block. Each is a binary search with the comparison
+/// folded into a select rather than a branch, which for built-in types
+/// compiles to a conditional move, so there is nothing to mispredict.
+template <typename T, typename Compare>
+struct bsl_branchless_search
+{
+    /// The first of the count sorted keys that is not ordered before
+    /// value, or keys+count if there is none.
+    static const T *lower_bound(const T *keys, unsigned count, const T &value, const Compare &less)
+    {
+        if (!count) return keys;
+        const T *base = keys;
+        while (count > 1)
+        {
+            const unsigned half = count/2;
+            base   = less(base[half], value) ? base+half : base;
+            count -= half;
+        }
+        return base + (less(*base, value) ? 1 : 0);
+    }
+
+    /// The first of the count sorted keys that is ordered after value, or
+    /// keys+count if there is none.
+    static const T *upper_bound(const T *keys, unsigned count, const T &value, const Compare &less)
+    {
+        if (!count) return keys;
+        const T *base = keys;
+        while (count > 1)
+        {
+            const unsigned half = count/2;
+            base   = less(value, base[half]) ? base : base+half;
+            count -= half;
+        }
+        return base + (less(value, *base) ? 0 : 1);
+    }
+};
+
+/// Searches within a block: the branchless search for any comparator, but
+/// for arithmetic keys ordered by std::less, see bsl_less_search.
+template <typename T, typename Compare>
+struct bsl_block_search : bsl_branchless_search<T,Compare> {};
+
+//==============================================================================
+#pragma mark simd
+
+/// Counts the keys in a block that are less than value, and those not
+/// greater than it, a vector register at a time: each comparison gives a
+/// lane of all ones (minus one) where it holds, which is subtracted from a
+/// running count per lane, and the lanes are summed at the end. In a
+/// sorted block these counts are the lower and upper bounds, and finding
+/// them takes no branches on the data at all.
+///
+/// Specialised for int, the 32 and 64 bit signed integers, float and
+/// double when the compiler targets AVX2 (and SKIP_LIST_NO_SIMD is not
+/// defined). Uses 256 bit vectors, then 128 bit ones, then scalar code for
+/// what's left. With only 128 bit SSE2 vectors the scan is slower than the
+/// branchless binary search on blocks of 32, so that is used instead.
+template <typename T>
+struct bsl_simd_count
+{
+    static const bool enabled = false;
+};
+
+#ifdef SKIP_LIST_AVX2
+
+/// Sum of the four 32 bit lane counts
+inline unsigned bsl_sum32(__m128i counts)
+{
+    counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1,0,3,2)));
+    counts = _mm_add_epi32(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(2,3,0,1)));
+    return unsigned(_mm_cvtsi128_si32(counts));
+}
+
+/// Sum of the two 64 bit lane counts
+inline unsigned bsl_sum64(__m128i counts)
+{
+    counts = _mm_add_epi64(counts, _mm_shuffle_epi32(counts, _MM_SHUFFLE(1,0,3,2)));
+    return unsigned(_mm_cvtsi128_si32(counts));
+}
+
+inline __m128i bsl_fold32(__m256i counts)
+{
+    return _mm_add_epi32(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+}
+
+inline __m128i bsl_fold64(__m256i counts)
+{
+    return _mm_add_epi64(_mm256_castsi256_si128(counts), _mm256_extracti128_si256(counts, 1));
+}
+
+/// Signed integers, by size
+template <typename T, unsigned Bytes>
+struct bsl_simd_integer
+{
+    static const bool enabled = false;
+};
+
+template <typename T>
+struct bsl_simd_integer<T, 4>
+{
+    static const bool enabled = true;
+
+    static unsigned less_than(const T *keys, unsigned count, T value)
+    {
+        unsigned n = 0;
+        const __m256i v8 = _mm256_set1_epi32(int(value));
+        __m256i counts8 = _mm256_setzero_si256();
+        for (; n+8 <= count; n += 8)
+        {
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys+n));
+            counts8 = _mm256_sub_epi32(counts8, _mm256_cmpgt_epi32(v8, k));
+        }
+        __m128i counts = bsl_fold32(counts8);
+        const __m128i v = _mm_set1_epi32(int(value));
+        for (; n+4 <= count; n += 4)
+        {
+            const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+n));
+            counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(v, k));
+        }
+        unsigned result = bsl_sum32(counts);
+        for (; n < count; ++n) result += keys[n] < value;
+        return result;
+    }
+
+    static unsigned not_greater(const T *keys, unsigned count, T value)
+    {
+        unsigned n = 0;
+        const __m256i v8 = _mm256_set1_epi32(int(value));
+        __m256i counts8 = _mm256_setzero_si256();
+        for (; n+8 <= count; n += 8)
+        {
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys+n));
+            counts8 = _mm256_sub_epi32(counts8, _mm256_cmpgt_epi32(k, v8));
+        }
+        __m128i counts = bsl_fold32(counts8);
+        const __m128i v = _mm_set1_epi32(int(value));
+        for (; n+4 <= count; n += 4)
+        {
+            const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+n));
+            counts = _mm_sub_epi32(counts, _mm_cmpgt_epi32(k, v));
+        }
+        unsigned greater = bsl_sum32(counts);
+        for (; n < count; ++n) greater += value < keys[n];
+        return count - greater;
+    }
+};
+
+template <typename T>
+struct bsl_simd_integer<T, 8>
+{
+    static const bool enabled = true;
+
+    static unsigned less_than(const T *keys, unsigned count, T value)
+    {
+        unsigned n = 0;
+        const __m256i v4 = _mm256_set1_epi64x(value);
+        __m256i counts4 = _mm256_setzero_si256();
+        for (; n+4 <= count; n += 4)
+        {
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys+n));
+            counts4 = _mm256_sub_epi64(counts4, _mm256_cmpgt_epi64(v4, k));
+        }
+        __m128i counts = bsl_fold64(counts4);
+        const __m128i v = _mm_set1_epi64x(value);
+        for (; n+2 <= count; n += 2)
+        {
+            const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+n));
+            counts = _mm_sub_epi64(counts, _mm_cmpgt_epi64(v, k));
+        }
+        unsigned result = bsl_sum64(counts);
+        for (; n < count; ++n) result += keys[n] < value;
+        return result;
+    }
+
+    static unsigned not_greater(const T *keys, unsigned count, T value)
+    {
+        unsigned n = 0;
+        const __m256i v4 = _mm256_set1_epi64x(value);
+        __m256i counts4 = _mm256_setzero_si256();
+        for (; n+4 <= count; n += 4)
+        {
+            const __m256i k = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(keys+n));
+            counts4 = _mm256_sub_epi64(counts4, _mm256_cmpgt_epi64(k, v4));
+        }
+        __m128i counts = bsl_fold64(counts4);
+        const __m128i v = _mm_set1_epi64x(value);
+        for (; n+2 <= count; n += 2)
+        {
+            const __m128i k = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys+n));
+            counts = _mm_sub_epi64(counts, _mm_cmpgt_epi64(k, v));
+        }
+        unsigned greater = bsl_sum64(counts);
+        for (; n < count; ++n) greater += value < keys[n];
+        return count - greater;
+    }
+};
+
+template <> struct bsl_simd_count<int>  : bsl_simd_integer<int,  sizeof(int)>  {};
+template <> struct bsl_simd_count<long> : bsl_simd_integer<long, sizeof(long)> {};
+#ifdef SKIP_LIST_CPP11
+template <> struct bsl_simd_count<long long> : bsl_simd_integer<long long, sizeof(long long)> {};
+#endif
+
+template <>
+struct bsl_simd_count<float>
+{
+    static const bool enabled = true;
+
+    static unsigned less_than(const float *keys, unsigned count, float value)
+    {
+        unsigned n = 0;
+        const __m256 v8 = _mm256_set1_ps(value);
+        __m256i counts8 = _mm256_setzero_si256();
+        for (; n+8 <= count; n += 8)
+        {
+            const __m256 less = _mm256_cmp_ps(_mm256_loadu_ps(keys+n), v8, _CMP_LT_OQ);
+            counts8 = _mm256_sub_epi32(counts8, _mm256_castps_si256(less));
+        }
+        __m128i counts = bsl_fold32(counts8);
+        const __m128 v = _mm_set1_ps(value);
+        for (; n+4 <= count; n += 4)
+        {
+            counts = _mm_sub_epi32(counts, _mm_castps_si128(_mm_cmplt_ps(_mm_loadu_ps(keys+n), v)));
+        }
+        unsigned result = bsl_sum32(counts);
+        for (; n < count; ++n) result += keys[n] < value;
+        return result;
+    }
+
+    static unsigned not_greater(const float *keys, unsigned count, float value)
+    {
+        unsigned n = 0;
+        const __m256 v8 = _mm256_set1_ps(value);
+        __m256i counts8 = _mm256_setzero_si256();
+        for (; n+8 <= count; n += 8)
+        {
+            const __m256 greater = _mm256_cmp_ps(v8, _mm256_loadu_ps(keys+n), _CMP_LT_OQ);
+            counts8 = _mm256_sub_epi32(counts8, _mm256_castps_si256(greater));
+        }
+        __m128i counts = bsl_fold32(counts8);
+        const __m128 v = _mm_set1_ps(value);
+        for (; n+4 <= count; n += 4)
+        {
+            counts = _mm_sub_epi32(counts, _mm_castps_si128(_mm_cmplt_ps(v, _mm_loadu_ps(keys+n))));
+        }
+        unsigned greater = bsl_sum32(counts);
+        for (; n < count; ++n) greater += value < keys[n];
+        return count - greater;
+    }
+};
+
+template <>
+struct bsl_simd_count<double>
+{
+    static const bool enabled = true;
+
+    static unsigned less_than(const double *keys, unsigned count, double value)
+    {
+        unsigned n = 0;
+        const __m256d v4 = _mm256_set1_pd(value);
+        __m256i counts4 = _mm256_setzero_si256();
+        for (; n+4 <= count; n += 4)
+        {
+            const __m256d less = _mm256_cmp_pd(_mm256_loadu_pd(keys+n), v4, _CMP_LT_OQ);
+            counts4 = _mm256_sub_epi64(counts4, _mm256_castpd_si256(less));
+        }
+        __m128i counts = bsl_fold64(counts4);
+        const __m128d v = _mm_set1_pd(value);
+        for (; n+2 <= count; n += 2)
+        {
+            counts = _mm_sub_epi64(counts, _mm_castpd_si128(_mm_cmplt_pd(_mm_loadu_pd(keys+n), v)));
+        }
+        unsigned result = bsl_sum64(counts);
+        for (; n < count; ++n) result += keys[n] < value;
+        return result;
+    }
+
+    static unsigned not_greater(const double *keys, unsigned count, double value)
+    {
+        unsigned n = 0;
+        const __m256d v4 = _mm256_set1_pd(value);
+        __m256i counts4 = _mm256_setzero_si256();
+        for (; n+4 <= count; n += 4)
+        {
+            const __m256d greater = _mm256_cmp_pd(v4, _mm256_loadu_pd(keys+n), _CMP_LT_OQ);
+            counts4 = _mm256_sub_epi64(counts4, _mm256_castpd_si256(greater));
+        }
+        __m128i counts = bsl_fold64(counts4);
+        const __m128d v = _mm_set1_pd(value);
+        for (; n+2 <= count; n += 2)
+        {
+            counts = _mm_sub_epi64(counts, _mm_castpd_si128(_mm_cmplt_pd(v, _mm_loadu_pd(keys+n))));
+        }
+        unsigned greater = bsl_sum64(counts);
+        for (; n < count; ++n) greater += value < keys[n];
+        return count - greater;
+    }
+};
+
+#endif // SKIP_LIST_AVX2
+
+/// The block search for keys ordered by std::less: vectorised counts where
+/// bsl_simd_count supports the type, the branchless search otherwise.
+template <typename T, bool Vectorised = bsl_simd_count<T>::enabled>
+struct bsl_less_search : bsl_branchless_search<T, std::less<T> > {};
+
+template <typename T>
+struct bsl_less_search<T, true>
+{
+    static const T *lower_bound(const T *keys, unsigned count, const T &value, const std::less<T> &)
+    {
+        return keys + bsl_simd_count<T>::less_than(keys, count, value);
+    }
+
+    static const T *upper_bound(const T *keys, unsigned count, const T &value, const std::less<T> &)
+    {
+        return keys + bsl_simd_count<T>::not_greater(keys, count, value);
+    }
+};
+
+template <typename T>
+struct bsl_block_search<T, std::less<T> > : bsl_less_search<T> {};
+
+/// Internal implementation of blocked_skip_list data structure and methods
+/// for modifying it.
+///
+/// Not for "public" access.
+///
+/// @internal
+template <typename T, typename Compare, typename Allocator,
+          typename LevelGenerator, unsigned BlockSize>
+class bsl_impl
+{
+public:
+
+    typedef T                                   value_type;
+    typedef typename Allocator::size_type       size_type;
+    typedef typename Allocator::difference_type difference_type;
+    typedef typename Allocator::const_reference const_reference;
+    typedef typename Allocator::const_pointer   const_pointer;
+    typedef Allocator                           allocator_type;
+    typedef Compare                             compare_type;
+    typedef LevelGenerator                      generator_type;
+    typedef bsl_block<T,BlockSize>              block_type;
+    typedef bsl_block_search<T,Compare>         search_type;
+
+    static const unsigned num_levels = LevelGenerator::num_levels;
+
+    bsl_impl(const Allocator &alloc = Allocator());
+    ~bsl_impl();
+
+    Allocator         get_allocator() const                   { return alloc; }
+    size_type         size() const                            { return item_count; }
+    bool              is_valid(const block_type *block) const { return block && block != head && block != tail; }
+    const block_type *front() const                           { return head->next[0]; }
+    const block_type *one_past_end() const                    { return tail; }
+
+    block_type       *insert(const value_type &value, unsigned &slot, bool &inserted);
+    block_type       *erase(block_type *block, unsigned &slot);
+    const block_type *lower_bound(const value_type &value, unsigned &slot) const;
+    const block_type *upper_bound(const value_type &value, unsigned &slot) const;
+    void              remove_all();
+    void              swap(bsl_impl &other);
+
+    template <typename InputIterator>
+    void              assign_sorted(InputIterator first, InputIterator last);
+
+    template <typename STREAM>
+    void        dump(STREAM &stream) const;
+    bool        check() const;
+
+    compare_type less;
+
+private:
+    typedef typename Allocator::template rebind<block_type>::other  block_allocator;
+    typedef typename Allocator::template rebind<block_type*>::other list_allocator;
+
+    bsl_impl(const bsl_impl &other);
+    bsl_impl &operator=(const bsl_impl &other);
+
+    block_type *find_block(const value_type &value, block_type **chain) const;
+    void        find_predecessors(const value_type &value, block_type **chain) const;
+    void        split(block_type *block, block_type **chain);
+    void        unlink(block_type *block, block_type **chain);
+    unsigned    new_level();
+
+    allocator_type  alloc;
+    generator_type  generator;
+    unsigned        levels;
+    block_type     *head;
+    block_type     *tail;
+    size_type       item_count;
+
+    block_type *allocate(unsigned level)
+    {
+        block_type *block = block_allocator(alloc).allocate(1, (void*)0);
+        block->next  = list_allocator(alloc).allocate(level+1, (void*)0);
+        block->level = level;
+        block->count = 0;
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+        for (unsigned n = 0; n <= level; ++n) block->next[n] = 0;
+        block->magic = MAGIC_GOOD;
+#endif
+        return block;
+    }
+
+    /// Destroys the block's elements, and releases it.
+    void deallocate(block_type *block)
+    {
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+        assert_that(block->magic == MAGIC_GOOD);
+        block->magic = MAGIC_BAD;
+#endif
+        for (unsigned n = 0; n < block->count; ++n) alloc.destroy(block->keys()+n);
+        list_allocator(alloc).deallocate(block->next, block->level+1);
+        block_allocator(alloc).deallocate(block, 1);
+    }
+};
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bsl_impl<T,C,A,LG,B>::bsl_impl(const allocator_type &alloc_)
+:   alloc(alloc_),
+    levels(0),
+    head(allocate(num_levels)),
+    tail(allocate(num_levels)),
+    item_count(0)
+{
+    static_assert_that(B >= 4);
+
+    for (unsigned n = 0; n < num_levels; n++)
+    {
+        head->next[n] = tail;
+        tail->next[n] = 0;
+    }
+    head->prev = 0;
+    tail->prev = head;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bsl_impl<T,C,A,LG,B>::~bsl_impl()
+{
+    remove_all();
+    deallocate(head);
+    deallocate(tail);
+}
+
+/// Returns the last block whose first element is not ordered after value
+/// (or head, if there is none), filling chain[l] (if chain is not null)
+/// with the last such block on each level l < levels.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename bsl_impl<T,C,A,LG,B>::block_type *
+bsl_impl<T,C,A,LG,B>::find_block(const value_type &value, block_type **chain) const
+{
+    block_type *cur = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        for (;;)
+        {
+            block_type *next = cur->next[l];
+            if (next == tail || less(value, next->keys()[0])) break;
+            cur = next;
+        }
+        if (chain) chain[l] = cur;
+    }
+    return cur;
+}
+
+/// Fills chain[l], for every level, with the last block whose first element
+/// is ordered before value: the predecessors of the block starting with
+/// value.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+void bsl_impl<T,C,A,LG,B>::find_predecessors(const value_type &value, block_type **chain) const
+{
+    block_type *cur = head;
+    for (unsigned l = num_levels; l > levels; ) chain[--l] = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && less(cur->next[l]->keys()[0], value))
+        {
+            cur = cur->next[l];
+        }
+        chain[l] = cur;
+    }
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+const typename bsl_impl<T,C,A,LG,B>::block_type *
+bsl_impl<T,C,A,LG,B>::lower_bound(const value_type &value, unsigned &slot) const
+{
+    const block_type *block = find_block(value, 0);
+    slot = 0;
+    if (block == head) return head->next[0];
+
+    slot = unsigned(search_type::lower_bound(block->keys(), block->count, value, less) - block->keys());
+    if (slot < block->count) return block;
+    slot = 0;
+    return block->next[0];
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+const typename bsl_impl<T,C,A,LG,B>::block_type *
+bsl_impl<T,C,A,LG,B>::upper_bound(const value_type &value, unsigned &slot) const
+{
+    const block_type *block = find_block(value, 0);
+    slot = 0;
+    if (block == head) return head->next[0];
+
+    slot = unsigned(search_type::upper_bound(block->keys(), block->count, value, less) - block->keys());
+    if (slot < block->count) return block;
+    slot = 0;
+    return block->next[0];
+}
+
+/// Inserts value, if there is no equivalent element, in the block it falls
+/// in (the first block, if it orders before them all), splitting that
+/// first if it is full. Returns the block the element ends up in, and sets
+/// slot to its place there.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename bsl_impl<T,C,A,LG,B>::block_type *
+bsl_impl<T,C,A,LG,B>::insert(const value_type &value, unsigned &slot, bool &inserted)
+{
+    block_type *chain[num_levels+1];
+    block_type *block = find_block(value, chain);
+    for (unsigned l = levels; l <= num_levels; ++l) chain[l] = head;
+
+    inserted = false;
+    slot     = 0;
+    if (block == head)
+    {
+        block = head->next[0];
+        if (block == tail)
+        {
+            // The first block
+            block = allocate(new_level());
+            block->prev = head;
+            for (unsigned l = 0; l <= block->level; ++l)
+            {
+                block->next[l] = tail;
+                head->next[l]  = block;
+            }
+            tail->prev = block;
+        }
+        for (unsigned l = 0; l <= block->level; ++l) chain[l] = block;
+    }
+    else
+    {
+        const T *pos = search_type::lower_bound(block->keys(), block->count, value, less);
+        slot = unsigned(pos - block->keys());
+        if (slot < block->count && !less(value, *pos)) return block;
+    }
+
+    if (block->count == B)
+    {
+        split(block, chain);
+        if (slot > block->count)
+        {
+            slot  -= block->count;
+            block  = block->next[0];
+        }
+    }
+
+    T *keys = block->keys();
+    if (slot == block->count)
+    {
+        alloc.construct(keys+slot, value);
+    }
+    else
+    {
+        alloc.construct(keys+block->count, keys[block->count-1]);
+        std::copy_backward(keys+slot, keys+block->count-1, keys+block->count);
+        keys[slot] = value;
+    }
+    ++block->count;
+    ++item_count;
+    inserted = true;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+    return block;
+}
+
+/// Moves the upper half of a full block to a new block linked in after it.
+/// chain holds the block's predecessors on the levels above its own, and
+/// the block itself on its own levels.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+void bsl_impl<T,C,A,LG,B>::split(block_type *block, block_type **chain)
+{
+    assert_that(block->count == B);
+    assert_that(chain[0] == block);
+
+    block_type *next = allocate(new_level());
+    for (unsigned l = 0; l <= next->level; ++l)
+    {
+        next->next[l]     = chain[l]->next[l];
+        chain[l]->next[l] = next;
+    }
+    next->prev          = block;
+    next->next[0]->prev = next;
+
+    const unsigned keep = B/2;
+    T *from = block->keys();
+    T *to   = next->keys();
+    for (unsigned n = keep; n < B; ++n)
+    {
+        alloc.construct(to + n-keep, from[n]);
+        alloc.destroy(from+n);
+    }
+    block->count = keep;
+    next->count  = B-keep;
+}
+
+/// Unlinks block, given its predecessors, and releases it.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+void bsl_impl<T,C,A,LG,B>::unlink(block_type *block, block_type **chain)
+{
+    for (unsigned l = 0; l <= block->level; ++l)
+    {
+        assert_that(chain[l]->next[l] == block);
+        chain[l]->next[l] = block->next[l];
+    }
+    block->next[0]->prev = block->prev;
+    deallocate(block);
+}
+
+/// Erases the element at slot of block. If that empties the block it is
+/// unlinked; if it leaves the block less than a quarter full, and the next
+/// block's elements fit in the rest of the block with room to spare, they
+/// are moved in and the next block unlinked. Returns the block holding the
+/// element after the erased one (or the tail), and sets slot to its place.
+template <class T, class C, class A, class LG, unsigned B>
+inline
+typename bsl_impl<T,C,A,LG,B>::block_type *
+bsl_impl<T,C,A,LG,B>::erase(block_type *block, unsigned &slot)
+{
+    assert_that(is_valid(block) && slot < block->count);
+
+    block_type *chain[num_levels+1];
+    --item_count;
+
+    if (block->count == 1)
+    {
+        block_type *next = block->next[0];
+        find_predecessors(block->keys()[0], chain);
+        unlink(block, chain);
+        slot = 0;
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+        check();
+#endif
+        return next;
+    }
+
+    T *keys = block->keys();
+    std::copy(keys+slot+1, keys+block->count, keys+slot);
+    alloc.destroy(keys + --block->count);
+
+    block_type *result = block;
+    if (slot == block->count)
+    {
+        result = block->next[0];
+        slot   = 0;
+    }
+
+    block_type *next = block->next[0];
+    if (block->count < B/4 && next != tail && block->count + next->count <= B - B/4)
+    {
+        if (result == next)
+        {
+            result = block;
+            slot   = block->count;
+        }
+        T *from = next->keys();
+        for (unsigned n = 0; n < next->count; ++n)
+        {
+            alloc.construct(keys + block->count++, from[n]);
+        }
+        find_predecessors(from[0], chain);
+        unlink(next, chain);
+    }
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+    return result;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+void bsl_impl<T,C,A,LG,B>::remove_all()
+{
+    block_type *block = head->next[0];
+    while (block != tail)
+    {
+        block_type *next = block->next[0];
+        deallocate(block);
+        block = next;
+    }
+
+    for (unsigned l = 0; l < num_levels; ++l) head->next[l] = tail;
+    tail->prev = head;
+    item_count = 0;
+}
+
+/// Fills each block in turn, linking blocks on to the back of the list as
+/// it goes; chain holds the last block on each level.
+template <class T, class C, class A, class LG, unsigned B>
+template <typename InputIterator>
+inline
+void bsl_impl<T,C,A,LG,B>::assign_sorted(InputIterator first, InputIterator last)
+{
+    remove_all();
+
+    block_type *chain[num_levels+1];
+    for (unsigned l = 0; l <= num_levels; ++l) chain[l] = head;
+
+    for (; first != last; ++first)
+    {
+        block_type *back = chain[0];
+        assert_that(back == head || less(back->keys()[back->count-1], *first));
+        if (back == head || back->count == B)
+        {
+            back = allocate(new_level());
+            back->prev = chain[0];
+            for (unsigned l = 0; l <= back->level; ++l)
+            {
+                chain[l]->next[l] = back;
+                chain[l]          = back;
+            }
+        }
+        alloc.construct(back->keys() + back->count++, *first);
+        ++item_count;
+    }
+
+    for (unsigned l = 0; l < num_levels; ++l) chain[l]->next[l] = tail;
+    tail->prev = chain[0];
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+unsigned bsl_impl<T,C,A,LG,B>::new_level()
+{
+    unsigned level = generator.new_level();
+    if (level >= levels)
+    {
+        level = levels;
+        ++levels;
+    }
+    return level;
+}
+
+template <class T, class C, class A, class LG, unsigned B>
+inline
+void bsl_impl<T,C,A,LG,B>::swap(bsl_impl &other)
+{
+    using std::swap;
+
+    swap(alloc,      other.alloc);
+    swap(less,       other.less);
+    swap(generator,  other.generator);
+    swap(levels,     other.levels);
+    swap(head,       other.head);
+    swap(tail,       other.tail);
+    swap(item_count, other.item_count);
+}
+
+// for diagnostics only
+template <class T, class C, class A, class LG, unsigned B>
+template <class STREAM>
+inline
+void bsl_impl<T,C,A,LG,B>::dump(STREAM &s) const
+{
+    s << "blocked_skip_list(size=" << item_count << ",levels=" << levels << ")\n";
+    for (unsigned l = 0; l < levels; ++l)
+    {
+        s << "  [" << l << "]";
+        for (const block_type *block = head->next[l]; block != tail; block = block->next[l])
+        {
+            s << " {";
+            for (unsigned n = 0; n < block->count; ++n) s << (n ? "," : "") << block->keys()[n];
+            s << "}";
+        }
+        s << "\n";
+    }
+}
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+// for diagnostics only
+template <class T, class C, class A, class LG, unsigned B>
+inline
+bool bsl_impl<T,C,A,LG,B>::check() const
+{
+    size_type count = 0;
+    for (const block_type *block = head->next[0]; block != tail; block = block->next[0])
+    {
+        if (block->magic != MAGIC_GOOD || block->next[0]->prev != block)
+        {
+            assert_that(false && "chain error");
+            dump(std::cerr);
+            return false;
+        }
+        if (block->count == 0 || block->count > B)
+        {
+            assert_that(false && "block count error");
+            dump(std::cerr);
+            return false;
+        }
+        const T *keys = block->keys();
+        for (unsigned n = 1; n < block->count; ++n)
+        {
+            if (!less(keys[n-1], keys[n]))
+            {
+                assert_that(false && "value order error");
+                dump(std::cerr);
+                return false;
+            }
+        }
+        if (block->next[0] != tail && !less(keys[block->count-1], block->next[0]->keys()[0]))
+        {
+            assert_that(false && "block order error");
+            dump(std::cerr);
+            return false;
+        }
+        count += block->count;
+    }
+    if (count != item_count)
+    {
+        assert_that(false && "item count error");
+        dump(std::cerr);
+        return false;
+    }
+
+    for (unsigned l = 1; l < levels; ++l)
+    {
+        for (const block_type *block = head; block->next[l] != tail; block = block->next[l])
+        {
+            const block_type *next = block->next[l];
+            if (next->level < l || (block != head && !less(block->keys()[0], next->keys()[0])))
+            {
+                assert_that(false && "level order error");
+                dump(std::cerr);
+                return false;
+            }
+        }
+    }
+    return true;
+}
+#endif
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,778 @@
+//==============================================================================
+// concurrent_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list_detail.h"
+#include "skip_list_epoch.h"
+
+#ifndef SKIP_LIST_CPP11
+#error "concurrent_skip_list requires C++11 (for std::atomic)"
+#endif
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+#include <iterator>   // for std::iterator
+#include <utility>    // for std::pair
+#include <atomic>     // for std::atomic
+#include <cstdint>    // for std::uintptr_t
+#include <new>        // for placement new
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - internal forward declarations
+
+namespace goodliffe {
+
+/// @internal
+/// Internal namespace for impementation of skip list data structure
+namespace detail
+{
+    template <typename T,typename C,typename A,typename LG>
+    class csl_impl;
+
+    template <typename LIST> class csl_const_iterator;
+}
+}
+
+//==============================================================================
+#pragma mark - concurrent_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// A skip list of unique objects that may be used from many threads at once
+/// without any external locking.
+///
+/// insert, erase, find, contains and count are lock-free: they are built on
+/// compare-and-swap of the links in each node's tower, with erased nodes
+/// first logically deleted (by marking their links) and then physically
+/// unlinked by whichever thread next passes them. This is the Fraser/Harris
+/// scheme, as presented by Herlihy and Shavit. find, contains and count
+/// never write to the list.
+///
+/// Iteration is weakly consistent: an iterator never becomes invalid, and
+/// will see every element that is present for the whole of the iteration,
+/// but may or may not see elements inserted or erased concurrently.
+/// Elements cannot be modified through an iterator.
+///
+/// Erased elements cannot be freed straight away, since another thread may
+/// still be looking at them. Instead they are reclaimed (destroyed, and
+/// deallocated through Allocator) by epoch-based reclamation, once no
+/// thread can hold them. Each operation pins the calling thread for its
+/// duration, as does every iterator for its lifetime; so holding on to an
+/// iterator holds up the reclamation of everything erased after it was
+/// created. Let iterators go (or reach end()) promptly.
+///
+/// clear(), and destruction, must not run concurrently with any other
+/// operation, nor while any iterators exist.
+///
+/// @param T              Template type for kind of object held in the
+///                       container.
+/// @param Compare        Template type describing the ordering comparator.
+/// @param Allocator      Template type for memory allocator for the contents
+///                       of the container. Must be safe to call from several
+///                       threads at once, as std::allocator is.
+/// @param LevelGenerator Template type for the node height generator. The
+///                       default keeps its state per thread, to avoid
+///                       contending on std::rand.
+///
+/// @see skip_list
+template <typename T,
+          typename Compare         = std::less<T>,
+          typename Allocator       = std::allocator<T>,
+          typename LevelGenerator  = detail::concurrent_level_generator<32> >
+class concurrent_skip_list
+{
+protected:
+    typedef typename detail::csl_impl<T,Compare,Allocator,LevelGenerator> impl_type;
+    typedef typename impl_type::node_type node_type;
+    typedef typename impl_type::pin_type  pin_type;
+
+public:
+
+    //======================================================================
+    // types
+
+    typedef T                                           value_type;
+    typedef Allocator                                   allocator_type;
+    typedef typename impl_type::size_type               size_type;
+    typedef typename allocator_type::difference_type    difference_type;
+    typedef typename allocator_type::reference          reference;
+    typedef typename allocator_type::const_reference    const_reference;
+    typedef typename allocator_type::pointer            pointer;
+    typedef typename allocator_type::const_pointer      const_pointer;
+    typedef Compare                                     compare;
+
+    typedef typename detail::csl_const_iterator<impl_type> const_iterator;
+    typedef const_iterator                                 iterator;
+
+    //======================================================================
+    // lifetime management
+
+    explicit concurrent_skip_list(const Allocator &alloc = Allocator())
+        : impl(alloc) {}
+
+    template <class InputIterator>
+    concurrent_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
+        : impl(alloc) { insert(first, last); }
+
+    allocator_type get_allocator() const { return impl.get_allocator(); }
+
+    //======================================================================
+    // iterators
+
+    const_iterator begin() const
+    {
+        pin_type pin(impl.get_domain());
+        node_type *front = impl.front();
+        return const_iterator(&impl, front, std::move(pin));
+    }
+    const_iterator cbegin() const           { return begin(); }
+    const_iterator end() const              { return const_iterator(&impl, 0, pin_type()); }
+    const_iterator cend() const             { return end(); }
+
+    //======================================================================
+    // capacity
+
+    /// With concurrent updates, these give a snapshot that may already be
+    /// out of date.
+    bool      empty() const         { pin_type pin(impl.get_domain()); return impl.front() == 0; }
+    size_type size() const          { return impl.size(); }
+    size_type max_size() const      { return impl.get_allocator().max_size(); }
+
+    //======================================================================
+    // modifiers
+
+    /// Not thread safe.
+    void clear() { impl.remove_all(); }
+
+    typedef typename std::pair<iterator,bool> insert_by_value_result;
+
+    insert_by_value_result insert(const value_type &value)
+    {
+        pin_type pin(impl.get_domain());
+        std::pair<node_type*,bool> result = impl.insert(value, pin.get());
+        return insert_by_value_result(iterator(&impl, result.first, std::move(pin)), result.second);
+    }
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+    {
+        while (first != last)
+        {
+            pin_type pin(impl.get_domain());
+            impl.insert(*first++, pin.get());
+        }
+    }
+
+    size_type erase(const value_type &value)
+    {
+        pin_type pin(impl.get_domain());
+        return impl.erase(value, pin.get());
+    }
+
+    //======================================================================
+    // lookup
+
+    bool contains(const value_type &value) const
+    {
+        pin_type pin(impl.get_domain());
+        return impl.find(value) != 0;
+    }
+
+    size_type count(const value_type &value) const { return contains(value); }
+
+    const_iterator find(const value_type &value) const
+    {
+        pin_type pin(impl.get_domain());
+        node_type *node = impl.find(value);
+        return node ? const_iterator(&impl, node, std::move(pin)) : end();
+    }
+
+protected:
+    impl_type impl;
+
+private:
+    concurrent_skip_list(const concurrent_skip_list &other);
+    concurrent_skip_list &operator=(const concurrent_skip_list &other);
+};
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - iterators
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+template <class CSL_IMPL>
+class csl_const_iterator
+    : public std::iterator<std::forward_iterator_tag,
+                           typename CSL_IMPL::value_type,
+                           typename CSL_IMPL::difference_type,
+                           typename CSL_IMPL::const_pointer,
+                           typename CSL_IMPL::const_reference>
+{
+public:
+    typedef const CSL_IMPL                      impl_type;
+    typedef typename impl_type::node_type       node_type;
+    typedef typename impl_type::pin_type        pin_type;
+    typedef csl_const_iterator<CSL_IMPL>        self_type;
+
+    typedef typename impl_type::const_reference const_reference;
+    typedef typename impl_type::const_pointer   const_pointer;
+
+    csl_const_iterator()
+        : impl(0), node(0), pin() {}
+    csl_const_iterator(impl_type *impl_, node_type *node_, pin_type &&pin_)
+        : impl(impl_), node(node_), pin(std::move(pin_)) {}
+
+    self_type &operator++()
+        { advance(); return *this; }
+    self_type operator++(int) // postincrement
+        { self_type old(*this); advance(); return old; }
+
+    const_reference operator*()  { return node->value; }
+    const_pointer   operator->() { return &node->value; }
+
+    bool operator==(const self_type &other) const
+        { return node == other.node; }
+    bool operator!=(const self_type &other) const
+        { return !operator==(other); }
+
+    const impl_type *get_impl() const { return impl; } ///< @internal
+    const node_type *get_node() const { return node; } ///< @internal
+
+private:
+    void advance()
+    {
+        node = impl->next(node);
+        if (!node) pin.reset(); // no longer protecting anything
+    }
+
+    impl_type *impl;
+    node_type *node;
+    pin_type   pin;  ///< keeps node from being reclaimed
+};
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - csl_impl
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// A node's links hold an atomic pointer to the next node at that level.
+/// The bottom bit of a link is set to mark the node as deleted; once set,
+/// that link never changes again.
+template <typename T>
+struct csl_node
+{
+    typedef csl_node<T>             self_type;
+    typedef std::atomic<self_type*> link_type;
+
+    T                       value;
+    unsigned                level;
+    link_type              *next;         ///< effectively link_type next[level+1];
+    std::atomic<unsigned>   claims;       ///< see csl_impl::release_claim
+    self_type              *next_retired; ///< chains erased nodes awaiting reclamation
+};
+
+template <typename NODE>
+inline
+bool csl_is_marked(NODE *node)
+    { return (reinterpret_cast<std::uintptr_t>(node) & 1) != 0; }
+
+template <typename NODE>
+inline
+NODE *csl_marked(NODE *node)
+    { return reinterpret_cast<NODE*>(reinterpret_cast<std::uintptr_t>(node) | 1); }
+
+template <typename NODE>
+inline
+NODE *csl_unmarked(NODE *node)
+    { return reinterpret_cast<NODE*>(reinterpret_cast<std::uintptr_t>(node) & ~std::uintptr_t(1)); }
+
+/// Internal implementation of concurrent_skip_list data structure and
+/// methods for modifying it.
+///
+/// The end of each level is marked by a null link, rather than a tail node.
+///
+/// Not for "public" access.
+///
+/// @internal
+template <typename T, typename Compare, typename Allocator, typename LevelGenerator>
+class csl_impl
+{
+public:
+
+    typedef T                                   value_type;
+    typedef typename Allocator::size_type       size_type;
+    typedef typename Allocator::difference_type difference_type;
+    typedef typename Allocator::const_reference const_reference;
+    typedef typename Allocator::const_pointer   const_pointer;
+    typedef Allocator                           allocator_type;
+    typedef Compare                             compare_type;
+    typedef LevelGenerator                      generator_type;
+    typedef csl_node<T>                         node_type;
+    typedef typename node_type::link_type       link_type;
+    typedef epoch_domain<node_type,csl_impl,Allocator>  domain_type;
+    typedef epoch_pin<domain_type>                      pin_type;
+    typedef typename domain_type::record                record_type;
+
+    static const unsigned num_levels = LevelGenerator::num_levels;
+
+    csl_impl(const Allocator &alloc = Allocator());
+    ~csl_impl();
+
+    Allocator    get_allocator() const   { return alloc; }
+    domain_type &get_domain() const      { return domain; }
+    size_type    size() const            { return item_count.load(std::memory_order_relaxed); }
+
+    // The caller must hold a pin for all of these
+    node_type   *front() const           { return next(head); }
+    node_type   *next(const node_type *node) const;
+    node_type   *find(const value_type &value) const;
+    std::pair<node_type*,bool>
+                 insert(const value_type &value, record_type *pin);
+    bool         erase(const value_type &value, record_type *pin);
+    template <class Random>
+    node_type   *spray(unsigned height, unsigned max_jump, Random &random) const;
+
+    void         remove_all();
+    void         reclaim(node_type *node);
+
+    compare_type less;
+
+private:
+    typedef typename Allocator::template rebind<node_type>::other    node_allocator;
+    typedef typename Allocator::template rebind<link_type>::other    list_allocator;
+
+    csl_impl(const csl_impl &other);
+    csl_impl &operator=(const csl_impl &other);
+
+    unsigned new_level();
+    bool     find(const value_type &value, node_type **preds, node_type **succs);
+    bool     try_find(const value_type &value, node_type **preds, node_type **succs, bool &found);
+    void     link_tower(node_type *node, node_type **preds, node_type **succs);
+    void     release_claim(node_type *node, record_type *pin);
+
+    allocator_type           alloc;
+    generator_type           generator;
+    std::atomic<unsigned>    levels;
+    node_type               *head;
+    std::atomic<size_type>   item_count;
+    mutable domain_type      domain;
+
+    node_type *allocate(unsigned level)
+    {
+        node_type *node = node_allocator(alloc).allocate(1, (void*)0);
+        node->next  = list_allocator(alloc).allocate(level+1, (void*)0);
+        node->level = level;
+        for (unsigned n = 0; n <= level; ++n) new (&node->next[n]) link_type(0);
+        new (&node->claims) std::atomic<unsigned>(0);
+        node->next_retired = 0;
+        return node;
+    }
+
+    void deallocate(node_type *node)
+    {
+        list_allocator(alloc).deallocate(node->next, node->level+1);
+        node_allocator(alloc).deallocate(node, 1);
+    }
+};
+
+template <class T, class C, class A, class LG>
+inline
+csl_impl<T,C,A,LG>::csl_impl(const allocator_type &alloc_)
+:   alloc(alloc_),
+    levels(0),
+    head(allocate(num_levels-1)),
+    item_count(0),
+    domain(*this, alloc_)
+{
+}
+
+template <class T, class C, class A, class LG>
+inline
+csl_impl<T,C,A,LG>::~csl_impl()
+{
+    remove_all();
+    deallocate(head);
+}
+
+template <class T, class C, class A, class LG>
+inline
+unsigned csl_impl<T,C,A,LG>::new_level()
+{
+    unsigned level = generator.new_level();
+    if (level >= num_levels) level = num_levels-1;
+
+    // As with sl_impl, let the list grow by at most one level at a time
+    unsigned top = levels.load(std::memory_order_relaxed);
+    while (level >= top)
+    {
+        level = top;
+        if (levels.compare_exchange_weak(top, top+1, std::memory_order_release, std::memory_order_relaxed))
+            break;
+    }
+    return level;
+}
+
+/// Returns the first unmarked node after node on level 0, or null.
+template <class T, class C, class A, class LG>
+inline
+typename csl_impl<T,C,A,LG>::node_type *
+csl_impl<T,C,A,LG>::next(const node_type *node) const
+{
+    node_type *next = csl_unmarked(node->next[0].load(std::memory_order_acquire));
+    while (next)
+    {
+        node_type *after = next->next[0].load(std::memory_order_acquire);
+        if (!csl_is_marked(after)) break;
+        next = csl_unmarked(after);
+    }
+    return next;
+}
+
+/// The read-only search: steps over marked nodes, but never unlinks them.
+/// Returns the node holding an equivalent value, or null.
+template <class T, class C, class A, class LG>
+inline
+typename csl_impl<T,C,A,LG>::node_type *
+csl_impl<T,C,A,LG>::find(const value_type &value) const
+{
+    const node_type *pred = head;
+    node_type       *curr = 0;
+
+    for (unsigned l = levels.load(std::memory_order_acquire); l; )
+    {
+        --l;
+        curr = csl_unmarked(pred->next[l].load(std::memory_order_acquire));
+        while (curr)
+        {
+            node_type *succ = curr->next[l].load(std::memory_order_acquire);
+            if (csl_is_marked(succ))
+            {
+                curr = csl_unmarked(succ);
+            }
+            else if (less(curr->value, value))
+            {
+                pred = curr;
+                curr = succ;
+            }
+            else
+            {
+                break;
+            }
+        }
+    }
+
+    return curr && !less(value, curr->value) ? curr : 0;
+}
+
+/// The updating search: fills preds[l] and succs[l] with the nodes either
+/// side of value at each level, unlinking any marked nodes found on the way.
+/// Returns true if succs[0] holds an equivalent value.
+template <class T, class C, class A, class LG>
+inline
+bool
+csl_impl<T,C,A,LG>::find(const value_type &value, node_type **preds, node_type **succs)
+{
+    bool found = false;
+    while (!try_find(value, preds, succs, found))
+    {
+    }
+    return found;
+}
+
+/// One attempt at the updating search. Returns false if a concurrent change
+/// got in the way, and the search must start again from the head.
+template <class T, class C, class A, class LG>
+inline
+bool
+csl_impl<T,C,A,LG>::try_find(const value_type &value, node_type **preds, node_type **succs, bool &found)
+{
+    node_type *pred = head;
+    node_type *curr = 0;
+
+    for (unsigned l = levels.load(std::memory_order_acquire); l; )
+    {
+        --l;
+        curr = csl_unmarked(pred->next[l].load(std::memory_order_acquire));
+        while (curr)
+        {
+            node_type *succ = curr->next[l].load(std::memory_order_acquire);
+            if (csl_is_marked(succ))
+            {
+                // curr is being erased: unlink it at this level
+                node_type *expected = curr;
+                if (!pred->next[l].compare_exchange_strong(expected, csl_unmarked(succ),
+                                                           std::memory_order_acq_rel,
+                                                           std::memory_order_acquire))
+                {
+                    return false;
+                }
+                curr = csl_unmarked(succ);
+            }
+            else if (less(curr->value, value))
+            {
+                pred = curr;
+                curr = succ;
+            }
+            else
+            {
+                break;
+            }
+        }
+        preds[l] = pred;
+        succs[l] = curr;
+    }
+
+    found = curr && !less(value, curr->value);
+    return true;
+}
+
+template <class T, class C, class A, class LG>
+inline
+std::pair<typename csl_impl<T,C,A,LG>::node_type*,bool>
+csl_impl<T,C,A,LG>::insert(const value_type &value, record_type *pin)
+{
+    const unsigned level = new_level();
+
+    node_type *preds[num_levels];
+    node_type *succs[num_levels];
+    node_type *new_node = 0;
+
+    for (;;)
+    {
+        if (find(value, preds, succs))
+        {
+            if (new_node)
+            {
+                alloc.destroy(&new_node->value);
+                deallocate(new_node);
+            }
+            return std::make_pair(succs[0], false);
+        }
+
+        if (!new_node)
+        {
+            new_node = allocate(level);
+            alloc.construct(&new_node->value, value);
+            new_node->claims.store(2, std::memory_order_relaxed);
+        }
+        for (unsigned l = 0; l <= level; ++l)
+        {
+            new_node->next[l].store(succs[l], std::memory_order_relaxed);
+        }
+
+        // Linking at level 0 is what puts the value in the list
+        node_type *expected = succs[0];
+        if (preds[0]->next[0].compare_exchange_strong(expected, new_node,
+                                                      std::memory_order_acq_rel,
+                                                      std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    item_count.fetch_add(1, std::memory_order_relaxed);
+    link_tower(new_node, preds, succs);
+
+    // If the node was erased while we were building its tower, we may have
+    // linked it at some level after the eraser's search unlinked it; search
+    // again to be sure it is gone before it can be retired.
+    if (csl_is_marked(new_node->next[0].load(std::memory_order_acquire)))
+    {
+        find(value, preds, succs);
+    }
+    release_claim(new_node, pin);
+
+    return std::make_pair(new_node, true);
+}
+
+/// Links the upper levels of a node that has just been linked at level 0.
+/// If the node is erased part way through, its tower is left unfinished.
+template <class T, class C, class A, class LG>
+inline
+void
+csl_impl<T,C,A,LG>::link_tower(node_type *node, node_type **preds, node_type **succs)
+{
+    for (unsigned l = 1; l <= node->level; ++l)
+    {
+        for (;;)
+        {
+            node_type *next = node->next[l].load(std::memory_order_acquire);
+            if (csl_is_marked(next)) return;
+            if (next != succs[l]
+                && !node->next[l].compare_exchange_strong(next, succs[l],
+                                                          std::memory_order_acq_rel,
+                                                          std::memory_order_acquire))
+            {
+                return; // only erase changes our links: we've been marked
+            }
+
+            node_type *expected = succs[l];
+            if (preds[l]->next[l].compare_exchange_strong(expected, node,
+                                                          std::memory_order_acq_rel,
+                                                          std::memory_order_acquire))
+            {
+                break;
+            }
+
+            find(node->value, preds, succs);
+            if (succs[0] != node) return;
+        }
+    }
+}
+
+template <class T, class C, class A, class LG>
+inline
+bool
+csl_impl<T,C,A,LG>::erase(const value_type &value, record_type *pin)
+{
+    node_type *preds[num_levels];
+    node_type *succs[num_levels];
+
+    if (!find(value, preds, succs)) return false;
+    node_type *victim = succs[0];
+
+    // Mark the tower from the top down, so searches stop using it
+    for (unsigned l = victim->level; l > 0; --l)
+    {
+        node_type *next = victim->next[l].load(std::memory_order_acquire);
+        while (!csl_is_marked(next)
+               && !victim->next[l].compare_exchange_weak(next, csl_marked(next),
+                                                         std::memory_order_acq_rel,
+                                                         std::memory_order_acquire))
+        {
+        }
+    }
+
+    // Marking level 0 is what removes the value; only one thread can win
+    node_type *next = victim->next[0].load(std::memory_order_acquire);
+    for (;;)
+    {
+        if (csl_is_marked(next)) return false;
+        if (victim->next[0].compare_exchange_weak(next, csl_marked(next),
+                                                  std::memory_order_acq_rel,
+                                                  std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    item_count.fetch_sub(1, std::memory_order_relaxed);
+    find(value, preds, succs); // unlinks victim at every level
+    release_claim(victim, pin);
+    return true;
+}
+
+/// A SprayList "spray" (Alistarh, Kopinsky, Li and Shavit): a random walk
+/// from the head that lands on one of the first few nodes, so that threads
+/// which each want a node near the front mostly pick different ones.
+///
+/// Starting at level height (or the top of the list, if that is lower) it
+/// steps forward over between 0 and max_jump nodes, chosen by random(),
+/// then drops a level, down to level 0. Returns the node it lands on (which
+/// may since have been marked), the first node if it never left the head,
+/// or null if the list is empty. With height and max_jump both 0 it always
+/// returns the first node.
+template <class T, class C, class A, class LG>
+template <class Random>
+inline
+typename csl_impl<T,C,A,LG>::node_type *
+csl_impl<T,C,A,LG>::spray(unsigned height, unsigned max_jump, Random &random) const
+{
+    node_type *pred = head;
+
+    const unsigned top = levels.load(std::memory_order_acquire);
+    for (unsigned l = height < top ? height+1 : top; l; )
+    {
+        --l;
+        for (unsigned jump = max_jump ? random() % (max_jump+1) : 0; jump; --jump)
+        {
+            node_type *curr = csl_unmarked(pred->next[l].load(std::memory_order_acquire));
+            while (curr)
+            {
+                node_type *succ = curr->next[l].load(std::memory_order_acquire);
+                if (!csl_is_marked(succ)) break;
+                curr = csl_unmarked(succ);
+            }
+            if (!curr) break;
+            pred = curr;
+        }
+    }
+
+    return pred == head ? front() : pred;
+}
+
+/// A node can only be retired once it is unreachable at every level. Its
+/// inserter and its eraser each hold a claim on it, and give it up once
+/// they are done linking or unlinking it; the last one out retires it.
+template <class T, class C, class A, class LG>
+inline
+void
+csl_impl<T,C,A,LG>::release_claim(node_type *node, record_type *pin)
+{
+    if (node->claims.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+        domain.retire(pin, node);
+    }
+}
+
+/// Destroys and deallocates a node, once the domain says it is safe to.
+template <class T, class C, class A, class LG>
+inline
+void
+csl_impl<T,C,A,LG>::reclaim(node_type *node)
+{
+    alloc.destroy(&node->value);
+    deallocate(node);
+}
+
+template <class T, class C, class A, class LG>
+inline
+void
+csl_impl<T,C,A,LG>::remove_all()
+{
+    // Erased nodes are no longer reachable on level 0, so nothing is both
+    // in the list and retired
+    node_type *node = csl_unmarked(head->next[0].load(std::memory_order_acquire));
+    while (node)
+    {
+        node_type *next = csl_unmarked(node->next[0].load(std::memory_order_relaxed));
+        reclaim(node);
+        node = next;
+    }
+    domain.reclaim_all();
+
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        head->next[l].store(0, std::memory_order_relaxed);
+    }
+    item_count.store(0, std::memory_order_release);
+}
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,762 @@
+//==============================================================================
+// interval_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list.h"
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+#include <vector>     // for the marker lists
+#include <algorithm>  // for std::find
+#include <new>        // for placement new
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - internal forward declarations
+
+namespace goodliffe {
+namespace detail
+{
+    template <typename T, typename Compare, typename Allocator, typename LevelGenerator>
+    class isl_impl;
+
+    template <typename Compare> struct isl_interval_order;
+}
+}
+
+//==============================================================================
+#pragma mark - interval
+//==============================================================================
+
+namespace goodliffe {
+
+/// A closed interval [first,second], as held in an interval_skip_list.
+/// Like a std::pair, it compares by first and then by second.
+template <typename T>
+struct interval
+{
+    typedef T value_type;
+
+    interval() : first(), second() {}
+    interval(const T &first_, const T &second_) : first(first_), second(second_) {}
+
+    T first;
+    T second;
+};
+
+template <typename T>
+inline
+bool operator==(const interval<T> &lhs, const interval<T> &rhs)
+{
+    return lhs.first == rhs.first && lhs.second == rhs.second;
+}
+
+template <typename T>
+inline
+bool operator!=(const interval<T> &lhs, const interval<T> &rhs)
+{
+    return !operator==(lhs, rhs);
+}
+
+template <typename T>
+inline
+bool operator<(const interval<T> &lhs, const interval<T> &rhs)
+{
+    return lhs.first < rhs.first || (!(rhs.first < lhs.first) && lhs.second < rhs.second);
+}
+
+template <typename STREAM, typename T>
+inline
+STREAM &operator<<(STREAM &s, const interval<T> &i)
+{
+    s << "[" << i.first << "," << i.second << "]";
+    return s;
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - interval_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// An interval_skip_list holds closed intervals [first,second], and finds
+/// those that contain a point (stab) or that overlap a range (overlaps) in
+/// O(log N + K), for N intervals of which K are found.
+///
+/// This is Hanson's interval skip list. Every distinct endpoint is a node in
+/// a skip list of endpoints, and each interval is marked on a path of links
+/// through that list, from its first endpoint to its second. The path uses
+/// the tallest links that fit inside the interval, so it takes O(log N)
+/// links. A point lies under exactly one link at each level, so a search
+/// for it visits O(log N) links, and collects the intervals marked on them.
+/// Each interval that holds the point is marked on exactly one of them, or
+/// on the node at the point itself.
+///
+/// The intervals themselves are held in a multi_skip_list, ordered by first
+/// endpoint and then by second. Iterating visits them in that order.
+///
+/// @param T              Template type for the endpoints of the intervals.
+/// @param Compare        Template type describing the ordering of endpoints.
+/// @param Allocator      Template type for memory allocator for the
+///                       intervals (and, rebound, for the endpoints).
+/// @param LevelGenerator Template type for the node height generator.
+template <typename T,
+          typename Compare        = std::less<T>,
+          typename Allocator      = std::allocator<interval<T> >,
+          typename LevelGenerator = detail::skip_list_level_generator<32> >
+class interval_skip_list
+{
+public:
+
+    //======================================================================
+    // types
+
+    typedef interval<T>                                         value_type;
+    typedef T                                                   point_type;
+    typedef multi_skip_list<value_type, detail::isl_interval_order<Compare>,
+                            Allocator, LevelGenerator>          container_type;
+    typedef Allocator                                           allocator_type;
+    typedef typename container_type::size_type                  size_type;
+    typedef typename container_type::difference_type            difference_type;
+    typedef typename container_type::const_reference            const_reference;
+    typedef typename container_type::const_iterator             const_iterator;
+    typedef Compare                                             compare;
+
+    //======================================================================
+    // lifetime management
+
+    explicit interval_skip_list(const Allocator &alloc = Allocator())
+        : intervals(alloc), impl(alloc) {}
+
+    template <class InputIterator>
+    interval_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
+        : intervals(alloc), impl(alloc) { insert(first, last); }
+
+    interval_skip_list(const interval_skip_list &other)
+        : intervals(other.get_allocator()), impl(other.get_allocator()) { insert(other.begin(), other.end()); }
+
+    interval_skip_list &operator=(const interval_skip_list &other);
+
+    allocator_type get_allocator() const { return intervals.get_allocator(); }
+
+    //======================================================================
+    // capacity
+
+    bool      empty() const         { return intervals.empty(); }
+    size_type size() const          { return intervals.size(); }
+    size_type max_size() const      { return intervals.max_size(); }
+
+    //======================================================================
+    // iterators
+
+    /// Iterates over the intervals in order of their endpoints
+    const_iterator begin() const    { return intervals.begin(); }
+    const_iterator end() const      { return intervals.end(); }
+    const_iterator cbegin() const   { return intervals.cbegin(); }
+    const_iterator cend() const     { return intervals.cend(); }
+
+    //======================================================================
+    // modifiers
+
+    /// Adds the interval [value.first,value.second], which must not end
+    /// before it starts. Equal intervals may be added more than once.
+    /// O(log N), plus a copy of the markers on any links that a new
+    /// endpoint splits.
+    const_iterator insert(const value_type &value);
+
+    template <class InputIterator>
+    void insert(InputIterator first, InputIterator last)
+        { for (; first != last; ++first) insert(*first); }
+
+    const_iterator erase(const_iterator position);
+
+    /// Erases every interval equal to value, returning how many there were.
+    size_type erase(const value_type &value);
+
+    void clear()                            { impl.remove_all(); intervals.clear(); }
+    void swap(interval_skip_list &other)    { intervals.swap(other.intervals); impl.swap(other.impl); }
+
+    //======================================================================
+    // lookup
+
+    size_type      count(const value_type &value) const   { return intervals.count(value); }
+    const_iterator find(const value_type &value) const;
+
+    /// Writes out every interval that contains point, in O(log N + K).
+    template <typename OutputIterator>
+    OutputIterator stab(const point_type &point, OutputIterator out) const
+        { return impl.stab(point, out); }
+
+    /// Writes out every interval that shares at least one point with
+    /// [lo,hi], in O(log N + K): those that contain lo, then those that
+    /// start after lo but not after hi.
+    template <typename OutputIterator>
+    OutputIterator overlaps(const point_type &lo, const point_type &hi, OutputIterator out) const;
+
+    //======================================================================
+    // other operations
+
+    template <typename STREAM>
+    void dump(STREAM &stream) const { impl.dump(stream); }
+
+    const container_type &container() const { return intervals; }
+
+private:
+    typedef detail::isl_impl<T,Compare,Allocator,LevelGenerator> impl_type;
+
+    container_type intervals;
+    impl_type      impl;
+};
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - non-members
+//==============================================================================
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG>
+inline
+bool operator==(const interval_skip_list<T,C,A,LG> &lhs, const interval_skip_list<T,C,A,LG> &rhs)
+{
+    return lhs.container() == rhs.container();
+}
+
+template <class T, class C, class A, class LG>
+inline
+bool operator!=(const interval_skip_list<T,C,A,LG> &lhs, const interval_skip_list<T,C,A,LG> &rhs)
+{
+    return !operator==(lhs, rhs);
+}
+
+} // namespace goodliffe
+
+namespace std
+{
+    /// Override of std::swap for interval_skip_list
+    template <class T, class C, class A, class LG>
+    void swap(goodliffe::interval_skip_list<T,C,A,LG> &lhs,
+              goodliffe::interval_skip_list<T,C,A,LG> &rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+//==============================================================================
+#pragma mark - interval_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG>
+inline
+interval_skip_list<T,C,A,LG> &
+interval_skip_list<T,C,A,LG>::operator=(const interval_skip_list &other)
+{
+    if (&other != this)
+    {
+        clear();
+        insert(other.begin(), other.end());
+    }
+    return *this;
+}
+
+template <class T, class C, class A, class LG>
+inline
+typename interval_skip_list<T,C,A,LG>::const_iterator
+interval_skip_list<T,C,A,LG>::insert(const value_type &value)
+{
+    assert_that(!impl.less(value.second, value.first));
+    const_iterator i = intervals.insert(value).first;
+    impl.add(&*i);
+    return i;
+}
+
+template <class T, class C, class A, class LG>
+inline
+typename interval_skip_list<T,C,A,LG>::const_iterator
+interval_skip_list<T,C,A,LG>::erase(const_iterator position)
+{
+    assert_that(position != end());
+    impl.remove(&*position);
+    return intervals.erase(position);
+}
+
+template <class T, class C, class A, class LG>
+inline
+typename interval_skip_list<T,C,A,LG>::size_type
+interval_skip_list<T,C,A,LG>::erase(const value_type &value)
+{
+    size_type erased = 0;
+    for (const_iterator i = find(value); i != end(); i = find(value))
+    {
+        erase(i);
+        ++erased;
+    }
+    return erased;
+}
+
+template <class T, class C, class A, class LG>
+inline
+typename interval_skip_list<T,C,A,LG>::const_iterator
+interval_skip_list<T,C,A,LG>::find(const value_type &value) const
+{
+    const_iterator i = intervals.lower_bound(value);
+    const detail::isl_interval_order<C> order = detail::isl_interval_order<C>();
+    return i != end() && detail::equivalent(*i, value, order) ? i : end();
+}
+
+template <class T, class C, class A, class LG>
+template <typename OutputIterator>
+inline
+OutputIterator
+interval_skip_list<T,C,A,LG>::overlaps(const point_type &lo, const point_type &hi, OutputIterator out) const
+{
+    if (impl.less(hi, lo)) return out;
+
+    // Those that start at lo hold it, so stab() has found them already
+    out = impl.stab(lo, out);
+    const_iterator i = intervals.lower_bound(value_type(lo, lo));
+    while (i != end() && !impl.less(lo, i->first)) ++i;
+    for (; i != end() && !impl.less(hi, i->first); ++i)
+    {
+        *out++ = *i;
+    }
+    return out;
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - isl_impl
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// Orders intervals by their first endpoints, and then by their second.
+template <typename Compare>
+struct isl_interval_order
+{
+    template <typename Interval>
+    bool operator()(const Interval &lhs, const Interval &rhs) const
+    {
+        return less(lhs.first, rhs.first)
+            || (!less(rhs.first, lhs.first) && less(lhs.second, rhs.second));
+    }
+
+    Compare less;
+};
+
+/// An endpoint in an interval_skip_list: the value held in each node of its
+/// skip list of endpoints.
+///
+/// markers[l] lists the intervals marked on the node's level l link, each
+/// of which holds every point that the link passes over. eq lists the
+/// intervals whose paths pass through (or start or end at) this node, which
+/// therefore hold the endpoint itself.
+template <typename T, typename Interval, typename Allocator>
+struct isl_endpoint
+{
+    typedef typename Allocator::template rebind<const Interval*>::other marker_allocator;
+    typedef std::vector<const Interval*, marker_allocator>              marker_list;
+
+    explicit isl_endpoint(const T &value_) : value(value_), owners(0), markers(0) {}
+
+    T            value;
+    unsigned     owners;  ///< the number of interval ends at this point
+    marker_list *markers; ///< effectively marker_list markers[level+1];
+    marker_list  eq;
+};
+
+/// Orders endpoints by their values.
+template <typename Compare>
+struct isl_endpoint_order
+{
+    template <typename Endpoint>
+    bool operator()(const Endpoint &lhs, const Endpoint &rhs) const
+        { return less(lhs.value, rhs.value); }
+
+    Compare less;
+};
+
+template <typename STREAM, typename T, typename I, typename A>
+inline
+STREAM &operator<<(STREAM &s, const isl_endpoint<T,I,A> &endpoint)
+{
+    s << endpoint.value;
+    return s;
+}
+
+/// Internal implementation of interval_skip_list: the skip list of
+/// endpoints, and the markers on its links.
+///
+/// The endpoints are held in an sl_impl, which links, searches and levels
+/// its towers as for any skip_list. isl_impl keeps the markers up to date
+/// around it. Each interval is marked on a path of links from its first
+/// endpoint to its second, and in the eq list of every node on that path.
+/// When a node is added, the links it splits pass their markers to both
+/// halves, so every path stays whole. When a node is removed, the intervals
+/// that pass through it are unmarked and then marked afresh.
+///
+/// Not for "public" access.
+///
+/// @internal
+template <typename T, typename Compare, typename Allocator, typename LevelGenerator>
+class isl_impl
+{
+public:
+    typedef interval<T>                                                 interval_type;
+    typedef isl_endpoint<T,interval_type,Allocator>                     endpoint_type;
+    typedef typename Allocator::template rebind<endpoint_type>::other  endpoint_allocator;
+    typedef sl_impl<endpoint_type, isl_endpoint_order<Compare>,
+                    endpoint_allocator, LevelGenerator, false, single_threaded> list_type;
+    typedef typename list_type::node_type                               node_type;
+    typedef typename endpoint_type::marker_list                         marker_list;
+
+    static const unsigned num_levels = LevelGenerator::num_levels;
+
+    explicit isl_impl(const Allocator &alloc_)
+        : alloc(alloc_), endpoints(endpoint_allocator(alloc_)), levels(0)
+    {
+        // Markers are kept for fixed towers
+        static_assert_that(!sl_deterministic<LevelGenerator>::value);
+    }
+    ~isl_impl() { release_all_markers(); }
+
+    void add(const interval_type *interval);
+    void remove(const interval_type *interval);
+    void remove_all()               { release_all_markers(); endpoints.remove_all(); }
+    void swap(isl_impl &other);
+
+    template <typename OutputIterator>
+    OutputIterator stab(const T &point, OutputIterator out) const;
+
+    template <typename STREAM>
+    void dump(STREAM &stream) const;
+    bool check() const;
+
+    Compare less;
+
+private:
+    typedef typename Allocator::template rebind<marker_list>::other marker_list_allocator;
+    typedef typename endpoint_type::marker_allocator                marker_allocator;
+
+    isl_impl(const isl_impl &other);
+    isl_impl &operator=(const isl_impl &other);
+
+    node_type *head() const { return const_cast<node_type*>(endpoints.one_past_front()); }
+    node_type *tail() const { return const_cast<node_type*>(endpoints.one_past_end()); }
+
+    node_type *find(const T &value) const;
+    node_type *acquire(const T &value);
+    void       release(node_type *node);
+    void       mark(const interval_type *interval, node_type *first, node_type *last);
+    void       unmark(const interval_type *interval, node_type *first, node_type *last);
+    void       release_all_markers();
+
+    static void erase_marker(marker_list &list, const interval_type *interval)
+    {
+        typename marker_list::iterator i = std::find(list.begin(), list.end(), interval);
+        assert_that(i != list.end());
+        *i = list.back();
+        list.pop_back();
+    }
+
+    Allocator  alloc;
+    list_type  endpoints;
+    unsigned   levels;
+};
+
+template <class T, class C, class A, class LG>
+inline
+typename isl_impl<T,C,A,LG>::node_type *
+isl_impl<T,C,A,LG>::find(const T &value) const
+{
+    node_type *node = endpoints.find_equivalent(endpoint_type(value));
+    assert_that(endpoints.is_valid(node));
+    return node;
+}
+
+/// Returns the node for the endpoint value, adding one if there is none,
+/// and counts one more interval end there.
+///
+/// A new node splits the links that pass over it at each of its levels.
+/// Every interval marked on such a link holds both halves of it, and the
+/// node between them, so it is marked on all three.
+template <class T, class C, class A, class LG>
+inline
+typename isl_impl<T,C,A,LG>::node_type *
+isl_impl<T,C,A,LG>::acquire(const T &value)
+{
+    const endpoint_type endpoint(value);
+    node_type *node = endpoints.find_equivalent(endpoint);
+    if (node == tail())
+    {
+        node = endpoints.insert(endpoint);
+        if (node->level >= levels) levels = node->level+1;
+
+        const unsigned height = node->level+1;
+        marker_list *markers  = marker_list_allocator(alloc).allocate(height, (void*)0);
+        for (unsigned l = 0; l < height; ++l) new (&markers[l]) marker_list(marker_allocator(alloc));
+        node->value.markers = markers;
+
+        node_type *prev = head();
+        for (unsigned l = levels; l; )
+        {
+            --l;
+            while (prev->next[l] != node && prev->next[l] != tail()
+                   && less(prev->next[l]->value.value, value))
+            {
+                prev = prev->next[l];
+            }
+            if (l > node->level || prev == head()) continue;
+
+            const marker_list &split = prev->value.markers[l];
+            markers[l] = split;
+            node->value.eq.insert(node->value.eq.end(), split.begin(), split.end());
+        }
+    }
+    ++node->value.owners;
+    return node;
+}
+
+/// Counts one fewer interval end at node, and removes the node once no
+/// interval ends there. The intervals whose paths pass through it are
+/// unmarked first, and marked again once it has gone.
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::release(node_type *node)
+{
+    assert_that(node->value.owners);
+    if (--node->value.owners) return;
+
+    const marker_list through(node->value.eq);
+    for (typename marker_list::const_iterator i = through.begin(); i != through.end(); ++i)
+    {
+        unmark(*i, find((*i)->first), find((*i)->second));
+    }
+    assert_that(node->value.eq.empty());
+
+    marker_list *markers = node->value.markers;
+    for (unsigned l = 0; l <= node->level; ++l)
+    {
+        assert_that(markers[l].empty());
+        markers[l].~marker_list();
+    }
+    marker_list_allocator(alloc).deallocate(markers, node->level+1);
+    endpoints.remove(node);
+
+    for (typename marker_list::const_iterator i = through.begin(); i != through.end(); ++i)
+    {
+        mark(*i, find((*i)->first), find((*i)->second));
+    }
+}
+
+/// Marks interval on the path from first to last that takes, from each
+/// node, the tallest link that does not pass last.
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::mark(const interval_type *interval, node_type *first, node_type *last)
+{
+    node_type *node = first;
+    node->value.eq.push_back(interval);
+    while (node != last)
+    {
+        unsigned l = node->level < levels ? node->level : levels-1;
+        while (node->next[l] == tail() || less(last->value.value, node->next[l]->value.value)) --l;
+        node->value.markers[l].push_back(interval);
+        node = node->next[l];
+        node->value.eq.push_back(interval);
+    }
+}
+
+/// Removes interval's markers, following its path from first to last by the
+/// link at each node that carries it. (The path need not be the one mark()
+/// would take now, as nodes added since may have split its links.)
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::unmark(const interval_type *interval, node_type *first, node_type *last)
+{
+    node_type *node = first;
+    erase_marker(node->value.eq, interval);
+    while (node != last)
+    {
+        unsigned l = node->level+1;
+        do
+        {
+            assert_that(l);
+            --l;
+        }
+        while (std::find(node->value.markers[l].begin(), node->value.markers[l].end(), interval)
+               == node->value.markers[l].end());
+        erase_marker(node->value.markers[l], interval);
+        node = node->next[l];
+        erase_marker(node->value.eq, interval);
+    }
+}
+
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::add(const interval_type *interval)
+{
+    node_type *first = acquire(interval->first);
+    node_type *last  = acquire(interval->second);
+    mark(interval, first, last);
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::remove(const interval_type *interval)
+{
+    node_type *first = find(interval->first);
+    node_type *last  = find(interval->second);
+    unmark(interval, first, last);
+    release(first);
+    release(last);
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+/// Frees the marker lists of every node, ready for them all to be removed.
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::release_all_markers()
+{
+    for (node_type *node = head()->next[0]; node != tail(); node = node->next[0])
+    {
+        marker_list *markers = node->value.markers;
+        for (unsigned l = 0; l <= node->level; ++l) markers[l].~marker_list();
+        marker_list_allocator(alloc).deallocate(markers, node->level+1);
+        node->value.markers = 0;
+    }
+}
+
+/// Searches for point as a skip_list would. At each level, the link it
+/// drops down from passes over point, so every interval marked on it holds
+/// point. If point is itself an endpoint, the search finds its node, and
+/// the intervals that hold it are all in that node's eq list.
+template <class T, class C, class A, class LG>
+template <typename OutputIterator>
+inline
+OutputIterator isl_impl<T,C,A,LG>::stab(const T &point, OutputIterator out) const
+{
+    const node_type *node = head();
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        const node_type *next = node->next[l];
+        while (next != tail() && less(next->value.value, point))
+        {
+            node = next;
+            next = node->next[l];
+        }
+
+        if (next != tail() && !less(point, next->value.value))
+        {
+            const marker_list &eq = next->value.eq;
+            for (typename marker_list::const_iterator i = eq.begin(); i != eq.end(); ++i) *out++ = **i;
+            break;
+        }
+        if (node != head() && next != tail())
+        {
+            const marker_list &markers = node->value.markers[l];
+            for (typename marker_list::const_iterator i = markers.begin(); i != markers.end(); ++i) *out++ = **i;
+        }
+    }
+    return out;
+}
+
+template <class T, class C, class A, class LG>
+inline
+void isl_impl<T,C,A,LG>::swap(isl_impl &other)
+{
+    using std::swap;
+
+    swap(alloc,  other.alloc);
+    swap(less,   other.less);
+    swap(levels, other.levels);
+    endpoints.swap(other.endpoints);
+}
+
+// for diagnostics only
+template <class T, class C, class A, class LG>
+template <class STREAM>
+inline
+void isl_impl<T,C,A,LG>::dump(STREAM &s) const
+{
+    endpoints.dump(s);
+    for (const node_type *node = head()->next[0]; node != tail(); node = node->next[0])
+    {
+        s << "  " << node->value.value << " (owners=" << node->value.owners
+          << ",eq=" << node->value.eq.size() << ") markers:";
+        for (unsigned l = 0; l <= node->level; ++l) s << " " << node->value.markers[l].size();
+        s << "\n";
+    }
+}
+
+// for diagnostics only
+/// Every interval marked on a link must hold both of its ends, and every
+/// interval in a node's eq list must hold that node.
+template <class T, class C, class A, class LG>
+inline
+bool isl_impl<T,C,A,LG>::check() const
+{
+    for (const node_type *node = head()->next[0]; node != tail(); node = node->next[0])
+    {
+        const T &value = node->value.value;
+        for (typename marker_list::const_iterator i = node->value.eq.begin(); i != node->value.eq.end(); ++i)
+        {
+            if (less(value, (*i)->first) || less((*i)->second, value))
+            {
+                assert_that(false && "eq marker error");
+                return false;
+            }
+        }
+        for (unsigned l = 0; l <= node->level; ++l)
+        {
+            const marker_list &markers = node->value.markers[l];
+            if (!markers.empty() && node->next[l] == tail())
+            {
+                assert_that(false && "marker past the end");
+                return false;
+            }
+            for (typename marker_list::const_iterator i = markers.begin(); i != markers.end(); ++i)
+            {
+                if (less(value, (*i)->first) || less((*i)->second, node->next[l]->value.value))
+                {
+                    assert_that(false && "marker error");
+                    return false;
+                }
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -11,6 +11,9 @@
 #include <functional> // for std::less
 #include <iterator>   // for std::reverse_iterator
 #include <utility>    // for std::pair
+#include <limits>     // for std::numeric_limits
+#include <cstddef>    // for std::size_t
+#include <stdexcept>  // for std::length_error
 
 //==============================================================================
 
@@ -25,14 +28,38 @@
 namespace goodliffe {
 namespace detail
 {
-    template <typename T,typename C,typename A,typename LG>
+    template <typename T,typename C,typename A,typename LG,bool D,typename S,typename W>
     class rasl_impl;
 
+    struct unit_weight;
+
     template <typename LIST> class rasl_iterator;
     template <typename LIST> class rasl_const_iterator;
 }
 }
 
+//==============================================================================
+#pragma mark - weights
+//==============================================================================
+
+namespace goodliffe {
+
+/// A base for Weight function objects whose weights add up, such as
+/// volumes or sizes: it supplies the combine() and identity() that every
+/// Weight needs. A Weight that aggregates some other way (the latest of a
+/// set of timestamps, say) supplies its own: combine() must be
+/// associative, and identity() must change nothing it is combined with.
+template <typename R>
+struct additive_weight
+{
+    typedef R result_type;
+
+    static R identity()                         { return R(); }
+    static R combine(const R &lhs, const R &rhs) { return lhs + rhs; }
+};
+
+} // namespace goodliffe
+
 //==============================================================================
 #pragma mark - random_access_skip_list
 //==============================================================================
@@ -50,15 +77,40 @@ namespace goodliffe {
 /// This speed comes at the expense of a little extra storage within the
 /// data structure.
 ///
+/// Iterators remember their index until the list next changes, so ++, --
+/// and comparing or subtracting them is O(1), and i += n (for n > 0) is O(log n)
+/// rather than O(log N).
+///
+/// @param SpanType The unsigned integer type each node stores its spans in
+///                 (one per level): the list can hold one element fewer
+///                 than its largest value (see max_size()). The default,
+///                 unsigned, is usually 32 bits, so allows some 4 billion
+///                 elements; unsigned short halves the spans' memory again,
+///                 for lists that will stay under 65535 elements.
+///                 Growing a list past max_size() throws std::length_error.
+/// @param Weight   A function object giving each element's weight (a
+///                 volume, or a size in bytes) as its result_type, with
+///                 combine() and identity() to aggregate weights by: an
+///                 associative monoid, such as additive_weight's sum, or
+///                 a max or min. Each link then also keeps the aggregate
+///                 weight of the elements it passes over, and
+///                 prefix_weight(), aggregate() and
+///                 lower_bound_by_weight() are all O(log N). By default
+///                 every element weighs 1, and the spans serve as the
+///                 weights.
+///
 /// @see skip_list
 template <typename T,
-          typename Compare        = std::less<T>,
-          typename Allocator      = std::allocator<T>,
-          typename LevelGenerator = detail::skip_list_level_generator<32> >
+          typename Compare         = std::less<T>,
+          typename Allocator       = std::allocator<T>,
+          typename LevelGenerator  = detail::skip_list_level_generator<32>,
+          bool     AllowDuplicates = false,
+          typename SpanType        = unsigned,
+          typename Weight          = detail::unit_weight>
 class random_access_skip_list
 {
-private:
-    typedef typename detail::rasl_impl<T,Compare,Allocator,LevelGenerator> impl_type;
+protected:
+    typedef typename detail::rasl_impl<T,Compare,Allocator,LevelGenerator,AllowDuplicates,SpanType,Weight> impl_type;
     typedef typename impl_type::node_type                                  node_type;
 
     template <typename T1> friend class detail::rasl_iterator;
@@ -78,17 +130,28 @@ public:
     typedef typename allocator_type::pointer            pointer;
     typedef typename allocator_type::const_pointer      const_pointer;
     typedef Compare                                     compare;
+    typedef LevelGenerator                              level_generator;
+    typedef typename impl_type::weight_type             weight_type;
     
     typedef typename detail::rasl_iterator<impl_type>   iterator;
     typedef typename iterator::const_iterator           const_iterator;
     typedef std::reverse_iterator<iterator>             reverse_iterator;
     typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
 
+#ifdef SKIP_LIST_CPP11
+    typedef detail::sl_node_handle<node_type,Allocator>                 node_handle;
+    typedef detail::sl_insert_return_type<iterator,node_handle>         insert_return_type;
+#endif
+
     //======================================================================
     // lifetime management
 
     explicit random_access_skip_list(const Allocator &alloc = Allocator());
 
+    /// An empty list that orders its elements with less. Copies of the list
+    /// keep it.
+    explicit random_access_skip_list(const Compare &less, const Allocator &alloc = Allocator());
+
     template <class InputIterator>
     random_access_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator());
 
@@ -102,6 +165,9 @@ public:
 
     allocator_type get_allocator() const { return impl.get_allocator(); }
 
+    /// The comparator the list orders its elements with
+    compare value_comp() const { return impl.less; }
+
     //======================================================================
     // assignment
 
@@ -111,6 +177,12 @@ public:
     template <typename InputIterator>
     void assign(InputIterator first, InputIterator last);
 
+    /// Replaces the contents of the list with the range [first,last), which
+    /// must already be sorted. This builds the list, spans and all, in
+    /// linear time, rather than the O(N log N) of assign().
+    template <typename InputIterator>
+    void assign_sorted(InputIterator first, InputIterator last);
+
     //======================================================================
     // element access
 
@@ -122,13 +194,13 @@ public:
     //======================================================================
     // iterators
 
-    iterator       begin()                  { return iterator(&impl, impl.front()); }
-    const_iterator begin() const            { return const_iterator(&impl, impl.front()); }
-    const_iterator cbegin() const           { return const_iterator(&impl, impl.front()); }
+    iterator       begin()                  { return iterator(&impl, impl.front(), 0); }
+    const_iterator begin() const            { return const_iterator(&impl, impl.front(), 0); }
+    const_iterator cbegin() const           { return const_iterator(&impl, impl.front(), 0); }
 
-    iterator       end()                    { return iterator(&impl, impl.one_past_end()); }
-    const_iterator end() const              { return const_iterator(&impl, impl.one_past_end()); }
-    const_iterator cend() const             { return const_iterator(&impl, impl.one_past_end()); }
+    iterator       end()                    { return iterator(&impl, impl.one_past_end(), size()); }
+    const_iterator end() const              { return const_iterator(&impl, impl.one_past_end(), size()); }
+    const_iterator cend() const             { return const_iterator(&impl, impl.one_past_end(), size()); }
 
     reverse_iterator       rbegin()         { return reverse_iterator(end()); }
     const_reverse_iterator rbegin() const   { return const_reverse_iterator(end()); }
@@ -143,7 +215,7 @@ public:
 
     bool      empty() const         { return impl.size() == 0; }
     size_type size() const          { return impl.size(); }
-    size_type max_size() const      { return impl.get_allocator().max_size(); }
+    size_type max_size() const      { return impl.max_size(); }
 
     //======================================================================
     // modifiers
@@ -168,10 +240,53 @@ public:
     iterator  erase(const_iterator position);
     iterator  erase(const_iterator first, const_iterator last);
 
+#ifdef SKIP_LIST_CPP11
+    /// Unlinks the element from the list and returns a handle owning it.
+    /// The element is neither copied nor deallocated.
+    node_handle extract(const_iterator position);
+    node_handle extract(const value_type &value);
+
+    /// Relinks an extracted element, keeping its existing allocation.
+    /// If an equivalent element is already present, the handle is returned
+    /// (still owning the element) in the result's node.
+    insert_return_type insert(node_handle &&handle);
+#endif
+
+    /// Changes the value of the element at position in place, by calling
+    /// modifier(value), and then moves the element to its new place in the
+    /// list. This is O(1) if the element is still correctly ordered with
+    /// respect to its neighbours.
+    ///
+    /// Returns true if the element is still in the list. If its new value is
+    /// equivalent to another element's, or if modifier throws, the element is
+    /// erased and false is returned (or the exception rethrown).
+    ///
+    /// @see skip_list::modify
+    template <typename Modifier>
+    bool modify(const_iterator position, Modifier modifier);
+
     void swap(random_access_skip_list &other) { impl.swap(other.impl); }
 
     friend void swap(random_access_skip_list &lhs, random_access_skip_list &rhs) { lhs.swap(rhs); }
 
+    /// Moves all the elements of other, each of which must order after every
+    /// element of this list, onto the end of this list in O(log N), leaving
+    /// other empty. Only the spans of the links that cross the join change.
+    /// Both lists must have equal allocators.
+    ///
+    /// @see skip_list::join
+    void join(random_access_skip_list &other) { impl.join(other.impl); }
+
+    typedef std::pair<const_iterator,const_iterator> const_range;
+
+    /// As skip_list::partition, but the ranges are exactly as even as they
+    /// can be: range n holds the elements indexed from n*size()/k up to
+    /// (n+1)*size()/k. Each cut is found through the spans, in O(log N).
+    ///
+    /// @see parallel_for_each
+    template <typename OutputIterator>
+    void partition(size_type k, OutputIterator out) const;
+
     //======================================================================
     // lookup
 
@@ -181,6 +296,47 @@ public:
     iterator       find(const value_type &value);
     const_iterator find(const value_type &value) const;
 
+    /// The number of elements that order before value. This is the index of
+    /// the element equivalent to value, if there is one, or the index value
+    /// would be inserted at. Found in one O(log N) search, by summing the
+    /// spans of the links it follows.
+    size_type count_less(const value_type &value) const { return impl.count_less(value); }
+
+    /// The index value has, or would have if inserted; the same as
+    /// count_less(value).
+    size_type rank(const value_type &value) const { return impl.count_less(value); }
+
+    /// The number of elements in the range [lo,hi): those ordering neither
+    /// before lo nor after or equivalent to hi. The searches for lo and hi
+    /// share their path down the list until it splits, so this costs little
+    /// more than one search.
+    size_type count_between(const value_type &lo, const value_type &hi) const
+        { return impl.count_between(lo, hi); }
+
+    //======================================================================
+    // weights
+
+    /// The total weight of the first index elements, found in one O(log N)
+    /// search by combining the weights of the links it follows.
+    weight_type prefix_weight(size_type index) const { return impl.prefix_weight(index); }
+
+    /// The aggregate weight of the elements in the range [lo,hi), those
+    /// that count_between() counts. After a search for lo, it climbs
+    /// towards hi by the tallest links that do not pass it, so combines
+    /// O(log N) weights however long the range is, and never needs to undo
+    /// a combine (so it works for max and min as well as sums).
+    weight_type aggregate(const value_type &lo, const value_type &hi) const;
+
+    /// The aggregate weight of the elements in [first,last), in O(log N).
+    weight_type aggregate(const_iterator first, const_iterator last) const;
+
+    /// The first element at which the running total of weights (including
+    /// its own) reaches total, or end() if the whole list weighs less. For
+    /// an order book weighted by volume, this is the price level that fills
+    /// an order of that size.
+    iterator       lower_bound_by_weight(const weight_type &total);
+    const_iterator lower_bound_by_weight(const weight_type &total) const;
+
     //======================================================================
     // random access
 
@@ -206,49 +362,155 @@ protected:
 
 } // namespace goodliffe
 
+//==============================================================================
+#pragma mark - multi_random_access_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// The multi_random_access_skip_list is a random_access_skip_list variant
+/// that allows non-unique elements to be held. (It is to
+/// random_access_skip_list as multi_skip_list is to skip_list.)
+///
+/// The spans count equivalent elements like any others, so count,
+/// lower_bound, upper_bound and equal_range each take O(log N) searches,
+/// no matter how many equivalent elements there are; multi_skip_list has
+/// to walk along them. A new element goes in front of any equivalent ones.
+///
+/// @see random_access_skip_list
+/// @see multi_skip_list
+template <typename T,
+          typename Compare        = std::less<T>,
+          typename Allocator      = std::allocator<T>,
+          typename LevelGenerator = detail::skip_list_level_generator<32>,
+          typename SpanType       = unsigned,
+          typename Weight         = detail::unit_weight>
+class multi_random_access_skip_list :
+    public random_access_skip_list<T,Compare,Allocator,LevelGenerator,true,SpanType,Weight>
+{
+protected:
+    typedef random_access_skip_list<T,Compare,Allocator,LevelGenerator,true,SpanType,Weight> parent_type;
+    using typename parent_type::node_type;
+    using typename parent_type::impl_type;
+    using parent_type::impl;
+
+public:
+
+    //======================================================================
+    // types
+
+    using typename parent_type::value_type;
+    using typename parent_type::allocator_type;
+    using typename parent_type::size_type;
+    using typename parent_type::difference_type;
+    using typename parent_type::reference;
+    using typename parent_type::const_reference;
+    using typename parent_type::pointer;
+    using typename parent_type::const_pointer;
+    using typename parent_type::compare;
+
+    typedef typename detail::rasl_iterator<impl_type>   iterator;
+    typedef typename iterator::const_iterator           const_iterator;
+    typedef std::reverse_iterator<iterator>             reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+#ifdef SKIP_LIST_CPP11
+    using typename parent_type::node_handle;
+#endif
+
+    //======================================================================
+    // lifetime management
+
+    explicit multi_random_access_skip_list(const Allocator &alloc = Allocator())
+        : parent_type(alloc) {}
+    explicit multi_random_access_skip_list(const Compare &less, const Allocator &alloc = Allocator())
+        : parent_type(less, alloc) {}
+    template <class InputIterator>
+    multi_random_access_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
+        : parent_type(first, last, alloc) {}
+    multi_random_access_skip_list(const multi_random_access_skip_list &other)
+        : parent_type(other) {}
+    multi_random_access_skip_list(const multi_random_access_skip_list &other, const Allocator &alloc)
+        : parent_type(other, alloc) {}
+
+    multi_random_access_skip_list &operator=(const multi_random_access_skip_list &other)
+        { parent_type::operator=(other); return *this; }
+
+    //======================================================================
+    // Overridden operations
+
+    /// Erases every element equivalent to value, in one go, and returns how
+    /// many there were.
+    size_type erase(const value_type &value);
+    using parent_type::erase;
+
+#ifdef SKIP_LIST_CPP11
+    /// Relinks an extracted element, keeping its existing allocation.
+    /// This always succeeds in a multi_random_access_skip_list.
+    iterator insert(node_handle &&handle);
+    using parent_type::insert;
+#endif
+
+    //======================================================================
+    // Additional "multi" operations
+
+    size_type count(const value_type &value) const;
+
+    iterator lower_bound(const value_type &value);
+    const_iterator lower_bound(const value_type &value) const;
+
+    iterator upper_bound(const value_type &value);
+    const_iterator upper_bound(const value_type &value) const;
+
+    std::pair<iterator,iterator> equal_range(const value_type &value);
+    std::pair<const_iterator,const_iterator> equal_range(const value_type &value) const;
+};
+
+} // namespace goodliffe
+
 //==============================================================================
 #pragma mark - non-members
 
 namespace goodliffe {
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator==(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator==(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator!=(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator!=(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return !operator==(lhs, rhs);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator<(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator<(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator<=(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator<=(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return !(rhs < lhs);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator>(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator>(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return rhs < lhs;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool operator>=(const random_access_skip_list<T,C,A,LG> &lhs, const random_access_skip_list<T,C,A,LG> &rhs)
+bool operator>=(const random_access_skip_list<T,C,A,LG,D,S,W> &lhs, const random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
 {
     return !(lhs < rhs);
 }
@@ -257,8 +519,8 @@ bool operator>=(const random_access_skip_list<T,C,A,LG> &lhs, const random_acces
 
 namespace std
 {
-    template <class T, class C, class A, class LG>
-    void swap(goodliffe::random_access_skip_list<T,C,A,LG> &lhs, goodliffe::random_access_skip_list<T,C,A,LG> &rhs)
+    template <class T, class C, class A, class LG, bool D, class S, class W>
+    void swap(goodliffe::random_access_skip_list<T,C,A,LG,D,S,W> &lhs, goodliffe::random_access_skip_list<T,C,A,LG,D,S,W> &rhs)
     {
         lhs.swap(rhs);
     }
@@ -276,8 +538,8 @@ class rasl_iterator
     : public std::iterator<std::random_access_iterator_tag,
                            typename RASL_IMPL::value_type,
                            typename RASL_IMPL::difference_type,
-                           typename RASL_IMPL::const_pointer,
-                           typename RASL_IMPL::const_reference>
+                           typename RASL_IMPL::element_pointer,
+                           typename RASL_IMPL::element_reference>
 {
 public:
     typedef RASL_IMPL                               impl_type;
@@ -285,45 +547,50 @@ public:
     typedef typename impl_type::node_type           node_type;
     typedef rasl_iterator<impl_type>                self_type;
 
+    typedef typename impl_type::size_type           size_type;
     typedef typename impl_type::difference_type     difference_type;
     typedef typename impl_type::const_reference     const_reference;
     typedef typename impl_type::const_pointer       const_pointer;
+    typedef typename impl_type::element_reference   reference;
+    typedef typename impl_type::element_pointer     pointer;
 
     rasl_iterator()
-        : impl(0), node(0) {}
+        : impl(0), node(0), index(0), revision(0) {}
     rasl_iterator(impl_type *impl_, node_type *node_)
-        : impl(impl_), node(node_) {}
+        : impl(impl_), node(node_), index(0), revision(0) {}
+    rasl_iterator(impl_type *impl_, node_type *node_, size_type index_)
+        : impl(impl_), node(node_), index(index_), revision(impl_->revision()) {}
     rasl_iterator(const rasl_iterator &other)
-        : impl(other.impl), node(other.node) {}
+        : impl(other.impl), node(other.node), index(other.index), revision(other.revision) {}
 
     self_type &operator++()
-        { node = node->next[0]; return *this; }
+        { node = node->next[0]; ++index; return *this; }
     self_type operator++(int) // postincrement
-        { self_type old(*this); node = node->next[0]; return old; }
+        { self_type old(*this); operator++(); return old; }
 
     self_type &operator--()
-        { node = node->prev; return *this; }
+        { node = node->prev; --index; return *this; }
     self_type operator--(int) // postdecrement
-        { self_type old(*this); node = node->prev; return old; }
+        { self_type old(*this); operator--(); return old; }
     
     self_type &operator+=(difference_type n)
-        { node = impl->at(impl->index_of(node)+n); return *this; }
+        { node = impl->advance(node, get_index(), n); index += n; return *this; }
     self_type &operator-=(difference_type n)
-        { node = impl->at(impl->index_of(node)-n); return *this; }
+        { return operator+=(-n); }
 
     rasl_iterator operator+(difference_type rhs) const
         { return rasl_iterator(*this) += rhs; }
     rasl_iterator operator-(difference_type rhs) const
         { return rasl_iterator(*this) -= rhs; }
-    const_reference operator[](int index) const
+    reference operator[](int index) const
         { return *operator+(index); }
     bool operator<(const self_type &rhs) const
-        { return impl->index_of(node) < impl->index_of(rhs.node); }
+        { return get_index() < rhs.get_index(); }
     difference_type operator-(const self_type &rhs) const
-        { return impl->index_of(node) - impl->index_of(rhs.node); }
+        { return difference_type(get_index()) - difference_type(rhs.get_index()); }
 
-    const_reference operator*()  { return node->value; }
-    const_pointer   operator->() { return node->value; }
+    reference operator*()  { return node->value; }
+    pointer   operator->() { return &node->value; }
     
     bool operator==(const self_type &rhs) const
         { return impl == rhs.impl && node == rhs.node; }
@@ -331,16 +598,32 @@ public:
         { return !operator==(rhs); }
     
     bool operator==(const const_iterator &rhs) const
-        { return impl == rhs.impl && node == rhs.node; }
+        { return impl == rhs.get_impl() && node == rhs.get_node(); }
     bool operator!=(const const_iterator &rhs) const
         { return !operator==(rhs); }
 
     const impl_type *get_impl() const { return impl; } ///< @internal
     const node_type *get_node() const { return node; } ///< @internal
 
+    /// The position of node, remembered until the list next changes
+    /// @internal
+    size_type get_index() const
+    {
+        if (revision != impl->revision())
+        {
+            index    = impl->index_of(node);
+            revision = impl->revision();
+        }
+        return index;
+    }
+
 private:
-    impl_type *impl;
-    node_type *node;
+    template <typename I> friend class rasl_const_iterator;
+
+    impl_type         *impl;
+    node_type         *node;
+    mutable size_type  index;
+    mutable size_type  revision; ///< of impl when index was right; 0 for never
 };
 
 template <typename I>
@@ -362,33 +645,36 @@ public:
     typedef const typename impl_type::node_type node_type;
     typedef rasl_const_iterator<RASL_IMPL>      self_type;
 
+    typedef typename impl_type::size_type           size_type;
     typedef typename impl_type::difference_type     difference_type;
     typedef typename impl_type::const_reference     const_reference;
     typedef typename impl_type::const_pointer       const_pointer;
 
     rasl_const_iterator()
-        : impl(0), node(0) {}
+        : impl(0), node(0), index(0), revision(0) {}
     rasl_const_iterator(const normal_iterator &i)
-        : impl(i.get_impl()), node(i.get_node()) {}
+        : impl(i.impl), node(i.node), index(i.index), revision(i.revision) {}
     rasl_const_iterator(const impl_type *impl_, node_type *node_)
-        : impl(impl_), node(node_) {}
+        : impl(impl_), node(node_), index(0), revision(0) {}
+    rasl_const_iterator(const impl_type *impl_, node_type *node_, size_type index_)
+        : impl(impl_), node(node_), index(index_), revision(impl_->revision()) {}
     rasl_const_iterator(const rasl_const_iterator &other)
-        : impl(other.impl), node(other.node) {}
+        : impl(other.impl), node(other.node), index(other.index), revision(other.revision) {}
 
     self_type &operator++()
-        { node = node->next[0]; return *this; }
+        { node = node->next[0]; ++index; return *this; }
     self_type operator++(int) // postincrement
-        { self_type old(*this); node = node->next[0]; return old; }
+        { self_type old(*this); operator++(); return old; }
 
     self_type &operator--()
-        { node = node->prev; return *this; }
+        { node = node->prev; --index; return *this; }
     self_type operator--(int) // postdecrement
-        { self_type old(*this); node = node->prev; return old; }
+        { self_type old(*this); operator--(); return old; }
 
     self_type &operator+=(difference_type n)
-        { node = impl->at(impl->index_of(node)+n); return *this; }
+        { node = impl->advance(node, get_index(), n); index += n; return *this; }
     self_type &operator-=(difference_type n)
-        { node = impl->at(impl->index_of(node)-n); return *this; }
+        { return operator+=(-n); }
 
     rasl_const_iterator operator+(difference_type rhs) const
         { return rasl_const_iterator(*this) += rhs; }
@@ -397,12 +683,12 @@ public:
     const_reference operator[](int index) const
         { return *operator+(index); }
     bool operator<(const self_type &rhs) const
-        { return impl->index_of(node) < impl->index_of(rhs.node); }
+        { return get_index() < rhs.get_index(); }
     difference_type operator-(const self_type &rhs) const
-        { return impl->index_of(node) - impl->index_of(rhs.node); }
+        { return difference_type(get_index()) - difference_type(rhs.get_index()); }
 
     const_reference operator*()  { return node->value; }
-    const_pointer   operator->() { return node->value; }
+    const_pointer   operator->() { return &node->value; }
 
     bool operator==(const self_type &other) const
         { return impl == other.impl && node == other.node; }
@@ -410,16 +696,30 @@ public:
         { return !operator==(other); }
 
     bool operator==(const normal_iterator &other) const
-        { return impl == other.impl && node == other.node; }
+        { return impl == other.get_impl() && node == other.get_node(); }
     bool operator!=(const normal_iterator &other) const
         { return !operator==(other); }
 
     const impl_type *get_impl() const { return impl; } ///< @internal
     const node_type *get_node() const { return node; } ///< @internal
 
+    /// The position of node, remembered until the list next changes
+    /// @internal
+    size_type get_index() const
+    {
+        if (revision != impl->revision())
+        {
+            index    = impl->index_of(node);
+            revision = impl->revision();
+        }
+        return index;
+    }
+
 private:
-    impl_type *impl;
-    node_type *node;
+    impl_type         *impl;
+    node_type         *node;
+    mutable size_type  index;
+    mutable size_type  revision; ///< of impl when index was right; 0 for never
 };
 
 template <typename I>
@@ -436,36 +736,46 @@ rasl_const_iterator<I> operator+(int lhs, rasl_const_iterator<I> rhs)
 
 namespace goodliffe {
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-random_access_skip_list<T,C,A,LG>::random_access_skip_list(const allocator_type &alloc_)
+random_access_skip_list<T,C,A,LG,D,S,W>::random_access_skip_list(const allocator_type &alloc_)
 :   impl(alloc_)
 {
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+random_access_skip_list<T,C,A,LG,D,S,W>::random_access_skip_list(const compare &less_, const allocator_type &alloc_)
+:   impl(alloc_)
+{
+    impl.less = less_;
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
 template <class InputIterator>
 inline
-random_access_skip_list<T,C,A,LG>::random_access_skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
+random_access_skip_list<T,C,A,LG,D,S,W>::random_access_skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
 :   impl(alloc_)
 {
     assign(first, last);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-random_access_skip_list<T,C,A,LG>::random_access_skip_list(const random_access_skip_list &other)
+random_access_skip_list<T,C,A,LG,D,S,W>::random_access_skip_list(const random_access_skip_list &other)
 :   impl(other.get_allocator())
 {    
-    assign(other.begin(), other.end());
+    impl.less = other.impl.less;
+    assign_sorted(other.begin(), other.end());
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-random_access_skip_list<T,C,A,LG>::random_access_skip_list(const random_access_skip_list &other, const allocator_type &alloc_)
+random_access_skip_list<T,C,A,LG,D,S,W>::random_access_skip_list(const random_access_skip_list &other, const allocator_type &alloc_)
 :   impl(alloc_)
 {
-    assign(other.begin(), other.end());
+    impl.less = other.impl.less;
+    assign_sorted(other.begin(), other.end());
 }
 
 // C++11
@@ -476,60 +786,68 @@ random_access_skip_list<T,C,A,LG>::random_access_skip_list(const random_access_s
 //==============================================================================
 #pragma mark assignment
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-random_access_skip_list<T,C,A,LG> &
-random_access_skip_list<T,C,A,LG>::operator=(const random_access_skip_list<T,C,A,LG> &other)
+random_access_skip_list<T,C,A,LG,D,S,W> &
+random_access_skip_list<T,C,A,LG,D,S,W>::operator=(const random_access_skip_list<T,C,A,LG,D,S,W> &other)
 {
-    assign(other.begin(), other.end());
+    if (&other != this) assign_sorted(other.begin(), other.end());
     return *this;
 }
 
 //C++11 skip_list& operator=(skip_list&& other);
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 template <typename InputIterator>
 inline
-void random_access_skip_list<T,C,A,LG>::assign(InputIterator first, InputIterator last)
+void random_access_skip_list<T,C,A,LG,D,S,W>::assign(InputIterator first, InputIterator last)
 {
     clear();
     while (first != last) insert(*first++);
 }
 
+template <class T, class C, class A, class LG, bool D, class S, class W>
+template <typename InputIterator>
+inline
+void random_access_skip_list<T,C,A,LG,D,S,W>::assign_sorted(InputIterator first, InputIterator last)
+{
+    impl.assign_sorted(first, last);
+}
+
 //==============================================================================
 #pragma mark element access
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::reference
-random_access_skip_list<T,C,A,LG>::front()
+typename random_access_skip_list<T,C,A,LG,D,S,W>::reference
+random_access_skip_list<T,C,A,LG,D,S,W>::front()
 {
     assert_that(!empty());
     return impl.front()->value;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::const_reference
-random_access_skip_list<T,C,A,LG>::front() const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_reference
+random_access_skip_list<T,C,A,LG,D,S,W>::front() const
 {
     assert_that(!empty());
     return impl.front()->value;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::reference
-random_access_skip_list<T,C,A,LG>::back()
+typename random_access_skip_list<T,C,A,LG,D,S,W>::reference
+random_access_skip_list<T,C,A,LG,D,S,W>::back()
 {
     assert_that(!empty());
     return impl.one_past_end()->prev->value;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::const_reference
-random_access_skip_list<T,C,A,LG>::back() const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_reference
+random_access_skip_list<T,C,A,LG,D,S,W>::back() const
 {
     assert_that(!empty());
     return impl.one_past_end()->prev->value;
@@ -538,26 +856,26 @@ random_access_skip_list<T,C,A,LG>::back() const
 //==============================================================================
 #pragma mark modifiers
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-void random_access_skip_list<T,C,A,LG>::clear()
+void random_access_skip_list<T,C,A,LG,D,S,W>::clear()
 {
     impl.remove_all();
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::insert_by_value_result
-random_access_skip_list<T,C,A,LG>::insert(const value_type &value)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::insert_by_value_result
+random_access_skip_list<T,C,A,LG,D,S,W>::insert(const value_type &value)
 {
     node_type *node = impl.insert(value);
     return std::make_pair(iterator(&impl, node), impl.is_valid(node));
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::iterator
-random_access_skip_list<T,C,A,LG>::insert(const_iterator hint, const value_type &value)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::insert(const_iterator hint, const value_type &value)
 {
     assert_that(hint.get_impl() == &impl);
     
@@ -571,11 +889,11 @@ random_access_skip_list<T,C,A,LG>::insert(const_iterator hint, const value_type
 
 //C++11iterator insert const_iterator pos, value_type &&value);
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 template <class InputIterator>
 inline
 void
-random_access_skip_list<T,C,A,LG>::insert(InputIterator first, InputIterator last)
+random_access_skip_list<T,C,A,LG,D,S,W>::insert(InputIterator first, InputIterator last)
 {
     iterator last_inserted = end();
     while (first != last)
@@ -587,10 +905,10 @@ random_access_skip_list<T,C,A,LG>::insert(InputIterator first, InputIterator las
 //C++11iterator insert(std::initializer_list<value_type> ilist);
 // C++11 emplace
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::size_type
-random_access_skip_list<T,C,A,LG>::erase(const value_type &value)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::size_type
+random_access_skip_list<T,C,A,LG,D,S,W>::erase(const value_type &value)
 {
     node_type *node = impl.find(value);
     if (impl.is_valid(node) && detail::equivalent(node->value, value, impl.less))
@@ -604,10 +922,10 @@ random_access_skip_list<T,C,A,LG>::erase(const value_type &value)
     }
 }    
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::iterator
-random_access_skip_list<T,C,A,LG>::erase(const_iterator position)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::erase(const_iterator position)
 {
     assert_that(position.get_impl() == &impl);
     assert_that(impl.is_valid(position.get_node()));
@@ -617,10 +935,10 @@ random_access_skip_list<T,C,A,LG>::erase(const_iterator position)
     return iterator(&impl, next);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::iterator
-random_access_skip_list<T,C,A,LG>::erase(const_iterator first, const_iterator last)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::erase(const_iterator first, const_iterator last)
 {
     assert_that(first.get_impl() == &impl);
     assert_that(last.get_impl() == &impl);
@@ -635,22 +953,88 @@ random_access_skip_list<T,C,A,LG>::erase(const_iterator first, const_iterator la
     return iterator(&impl, const_cast<node_type*>(last.get_node()));
 }
 
+#ifdef SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::node_handle
+random_access_skip_list<T,C,A,LG,D,S,W>::extract(const_iterator position)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_node()));
+    node_type *node = const_cast<node_type*>(position.get_node());
+    impl.unlink(node);
+    return node_handle(node, impl.get_allocator());
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::node_handle
+random_access_skip_list<T,C,A,LG,D,S,W>::extract(const value_type &value)
+{
+    const_iterator i = find(value);
+    return i != end() ? extract(i) : node_handle();
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::insert_return_type
+random_access_skip_list<T,C,A,LG,D,S,W>::insert(node_handle &&handle)
+{
+    insert_return_type result = { end(), false, node_handle() };
+    if (handle.empty()) return result;
+
+    assert_that(handle.get_allocator() == get_allocator());
+    node_type *node = impl.link(handle.get_node());
+    result.position = iterator(&impl, node);
+    result.inserted = node == handle.get_node();
+    if (result.inserted)
+        handle.release();
+    else
+        result.node = std::move(handle);
+    return result;
+}
+
+#endif // SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+template <typename Modifier>
+inline
+bool random_access_skip_list<T,C,A,LG,D,S,W>::modify(const_iterator position, Modifier modifier)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_node()));
+    node_type *node = const_cast<node_type*>(position.get_node());
+
+    try
+    {
+        modifier(node->value);
+    }
+    catch (...)
+    {
+        impl.remove_unordered(node);
+        throw;
+    }
+
+    return impl.reposition(node);
+}
+
 //==============================================================================
 #pragma mark lookup
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::size_type
-random_access_skip_list<T,C,A,LG>::count(const value_type &value) const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::size_type
+random_access_skip_list<T,C,A,LG,D,S,W>::count(const value_type &value) const
 {
     const node_type *node = impl.find(value);
     return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::iterator
-random_access_skip_list<T,C,A,LG>::find(const value_type &value)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::find(const value_type &value)
 {
     node_type *node = impl.find(value);
     return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less)
@@ -658,10 +1042,10 @@ random_access_skip_list<T,C,A,LG>::find(const value_type &value)
         : end();
 }
   
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::const_iterator
-random_access_skip_list<T,C,A,LG>::find(const value_type &value) const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::find(const value_type &value) const
 {
     const node_type *node = impl.find(value);
     return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less)
@@ -669,55 +1053,231 @@ random_access_skip_list<T,C,A,LG>::find(const value_type &value) const
         : end();
 }
     
+//==============================================================================
+#pragma mark weights
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::weight_type
+random_access_skip_list<T,C,A,LG,D,S,W>::aggregate(const value_type &lo, const value_type &hi) const
+{
+    size_type        first;
+    const node_type *node  = impl.lower_bound(lo, first);
+    const size_type  count = impl.less(lo, hi) ? impl.count_less(hi) - first : 0;
+    return impl.aggregate(node, count);
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::weight_type
+random_access_skip_list<T,C,A,LG,D,S,W>::aggregate(const_iterator first, const_iterator last) const
+{
+    assert_that(first.get_impl() == &impl);
+    assert_that(last.get_impl() == &impl);
+    assert_that(!(last < first));
+    return impl.aggregate(first.get_node(), size_type(last - first));
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::lower_bound_by_weight(const weight_type &total)
+{
+    size_type  index;
+    node_type *node = impl.lower_bound_by_weight(total, index);
+    return iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::lower_bound_by_weight(const weight_type &total) const
+{
+    size_type        index;
+    const node_type *node = impl.lower_bound_by_weight(total, index);
+    return const_iterator(&impl, node, index);
+}
+
 //==============================================================================
 #pragma mark random access
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::const_reference
-random_access_skip_list<T,C,A,LG>::operator[](unsigned index) const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_reference
+random_access_skip_list<T,C,A,LG,D,S,W>::operator[](unsigned index) const
 {
     const node_type *node = impl.at(index);
     assert_that(impl.is_valid(node));
     return node->value;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
 void
-random_access_skip_list<T,C,A,LG>::erase_at(size_type index)
+random_access_skip_list<T,C,A,LG,D,S,W>::erase_at(size_type index)
 {
     node_type *node = impl.at(index);
     assert_that(impl.is_valid(node));
     impl.remove(node);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::iterator
-random_access_skip_list<T,C,A,LG>::iterator_at(unsigned index)
+typename random_access_skip_list<T,C,A,LG,D,S,W>::iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::iterator_at(unsigned index)
 {
     node_type *node = impl.at(index);
-    return iterator(&impl, node);
+    return iterator(&impl, node, index);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::const_iterator
-random_access_skip_list<T,C,A,LG>::iterator_at(unsigned index) const
+typename random_access_skip_list<T,C,A,LG,D,S,W>::const_iterator
+random_access_skip_list<T,C,A,LG,D,S,W>::iterator_at(unsigned index) const
 {
     const node_type *node = impl.at(index);
-    return const_iterator(&impl, node);
+    return const_iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename random_access_skip_list<T,C,A,LG,D,S,W>::size_type
+random_access_skip_list<T,C,A,LG,D,S,W>::index_of(const const_iterator &i) const
+{
+    return i.get_index();
+}
+
+//==============================================================================
+#pragma mark other operations
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+template <typename OutputIterator>
+inline
+void random_access_skip_list<T,C,A,LG,D,S,W>::partition(size_type k, OutputIterator out) const
+{
+    const size_type size  = impl.size();
+    const_iterator  first = begin();
+    for (size_type n = 0; n < k; ++n)
+    {
+        const size_type index = (n+1)*size/k;
+        const_iterator  last  = index < size ? iterator_at(unsigned(index)) : end();
+        *out++ = const_range(first, last);
+        first = last;
+    }
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - multi_random_access_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::size_type
+multi_random_access_skip_list<T,C,A,LG,S,W>::count(const value_type &value) const
+{
+    size_type first, last;
+    impl.lower_bound(value, first);
+    impl.upper_bound(value, last);
+    return last - first;
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::iterator
+multi_random_access_skip_list<T,C,A,LG,S,W>::lower_bound(const value_type &value)
+{
+    size_type  index;
+    node_type *node = impl.lower_bound(value, index);
+    return iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::const_iterator
+multi_random_access_skip_list<T,C,A,LG,S,W>::lower_bound(const value_type &value) const
+{
+    size_type  index;
+    node_type *node = impl.lower_bound(value, index);
+    return const_iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::iterator
+multi_random_access_skip_list<T,C,A,LG,S,W>::upper_bound(const value_type &value)
+{
+    size_type  index;
+    node_type *node = impl.upper_bound(value, index);
+    return iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::const_iterator
+multi_random_access_skip_list<T,C,A,LG,S,W>::upper_bound(const value_type &value) const
+{
+    size_type  index;
+    node_type *node = impl.upper_bound(value, index);
+    return const_iterator(&impl, node, index);
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+std::pair
+    <
+        typename multi_random_access_skip_list<T,C,A,LG,S,W>::iterator,
+        typename multi_random_access_skip_list<T,C,A,LG,S,W>::iterator
+    >
+multi_random_access_skip_list<T,C,A,LG,S,W>::equal_range(const value_type &value)
+{
+    return std::make_pair(lower_bound(value), upper_bound(value));
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+std::pair
+    <
+        typename multi_random_access_skip_list<T,C,A,LG,S,W>::const_iterator,
+        typename multi_random_access_skip_list<T,C,A,LG,S,W>::const_iterator
+    >
+multi_random_access_skip_list<T,C,A,LG,S,W>::equal_range(const value_type &value) const
+{
+    return std::make_pair(lower_bound(value), upper_bound(value));
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::size_type
+multi_random_access_skip_list<T,C,A,LG,S,W>::erase(const value_type &value)
+{
+    size_type  first_index, last_index;
+    node_type *first = impl.lower_bound(value, first_index);
+    node_type *last  = impl.upper_bound(value, last_index);
+    if (first != last) impl.remove_between(first, last->prev);
+    return last_index - first_index;
 }
 
-template <class T, class C, class A, class LG>
+#ifdef SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG, class S, class W>
 inline
-typename random_access_skip_list<T,C,A,LG>::size_type
-random_access_skip_list<T,C,A,LG>::index_of(const const_iterator &i) const
+typename multi_random_access_skip_list<T,C,A,LG,S,W>::iterator
+multi_random_access_skip_list<T,C,A,LG,S,W>::insert(node_handle &&handle)
 {
-    return impl.index_of(i.get_node());
+    if (handle.empty()) return this->end();
+
+    assert_that(handle.get_allocator() == this->get_allocator());
+    node_type *node = impl.link(handle.get_node());
+    handle.release();
+    return iterator(&impl, node);
 }
 
+#endif // SKIP_LIST_CPP11
+
 } // namespace goodliffe
 
 //==============================================================================
@@ -727,8 +1287,28 @@ random_access_skip_list<T,C,A,LG>::index_of(const const_iterator &i) const
 namespace goodliffe {
 namespace detail {
 
-template <typename T, typename SPAN>
-struct rasl_node
+/// The default Weight of a random_access_skip_list: every element weighs
+/// one, so each link's weight is its span, and nothing more is stored.
+struct unit_weight : additive_weight<std::size_t>
+{
+    template <typename T>
+    result_type operator()(const T &) const { return 1; }
+};
+
+/// The weights a node keeps, when its list has a Weight of its own:
+/// weight[l] is the aggregate weight of the nodes its level l link passes
+/// to, the same nodes that span[l] counts.
+template <typename WeightType>
+struct rasl_node_weights
+{
+    WeightType *weight; ///< effectively weight_type weight[level+1];
+};
+
+/// A node in a list of unit_weight keeps no weights.
+struct rasl_no_weights {};
+
+template <typename T, typename SPAN, typename WEIGHTS = rasl_no_weights>
+struct rasl_node : WEIGHTS
 {
     typedef SPAN size_type;
     
@@ -739,37 +1319,183 @@ struct rasl_node
     unsigned    level;
     rasl_node  *prev;
     rasl_node **next; ///< effectively node_type *next[level+1];
-    size_type  *span; ///< effectively unsigned span[level+1];
+    size_type  *span; ///< effectively size_type span[level+1];
 };
 
-/// Internal implementation of skip_list data structure and methods for
-/// modifying it.
-///
-/// Not for "public" access.
+template <typename Allocator, typename WeightType>
+inline
+void deallocate_weights(Allocator &alloc, rasl_node_weights<WeightType> *weights, unsigned size)
+{
+    typedef typename Allocator::template rebind<WeightType>::other weight_allocator;
+    weight_allocator weight_alloc(alloc);
+    for (unsigned n = 0; n < size; ++n) weight_alloc.destroy(&weights->weight[n]);
+    weight_alloc.deallocate(weights->weight, size);
+}
+
+template <typename Allocator>
+inline
+void deallocate_weights(Allocator &, rasl_no_weights *, unsigned) {}
+
+/// Releases the memory for node, and its tower. Does not destroy the value.
+template <typename T, typename SPAN, typename WEIGHTS, typename Allocator>
+inline
+void deallocate_node(Allocator &alloc, rasl_node<T,SPAN,WEIGHTS> *node)
+{
+    typedef typename Allocator::template rebind<rasl_node<T,SPAN,WEIGHTS> >::other  node_allocator;
+    typedef typename Allocator::template rebind<rasl_node<T,SPAN,WEIGHTS>*>::other list_allocator;
+    typedef typename Allocator::template rebind<SPAN>::other                        span_allocator;
+
+    deallocate_weights(alloc, node, node->level+1);
+    span_allocator(alloc).deallocate(node->span, node->level+1);
+    list_allocator(alloc).deallocate(node->next, node->level+1);
+    node_allocator(alloc).deallocate(node, 1);
+}
+
+/// How a rasl_impl keeps the weights of its links up to date. A link's
+/// weight is worked out afresh from the links below it (or, on level 0,
+/// from the value it leads to) by reweigh(), which is all a change to the
+/// list needs to call, from level 0 up, on each link that passes over the
+/// change. Since nothing is ever subtracted, any monoid will do.
 ///
 /// @internal
-template <typename T, typename Compare, typename Allocator, typename LevelGenerator>
-class rasl_impl
+template <typename Weight>
+struct rasl_weighting
 {
-public:
-    
-    typedef T                                   value_type;
-    typedef typename Allocator::size_type       size_type;
-    typedef typename Allocator::difference_type difference_type;
-    typedef typename Allocator::const_reference const_reference;
-    typedef typename Allocator::const_pointer   const_pointer;
-    typedef Allocator                           allocator_type;
-    typedef Compare                             compare_type;
-    typedef LevelGenerator                      generator_type;    
-    typedef rasl_node<T, size_type>             node_type;
+    typedef typename Weight::result_type         weight_type;
+    typedef rasl_node_weights<weight_type>       node_weights;
 
-    static const unsigned num_levels = LevelGenerator::num_levels;
+    static const bool stored = true;
 
-    rasl_impl(const Allocator &alloc = Allocator());
-    ~rasl_impl();
+    template <typename Node, typename Allocator>
+    static void allocate(Allocator &alloc, Node *node, const Weight &weight)
+    {
+        typedef typename Allocator::template rebind<weight_type>::other weight_allocator;
+        weight_allocator weight_alloc(alloc);
+        node->weight = weight_alloc.allocate(node->level+1, (void*)0);
+        unsigned n = 0;
+        try
+        {
+            for (; n <= node->level; ++n) weight_alloc.construct(&node->weight[n], weight.identity());
+        }
+        catch (...)
+        {
+            while (n) weight_alloc.destroy(&node->weight[--n]);
+            weight_alloc.deallocate(node->weight, node->level+1);
+            throw;
+        }
+    }
+
+    template <typename Node>
+    static weight_type link_weight(const Node *node, unsigned l) { return node->weight[l]; }
+
+    /// What node's level l link should weigh, given the weights below it
+    template <typename Node>
+    static weight_type weigh(const Node *node, unsigned l, const Node *tail, const Weight &weight)
+    {
+        if (l == 0)
+            return node->next[0] != tail ? weight_type(weight(node->next[0]->value)) : weight.identity();
+
+        weight_type total = node->weight[l-1];
+        for (const Node *n = node->next[l-1]; n != node->next[l]; n = n->next[l-1])
+            total = weight.combine(total, n->weight[l-1]);
+        return total;
+    }
+
+    template <typename Node>
+    static void reweigh(Node *node, unsigned l, const Node *tail, const Weight &weight)
+        { node->weight[l] = weigh(node, l, tail, weight); }
+};
+
+template <>
+struct rasl_weighting<unit_weight>
+{
+    typedef unit_weight::result_type             weight_type;
+    typedef rasl_no_weights                      node_weights;
+
+    static const bool stored = false;
+
+    template <typename Node, typename Allocator>
+    static void allocate(Allocator &, Node *, const unit_weight &) {}
+
+    template <typename Node>
+    static weight_type link_weight(const Node *node, unsigned l) { return node->span[l]; }
+
+    template <typename Node>
+    static weight_type weigh(const Node *node, unsigned l, const Node *, const unit_weight &)
+        { return node->span[l]; }
+
+    template <typename Node>
+    static void reweigh(Node *, unsigned, const Node *, const unit_weight &) {}
+};
+
+/// The "order" of a sequence_skip_list: no element orders before another,
+/// so a list that allows duplicates keeps its elements wherever they were
+/// put.
+///
+/// @internal
+struct sequence_order
+{
+    template <typename T>
+    bool operator()(const T &, const T &) const { return false; }
+};
+
+/// What a rasl_iterator gives access to. A sorted list's values are const,
+/// so that none can be changed out of order; a sequence has no order to
+/// break.
+///
+/// @internal
+template <typename Compare, typename Allocator>
+struct rasl_element_access
+{
+    typedef typename Allocator::const_reference reference;
+    typedef typename Allocator::const_pointer   pointer;
+};
+
+template <typename Allocator>
+struct rasl_element_access<sequence_order, Allocator>
+{
+    typedef typename Allocator::reference       reference;
+    typedef typename Allocator::pointer         pointer;
+};
+
+/// Internal implementation of skip_list data structure and methods for
+/// modifying it.
+///
+/// Not for "public" access.
+///
+/// @internal
+template <typename T, typename Compare, typename Allocator, typename LevelGenerator,
+          bool AllowDuplicates, typename SpanType, typename Weight>
+class rasl_impl
+{
+public:
+    
+    typedef T                                   value_type;
+    typedef typename Allocator::size_type       size_type;
+    typedef typename Allocator::difference_type difference_type;
+    typedef typename Allocator::const_reference const_reference;
+    typedef typename Allocator::const_pointer   const_pointer;
+    typedef Allocator                           allocator_type;
+    typedef Compare                             compare_type;
+    typedef LevelGenerator                      generator_type;    
+    typedef SpanType                            span_type;
+    typedef Weight                              weight_function;
+    typedef rasl_weighting<Weight>              weighting;
+    typedef typename weighting::weight_type     weight_type;
+    typedef rasl_node<T, span_type, typename weighting::node_weights> node_type;
+
+    typedef typename rasl_element_access<Compare,Allocator>::reference element_reference;
+    typedef typename rasl_element_access<Compare,Allocator>::pointer   element_pointer;
+
+    static const unsigned num_levels = LevelGenerator::num_levels;
+
+    rasl_impl(const Allocator &alloc = Allocator());
+    ~rasl_impl();
 
     Allocator        get_allocator() const                 { return alloc; }
     size_type        size() const                          { return item_count; }
+    size_type        max_size() const;
+    void             check_room(size_type count) const;
     bool             is_valid(const node_type *node) const { return node && node != head && node != tail; }
     node_type       *front()                               { return head->next[0]; }
     const node_type *front() const                         { return head->next[0]; }
@@ -779,23 +1505,44 @@ public:
     node_type       *at(size_type index);
     const node_type *at(size_type index) const;
     node_type       *insert(const value_type &value, node_type *hint = 0);
+    node_type       *insert_at(size_type index, const value_type &value);
+    node_type       *link(node_type *node);
     void             remove(node_type *value);
+    void             unlink(node_type *node);
+    void             remove_unordered(node_type *node);
+    bool             reposition(node_type *node);
     void             remove_all();
     void             remove_between(node_type *first, node_type *last);
+    void             remove_front(size_type count);
     void             swap(rasl_impl &other);
+    void             join(rasl_impl &other);
     size_type        index_of(const node_type *node) const;
+    size_type        count_less(const value_type &value) const;
+    size_type        count_less_near_front(const value_type &value) const;
+    size_type        count_between(const value_type &lo, const value_type &hi) const;
+    node_type       *lower_bound(const value_type &value, size_type &index) const;
+    node_type       *upper_bound(const value_type &value, size_type &index) const;
+    node_type       *advance(const node_type *node, size_type index, difference_type n) const;
+    size_type        revision() const                      { return changes; }
+    weight_type      prefix_weight(size_type index) const;
+    node_type       *lower_bound_by_weight(const weight_type &total, size_type &index) const;
+    weight_type      aggregate(const node_type *first, size_type count) const;
+
+    template <typename InputIterator>
+    void             assign_sorted(InputIterator first, InputIterator last);
 
     template <typename STREAM>
     void        dump(STREAM &stream) const;
     bool        check() const;
     unsigned    new_level();
 
-    compare_type less;
+    compare_type    less;
+    weight_function weight;
 
 private:
     typedef typename Allocator::template rebind<node_type>::other    node_allocator;
     typedef typename Allocator::template rebind<node_type*>::other   list_allocator;
-    typedef typename Allocator::template rebind<size_type>::other    span_allocator;
+    typedef typename Allocator::template rebind<span_type>::other    span_allocator;
 
     rasl_impl(const rasl_impl &other);
     rasl_impl &operator=(const rasl_impl &other);
@@ -803,7 +1550,15 @@ private:
     size_type find_chain(const value_type &value, node_type **chain) const;
     size_type find_chain(const value_type &value, node_type **chain, size_type *indexes) const;
     size_type find_chain(const node_type *node, node_type **chain, size_type *indexes) const;
+    size_type find_chain_before(size_type position, node_type **chain, size_type *indexes) const;
     size_type find_end_chain(node_type **chain, size_type *indexes) const;
+    size_type position_of(const node_type *node) const;
+    size_type count_less(const value_type &value, const node_type *from, size_type index, unsigned level) const;
+    void      link_after(node_type *node, node_type **chain, size_type *indexes, size_type index);
+    void      unlink_after(node_type *node, node_type **chain);
+    void      finish_append(node_type **chain, size_type *indexes);
+    void      reweigh_chain(node_type **chain, unsigned top);
+    void      reweigh_all();
 
     allocator_type  alloc;
     generator_type  generator;
@@ -811,6 +1566,7 @@ private:
     node_type      *head;
     node_type      *tail;
     size_type       item_count;
+    size_type       changes; ///< bumped whenever a node is added or removed
         
     node_type *allocate(unsigned level)
     {
@@ -819,6 +1575,7 @@ private:
         node->span  = span_allocator(alloc).allocate(level+1, (void*)0);
         node->level = level;
         for (unsigned n = 0; n <= level; ++n) node->span[n] = 1;
+        weighting::allocate(alloc, node, weight);
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
         for (unsigned n = 0; n <= level; ++n) node->next[n] = 0;
         node->magic = MAGIC_GOOD;
@@ -834,21 +1591,23 @@ private:
         for (unsigned n = 0; n <= node->level; ++n) node->next[n] = 0;
         node->prev = 0;
 #endif
-        span_allocator(alloc).deallocate(node->span, node->level+1);
-        list_allocator(alloc).deallocate(node->next, node->level+1);
-        node_allocator(alloc).deallocate(node, 1);
+        deallocate_node(alloc, node);
     }
 };
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-rasl_impl<T,C,A,LG>::rasl_impl(const allocator_type &alloc_)
+rasl_impl<T,C,A,LG,D,S,W>::rasl_impl(const allocator_type &alloc_)
 :   alloc(alloc_),
     levels(0),
     head(allocate(num_levels)),
     tail(allocate(num_levels)),
-    item_count(0)
+    item_count(0),
+    changes(1)
 {
+    // Spans are kept for fixed towers
+    static_assert_that(!sl_deterministic<LG>::value);
+
     for (unsigned n = 0; n < num_levels; n++)
     {
         head->next[n] = tail;
@@ -859,19 +1618,41 @@ rasl_impl<T,C,A,LG>::rasl_impl(const allocator_type &alloc_)
     tail->prev = head;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-rasl_impl<T,C,A,LG>::~rasl_impl()
+rasl_impl<T,C,A,LG,D,S,W>::~rasl_impl()
 {
     remove_all();
     deallocate(head);
     deallocate(tail);
 }
 
-template <class T, class C, class A, class LG>
+/// The tail sits at position size()+1, and the head's spans must reach it,
+/// so that is as many as a span_type can count.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::max_size() const
+{
+    const size_type spans = size_type(std::numeric_limits<span_type>::max()) - 1;
+    const size_type nodes = alloc.max_size();
+    return spans < nodes ? spans : nodes;
+}
+
+/// Throws std::length_error unless count more elements fit, so that no
+/// span outgrows its span_type.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::check_room(size_type count) const
+{
+    if (count > max_size() - item_count)
+        throw std::length_error("random_access_skip_list would exceed max_size()");
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::node_type *
-rasl_impl<T,C,A,LG>::find(const value_type &value) const
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::find(const value_type &value) const
 {
     // I could have a const and non-const overload, but this cast is simpler
     node_type *search = const_cast<node_type*>(head);
@@ -886,10 +1667,10 @@ rasl_impl<T,C,A,LG>::find(const value_type &value) const
     return search;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::size_type
-rasl_impl<T,C,A,LG>::find_chain(const value_type &value, node_type **chain, size_type *indexes) const
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::find_chain(const value_type &value, node_type **chain, size_type *indexes) const
 {
     size_type index = 0;
     node_type *cur = head;
@@ -918,45 +1699,11 @@ rasl_impl<T,C,A,LG>::find_chain(const value_type &value, node_type **chain, size
     return index;
 }
 
-// TODO: fold these down
-template <class T, class C, class A, class LG>
-inline
-typename rasl_impl<T,C,A,LG>::size_type
-rasl_impl<T,C,A,LG>::find_chain(const node_type *node, node_type **chain, size_type *indexes) const
-{
-    assert_that(node && node != head);
-    if (node == tail) return find_end_chain(chain, indexes);
-    assert_that(is_valid(node));
-    size_type index = 0;
-    node_type *cur = head;
-    unsigned l = num_levels;
-    while (l)
-    {
-        --l;
-        impl_assert_that(l <= cur->level);
-        while (cur->next[l] != tail && less(cur->next[l]->value, node->value))
-        {
-            index += cur->span[l];
-            cur = cur->next[l];
-            impl_assert_that(l <= cur->level);
-        }
-        chain[l]   = cur;
-        indexes[l] = index;
-    }
-#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
-    for (unsigned l1 = 0; l1 < num_levels; ++l1)
-    {
-        assert_that(chain[l1]->level >= l1);
-    }
-#endif
-    return index;
-}
-
 // TODO: fold these down, up, sideways
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::size_type
-rasl_impl<T,C,A,LG>::find_end_chain(node_type **chain, size_type *indexes) const
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::find_end_chain(node_type **chain, size_type *indexes) const
 {
     size_type index = 0;
     node_type *cur = head;
@@ -984,18 +1731,20 @@ rasl_impl<T,C,A,LG>::find_end_chain(node_type **chain, size_type *indexes) const
 }
 
 // TODO: Hint is now ignored (has to be, for spans to work)
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::node_type*
-rasl_impl<T,C,A,LG>::insert(const value_type &value, node_type *hint)
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type*
+rasl_impl<T,C,A,LG,D,S,W>::insert(const value_type &value, node_type *hint)
 {
+    check_room(1);
     const unsigned level = new_level();
 
     node_type *chain[num_levels]   = {0};
     size_type  indexes[num_levels] = {0};
     size_type  index               = find_chain(value, chain, indexes);
 
-    // Do not allow repeated values in the list (we could in a "multi_skip_list")
+    // Do not allow repeated values in the list (unless a multi list)
+    if (!D)
     {
         node_type *next = chain[0]->next[0];
         if (next != tail && detail::equivalent(next->value, value, less))
@@ -1007,6 +1756,78 @@ rasl_impl<T,C,A,LG>::insert(const value_type &value, node_type *hint)
     impl_assert_that(new_node->level == level);
     alloc.construct(&new_node->value, value);
 
+    link_after(new_node, chain, indexes, index);
+
+    return new_node;
+}
+
+/// Inserts value so that it lands at index, whatever its order; only a
+/// sequence_skip_list, which has none, should do this.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type*
+rasl_impl<T,C,A,LG,D,S,W>::insert_at(size_type index, const value_type &value)
+{
+    assert_that(index <= item_count);
+    check_room(1);
+    const unsigned level = new_level();
+
+    node_type *chain[num_levels]   = {0};
+    size_type  indexes[num_levels] = {0};
+    find_chain_before(index+1, chain, indexes);
+
+    node_type *new_node = allocate(level);
+    try
+    {
+        alloc.construct(&new_node->value, value);
+    }
+    catch (...)
+    {
+        deallocate(new_node);
+        throw;
+    }
+
+    link_after(new_node, chain, indexes, index);
+
+    return new_node;
+}
+
+/// Links an existing (unlinked) node into the list. The node keeps its
+/// level; if it came from a taller list, this list grows to accommodate it.
+/// Returns the node, or (if the list does not allow duplicates and already
+/// holds an equivalent value) that equivalent node, leaving node unlinked.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type*
+rasl_impl<T,C,A,LG,D,S,W>::link(node_type *node)
+{
+    assert_that(node && node->level < num_levels);
+    check_room(1);
+    if (node->level >= levels) levels = node->level+1;
+
+    node_type *chain[num_levels]   = {0};
+    size_type  indexes[num_levels] = {0};
+    size_type  index               = find_chain(node->value, chain, indexes);
+
+    node_type *next = chain[0]->next[0];
+    if (!D && next != tail && detail::equivalent(next->value, node->value, less))
+        return next;
+
+    link_after(node, chain, indexes, index);
+
+    return node;
+}
+
+/// Splices node into the list after the predecessors in chain, which lie
+/// at the given indexes, fixing up all the spans.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void
+rasl_impl<T,C,A,LG,D,S,W>::link_after(node_type *new_node, node_type **chain, size_type *indexes, size_type index)
+{
+    const unsigned level = new_node->level;
+    assert_that(item_count < max_size());
+
     for (unsigned l = 0; l < num_levels; ++l)
     {
         if (l > level)
@@ -1025,20 +1846,43 @@ rasl_impl<T,C,A,LG>::insert(const value_type &value, node_type *hint)
     }
     new_node->next[0]->prev = new_node;
     new_node->prev          = chain[0];
+
+    if (weighting::stored)
+    {
+        for (unsigned l = 0; l <= level; ++l)
+        {
+            weighting::reweigh(new_node, l, tail, weight);
+            weighting::reweigh(chain[l], l, tail, weight);
+        }
+        for (unsigned l = level+1; l < levels; ++l)
+        {
+            weighting::reweigh(chain[l], l, tail, weight);
+        }
+    }
     
     ++item_count;
+    ++changes;
 
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
+}
 
-    return new_node;
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void
+rasl_impl<T,C,A,LG,D,S,W>::remove(node_type *node)
+{
+    unlink(node);
+    alloc.destroy(&node->value);
+    deallocate(node);
 }
 
-template <class T, class C, class A, class LG>
+/// Removes node from the list, without destroying it.
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
 void
-rasl_impl<T,C,A,LG>::remove(node_type *node)
+rasl_impl<T,C,A,LG,D,S,W>::unlink(node_type *node)
 {
     assert_that(is_valid(node));
     assert_that(node->next[0]);
@@ -1046,7 +1890,16 @@ rasl_impl<T,C,A,LG>::remove(node_type *node)
     node_type *chain[num_levels]   = {0};
     size_type  indexes[num_levels] = {0};
     find_chain(node, chain, indexes);
+    unlink_after(node, chain);
+}
 
+/// Removes node from the list, given its predecessor at every level,
+/// fixing up all the spans. The inverse of link_after.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void
+rasl_impl<T,C,A,LG,D,S,W>::unlink_after(node_type *node, node_type **chain)
+{
     node->next[0]->prev = node->prev;
     
     for (unsigned l = 0; l < num_levels; ++l)
@@ -1056,27 +1909,150 @@ rasl_impl<T,C,A,LG>::remove(node_type *node)
             chain[l]->span[l] = chain[l]->span[l] + node->span[l]-1;
             chain[l]->next[l] = node->next[l];
         }
-        else if (chain[l] == head || less(chain[l]->value, node->value))
+        else if (l > 0)
         {
-            if (l > 0)
-                --chain[l]->span[l];
+            // chain[l]'s link at this level passes over node
+            --chain[l]->span[l];
         }
     }
-
-    alloc.destroy(&node->value);
-    deallocate(node);
+    reweigh_chain(chain, levels);
 
     item_count--;
+    ++changes;
     
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG>
+/// The position of node in the list: the head is at 0, the first node at
+/// 1, and the tail at size()+1.
+///
+/// Found without comparing any values: following the tallest link out of
+/// each node, from node to the tail, climbs node's tower and those after
+/// it to the top level, and the spans of those links add up to node's
+/// distance from the tail. That is O(log N) links, as a search is.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::position_of(const node_type *node) const
+{
+    assert_that(node && node != head);
+
+    size_type to_tail = 0;
+    for (const node_type *cur = node; cur != tail; cur = cur->next[cur->level])
+    {
+        to_tail += cur->span[cur->level];
+    }
+    return item_count + 1 - to_tail;
+}
+
+/// Fills chain with node's predecessor on each level, and indexes with
+/// their positions, and returns the position of node's predecessor.
+///
+/// node is located by its position (from position_of) rather than its
+/// value, so no values are compared (which is cheaper for costly
+/// comparators), and node's value need not be correctly ordered any more.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::find_chain(const node_type *node, node_type **chain, size_type *indexes) const
+{
+    assert_that(node && node != head);
+    if (node == tail) return find_end_chain(chain, indexes);
+    assert_that(is_valid(node));
+
+    const size_type index = find_chain_before(position_of(node), chain, indexes);
+    assert_that(chain[0]->next[0] == node);
+    return index;
+}
+
+/// Fills chain with the predecessors, on each level, of whichever node
+/// lies at position (the tail, for size()+1), and indexes with their
+/// positions, and returns the position of the node before it.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::find_chain_before(size_type position, node_type **chain, size_type *indexes) const
+{
+    assert_that(position > 0 && position <= item_count+1);
+
+    size_type index = 0;
+    node_type *cur = head;
+    for (unsigned l = num_levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && index + cur->span[l] < position)
+        {
+            index += cur->span[l];
+            cur = cur->next[l];
+        }
+        chain[l]   = cur;
+        indexes[l] = index;
+    }
+    return index;
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
 void
-rasl_impl<T,C,A,LG>::remove_all()
+rasl_impl<T,C,A,LG,D,S,W>::remove_unordered(node_type *node)
+{
+    node_type *chain[num_levels]   = {0};
+    size_type  indexes[num_levels] = {0};
+    find_chain(node, chain, indexes);
+    unlink_after(node, chain);
+    alloc.destroy(&node->value);
+    deallocate(node);
+}
+
+/// Moves node, whose value has been changed in place, to the correct
+/// position for its new value. If node is still ordered with respect to its
+/// neighbours nothing is done; otherwise it is unlinked (find_chain goes by
+/// position, not value) and relinked (keeping its level).
+///
+/// Returns false if the new value is equivalent to an existing one (and the
+/// list does not allow duplicates); the node is then destroyed.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+bool
+rasl_impl<T,C,A,LG,D,S,W>::reposition(node_type *node)
+{
+    assert_that(is_valid(node));
+
+    const node_type *prev = node->prev;
+    const node_type *next = node->next[0];
+    node_type *chain[num_levels]   = {0};
+    size_type  indexes[num_levels] = {0};
+
+    if ((prev == head || (D ? !less(node->value, prev->value) : less(prev->value, node->value)))
+        && (next == tail || (D ? !less(next->value, node->value) : less(node->value, next->value))))
+    {
+        if (weighting::stored)
+        {
+            // node's weight may have changed, and the links over it with it
+            find_chain(node, chain, indexes);
+            reweigh_chain(chain, levels);
+        }
+        return true;
+    }
+
+    find_chain(node, chain, indexes);
+    unlink_after(node, chain);
+
+    if (link(node) != node)
+    {
+        alloc.destroy(&node->value);
+        deallocate(node);
+        return false;
+    }
+    return true;
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void
+rasl_impl<T,C,A,LG,D,S,W>::remove_all()
 {
     node_type *node = head->next[0];
     while (node != tail)
@@ -1091,19 +2067,21 @@ rasl_impl<T,C,A,LG>::remove_all()
     {
         head->next[l] = tail;
         head->span[l] = 1;
+        weighting::reweigh(head, l, tail, weight);
     }
     tail->prev = head;
     item_count = 0;
+    ++changes;
         
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
 void 
-rasl_impl<T,C,A,LG>::remove_between(node_type *first, node_type *last)
+rasl_impl<T,C,A,LG,D,S,W>::remove_between(node_type *first, node_type *last)
 {
     assert_that(is_valid(first));
     assert_that(is_valid(last));
@@ -1159,16 +2137,83 @@ rasl_impl<T,C,A,LG>::remove_between(node_type *first, node_type *last)
         item_count--;
         first = next;
     }
+    reweigh_chain(first_chain, levels);
+    ++changes;
         
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG>
+/// Removes the first count nodes. Only the head's links change: below the
+/// level that the search for the last of them climbs to, each now leads on
+/// from where that search left it; above, each loses count from its span.
+/// So this costs O(log count), plus the nodes removed, however long the
+/// list is.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void
+rasl_impl<T,C,A,LG,D,S,W>::remove_front(size_type count)
+{
+    assert_that(count <= item_count);
+    if (!count) return;
+
+    unsigned top = 0;
+    while (top < levels && head->span[top] <= count) ++top;
+
+    node_type *chain[num_levels];
+    size_type  indexes[num_levels];
+    node_type *cur   = head;
+    size_type  index = 0;
+    for (unsigned l = top; l; )
+    {
+        --l;
+        while (index + cur->span[l] <= count)
+        {
+            index += cur->span[l];
+            cur    = cur->next[l];
+        }
+        chain[l]   = cur;
+        indexes[l] = index;
+    }
+    impl_assert_that(index == count);
+
+    node_type *first = head->next[0];
+    node_type *last  = cur->next[0];
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        if (l < top)
+        {
+            head->next[l] = chain[l]->next[l];
+            head->span[l] = indexes[l] + chain[l]->span[l] - count;
+        }
+        else
+        {
+            head->span[l] = head->span[l] - count;
+        }
+    }
+    last->prev = head;
+
+    while (first != last)
+    {
+        node_type *next = first->next[0];
+        alloc.destroy(&first->value);
+        deallocate(first);
+        first = next;
+    }
+    item_count -= count;
+    for (unsigned l = 0; l < levels; ++l) weighting::reweigh(head, l, tail, weight);
+    ++changes;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::node_type *
-rasl_impl<T,C,A,LG>::at(size_type index)
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::at(size_type index)
 {
     assert_that(index < item_count);
 
@@ -1189,27 +2234,245 @@ rasl_impl<T,C,A,LG>::at(size_type index)
     return node;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-const typename rasl_impl<T,C,A,LG>::node_type *
-rasl_impl<T,C,A,LG>::at(size_type index) const
+const typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::at(size_type index) const
 {
     return const_cast<rasl_impl*>(this)->at(index);
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-typename rasl_impl<T,C,A,LG>::size_type
-rasl_impl<T,C,A,LG>::index_of(const node_type *node) const
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::index_of(const node_type *node) const
 {
-    node_type *chain[num_levels]   = {0};
-    size_type  indexes[num_levels] = {0};
-    return find_chain(node, chain, indexes);
+    return position_of(node) - 1;
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::count_less(const value_type &value) const
+{
+    return count_less(value, head, 0, levels);
 }
 
-template <class T, class C, class A, class LG>
+/// As count_less, but the search climbs from the bottom of the head only as
+/// high as it must, so it takes O(log K) for a result of K, however long the
+/// list is. For finding how much of the front has expired.
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-unsigned rasl_impl<T,C,A,LG>::new_level()
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::count_less_near_front(const value_type &value) const
+{
+    unsigned top = 0;
+    while (top < levels && head->next[top] != tail && less(head->next[top]->value, value)) ++top;
+    return count_less(value, head, 0, top);
+}
+
+/// Finds where the paths of the searches for lo and hi part: down to there,
+/// each node compared with lo decides hi's path too. Then each goes on
+/// alone, and the difference in their positions is the count.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::count_between(const value_type &lo, const value_type &hi) const
+{
+    const node_type *cur   = head;
+    size_type        index = 0;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        const node_type *next = cur->next[l];
+        while (next != tail && less(next->value, lo))
+        {
+            index += cur->span[l];
+            cur    = next;
+            next   = cur->next[l];
+        }
+        if (next != tail && less(next->value, hi))
+        {
+            // hi's path goes on along this level, lo's goes down
+            return count_less(hi, cur, index, l+1) - count_less(lo, cur, index, l);
+        }
+    }
+    return 0; // nothing lies in [lo,hi)
+}
+
+/// The first node not ordering before value (or the tail), and its index.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::lower_bound(const value_type &value, size_type &index) const
+{
+    const node_type *cur = head;
+    index = 0;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && less(cur->next[l]->value, value))
+        {
+            index += cur->span[l];
+            cur    = cur->next[l];
+        }
+    }
+    return cur->next[0];
+}
+
+/// The first node ordering after value (or the tail), and its index.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::upper_bound(const value_type &value, size_type &index) const
+{
+    const node_type *cur = head;
+    index = 0;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && !less(value, cur->next[l]->value))
+        {
+            index += cur->span[l];
+            cur    = cur->next[l];
+        }
+    }
+    return cur->next[0];
+}
+
+/// Continues a search for value from node from, at position index, down
+/// from (but not including) the given level, and returns the position of
+/// the last node ordering before value: that is, the number of elements
+/// before value.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::size_type
+rasl_impl<T,C,A,LG,D,S,W>::count_less(const value_type &value, const node_type *from,
+                                size_type index, unsigned level) const
+{
+    const node_type *cur = from;
+    for (unsigned l = level; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && less(cur->next[l]->value, value))
+        {
+            index += cur->span[l];
+            cur    = cur->next[l];
+        }
+    }
+    return index;
+}
+
+/// The node n places on from node, which is at index; n may be negative.
+///
+/// Forwards, this never goes back to the head: it takes the tallest link
+/// out of each node that does not overshoot, so climbs node's own tower
+/// and those after it, then comes down again, like a search from the head
+/// but in O(log n) expected time rather than O(log size()). Short steps
+/// back follow prev; longer ones search from the head, by index.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::advance(const node_type *node, size_type index, difference_type n) const
+{
+    assert_that(n >= 0 || size_type(-n) <= index);
+    assert_that(n <= 0 || index + size_type(n) <= item_count);
+
+    node_type *cur = const_cast<node_type*>(node);
+    if (n >= 0)
+    {
+        for (size_type remaining = size_type(n); remaining; )
+        {
+            unsigned l = cur->level;
+            while (cur->span[l] > remaining) --l;
+            remaining -= cur->span[l];
+            cur = cur->next[l];
+        }
+    }
+    else if (size_type(-n) <= levels)
+    {
+        for (; n; ++n) cur = cur->prev;
+    }
+    else
+    {
+        cur = const_cast<node_type*>(at(index - size_type(-n)));
+    }
+    return cur;
+}
+
+/// The total weight of the first index elements: the search of at(),
+/// combining the weights of the links it takes rather than their spans.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::weight_type
+rasl_impl<T,C,A,LG,D,S,W>::prefix_weight(size_type index) const
+{
+    assert_that(index <= item_count);
+
+    weight_type      total    = weight.identity();
+    size_type        position = 0;
+    const node_type *cur      = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (position + cur->span[l] <= index)
+        {
+            total     = weight.combine(total, weighting::link_weight(cur, l));
+            position += cur->span[l];
+            cur       = cur->next[l];
+        }
+    }
+    return total;
+}
+
+/// Finds the first node at which the running total of weights reaches
+/// total, and its index; or the tail (and size()) if none does.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::node_type *
+rasl_impl<T,C,A,LG,D,S,W>::lower_bound_by_weight(const weight_type &total, size_type &index) const
+{
+    weight_type      sum      = weight.identity();
+    size_type        position = 0;
+    const node_type *cur      = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail && weight.combine(sum, weighting::link_weight(cur, l)) < total)
+        {
+            sum       = weight.combine(sum, weighting::link_weight(cur, l));
+            position += cur->span[l];
+            cur       = cur->next[l];
+        }
+    }
+    index = position;
+    return cur->next[0];
+}
+
+/// The aggregate weight of the count nodes from first on. Starting from the
+/// node before first, it takes the tallest link that does not pass the
+/// last of them, as advance() does, so its path climbs and then falls.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+typename rasl_impl<T,C,A,LG,D,S,W>::weight_type
+rasl_impl<T,C,A,LG,D,S,W>::aggregate(const node_type *first, size_type count) const
+{
+    weight_type      total = weight.identity();
+    const node_type *cur   = first->prev;
+    while (count)
+    {
+        unsigned l = cur->level < levels ? cur->level : levels-1;
+        while (cur->span[l] > count) --l;
+        total  = weight.combine(total, weighting::link_weight(cur, l));
+        count -= cur->span[l];
+        cur    = cur->next[l];
+    }
+    return total;
+}
+
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+unsigned rasl_impl<T,C,A,LG,D,S,W>::new_level()
 {    
     unsigned level = generator.new_level();
     if (level >= levels)
@@ -1220,30 +2483,201 @@ unsigned rasl_impl<T,C,A,LG>::new_level()
     return level;
 }
 
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-void rasl_impl<T,C,A,LG>::swap(rasl_impl &other)
+void rasl_impl<T,C,A,LG,D,S,W>::swap(rasl_impl &other)
 {
     using std::swap;
 
     swap(alloc,      other.alloc);
     swap(less,       other.less);
+    swap(weight,     other.weight);
     swap(generator,  other.generator);
     swap(levels,     other.levels);
     swap(head,       other.head);
     swap(tail,       other.tail);
     swap(item_count, other.item_count);
 
+    // Every iterator's index, into either list, is now out of date
+    ++changes;
+    ++other.changes;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+//==============================================================================
+#pragma mark linear-time building
+
+/// Appends each value in turn, without searching: a new node is linked
+/// after the last node of each level it reaches, and the span of that link
+/// is the distance between their positions. Unless the list allows
+/// duplicates, values equivalent to the one before are skipped.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+template <typename InputIterator>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::assign_sorted(InputIterator first, InputIterator last)
+{
+    remove_all();
+
+    node_type *chain[num_levels];
+    size_type  indexes[num_levels];
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        chain[l]   = head;
+        indexes[l] = 0;
+    }
+
+    try
+    {
+        for (; first != last; ++first)
+        {
+            node_type *back = chain[0];
+            assert_that(back == head || detail::less_or_equal(back->value, *first, less));
+            if (!D && back != head && !less(back->value, *first)) continue;
+            check_room(1);
+
+            node_type *node = allocate(new_level());
+            try
+            {
+                alloc.construct(&node->value, *first);
+            }
+            catch (...)
+            {
+                deallocate(node);
+                throw;
+            }
+
+            const size_type index = item_count + 1;
+            node->prev = back;
+            for (unsigned l = 0; l <= node->level; ++l)
+            {
+                chain[l]->next[l] = node;
+                chain[l]->span[l] = index - indexes[l];
+                chain[l]          = node;
+                indexes[l]        = index;
+            }
+            ++item_count;
+            ++changes;
+        }
+    }
+    catch (...)
+    {
+        finish_append(chain, indexes);
+        throw;
+    }
+    finish_append(chain, indexes);
+
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
+/// Ends every level of an appended list at the tail, given the last node on
+/// each level and its position.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::finish_append(node_type **chain, size_type *indexes)
+{
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        chain[l]->next[l] = tail;
+        chain[l]->span[l] = item_count + 1 - indexes[l];
+    }
+    tail->prev = chain[0];
+    reweigh_all();
+}
+
+/// Brings the weights of the links in chain (each passing over the same
+/// change) up to date, from level 0 up to top.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::reweigh_chain(node_type **chain, unsigned top)
+{
+    if (!weighting::stored) return;
+    for (unsigned l = 0; l < top; ++l)
+    {
+        weighting::reweigh(chain[l], l, tail, weight);
+    }
+}
+
+/// Works out the weight of every link afresh, level by level, in O(N).
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::reweigh_all()
+{
+    if (!weighting::stored) return;
+    for (unsigned l = 0; l < levels; ++l)
+    {
+        for (node_type *node = head; node != tail; node = node->next[l])
+            weighting::reweigh(node, l, tail, weight);
+    }
+}
+
+/// As sl_impl::join. Every node of other moves item_count places along, so
+/// the spans within it still hold; only the links into the join (from our
+/// last node on each level) need new spans.
+template <class T, class C, class A, class LG, bool D, class S, class W>
+inline
+void rasl_impl<T,C,A,LG,D,S,W>::join(rasl_impl &other)
+{
+    assert_that(&other != this);
+    assert_that(alloc == other.alloc);
+    if (other.item_count == 0) return;
+
+    check_room(other.item_count);
+
+    node_type *first = other.head->next[0];
+    assert_that(item_count == 0 || (D ? !less(first->value, tail->prev->value)
+                                      : less(tail->prev->value, first->value)));
+
+    node_type *last[num_levels];
+    node_type *other_last[num_levels];
+    size_type  indexes[num_levels];
+    size_type  other_indexes[num_levels];
+    find_end_chain(last, indexes);
+    other.find_end_chain(other_last, other_indexes);
+
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        node_type *after = other.head->next[l];
+        if (after != other.tail)
+        {
+            last[l]->next[l]       = after;
+            last[l]->span[l]       = item_count - indexes[l] + other.head->span[l];
+            other_last[l]->next[l] = tail;
+        }
+        else
+        {
+            last[l]->span[l] += other.item_count;
+        }
+        other.head->next[l] = other.tail;
+        other.head->span[l] = 1;
+        weighting::reweigh(other.head, l, other.tail, other.weight);
+    }
+    first->prev      = last[0];
+    tail->prev       = other.tail->prev;
+    other.tail->prev = other.head;
+
+    item_count       += other.item_count;
+    other.item_count  = 0;
+    ++changes;
+    ++other.changes;
+    if (other.levels > levels) levels = other.levels;
+    reweigh_chain(last, levels);
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+    other.check();
+#endif
+}
+
 // for diagnostics only
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 template <class STREAM>
 inline
-void rasl_impl<T,C,A,LG>::dump(STREAM &s) const
+void rasl_impl<T,C,A,LG,D,S,W>::dump(STREAM &s) const
 {
     s << "skip_list(size="<<item_count<<",levels=" << levels << ")\n";
     for (unsigned l = 0; l < levels+1; ++l)
@@ -1272,7 +2706,7 @@ void rasl_impl<T,C,A,LG>::dump(STREAM &s) const
             
             if (n != tail)
             {
-                if (next != tail && !less(n->value, next->value))
+                if (next != tail && (D ? less(next->value, n->value) : !less(n->value, next->value)))
                     s << "*XXXXXXXXX* ";
                 s << span << ">"
                   << " "
@@ -1286,13 +2720,14 @@ void rasl_impl<T,C,A,LG>::dump(STREAM &s) const
 
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
 // for diagnostics only
-template <class T, class C, class A, class LG>
+template <class T, class C, class A, class LG, bool D, class S, class W>
 inline
-bool rasl_impl<T,C,A,LG>::check() const
+bool rasl_impl<T,C,A,LG,D,S,W>::check() const
 {
     for (unsigned l = 0; l < levels; ++l)
     {
-        unsigned count = 0;
+        unsigned  count = 0;
+        size_type spans = 0;
         const node_type *n = head;
 
         while (n != tail)
@@ -1315,18 +2750,35 @@ bool rasl_impl<T,C,A,LG>::check() const
             node_type *next = n->next[l];
             if (n != head && next != tail)
             {
-                if (!(less(n->value, next->value)))
+                if ((!D && !(less(n->value, next->value)))
+                    || (D && less(next->value, n->value)))
                 {
                     assert_that(false && "value order error");
                     dump(std::cerr);
                     return false;
                 }
             }
+            // each link weighs what the links (or value) below it do
+            if (!(weighting::weigh(n, l, tail, weight) == weighting::link_weight(n, l)))
+            {
+                assert_that(false && "weight error");
+                dump(std::cerr);
+                return false;
+            }
             if (n != head)
                 ++count;
+            spans += n->span[l];
             n = next;
         }
 
+        // the spans on every level add up to the tail's position
+        if (spans != item_count+1)
+        {
+            assert_that(false && "span error");
+            dump(std::cerr);
+            return false;
+        }
+
         if (l == 0 && count != item_count)
         {
             assert_that(false && "item count error")
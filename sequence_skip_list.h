@@ -0,0 +1,532 @@
+//==============================================================================
+// sequence_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "random_access_skip_list.h"
+
+#include <memory>     // for std::allocator
+#include <iterator>   // for std::reverse_iterator
+#include <algorithm>  // for std::equal, std::lexicographical_compare
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - sequence_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// A sequence_skip_list holds its elements in the order they are put in,
+/// like a std::deque or std::vector, rather than sorted. It is a
+/// random_access_skip_list with no comparator: the same spans find an
+/// element by index, or the place to insert one, in O(log N).
+///
+/// So inserting or erasing in the middle of a long sequence is O(log N),
+/// where a vector or deque moves O(N) elements, and elements never move in
+/// memory, so iterators and references to them stay valid until the element
+/// itself is erased. Indexing is O(log N) rather than O(1), though stepping
+/// an iterator is O(1). That suits long sequences that are edited all over,
+/// such as text buffers and playlists.
+///
+/// @param T              Template type for kind of object held in the
+///                       container.
+/// @param Allocator      Template type for memory allocator for the contents
+///                       of the container.
+/// @param LevelGenerator Template type for the node height generator.
+/// @param SpanType       As for random_access_skip_list.
+/// @param Weight         As for random_access_skip_list: with, say, each
+///                       element's length in bytes as its weight, the
+///                       sequence is a rope, and lower_bound_by_weight()
+///                       finds the piece holding a given byte offset.
+///
+/// @see random_access_skip_list
+template <typename T,
+          typename Allocator      = std::allocator<T>,
+          typename LevelGenerator = detail::skip_list_level_generator<32>,
+          typename SpanType       = unsigned,
+          typename Weight         = detail::unit_weight>
+class sequence_skip_list
+{
+protected:
+    typedef typename detail::rasl_impl<T,detail::sequence_order,Allocator,LevelGenerator,true,SpanType,Weight> impl_type;
+    typedef typename impl_type::node_type                                  node_type;
+
+public:
+
+    //======================================================================
+    // types
+
+    typedef T                                           value_type;
+    typedef Allocator                                   allocator_type;
+    typedef typename impl_type::size_type               size_type;
+    typedef typename allocator_type::difference_type    difference_type;
+    typedef typename allocator_type::reference          reference;
+    typedef typename allocator_type::const_reference    const_reference;
+    typedef typename allocator_type::pointer            pointer;
+    typedef typename allocator_type::const_pointer      const_pointer;
+    typedef typename impl_type::weight_type             weight_type;
+
+    typedef typename detail::rasl_iterator<impl_type>   iterator;
+    typedef typename iterator::const_iterator           const_iterator;
+    typedef std::reverse_iterator<iterator>             reverse_iterator;
+    typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
+
+    //======================================================================
+    // lifetime management
+
+    explicit sequence_skip_list(const Allocator &alloc = Allocator());
+
+    template <class InputIterator>
+    sequence_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator());
+
+    sequence_skip_list(const sequence_skip_list &other);
+    sequence_skip_list(const sequence_skip_list &other, const Allocator &alloc);
+
+    allocator_type get_allocator() const { return impl.get_allocator(); }
+
+    //======================================================================
+    // assignment
+
+    sequence_skip_list &operator=(const sequence_skip_list &other);
+
+    /// Replaces the contents with the range [first,last), in linear time.
+    template <typename InputIterator>
+    void assign(InputIterator first, InputIterator last) { impl.assign_sorted(first, last); }
+
+    //======================================================================
+    // element access
+
+    reference       front();
+    const_reference front() const;
+    reference       back();
+    const_reference back() const;
+
+    reference       operator[](size_type index);
+    const_reference operator[](size_type index) const;
+
+    //======================================================================
+    // iterators
+
+    iterator       begin()                  { return iterator(&impl, impl.front(), 0); }
+    const_iterator begin() const            { return const_iterator(&impl, impl.front(), 0); }
+    const_iterator cbegin() const           { return const_iterator(&impl, impl.front(), 0); }
+
+    iterator       end()                    { return iterator(&impl, impl.one_past_end(), size()); }
+    const_iterator end() const              { return const_iterator(&impl, impl.one_past_end(), size()); }
+    const_iterator cend() const             { return const_iterator(&impl, impl.one_past_end(), size()); }
+
+    reverse_iterator       rbegin()         { return reverse_iterator(end()); }
+    const_reverse_iterator rbegin() const   { return const_reverse_iterator(end()); }
+    const_reverse_iterator crbegin() const  { return const_reverse_iterator(end()); }
+
+    reverse_iterator       rend()           { return reverse_iterator(begin()); }
+    const_reverse_iterator rend() const     { return const_reverse_iterator(begin()); }
+    const_reverse_iterator crend() const    { return const_reverse_iterator(begin()); }
+
+    //======================================================================
+    // capacity
+
+    bool      empty() const         { return impl.size() == 0; }
+    size_type size() const          { return impl.size(); }
+    size_type max_size() const      { return impl.max_size(); }
+
+    //======================================================================
+    // modifiers
+
+    void clear()                                { impl.remove_all(); }
+
+    /// Inserts value before position, in O(log N).
+    iterator insert(const_iterator position, const value_type &value);
+
+    /// Inserts the range [first,last) before position, in order.
+    template <class InputIterator>
+    void insert(const_iterator position, InputIterator first, InputIterator last);
+
+    /// Inserts value so that it has the given index (up to and including
+    /// size()), in O(log N).
+    iterator insert_at(size_type index, const value_type &value);
+
+    void push_front(const value_type &value)    { impl.insert_at(0, value); }
+    void push_back(const value_type &value)     { impl.insert_at(size(), value); }
+    void pop_front();
+    void pop_back();
+
+    iterator erase(const_iterator position);
+    iterator erase(const_iterator first, const_iterator last);
+    void     erase_at(size_type index);
+
+    void swap(sequence_skip_list &other) { impl.swap(other.impl); }
+
+    friend void swap(sequence_skip_list &lhs, sequence_skip_list &rhs) { lhs.swap(rhs); }
+
+    /// Moves all the elements of other onto the end of this sequence in
+    /// O(log N), leaving other empty. Both must have equal allocators.
+    ///
+    /// @see random_access_skip_list::join
+    void join(sequence_skip_list &other) { impl.join(other.impl); }
+
+    //======================================================================
+    // random access
+
+    iterator       iterator_at(size_type index);
+    const_iterator iterator_at(size_type index) const;
+    const_iterator citerator_at(size_type index) const { return iterator_at(index); }
+
+    size_type index_of(const const_iterator &i) const { return i.get_index(); }
+
+    //======================================================================
+    // weights
+
+    /// The total weight of the first index elements, in O(log N).
+    weight_type prefix_weight(size_type index) const { return impl.prefix_weight(index); }
+
+    /// The aggregate weight of the elements in [first,last), in O(log N)
+    /// however long the range is.
+    weight_type aggregate(const_iterator first, const_iterator last) const;
+
+    /// The first element at which the running total of weights (including
+    /// its own) reaches total, or end() if the whole sequence weighs less.
+    iterator       lower_bound_by_weight(const weight_type &total);
+    const_iterator lower_bound_by_weight(const weight_type &total) const;
+
+    //======================================================================
+    // other operations
+
+    template <typename STREAM>
+    void dump(STREAM &stream) const { impl.dump(stream); }
+
+protected:
+    impl_type impl;
+};
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - non-members
+
+namespace goodliffe {
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator==(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator!=(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return !operator==(lhs, rhs);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator<(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator<=(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return !(rhs < lhs);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator>(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return rhs < lhs;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+bool operator>=(const sequence_skip_list<T,A,LG,S,W> &lhs, const sequence_skip_list<T,A,LG,S,W> &rhs)
+{
+    return !(lhs < rhs);
+}
+
+} // namespace goodliffe
+
+namespace std
+{
+    template <class T, class A, class LG, class S, class W>
+    void swap(goodliffe::sequence_skip_list<T,A,LG,S,W> &lhs, goodliffe::sequence_skip_list<T,A,LG,S,W> &rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+//==============================================================================
+#pragma mark - sequence_skip_list implementation
+//==============================================================================
+
+namespace goodliffe {
+
+//==============================================================================
+#pragma mark lifetime management
+
+template <class T, class A, class LG, class S, class W>
+inline
+sequence_skip_list<T,A,LG,S,W>::sequence_skip_list(const allocator_type &alloc_)
+:   impl(alloc_)
+{
+}
+
+template <class T, class A, class LG, class S, class W>
+template <class InputIterator>
+inline
+sequence_skip_list<T,A,LG,S,W>::sequence_skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
+:   impl(alloc_)
+{
+    assign(first, last);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+sequence_skip_list<T,A,LG,S,W>::sequence_skip_list(const sequence_skip_list &other)
+:   impl(other.get_allocator())
+{
+    assign(other.begin(), other.end());
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+sequence_skip_list<T,A,LG,S,W>::sequence_skip_list(const sequence_skip_list &other, const allocator_type &alloc_)
+:   impl(alloc_)
+{
+    assign(other.begin(), other.end());
+}
+
+//==============================================================================
+#pragma mark assignment
+
+template <class T, class A, class LG, class S, class W>
+inline
+sequence_skip_list<T,A,LG,S,W> &
+sequence_skip_list<T,A,LG,S,W>::operator=(const sequence_skip_list<T,A,LG,S,W> &other)
+{
+    if (&other != this) assign(other.begin(), other.end());
+    return *this;
+}
+
+//==============================================================================
+#pragma mark element access
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::reference
+sequence_skip_list<T,A,LG,S,W>::front()
+{
+    assert_that(!empty());
+    return impl.front()->value;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::const_reference
+sequence_skip_list<T,A,LG,S,W>::front() const
+{
+    assert_that(!empty());
+    return impl.front()->value;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::reference
+sequence_skip_list<T,A,LG,S,W>::back()
+{
+    assert_that(!empty());
+    return impl.one_past_end()->prev->value;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::const_reference
+sequence_skip_list<T,A,LG,S,W>::back() const
+{
+    assert_that(!empty());
+    return impl.one_past_end()->prev->value;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::reference
+sequence_skip_list<T,A,LG,S,W>::operator[](size_type index)
+{
+    node_type *node = impl.at(index);
+    assert_that(impl.is_valid(node));
+    return node->value;
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::const_reference
+sequence_skip_list<T,A,LG,S,W>::operator[](size_type index) const
+{
+    const node_type *node = impl.at(index);
+    assert_that(impl.is_valid(node));
+    return node->value;
+}
+
+//==============================================================================
+#pragma mark modifiers
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::insert(const_iterator position, const value_type &value)
+{
+    assert_that(position.get_impl() == &impl);
+    return insert_at(position.get_index(), value);
+}
+
+template <class T, class A, class LG, class S, class W>
+template <class InputIterator>
+inline
+void
+sequence_skip_list<T,A,LG,S,W>::insert(const_iterator position, InputIterator first, InputIterator last)
+{
+    assert_that(position.get_impl() == &impl);
+    size_type index = position.get_index();
+    while (first != last)
+    {
+        impl.insert_at(index++, *first++);
+    }
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::insert_at(size_type index, const value_type &value)
+{
+    assert_that(index <= size());
+    return iterator(&impl, impl.insert_at(index, value), index);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+void sequence_skip_list<T,A,LG,S,W>::pop_front()
+{
+    assert_that(!empty());
+    impl.remove(impl.front());
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+void sequence_skip_list<T,A,LG,S,W>::pop_back()
+{
+    assert_that(!empty());
+    impl.remove(impl.one_past_end()->prev);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::erase(const_iterator position)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_node()));
+    node_type *node = const_cast<node_type*>(position.get_node());
+    node_type *next = node->next[0];
+    impl.remove(node);
+    return iterator(&impl, next);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::erase(const_iterator first, const_iterator last)
+{
+    assert_that(first.get_impl() == &impl);
+    assert_that(last.get_impl() == &impl);
+
+    if (first != last)
+    {
+        node_type *first_node = const_cast<node_type*>(first.get_node());
+        node_type *last_node  = const_cast<node_type*>(last.get_node()->prev);
+        impl.remove_between(first_node, last_node);
+    }
+
+    return iterator(&impl, const_cast<node_type*>(last.get_node()));
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+void sequence_skip_list<T,A,LG,S,W>::erase_at(size_type index)
+{
+    node_type *node = impl.at(index);
+    assert_that(impl.is_valid(node));
+    impl.remove(node);
+}
+
+//==============================================================================
+#pragma mark random access
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::iterator_at(size_type index)
+{
+    return iterator(&impl, impl.at(index), index);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::const_iterator
+sequence_skip_list<T,A,LG,S,W>::iterator_at(size_type index) const
+{
+    return const_iterator(&impl, impl.at(index), index);
+}
+
+//==============================================================================
+#pragma mark weights
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::weight_type
+sequence_skip_list<T,A,LG,S,W>::aggregate(const_iterator first, const_iterator last) const
+{
+    assert_that(first.get_impl() == &impl);
+    assert_that(last.get_impl() == &impl);
+    assert_that(!(last < first));
+    return impl.aggregate(first.get_node(), size_type(last - first));
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::iterator
+sequence_skip_list<T,A,LG,S,W>::lower_bound_by_weight(const weight_type &total)
+{
+    size_type  index;
+    node_type *node = impl.lower_bound_by_weight(total, index);
+    return iterator(&impl, node, index);
+}
+
+template <class T, class A, class LG, class S, class W>
+inline
+typename sequence_skip_list<T,A,LG,S,W>::const_iterator
+sequence_skip_list<T,A,LG,S,W>::lower_bound_by_weight(const weight_type &total) const
+{
+    size_type        index;
+    const node_type *node = impl.lower_bound_by_weight(total, index);
+    return const_iterator(&impl, node, index);
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,553 @@
+//==============================================================================
+// sharded_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list.h"
+#include "skip_list_epoch.h"
+
+#ifndef SKIP_LIST_CPP11
+#error "sharded_skip_list requires C++11 (for std::mutex)"
+#endif
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+#include <iterator>   // for std::iterator
+#include <algorithm>  // for std::upper_bound
+#include <vector>
+#include <mutex>
+#include <atomic>
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - internal types
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// One shard of a sharded_skip_list: a skip_list, and the lock that guards
+/// it.
+///
+/// @internal
+template <typename T, typename Compare, typename Allocator>
+class sharded_list_shard
+    : public skip_list<T,Compare,Allocator,concurrent_level_generator<32> >
+{
+public:
+    typedef skip_list<T,Compare,Allocator,concurrent_level_generator<32> > parent_type;
+    typedef typename parent_type::size_type                                size_type;
+
+    explicit sharded_list_shard(const Allocator &alloc)
+        : parent_type(alloc), live(0), inserts_since_check(0) {}
+
+    /// See sl_impl::sample
+    template <typename OutputIterator>
+    size_type sample(size_type count, OutputIterator out) const
+        { return this->impl.sample(count, out); }
+
+    std::mutex              mutex;
+    std::atomic<size_type>  live;                ///< size(), for reading without the lock
+    unsigned                inserts_since_check;
+};
+
+/// The values at which each shard after the first begins. Replaced, never
+/// changed, so readers need only be pinned to use one.
+///
+/// @internal
+template <typename T, typename Allocator>
+struct sharded_list_bounds
+{
+    explicit sharded_list_bounds(const Allocator &alloc)
+        : bounds(alloc), next_retired(0) {}
+
+    std::vector<T,Allocator>  bounds;
+    sharded_list_bounds      *next_retired; ///< for the epoch_domain
+};
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - sharded_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// A skip list of unique objects, split by value range across Shards
+/// separate skip_lists, each with its own lock, so that threads working on
+/// different ranges do not contend. A middle ground between a skip_list
+/// behind one lock and the lock-free concurrent_skip_list.
+///
+/// insert, erase, contains, count, size and empty are thread safe. Each
+/// point operation locks just the one shard holding its value.
+///
+/// The shard boundaries adapt to the data. Every so often an insert checks
+/// whether its shard has grown well beyond its fair share, and if so the
+/// list is rebalanced: the boundaries are recomputed from a sample of keys
+/// taken from the upper levels of each shard (so without visiting every
+/// element), and the elements that fall on the other side of a boundary
+/// that moved are passed to the neighbouring shard with skip_list's
+/// split() and join(), which relink towers rather than copying. That is
+/// O(log N) per boundary, plus a walk over the elements that move (which
+/// split() counts). Rebalancing locks every shard while it runs.
+/// rebalance() may also be called directly.
+///
+/// Iteration visits the shards in order, stitching them into one sorted
+/// sequence. It is not thread safe: nothing may change the list while an
+/// iterator is in use. Neither is clear() thread safe.
+///
+/// @param T         Template type for kind of object held in the container.
+/// @param Shards    The number of shards.
+/// @param Compare   Template type describing the ordering comparator.
+/// @param Allocator Template type for memory allocator for the contents of
+///                  the container. Must be safe to call from several threads
+///                  at once, as std::allocator is.
+///
+/// @see skip_list
+/// @see concurrent_skip_list
+template <typename T,
+          unsigned Shards    = 8,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+class sharded_skip_list
+{
+    typedef detail::sharded_list_shard<T,Compare,Allocator>   shard_type;
+    typedef detail::sharded_list_bounds<T,Allocator>          bounds_type;
+    typedef detail::epoch_domain<bounds_type,sharded_skip_list,Allocator> domain_type;
+    typedef detail::epoch_pin<domain_type>                    pin_type;
+    typedef typename shard_type::const_iterator               shard_iterator;
+
+public:
+
+    //======================================================================
+    // types
+
+    typedef T                                           value_type;
+    typedef Allocator                                   allocator_type;
+    typedef typename shard_type::size_type              size_type;
+    typedef typename allocator_type::difference_type    difference_type;
+    typedef typename allocator_type::const_reference    const_reference;
+    typedef typename allocator_type::const_pointer      const_pointer;
+    typedef Compare                                     compare;
+
+    class const_iterator;
+    typedef const_iterator                              iterator;
+
+    static const unsigned num_shards = Shards;
+
+    /// An insert checks whether its shard needs rebalancing after this
+    /// many inserts into it
+    static const unsigned check_interval = 64;
+
+    /// A shard needs rebalancing when it holds more than rebalance_factor
+    /// times its share of the elements, and at least min_rebalance_size
+    static const unsigned rebalance_factor   = 2;
+    static const unsigned min_rebalance_size = 1024;
+
+    /// How many keys per shard rebalancing samples
+    static const unsigned sample_size = 32;
+
+    //======================================================================
+    // lifetime management
+
+    explicit sharded_skip_list(const Allocator &alloc = Allocator());
+    ~sharded_skip_list();
+
+    allocator_type get_allocator() const { return alloc; }
+
+    //======================================================================
+    // iterators
+
+    const_iterator begin() const;
+    const_iterator end() const   { return const_iterator(this, Shards, shard_iterator()); }
+
+    //======================================================================
+    // capacity
+
+    bool      empty() const { return size() == 0; }
+    size_type size() const;
+
+    /// The number of elements in one shard, to see how well balanced the
+    /// list is
+    size_type shard_size(unsigned shard) const { return shards[shard]->live.load(std::memory_order_relaxed); }
+
+    //======================================================================
+    // modifiers
+
+    /// Not thread safe
+    void clear();
+
+    /// Returns true if value was inserted, false if an equivalent value was
+    /// already present
+    bool      insert(const value_type &value);
+    size_type erase(const value_type &value);
+
+    /// Recomputes the shard boundaries and moves elements between shards to
+    /// match. Blocks every other operation while it runs.
+    void rebalance();
+
+    //======================================================================
+    // lookup
+
+    bool      contains(const value_type &value) const { return count(value) != 0; }
+    size_type count(const value_type &value) const;
+
+    /// For the epoch_domain: frees a retired set of bounds
+    /// @internal
+    void reclaim(bounds_type *bounds) { delete_bounds(bounds); }
+
+private:
+    sharded_skip_list(const sharded_skip_list &other);
+    sharded_skip_list &operator=(const sharded_skip_list &other);
+
+    shard_type &lock_shard(const value_type &value, std::unique_lock<std::mutex> &lock) const;
+    unsigned    shard_index(const bounds_type &bounds, const value_type &value) const;
+    bool        needs_rebalance(const shard_type &shard) const;
+    void        redistribute();
+
+    allocator_type              alloc;
+    compare                     less;
+    shard_type                 *shards[Shards];
+    std::atomic<bounds_type*>   current_bounds;
+    std::mutex                  rebalance_mutex;
+    mutable domain_type         domain;
+
+    typedef typename Allocator::template rebind<shard_type>::other  shard_allocator;
+    typedef typename Allocator::template rebind<bounds_type>::other bounds_allocator;
+
+    /// Allocates a shard, or a set of bounds, with alloc, as the lists do
+    /// their nodes, and constructs it in place
+    shard_type *new_shard()
+    {
+        shard_type *shard = shard_allocator(alloc).allocate(1, (void*)0);
+        try
+        {
+            new (shard) shard_type(alloc);
+        }
+        catch (...)
+        {
+            shard_allocator(alloc).deallocate(shard, 1);
+            throw;
+        }
+        return shard;
+    }
+
+    bounds_type *new_bounds()
+    {
+        bounds_type *bounds = bounds_allocator(alloc).allocate(1, (void*)0);
+        new (bounds) bounds_type(alloc);
+        return bounds;
+    }
+
+    void delete_shard(shard_type *shard)
+    {
+        shard->~shard_type();
+        shard_allocator(alloc).deallocate(shard, 1);
+    }
+
+    void delete_bounds(bounds_type *bounds)
+    {
+        bounds->~bounds_type();
+        bounds_allocator(alloc).deallocate(bounds, 1);
+    }
+};
+
+//==============================================================================
+#pragma mark - sharded_skip_list::const_iterator
+
+/// Walks each shard in turn
+template <class T, unsigned S, class C, class A>
+class sharded_skip_list<T,S,C,A>::const_iterator
+    : public std::iterator<std::forward_iterator_tag,
+                           T,
+                           typename A::difference_type,
+                           typename A::const_pointer,
+                           typename A::const_reference>
+{
+public:
+    const_iterator() : list(0), shard(S) {}
+
+    const_reference operator*() const  { return *inner; }
+    const_pointer   operator->() const { return &*inner; }
+
+    const_iterator &operator++()   { ++inner; skip_empty_shards(); return *this; }
+    const_iterator  operator++(int) { const_iterator old(*this); operator++(); return old; }
+
+    bool operator==(const const_iterator &other) const
+        { return shard == other.shard && (shard == S || inner == other.inner); }
+    bool operator!=(const const_iterator &other) const
+        { return !operator==(other); }
+
+private:
+    friend class sharded_skip_list;
+
+    const_iterator(const sharded_skip_list *list_, unsigned shard_, shard_iterator inner_)
+        : list(list_), shard(shard_), inner(inner_) { if (shard < S) skip_empty_shards(); }
+
+    void skip_empty_shards()
+    {
+        while (inner == list->shards[shard]->end())
+        {
+            if (++shard == S) return;
+            inner = list->shards[shard]->begin();
+        }
+    }
+
+    const sharded_skip_list *list;
+    unsigned                 shard;
+    shard_iterator           inner;
+};
+
+//==============================================================================
+#pragma mark - sharded_skip_list implementation
+
+template <class T, unsigned S, class C, class A>
+inline
+sharded_skip_list<T,S,C,A>::sharded_skip_list(const allocator_type &alloc_)
+:   alloc(alloc_),
+    current_bounds(new_bounds()),
+    domain(*this, alloc_)
+{
+    for (unsigned n = 0; n < S; ++n) shards[n] = new_shard();
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+sharded_skip_list<T,S,C,A>::~sharded_skip_list()
+{
+    for (unsigned n = 0; n < S; ++n) delete_shard(shards[n]);
+    delete_bounds(current_bounds.load());
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+typename sharded_skip_list<T,S,C,A>::const_iterator
+sharded_skip_list<T,S,C,A>::begin() const
+{
+    return const_iterator(this, 0, shards[0]->begin());
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+typename sharded_skip_list<T,S,C,A>::size_type
+sharded_skip_list<T,S,C,A>::size() const
+{
+    size_type total = 0;
+    for (unsigned n = 0; n < S; ++n) total += shard_size(n);
+    return total;
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+void sharded_skip_list<T,S,C,A>::clear()
+{
+    for (unsigned n = 0; n < S; ++n)
+    {
+        shards[n]->clear();
+        shards[n]->live.store(0, std::memory_order_relaxed);
+    }
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+unsigned
+sharded_skip_list<T,S,C,A>::shard_index(const bounds_type &bounds, const value_type &value) const
+{
+    return unsigned(std::upper_bound(bounds.bounds.begin(), bounds.bounds.end(), value, less)
+                    - bounds.bounds.begin());
+}
+
+/// Locks and returns the shard that value belongs in.
+template <class T, unsigned S, class C, class A>
+inline
+typename sharded_skip_list<T,S,C,A>::shard_type &
+sharded_skip_list<T,S,C,A>::lock_shard(const value_type &value, std::unique_lock<std::mutex> &lock) const
+{
+    for (;;)
+    {
+        // The pin keeps the bounds we look at alive (and so their address
+        // from being reused) until we have checked them again
+        pin_type pin(domain);
+        const bounds_type *bounds = current_bounds.load(std::memory_order_acquire);
+        shard_type &shard = *shards[shard_index(*bounds, value)];
+
+        std::unique_lock<std::mutex> shard_lock(shard.mutex);
+
+        // The bounds only change while every shard is locked, so if they
+        // are the ones we used, they are now fixed
+        if (current_bounds.load(std::memory_order_relaxed) == bounds)
+        {
+            lock.swap(shard_lock);
+            return shard;
+        }
+    }
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+bool sharded_skip_list<T,S,C,A>::needs_rebalance(const shard_type &shard) const
+{
+    const size_type mine = shard.live.load(std::memory_order_relaxed);
+    return mine >= min_rebalance_size && mine > rebalance_factor * size() / S;
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+bool sharded_skip_list<T,S,C,A>::insert(const value_type &value)
+{
+    bool check = false;
+    shard_type *shard = 0;
+    bool inserted = false;
+    {
+        std::unique_lock<std::mutex> lock;
+        shard    = &lock_shard(value, lock);
+        inserted = shard->insert(value).second;
+        if (inserted)
+        {
+            shard->live.store(shard->size(), std::memory_order_relaxed);
+            if (++shard->inserts_since_check >= check_interval)
+            {
+                shard->inserts_since_check = 0;
+                check = true;
+            }
+        }
+    }
+
+    if (check && needs_rebalance(*shard))
+    {
+        // If another thread is already rebalancing, leave it to them
+        std::unique_lock<std::mutex> lock(rebalance_mutex, std::try_to_lock);
+        if (lock.owns_lock() && needs_rebalance(*shard)) redistribute();
+    }
+    return inserted;
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+typename sharded_skip_list<T,S,C,A>::size_type
+sharded_skip_list<T,S,C,A>::erase(const value_type &value)
+{
+    std::unique_lock<std::mutex> lock;
+    shard_type &shard = lock_shard(value, lock);
+    const size_type erased = shard.erase(value);
+    shard.live.store(shard.size(), std::memory_order_relaxed);
+    return erased;
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+typename sharded_skip_list<T,S,C,A>::size_type
+sharded_skip_list<T,S,C,A>::count(const value_type &value) const
+{
+    std::unique_lock<std::mutex> lock;
+    return lock_shard(value, lock).count(value);
+}
+
+template <class T, unsigned S, class C, class A>
+inline
+void sharded_skip_list<T,S,C,A>::rebalance()
+{
+    std::lock_guard<std::mutex> lock(rebalance_mutex);
+    redistribute();
+}
+
+/// Recomputes the bounds, and moves the elements to match. The caller must
+/// hold the rebalance_mutex.
+template <class T, unsigned S, class C, class A>
+inline
+void sharded_skip_list<T,S,C,A>::redistribute()
+{
+    // Always lock the shards in order, so two rebalances cannot deadlock
+    std::unique_lock<std::mutex> locks[S];
+    for (unsigned n = 0; n < S; ++n) locks[n] = std::unique_lock<std::mutex>(shards[n]->mutex);
+
+    size_type total = 0;
+    for (unsigned n = 0; n < S; ++n) total += shards[n]->size();
+
+    // Sample each shard. Taken in shard order, the samples are sorted; each
+    // stands for an equal part of its shard, which gives its (estimated)
+    // rank in the whole list.
+    std::vector<T,A>         samples(alloc);
+    std::vector<size_type>   ranks;
+    size_type                base = 0;
+    for (unsigned n = 0; n < S; ++n)
+    {
+        const size_type taken = shards[n]->sample(sample_size, std::back_inserter(samples));
+        const size_type size  = shards[n]->size();
+        for (size_type k = 0; k < taken; ++k) ranks.push_back(base + k*size/taken);
+        base += size;
+    }
+
+    // Each boundary is the first sample at or after its share of the total
+    bounds_type *bounds = new_bounds();
+    size_type next = 0;
+    for (unsigned n = 1; n < S && next < samples.size(); ++n)
+    {
+        const size_type target = total * n / S;
+        while (next < samples.size() && ranks[next] < target) ++next;
+        if (next == samples.size()) break;
+        if (next == 0) { ++next; continue; } // nothing would go before it
+        bounds->bounds.push_back(samples[next++]);
+    }
+
+    // Settle each boundary in turn, from the first. Shard n either has
+    // elements at or beyond its new end, which are pushed on to the front
+    // of shard n+1, or is short of elements that are pulled back from the
+    // front of the shards after it. Only the elements that change shard
+    // are walked, so shards whose boundaries did not move cost O(log N).
+    typename shard_type::parent_type spare(alloc);
+    for (unsigned n = 0; n+1 < S; ++n)
+    {
+        shard_type &shard = *shards[n];
+        if (n >= bounds->bounds.size())
+        {
+            // This is now the last shard in use: it takes all the rest
+            for (unsigned m = n+1; m < S; ++m) shard.join(*shards[m]);
+            break;
+        }
+        const value_type &end = bounds->bounds[n];
+
+        shard.split(end, spare);
+        if (!spare.empty())
+        {
+            spare.join(*shards[n+1]);
+            shards[n+1]->swap(spare);
+            continue;
+        }
+
+        for (unsigned m = n+1; m < S; ++m)
+        {
+            shards[m]->split(end, spare);
+            shard.join(*shards[m]);
+            shards[m]->swap(spare);
+            if (!shards[m]->empty()) break;
+        }
+    }
+    for (unsigned n = 0; n < S; ++n)
+    {
+        shards[n]->live.store(shards[n]->size(), std::memory_order_relaxed);
+        shards[n]->inserts_since_check = 0;
+    }
+
+    // Other threads may still be looking at the old bounds
+    bounds_type *old = current_bounds.exchange(bounds, std::memory_order_acq_rel);
+    pin_type pin(domain);
+    domain.retire(pin.get(), old);
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
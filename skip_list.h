@@ -11,6 +11,8 @@
 #include <functional> // for std::less
 #include <iterator>   // for std::reverse_iterator
 #include <utility>    // for std::pair
+#include <algorithm>  // for std::set_union et al
+#include <vector>     // for partition
 
 //==============================================================================
 
@@ -28,11 +30,12 @@ namespace goodliffe {
 /// Internal namespace for impementation of skip list data structure
 namespace detail
 {
-    template <typename T,typename C,typename A,typename LG,bool D>
+    template <typename T,typename C,typename A,typename LG,bool D,typename L>
     class sl_impl;
 
     template <typename LIST> class sl_iterator;
     template <typename LIST> class sl_const_iterator;
+    template <typename LIST> class sl_append_iterator;
 }
 }
 
@@ -73,6 +76,11 @@ namespace goodliffe {
 ///                  Defaults to useing the less than operator.
 /// @param Allocator Template type for memory allocator for the contents of
 ///                  of the container. Defaults to a standard std::allocator
+/// @param LockingPolicy How the list may be shared between threads. The
+///                  default, single_threaded, does no locking at all. With
+///                  lazy_locking (see skip_list_lazy.h) insert, erase, count,
+///                  contains and find by value are safe to call from many
+///                  threads at once.
 ///
 /// @see multi_skip_list
 /// @see random_access_skip_list
@@ -80,11 +88,12 @@ template <typename T,
           typename Compare         = std::less<T>,
           typename Allocator       = std::allocator<T>,
           typename LevelGenerator  = detail::skip_list_level_generator<32>,
-          bool     AllowDuplicates = false>
+          bool     AllowDuplicates = false,
+          typename LockingPolicy   = detail::single_threaded>
 class skip_list
 {
 protected:
-    typedef typename detail::sl_impl<T,Compare,Allocator,LevelGenerator,AllowDuplicates> impl_type;
+    typedef typename detail::sl_impl<T,Compare,Allocator,LevelGenerator,AllowDuplicates,LockingPolicy> impl_type;
     typedef typename impl_type::node_type node_type;
 
     template <typename T1> friend class detail::sl_iterator;
@@ -104,17 +113,40 @@ public:
     typedef typename allocator_type::pointer            pointer;
     typedef typename allocator_type::const_pointer      const_pointer;
     typedef Compare                                     compare;
+    typedef LevelGenerator                              level_generator;
     
     typedef typename detail::sl_iterator<impl_type>     iterator;
     typedef typename iterator::const_iterator           const_iterator;
     typedef std::reverse_iterator<iterator>             reverse_iterator;
     typedef std::reverse_iterator<const_iterator>       const_reverse_iterator;
 
+#ifdef SKIP_LIST_CPP11
+    typedef detail::sl_node_handle<node_type,Allocator>                 node_handle;
+    typedef detail::sl_insert_return_type<iterator,node_handle>         insert_return_type;
+#endif
+
+    /// While a read_guard exists, elements erased from the list are not
+    /// destroyed, so a reader's iterators stay dereferenceable. It does
+    /// nothing under the single_threaded policy; it is for readers of a
+    /// list shared with another thread (see single_writer in
+    /// skip_list_rcu.h).
+    class read_guard
+    {
+    public:
+        explicit read_guard(const skip_list &list) : guard(list.impl.get_locking()) {}
+    private:
+        typename impl_type::locking_guard guard;
+    };
+
     //======================================================================
     // lifetime management
 
     explicit skip_list(const Allocator &alloc = Allocator());
 
+    /// An empty list that orders its elements with less. Copies of the list
+    /// keep it.
+    explicit skip_list(const Compare &less, const Allocator &alloc = Allocator());
+
     template <class InputIterator>
     skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator());
 
@@ -128,6 +160,9 @@ public:
 
     allocator_type get_allocator() const { return impl.get_allocator(); }
 
+    /// The comparator the list orders its elements with
+    compare value_comp() const { return impl.less; }
+
     //======================================================================
     // assignment
 
@@ -137,6 +172,12 @@ public:
     template <typename InputIterator>
     void assign(InputIterator first, InputIterator last);
 
+    /// Replaces the contents of the list with the range [first,last), which
+    /// must already be sorted. This builds the list in linear time, rather
+    /// than the O(N log N) of assign().
+    template <typename InputIterator>
+    void assign_sorted(InputIterator first, InputIterator last);
+
     //======================================================================
     // element access
 
@@ -194,6 +235,34 @@ public:
     iterator  erase(const_iterator position);
     iterator  erase(const_iterator first, const_iterator last);
 
+#ifdef SKIP_LIST_CPP11
+    /// Unlinks the element from the list and returns a handle owning it.
+    /// The element is neither copied nor deallocated.
+    node_handle extract(const_iterator position);
+    node_handle extract(const value_type &value);
+
+    /// Relinks an extracted element, keeping its existing allocation.
+    /// If an equivalent element is already present, the handle is returned
+    /// (still owning the element) in the result's node.
+    insert_return_type insert(node_handle &&handle);
+    iterator           insert(const_iterator hint, node_handle &&handle);
+#endif
+
+    /// Changes the value of the element at position in place, by calling
+    /// modifier(value), and then moves the element to its new place in the
+    /// list, as boost::multi_index's modify does.
+    ///
+    /// The element keeps its allocation; no copies are made. If the element
+    /// is still correctly ordered with respect to its neighbours this is an
+    /// O(1) operation, otherwise the new place is found by searching out from
+    /// the element's current position, so small moves are cheap.
+    ///
+    /// Returns true if the element is still in the list. If its new value is
+    /// equivalent to another element's, or if modifier throws, the element is
+    /// erased and false is returned (or the exception rethrown).
+    template <typename Modifier>
+    bool modify(const_iterator position, Modifier modifier);
+
     void swap(skip_list &other) { impl.swap(other.impl); }
 
     friend void swap(skip_list &lhs, skip_list &rhs) { lhs.swap(rhs); }
@@ -210,8 +279,87 @@ public:
     //======================================================================
     // other operations
 
+    /// Moves the elements of other into this list, in a single linear sweep
+    /// over both lists. No memory is allocated and no elements are copied;
+    /// iterators to moved elements remain valid, but now refer into this list.
+    ///
+    /// As with std::set::merge, an element of other that is equivalent to
+    /// one already in this list is left behind in other.
+    ///
+    /// Both lists must have equal allocators.
+    void merge(skip_list &other) { impl.merge(other.impl); }
+
+    /// Moves the elements that do not order before value to other, which
+    /// must be empty and have an equal allocator. No elements are copied:
+    /// the towers are cut at value, and their ends relinked to other, in
+    /// O(log N). Counting the elements that move, though, takes a walk over
+    /// whichever part is smaller. A deterministic_skip_list then rebuilds
+    /// the 1-2-3 levels of both lists, so there split costs O(N).
+    void split(const value_type &value, skip_list &other) { impl.split(value, other.impl); }
+
+    /// Moves all the elements of other, none of which may order before any
+    /// element of this list, onto the end of this list in O(log N), leaving
+    /// other empty. Both lists must have equal allocators. A
+    /// deterministic_skip_list then rebuilds its 1-2-3 levels, in O(N).
+    void join(skip_list &other) { impl.join(other.impl); }
+
+    /// Experimental: keeps a dense, sorted array of the values and nodes on
+    /// the top levels levels of the list (some 2^levels of them), which
+    /// searches binary search before following the links of the levels
+    /// below. A large list's upper levels then cost a few cache misses
+    /// rather than one per node visited. The array is rebuilt by an insert
+    /// or erase that reaches those levels, and by any merge, split, join or
+    /// swap, so costs O(2^levels) more for those. 0, the default, turns it
+    /// off.
+    ///
+    /// Searches only read the index, so several threads may still search a
+    /// list at once while nothing changes it. Lists with a locking policy
+    /// other than single_threaded, whose searches run alongside changes,
+    /// cannot have it.
+    void set_express_levels(unsigned levels) { impl.set_express_levels(levels); }
+    unsigned express_levels() const          { return impl.express_levels(); }
+
+    typedef std::pair<const_iterator,const_iterator> const_range;
+
+    /// Cuts the list into k consecutive ranges of about size()/k elements
+    /// each (for handing out to k threads, say), and writes them to out as
+    /// const_ranges, in order. The cuts are made at the towers of an upper
+    /// level of the list, so this takes O(k + log N) rather than a walk over
+    /// every element; the ranges are only as even as that level's towers
+    /// are spread. Some ranges are empty if there are fewer than k elements.
+    ///
+    /// @see parallel_for_each
+    template <typename OutputIterator>
+    void partition(size_type k, OutputIterator out) const;
+
+    /// Returns a new list holding the elements in either lhs or rhs (as
+    /// std::set_union). Built in linear time.
+    friend skip_list set_union(const skip_list &lhs, const skip_list &rhs)
+    {
+        skip_list result(lhs.get_allocator());
+        result.impl.assign_union(lhs.impl, rhs.impl);
+        return result;
+    }
+
+    /// Returns a new list holding the elements in both lhs and rhs (as
+    /// std::set_intersection). Built in linear time.
+    friend skip_list set_intersection(const skip_list &lhs, const skip_list &rhs)
+    {
+        skip_list result(lhs.get_allocator());
+        result.impl.assign_intersection(lhs.impl, rhs.impl);
+        return result;
+    }
+
+    /// Returns a new list holding the elements in lhs that are not in rhs (as
+    /// std::set_difference). Built in linear time.
+    friend skip_list set_difference(const skip_list &lhs, const skip_list &rhs)
+    {
+        skip_list result(lhs.get_allocator());
+        result.impl.assign_difference(lhs.impl, rhs.impl);
+        return result;
+    }
+
     // std::list has:
-    //   * merge
     //   * splice
     //   * remove
     //   * remove_if
@@ -225,18 +373,6 @@ public:
 protected:
     impl_type impl;
 
-    iterator to_iterator(node_type *node, const value_type &value)
-    {
-        return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less)
-            ? iterator(&impl, node)
-            : end();
-    }
-    const_iterator to_iterator(const node_type *node, const value_type &value) const
-    {
-        return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less)
-            ? const_iterator(&impl, node)
-            : end();
-    }
 };
     
 } // namespace goodliffe
@@ -284,11 +420,17 @@ public:
     typedef std::reverse_iterator<iterator>         reverse_iterator;
     typedef std::reverse_iterator<const_iterator>   const_reverse_iterator;
 
+#ifdef SKIP_LIST_CPP11
+    using typename parent_type::node_handle;
+#endif
+
     //======================================================================
     // lifetime management
     
     explicit multi_skip_list(const Allocator &alloc = Allocator())
         : parent_type(alloc) {}
+    explicit multi_skip_list(const Compare &less, const Allocator &alloc = Allocator())
+        : parent_type(less, alloc) {}
     template <class InputIterator>
     multi_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
         : parent_type(first, last, alloc) {}
@@ -296,6 +438,9 @@ public:
         : parent_type(other) {}
     multi_skip_list(const multi_skip_list &other, const Allocator &alloc)
         : parent_type(other, alloc) {}
+
+    multi_skip_list &operator=(const multi_skip_list &other)
+        { parent_type::operator=(other); return *this; }
     
     // C++11
     //multi_skip_list(const multi_skip_list &&other);
@@ -309,6 +454,13 @@ public:
     iterator  erase(const_iterator first, const_iterator last);
     using parent_type::erase;
 
+#ifdef SKIP_LIST_CPP11
+    /// Relinks an extracted element, keeping its existing allocation.
+    /// This always succeeds in a multi_skip_list.
+    iterator insert(node_handle &&handle);
+    using parent_type::insert;
+#endif
+
     //======================================================================
     // Additional "multi" operations
 
@@ -322,8 +474,52 @@ public:
 
     std::pair<iterator,iterator> equal_range(const value_type &value);
     std::pair<const_iterator,const_iterator> equal_range(const value_type &value) const;
+
+    //======================================================================
+    // Set algebra (with std::multiset semantics for repeated elements)
+
+    friend multi_skip_list set_union(const multi_skip_list &lhs, const multi_skip_list &rhs)
+    {
+        multi_skip_list result(lhs.get_allocator());
+        result.impl.assign_union(lhs.impl, rhs.impl);
+        return result;
+    }
+
+    friend multi_skip_list set_intersection(const multi_skip_list &lhs, const multi_skip_list &rhs)
+    {
+        multi_skip_list result(lhs.get_allocator());
+        result.impl.assign_intersection(lhs.impl, rhs.impl);
+        return result;
+    }
+
+    friend multi_skip_list set_difference(const multi_skip_list &lhs, const multi_skip_list &rhs)
+    {
+        multi_skip_list result(lhs.get_allocator());
+        result.impl.assign_difference(lhs.impl, rhs.impl);
+        return result;
+    }
 };
 
+#ifdef SKIP_LIST_CPP11
+
+/// A skip_list whose find, insert and erase are O(log N) in the worst case;
+/// see detail::deterministic_level_generator.
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+using deterministic_skip_list = skip_list<T,Compare,Allocator,
+                                          detail::deterministic_level_generator<32> >;
+
+/// A multi_skip_list whose find, insert and erase are O(log N) in the worst
+/// case; see detail::deterministic_level_generator.
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+using deterministic_multi_skip_list = multi_skip_list<T,Compare,Allocator,
+                                                      detail::deterministic_level_generator<32> >;
+
+#endif // SKIP_LIST_CPP11
+
 } // namespace goodliffe
 
 //==============================================================================
@@ -331,44 +527,44 @@ public:
 
 namespace goodliffe {
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator==(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator==(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return lhs.size() == rhs.size() && std::equal(lhs.begin(), lhs.end(), rhs.begin());
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator!=(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator!=(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return !operator==(lhs, rhs);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator<(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator<(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return std::lexicographical_compare(lhs.begin(), lhs.end(), rhs.begin(), rhs.end());
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator<=(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator<=(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return !(rhs < lhs);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator>(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator>(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return rhs < lhs;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-bool operator>=(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &rhs)
+bool operator>=(const skip_list<T,C,A,LG,D,L> &lhs, const skip_list<T,C,A,LG,D,L> &rhs)
 {
     return !(lhs < rhs);
 }
@@ -377,8 +573,8 @@ bool operator>=(const skip_list<T,C,A,LG,D> &lhs, const skip_list<T,C,A,LG,D> &r
 
 namespace std
 {
-    template <class T, class C, class A, class LG, bool D>
-    void swap(goodliffe::skip_list<T,C,A,LG,D> &lhs, goodliffe::skip_list<T,C,A,LG,D> &rhs)
+    template <class T, class C, class A, class LG, bool D, class L>
+    void swap(goodliffe::skip_list<T,C,A,LG,D,L> &lhs, goodliffe::skip_list<T,C,A,LG,D,L> &rhs)
     {
         lhs.swap(rhs);
     }
@@ -429,8 +625,8 @@ public:
     self_type operator--(int) // postdecrement
         { self_type old(*this); node = node->prev; return old; }
 
-    const_reference operator*()  { return node->value; }
-    const_pointer   operator->() { return node->value; }
+    const_reference operator*() const  { return node->value; }
+    const_pointer   operator->() const { return &node->value; }
     
     bool operator==(const self_type &other) const
         { return node == other.node; }
@@ -497,8 +693,8 @@ public:
     self_type operator--(int) // postdecrement
         { self_type old(*this); node = node->prev; return old; }
 
-    const_reference operator*()  { return node->value; }
-    const_pointer   operator->() { return node->value; }
+    const_reference operator*() const  { return node->value; }
+    const_pointer   operator->() const { return &node->value; }
 
     bool operator==(const self_type &other) const
         { return node == other.node; }
@@ -522,6 +718,38 @@ private:
     node_type *node;
 };
 
+/// An output iterator that appends values to the end of an sl_impl, in
+/// constant time per value. Values must be written in sorted order.
+///
+/// The chain records the last node at each level, and is shared by all
+/// copies of the iterator.
+///
+/// @internal
+template <class SL_IMPL>
+class sl_append_iterator
+    : public std::iterator<std::output_iterator_tag, void, void, void, void>
+{
+public:
+    typedef SL_IMPL                         impl_type;
+    typedef typename impl_type::node_type   node_type;
+    typedef typename impl_type::value_type  value_type;
+    typedef sl_append_iterator<impl_type>   self_type;
+
+    sl_append_iterator(impl_type *impl_, node_type **chain_)
+        : impl(impl_), chain(chain_) {}
+
+    self_type &operator=(const value_type &value)
+        { impl->append(value, chain); return *this; }
+
+    self_type &operator*()     { return *this; }
+    self_type &operator++()    { return *this; }
+    self_type &operator++(int) { return *this; }
+
+private:
+    impl_type  *impl;
+    node_type **chain;
+};
+
 } // namespace detail
 } // namespace goodliffe
 
@@ -531,36 +759,46 @@ private:
 
 namespace goodliffe {
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+skip_list<T,C,A,LG,D,L>::skip_list(const allocator_type &alloc_)
+:   impl(alloc_)
+{
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-skip_list<T,C,A,LG,D>::skip_list(const allocator_type &alloc_)
+skip_list<T,C,A,LG,D,L>::skip_list(const compare &less_, const allocator_type &alloc_)
 :   impl(alloc_)
 {
+    impl.less = less_;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 template <class InputIterator>
 inline
-skip_list<T,C,A,LG,D>::skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
+skip_list<T,C,A,LG,D,L>::skip_list(InputIterator first, InputIterator last, const allocator_type &alloc_)
 :   impl(alloc_)
 {
     assign(first, last);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-skip_list<T,C,A,LG,D>::skip_list(const skip_list &other)
+skip_list<T,C,A,LG,D,L>::skip_list(const skip_list &other)
 :   impl(other.get_allocator())
 {    
-    assign(other.begin(), other.end());
+    impl.less = other.impl.less;
+    assign_sorted(other.begin(), other.end());
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-skip_list<T,C,A,LG,D>::skip_list(const skip_list &other, const allocator_type &alloc_)
+skip_list<T,C,A,LG,D,L>::skip_list(const skip_list &other, const allocator_type &alloc_)
 :   impl(alloc_)
 {
-    assign(other.begin(), other.end());
+    impl.less = other.impl.less;
+    assign_sorted(other.begin(), other.end());
 }
 
 // C++11
@@ -571,60 +809,68 @@ skip_list<T,C,A,LG,D>::skip_list(const skip_list &other, const allocator_type &a
 //==============================================================================
 #pragma mark assignment
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-skip_list<T,C,A,LG,D> &
-skip_list<T,C,A,LG,D>::operator=(const skip_list<T,C,A,LG,D> &other)
+skip_list<T,C,A,LG,D,L> &
+skip_list<T,C,A,LG,D,L>::operator=(const skip_list<T,C,A,LG,D,L> &other)
 {
-    assign(other.begin(), other.end());
+    if (&other != this) assign_sorted(other.begin(), other.end());
     return *this;
 }
 
 //C++11 skip_list& operator=(skip_list&& other);
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 template <typename InputIterator>
 inline
-void skip_list<T,C,A,LG,D>::assign(InputIterator first, InputIterator last)
+void skip_list<T,C,A,LG,D,L>::assign(InputIterator first, InputIterator last)
 {
     clear();
     while (first != last) insert(*first++);
 }
 
+template <class T, class C, class A, class LG, bool D, class L>
+template <typename InputIterator>
+inline
+void skip_list<T,C,A,LG,D,L>::assign_sorted(InputIterator first, InputIterator last)
+{
+    impl.assign_sorted(first, last);
+}
+
 //==============================================================================
 #pragma mark element access
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::reference
-skip_list<T,C,A,LG,D>::front()
+typename skip_list<T,C,A,LG,D,L>::reference
+skip_list<T,C,A,LG,D,L>::front()
 {
     assert_that(!empty());
     return impl.front()->value;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::const_reference
-skip_list<T,C,A,LG,D>::front() const
+typename skip_list<T,C,A,LG,D,L>::const_reference
+skip_list<T,C,A,LG,D,L>::front() const
 {
     assert_that(!empty());
     return impl.front()->value;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::reference
-skip_list<T,C,A,LG,D>::back()
+typename skip_list<T,C,A,LG,D,L>::reference
+skip_list<T,C,A,LG,D,L>::back()
 {
     assert_that(!empty());
     return impl.one_past_end()->prev->value;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::const_reference
-skip_list<T,C,A,LG,D>::back() const
+typename skip_list<T,C,A,LG,D,L>::const_reference
+skip_list<T,C,A,LG,D,L>::back() const
 {
     assert_that(!empty());
     return impl.one_past_end()->prev->value;
@@ -633,26 +879,26 @@ skip_list<T,C,A,LG,D>::back() const
 //==============================================================================
 #pragma mark modifiers
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-void skip_list<T,C,A,LG,D>::clear()
+void skip_list<T,C,A,LG,D,L>::clear()
 {
     impl.remove_all();
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::insert_by_value_result
-skip_list<T,C,A,LG,D>::insert(const value_type &value)
+typename skip_list<T,C,A,LG,D,L>::insert_by_value_result
+skip_list<T,C,A,LG,D,L>::insert(const value_type &value)
 {
     node_type *node = impl.insert(value);
     return std::make_pair(iterator(&impl, node), impl.is_valid(node));
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::iterator
-skip_list<T,C,A,LG,D>::insert(const_iterator hint, const value_type &value)
+typename skip_list<T,C,A,LG,D,L>::iterator
+skip_list<T,C,A,LG,D,L>::insert(const_iterator hint, const value_type &value)
 {
     assert_that(hint.get_impl() == &impl);
     
@@ -666,11 +912,11 @@ skip_list<T,C,A,LG,D>::insert(const_iterator hint, const value_type &value)
 
 //C++11iterator insert const_iterator pos, value_type &&value);
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 template <class InputIterator>
 inline
 void
-skip_list<T,C,A,LG,D>::insert(InputIterator first, InputIterator last)
+skip_list<T,C,A,LG,D,L>::insert(InputIterator first, InputIterator last)
 {
     iterator last_inserted = end();
     while (first != last)
@@ -682,27 +928,18 @@ skip_list<T,C,A,LG,D>::insert(InputIterator first, InputIterator last)
 //C++11iterator insert(std::initializer_list<value_type> ilist);
 // C++11 emplace
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::size_type
-skip_list<T,C,A,LG,D>::erase(const value_type &value)
+typename skip_list<T,C,A,LG,D,L>::size_type
+skip_list<T,C,A,LG,D,L>::erase(const value_type &value)
 {
-    node_type *node = impl.find(value);
-    if (impl.is_valid(node) && detail::equivalent(node->value, value, impl.less))
-    {
-        impl.remove(node);
-        return 1;
-    }
-    else
-    {
-        return 0;
-    }
+    return impl.erase(value);
 }    
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::iterator
-skip_list<T,C,A,LG,D>::erase(const_iterator position)
+typename skip_list<T,C,A,LG,D,L>::iterator
+skip_list<T,C,A,LG,D,L>::erase(const_iterator position)
 {
     assert_that(position.get_impl() == &impl);
     assert_that(impl.is_valid(position.get_node()));
@@ -712,54 +949,156 @@ skip_list<T,C,A,LG,D>::erase(const_iterator position)
     return iterator(&impl, next);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::iterator
-skip_list<T,C,A,LG,D>::erase(const_iterator first, const_iterator last)
+typename skip_list<T,C,A,LG,D,L>::iterator
+skip_list<T,C,A,LG,D,L>::erase(const_iterator first, const_iterator last)
 {
     assert_that(first.get_impl() == &impl);
     assert_that(last.get_impl() == &impl);
 
-    if (first != last)
+    if (first.get_node() == impl.front())
+    {
+        impl.remove_front(const_cast<node_type*>(last.get_node()));
+    }
+    else if (first != last)
     {
         node_type *first_node = const_cast<node_type*>(first.get_node());
-        node_type *last_node  = const_cast<node_type*>(last.get_node()->prev);
+        node_type *last_node  = last.get_node()->prev;
         impl.remove_between(first_node, last_node);
     }
     
     return iterator(&impl, const_cast<node_type*>(last.get_node()));
 }
   
+#ifdef SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename skip_list<T,C,A,LG,D,L>::node_handle
+skip_list<T,C,A,LG,D,L>::extract(const_iterator position)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_node()));
+    node_type *node = const_cast<node_type*>(position.get_node());
+    impl.unlink(node);
+    return node_handle(node, impl.get_allocator());
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename skip_list<T,C,A,LG,D,L>::node_handle
+skip_list<T,C,A,LG,D,L>::extract(const value_type &value)
+{
+    const_iterator i = find(value);
+    return i != end() ? extract(i) : node_handle();
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename skip_list<T,C,A,LG,D,L>::insert_return_type
+skip_list<T,C,A,LG,D,L>::insert(node_handle &&handle)
+{
+    insert_return_type result = { end(), false, node_handle() };
+    if (handle.empty()) return result;
+
+    assert_that(handle.get_allocator() == get_allocator());
+    node_type *node = impl.link(handle.get_node());
+    result.position = iterator(&impl, node);
+    result.inserted = node == handle.get_node();
+    if (result.inserted)
+        handle.release();
+    else
+        result.node = std::move(handle);
+    return result;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename skip_list<T,C,A,LG,D,L>::iterator
+skip_list<T,C,A,LG,D,L>::insert(const_iterator hint, node_handle &&handle)
+{
+    assert_that(hint.get_impl() == &impl);
+    if (handle.empty()) return end();
+
+    assert_that(handle.get_allocator() == get_allocator());
+    const node_type *hint_node = hint.get_node();
+    if (impl.is_valid(hint_node) && detail::less_or_equal(handle.value(), hint_node->value, impl.less))
+        hint_node = 0; // bad hint, resort to "normal" insert
+
+    node_type *node = impl.link(handle.get_node(), const_cast<node_type*>(hint_node));
+    if (node == handle.get_node()) handle.release();
+    return iterator(&impl, node);
+}
+
+#endif // SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG, bool D, class L>
+template <typename Modifier>
+inline
+bool skip_list<T,C,A,LG,D,L>::modify(const_iterator position, Modifier modifier)
+{
+    assert_that(position.get_impl() == &impl);
+    assert_that(impl.is_valid(position.get_node()));
+    node_type *node = const_cast<node_type*>(position.get_node());
+
+    try
+    {
+        modifier(node->value);
+    }
+    catch (...)
+    {
+        impl.remove_unordered(node);
+        throw;
+    }
+
+    return impl.reposition(node);
+}
+
 //==============================================================================
 #pragma mark lookup
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::size_type
-skip_list<T,C,A,LG,D>::count(const value_type &value) const
+typename skip_list<T,C,A,LG,D,L>::size_type
+skip_list<T,C,A,LG,D,L>::count(const value_type &value) const
 {
-    const node_type *node = impl.find(value);
-    return impl.is_valid(node) && detail::equivalent(node->value, value, impl.less);
+    return impl.contains(value);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::iterator
-skip_list<T,C,A,LG,D>::find(const value_type &value)
+typename skip_list<T,C,A,LG,D,L>::iterator
+skip_list<T,C,A,LG,D,L>::find(const value_type &value)
 {
-    node_type *node = impl.find(value);
-    return to_iterator(node, value);
+    return iterator(&impl, impl.find_equivalent(value));
 }
   
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename skip_list<T,C,A,LG,D>::const_iterator
-skip_list<T,C,A,LG,D>::find(const value_type &value) const
+typename skip_list<T,C,A,LG,D,L>::const_iterator
+skip_list<T,C,A,LG,D,L>::find(const value_type &value) const
 {
-    const node_type *node = impl.find(value);
-    return to_iterator(node, value);
+    return const_iterator(&impl, impl.find_equivalent(value));
 }
-    
+
+//==============================================================================
+#pragma mark other operations
+
+template <class T, class C, class A, class LG, bool D, class L>
+template <typename OutputIterator>
+inline
+void skip_list<T,C,A,LG,D,L>::partition(size_type k, OutputIterator out) const
+{
+    if (!k) return;
+    std::vector<node_type*> bounds(k+1);
+    impl.partition(k, &bounds[0]);
+    for (size_type n = 0; n < k; ++n)
+    {
+        *out++ = const_range(const_iterator(&impl, bounds[n]), const_iterator(&impl, bounds[n+1]));
+    }
+}
+
 } // namespace goodliffe
 
 //==============================================================================
@@ -866,6 +1205,22 @@ multi_skip_list<T,C,A,LG>::erase(const value_type &value)
     return count;
 }
 
+#ifdef SKIP_LIST_CPP11
+
+template <class T, class C, class A, class LG>
+inline
+typename multi_skip_list<T,C,A,LG>::iterator
+multi_skip_list<T,C,A,LG>::insert(node_handle &&handle)
+{
+    if (handle.empty()) return this->end();
+
+    assert_that(handle.get_allocator() == this->get_allocator());
+    node_type *node = impl.link(handle.release());
+    return iterator(&impl, node);
+}
+
+#endif // SKIP_LIST_CPP11
+
 template <class T, class C, class A, class LG>
 inline
 typename multi_skip_list<T,C,A,LG>::iterator
@@ -873,6 +1228,13 @@ multi_skip_list<T,C,A,LG>::erase(const_iterator first, const_iterator last)
 {
     assert_that(first.get_impl() == &impl);
     assert_that(last.get_impl() == &impl);
+
+    // Trimming the front (say, of expired events) needs no searches at all
+    if (first.get_node() == impl.front())
+    {
+        impl.remove_front(const_cast<node_type*>(last.get_node()));
+        return iterator(&impl, const_cast<node_type*>(last.get_node()));
+    }
     
     while (first != last)
     {
@@ -893,18 +1255,147 @@ multi_skip_list<T,C,A,LG>::erase(const_iterator first, const_iterator last)
 namespace goodliffe {
 namespace detail {
 
-template <typename T>
-struct sl_node
+template <typename T, typename LockingPolicy = single_threaded>
+struct sl_node : LockingPolicy::template node_state<sl_node<T,LockingPolicy> >
 {
-    typedef sl_node<T> self_type;
+    typedef sl_node<T,LockingPolicy>                                    self_type;
+    typedef typename LockingPolicy::template link<self_type>::type      link_type;
 
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     unsigned    magic;
 #endif
     T           value;
     unsigned    level;
-    self_type  *prev;
-    self_type **next; ///< effectively node_type *next[level+1];
+    link_type   prev;
+    link_type  *next; ///< effectively link_type next[level+1];
+};
+
+/// Releases the memory for node, and its tower. Does not destroy the value.
+template <typename T, typename L, typename Allocator>
+inline
+void deallocate_node(Allocator &alloc, sl_node<T,L> *node)
+{
+    typedef typename Allocator::template rebind<sl_node<T,L> >::other                  node_allocator;
+    typedef typename Allocator::template rebind<typename sl_node<T,L>::link_type>::other list_allocator;
+
+    list_allocator(alloc).deallocate(node->next, node->level+1);
+    node_allocator(alloc).deallocate(node, 1);
+}
+
+/// An experimental, cache-conscious index over the express lanes of a
+/// skip list: the value and node of every node on its top levels, copied
+/// into a dense, sorted array. A search binary searches the array (which,
+/// at a few thousand entries, stays in cache) rather than chasing links
+/// from node to node through the upper levels, and then follows the links
+/// down through the levels below from the node it found.
+///
+/// The array holds exactly the nodes whose towers reach floor, in order:
+/// that level's list. It is thrown away whenever such a node is linked in,
+/// unlinked or changed, and rebuilt at the end of the operation that
+/// changed it, so it lasts between the rare changes to the upper levels
+/// and searches only ever read it.
+///
+/// @internal
+template <typename T, typename NodeType, typename Allocator>
+class sl_express_index
+{
+public:
+    static const unsigned out_of_date = ~0u;
+
+    sl_express_index(const Allocator &alloc_)
+    :   levels(0), floor(out_of_date), alloc(alloc_), entries(0), count(0), capacity(0) {}
+
+    ~sl_express_index()
+    {
+        clear();
+        if (entries) entry_allocator(alloc).deallocate(entries, capacity);
+    }
+
+    unsigned levels; ///< How many of the top levels to index; 0 for none
+    unsigned floor;  ///< The lowest level indexed, or out_of_date
+
+    bool is_current() const { return floor != out_of_date; }
+
+    /// Throws the index away if node's tower reaches the levels it covers.
+    void changed(const NodeType *node) { if (node->level >= floor) clear(); }
+
+    void clear()
+    {
+        for (size_t n = 0; n < count; ++n) entry_allocator(alloc).destroy(entries+n);
+        count = 0;
+        floor = out_of_date;
+    }
+
+    void push_back(const T &value, NodeType *node)
+    {
+        if (count == capacity) grow();
+        entry_allocator(alloc).construct(entries + count++, entry(value, node));
+    }
+
+    /// Returns the last indexed node not after value, or head if there is
+    /// none.
+    template <typename Compare>
+    NodeType *find(const T &value, const Compare &less, NodeType *head) const
+    {
+        if (!count) return head;
+        const entry *base = entries;
+        for (size_t n = count; n > 1; )
+        {
+            const size_t half = n/2;
+            base = less(value, base[half].value) ? base : base+half;
+            n   -= half;
+        }
+        // base only moves on to entries not after value
+        return less(value, base->value) ? head : base->node;
+    }
+
+    /// Checks that the index holds exactly the nodes linked at level floor,
+    /// from first, with their current values.
+    template <typename Compare>
+    bool matches(const NodeType *first, const NodeType *tail, const Compare &less) const
+    {
+        size_t n = 0;
+        for (const NodeType *node = first; node != tail; node = node->next[floor], ++n)
+        {
+            if (n == count || entries[n].node != node
+                || less(entries[n].value, node->value) || less(node->value, entries[n].value))
+            {
+                return false;
+            }
+        }
+        return n == count;
+    }
+
+private:
+    struct entry
+    {
+        entry(const T &value_, NodeType *node_) : value(value_), node(node_) {}
+        T         value;
+        NodeType *node;
+    };
+    typedef typename Allocator::template rebind<entry>::other entry_allocator;
+
+    sl_express_index(const sl_express_index &other);
+    sl_express_index &operator=(const sl_express_index &other);
+
+    void grow()
+    {
+        const size_t new_capacity = capacity ? capacity*2 : 64;
+        entry *grown = entry_allocator(alloc).allocate(new_capacity, (void*)0);
+        for (size_t n = 0; n < count; ++n)
+        {
+            entry_allocator(alloc).construct(grown+n, entries[n]);
+            entry_allocator(alloc).destroy(entries+n);
+        }
+        if (entries) entry_allocator(alloc).deallocate(entries, capacity);
+        entries  = grown;
+        capacity = new_capacity;
+    }
+
+    Allocator  alloc;
+    entry     *entries;
+    size_t     count;
+    size_t     capacity;
 };
 
 /// Internal implementation of skip_list data structure and methods for
@@ -914,7 +1405,7 @@ struct sl_node
 ///
 /// @internal
 template <typename T, typename Compare, typename Allocator,
-          typename LevelGenerator, bool AllowDuplicates>
+          typename LevelGenerator, bool AllowDuplicates, typename LockingPolicy>
 class sl_impl
 {
 public:
@@ -927,9 +1418,13 @@ public:
     typedef Allocator                           allocator_type;
     typedef Compare                             compare_type;
     typedef LevelGenerator                      generator_type;
-    typedef sl_node<T>                          node_type;
+    typedef LockingPolicy                       locking_policy;
+    typedef sl_node<T,LockingPolicy>            node_type;
+    typedef typename LockingPolicy::template list_state<node_type,sl_impl,Allocator> locking_state;
+    typedef typename locking_state::guard       locking_guard;
 
-    static const unsigned num_levels = LevelGenerator::num_levels;
+    static const unsigned num_levels    = LevelGenerator::num_levels;
+    static const bool     deterministic = sl_deterministic<LevelGenerator>::value;
 
     sl_impl(const Allocator &alloc = Allocator());
     ~sl_impl();
@@ -945,39 +1440,121 @@ public:
     const node_type *one_past_end() const                  { return tail; }
     node_type       *find(const value_type &value) const;
     node_type       *find_first(const value_type &value) const;
+    node_type       *find_equivalent(const value_type &value) const;
+    bool             contains(const value_type &value) const { return find_equivalent(value) != tail; }
     node_type       *insert(const value_type &value, node_type *hint = 0);
+    bool             erase(const value_type &value);
+    node_type       *link(node_type *node, node_type *hint = 0);
     void             remove(node_type *value);
+    void             unlink(node_type *node);
+    void             remove_unordered(node_type *node);
+    bool             reposition(node_type *node);
     void             remove_all();
     void             remove_between(node_type *first, node_type *last);
+    void             remove_front(node_type *last);
     void             swap(sl_impl &other);
     size_type        count(const value_type &value) const;
 
+    void             start_append(node_type **chain);
+    node_type       *append(const value_type &value, node_type **chain);
+    template <typename InputIterator>
+    void             assign_sorted(InputIterator first, InputIterator last);
+    void             assign_union(const sl_impl &lhs, const sl_impl &rhs);
+    void             assign_intersection(const sl_impl &lhs, const sl_impl &rhs);
+    void             assign_difference(const sl_impl &lhs, const sl_impl &rhs);
+    void             merge(sl_impl &other);
+    void             split(const value_type &value, sl_impl &other);
+    void             join(sl_impl &other);
+    template <typename OutputIterator>
+    size_type        sample(size_type count, OutputIterator out) const;
+    void             partition(size_type k, node_type **bounds) const;
+
     template <typename STREAM>
     void        dump(STREAM &stream) const;
     bool        check() const;
+    bool        check_balance() const;
     unsigned    new_level();
 
+    void        set_express_levels(unsigned levels);
+    unsigned    express_levels() const { return express.levels; }
+
+    /// Destroys and deallocates a node that is no longer in the list; used
+    /// by the locking policy for deferred reclamation.
+    void        reclaim(node_type *node);
+
+    locking_state &get_locking() const { return locking; }
+
     compare_type less;
 
 private:
-    typedef typename Allocator::template rebind<node_type>::other    node_allocator;
-    typedef typename Allocator::template rebind<node_type*>::other   list_allocator;
+    typedef typename node_type::link_type                                   link_type;
+    typedef typename Allocator::template rebind<node_type>::other           node_allocator;
+    typedef typename Allocator::template rebind<link_type>::other           list_allocator;
+    typedef sl_concurrency<LockingPolicy::is_concurrent>                    concurrency;
+
+    typedef sl_const_iterator<sl_impl>      const_iterator;
+    typedef sl_append_iterator<sl_impl>     append_iterator;
 
     sl_impl(const sl_impl &other);
     sl_impl &operator=(const sl_impl &other);
-    
+
+    const_iterator begin() const { return const_iterator(this, head->next[0]); }
+    const_iterator end() const   { return const_iterator(this, tail); }
+
+    void link_back(node_type *node, node_type **chain);
+    node_type *find_insert_chain(const value_type &value, node_type *hint, node_type **chain) const;
+    void link_after(node_type *node, node_type **chain);
+    void find_tower_chain(const node_type *node, node_type **chain) const;
+    void find_last_chain(node_type **chain) const;
+    unsigned sample_level(size_type count) const;
+    void unlink_after(node_type *node, node_type **chain);
+
+    // Keeping a deterministic list balanced
+    void find_chain_before(const node_type *node, node_type **chain) const;
+    void rebalance_after_link(node_type **chain);
+    void rebalance_after_unlink(node_type **chain);
+    void unlink_balanced(node_type *node);
+    void rebalance_all();
+    unsigned append_level();
+
+    void rebuild_express();
+
+    /// Rebuilds the express index if it is on and out of date. Every
+    /// operation that changes the list ends with this.
+    void refresh_express() { if (express.levels && !express.is_current()) rebuild_express(); }
+
+    // The operations a locking policy can make thread safe; the concurrent
+    // versions are defined alongside the policy
+    node_type *find_equivalent(const value_type &value, sl_concurrency<false>) const;
+    node_type *find_equivalent(const value_type &value, sl_concurrency<true>) const;
+    node_type *insert(const value_type &value, node_type *hint, sl_concurrency<false>);
+    node_type *insert(const value_type &value, node_type *hint, sl_concurrency<true>);
+    bool       erase(const value_type &value, sl_concurrency<false>);
+    bool       erase(const value_type &value, sl_concurrency<true>);
+    unsigned   new_level(sl_concurrency<false>);
+    unsigned   new_level(sl_concurrency<true>);
+    int        find_lazy_chain(const value_type &value, node_type **preds, node_type **succs) const;
+
+    typedef typename LockingPolicy::template counter<unsigned>::type  level_counter;
+    typedef typename LockingPolicy::template counter<size_type>::type item_counter;
+
     allocator_type  alloc;
     generator_type  generator;
-    unsigned        levels;
+    level_counter   levels;
     node_type      *head;
     node_type      *tail;
-    size_type       item_count;
+    item_counter    item_count;
+    mutable locking_state locking;
+
+    typedef sl_express_index<T,node_type,Allocator> express_index;
+    express_index   express;
     
     node_type *allocate(unsigned level)
     {
         node_type *node = node_allocator(alloc).allocate(1, (void*)0);
         node->next  = list_allocator(alloc).allocate(level+1, (void*)0);
         node->level = level;
+        node->init_state();
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
         for (unsigned n = 0; n <= level; ++n) node->next[n] = 0;
         node->magic = MAGIC_GOOD;
@@ -993,20 +1570,60 @@ private:
         for (unsigned n = 0; n <= node->level; ++n) node->next[n] = 0;
         node->prev = 0;
 #endif
+        deallocate_node(alloc, node);
+    }
+
+    /// Gives node a tower of level+1 links, keeping the links it shares
+    /// with its old one. Only a deterministic list changes the height of a
+    /// node once it has been linked in.
+    void set_level(node_type *node, unsigned level)
+    {
+        if (node->level >= express.floor || level >= express.floor) express.clear();
+
+        link_type *next = list_allocator(alloc).allocate(level+1, (void*)0);
+        for (unsigned l = 0; l <= level; ++l)
+        {
+            if (l <= node->level) next[l] = node->next[l];
+            else                  next[l] = tail;
+        }
         list_allocator(alloc).deallocate(node->next, node->level+1);
-        node_allocator(alloc).deallocate(node, 1);
+        node->next  = next;
+        node->level = level;
+    }
+
+    /// Raises node a level, linking it in after pred on the level above.
+    void raise(node_type *node, node_type *pred)
+    {
+        const unsigned l = node->level+1;
+        set_level(node, l);
+        node->next[l] = pred->next[l];
+        pred->next[l] = node;
+    }
+
+    /// Lowers node a level, unlinking it from after pred on its top level.
+    void lower(node_type *node, node_type *pred)
+    {
+        const unsigned l = node->level;
+        assert_that(l && pred->next[l] == node);
+        pred->next[l] = node->next[l];
+        set_level(node, l-1);
     }
 };
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-sl_impl<T,C,A,LG,D>::sl_impl(const allocator_type &alloc_)
+sl_impl<T,C,A,LG,D,L>::sl_impl(const allocator_type &alloc_)
 :   alloc(alloc_),
     levels(0),
     head(allocate(num_levels)),
     tail(allocate(num_levels)),
-    item_count(0)
+    item_count(0),
+    locking(*this, alloc_),
+    express(alloc_)
 {
+    // Towers change height under the feet of readers of a deterministic list
+    static_assert_that((!deterministic || sl_single_threaded<L>::value));
+
     for (unsigned n = 0; n < num_levels; n++)
     {
         head->next[n] = tail;
@@ -1016,19 +1633,19 @@ sl_impl<T,C,A,LG,D>::sl_impl(const allocator_type &alloc_)
     tail->prev = head;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-sl_impl<T,C,A,LG,D>::~sl_impl()
+sl_impl<T,C,A,LG,D,L>::~sl_impl()
 {
     remove_all();
     deallocate(head);
     deallocate(tail);
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename sl_impl<T,C,A,LG,D>::size_type
-sl_impl<T,C,A,LG,D>::count(const value_type &value) const
+typename sl_impl<T,C,A,LG,D,L>::size_type
+sl_impl<T,C,A,LG,D,L>::count(const value_type &value) const
 {
     // only used in multi_skip_lists
     impl_assert_that(D);
@@ -1057,30 +1674,43 @@ sl_impl<T,C,A,LG,D>::count(const value_type &value) const
     return count;
 }
 
-template <class T, class C, class A, class LG, bool D>
+/// Returns the last node not after value (or head, if there is none).
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename sl_impl<T,C,A,LG,D>::node_type *
-sl_impl<T,C,A,LG,D>::find(const value_type &value) const
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find(const value_type &value) const
 {
     // I could have an identical const and non-const overload,
     // but this cast is simpler (and safe)
     node_type *search = const_cast<node_type*>(head);
+    unsigned   l      = levels;
 
-    for (unsigned l = levels; l; )
+    if (express.is_current())
+    {
+        // The upper levels in one binary search. Only a search made in the
+        // middle of a change finds the index out of date, and goes by links.
+        search = express.find(value, less, search);
+        l      = express.floor;
+    }
+
+    while (l)
     {
         --l;
-        while (search->next[l] != tail && detail::less_or_equal(search->next[l]->value, value, less))
+        // Each link is read once, as a writer may change it (see single_writer)
+        for (;;)
         {
-            search = search->next[l];
+            node_type *next = search->next[l];
+            if (next == tail || !detail::less_or_equal(next->value, value, less)) break;
+            search = next;
         }
     }
     return search;
 }
     
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename sl_impl<T,C,A,LG,D>::node_type *
-sl_impl<T,C,A,LG,D>::find_first(const value_type &value) const
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find_first(const value_type &value) const
 {
     // only used in multi_skip_lists
     impl_assert_that(D);
@@ -1096,80 +1726,212 @@ sl_impl<T,C,A,LG,D>::find_first(const value_type &value) const
     return node;
 }
 
-template <class T, class C, class A, class LG, bool AllowDuplicates>
+/// Finds the insertion point for value, filling chain[l] with the node
+/// that will precede it at each level l < levels.
+/// Returns the level 0 predecessor.
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-typename sl_impl<T,C,A,LG,AllowDuplicates>::node_type*
-sl_impl<T,C,A,LG,AllowDuplicates>::insert(const value_type &value, node_type *hint)
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find_insert_chain(const value_type &value, node_type *hint, node_type **chain) const
 {
-    const unsigned level = new_level();
-
-    node_type *new_node = allocate(level);
-    assert_that(new_node);
-    assert_that(new_node->level == level);
-    alloc.construct(&new_node->value, value);
-
     const bool good_hint    = is_valid(hint) && hint->level == levels-1;
     node_type *insert_point = good_hint ? hint : head;
-    unsigned   l            = levels;
 
-    while (l)
+    for (unsigned l = levels; l; )
     {
         --l;
         assert_that(l <= insert_point->level);
-        while (insert_point->next[l] != tail && less(insert_point->next[l]->value, value))
-        {
-            insert_point = insert_point->next[l];
-            assert_that(l <= insert_point->level);
-        }
-        
-        if (l <= level)
+        for (;;)
         {
             node_type *next = insert_point->next[l];
-            assert_that(next);
-        
-            new_node->next[l]     = next;
-            insert_point->next[l] = new_node;
+            if (next == tail || !less(next->value, value)) break;
+            insert_point = next;
+            assert_that(l <= insert_point->level);
         }
+        chain[l] = insert_point;
     }
-    
+
     // By the time we get here, insert_point is the level 0 node immediately
-    // preceding new_node
-    assert_that(insert_point->next[0] == new_node);
-    node_type *next = new_node->next[0];
+    // preceding the new value's position
+    return insert_point;
+}
+
+/// Splices node into the list after the predecessors in chain.
+///
+/// Each of node's links is set before node is linked in at that level, so
+/// a reader never finds node only partly set up.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::link_after(node_type *node, node_type **chain)
+{
+    assert_that(node->level < levels);
+    express.changed(node);
+    node->prev = chain[0];
+    for (unsigned l = 0; l <= node->level; ++l)
+    {
+        node->next[l]     = chain[l]->next[l];
+        chain[l]->next[l] = node;
+    }
+
+    node_type *next = node->next[0];
     assert_that(next);
-    new_node->prev = insert_point;
-    next->prev = new_node;
+    next->prev = node;
 
     ++item_count;
-          
-#if defined SKIP_LIST_IMPL_DIAGNOSTICS
-      for (unsigned n = 0; n < level; ++n)
-      {
-          assert_that(new_node->next[n] != 0);
-      }
-#endif
 
-    // Do not allow repeated values in the list
-    if (!AllowDuplicates && next != tail && detail::equivalent(next->value, value, less))
+#if defined SKIP_LIST_IMPL_DIAGNOSTICS
+    for (unsigned n = 0; n < node->level; ++n)
     {
-        remove(new_node);
-        new_node = tail;
+        assert_that(node->next[n] != 0);
     }
-
-#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
-
-    return new_node;
 }
 
-template <class T, class C, class A, class LG, bool AllowDuplicates>
+/// Returns the node holding a value equivalent to value, or tail if there
+/// is none.
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-void
-sl_impl<T,C,A,LG,AllowDuplicates>::remove(node_type *node)
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find_equivalent(const value_type &value) const
 {
-    assert_that(is_valid(node));
+    return find_equivalent(value, concurrency());
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find_equivalent(const value_type &value, sl_concurrency<false>) const
+{
+    node_type *node = find(value);
+    return is_valid(node) && detail::equivalent(node->value, value, less) ? node : tail;
+}
+
+/// Returns the new node, or tail if the list does not allow duplicates and
+/// already holds an equivalent value.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename sl_impl<T,C,A,LG,D,L>::node_type*
+sl_impl<T,C,A,LG,D,L>::insert(const value_type &value, node_type *hint)
+{
+    return insert(value, hint, concurrency());
+}
+
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+typename sl_impl<T,C,A,LG,AllowDuplicates,L>::node_type*
+sl_impl<T,C,A,LG,AllowDuplicates,L>::insert(const value_type &value, node_type *hint, sl_concurrency<false>)
+{
+    const unsigned level = new_level();
+
+    node_type *chain[num_levels+1];
+    node_type *prev = find_insert_chain(value, hint, chain);
+
+    // Do not allow repeated values in the list
+    if (!AllowDuplicates && prev->next[0] != tail
+        && detail::equivalent(prev->next[0]->value, value, less))
+    {
+        return tail;
+    }
+
+    node_type *new_node = allocate(level);
+    assert_that(new_node);
+    assert_that(new_node->level == level);
+    alloc.construct(&new_node->value, value);
+
+    link_after(new_node, chain);
+    if (deterministic) rebalance_after_link(chain);
+    refresh_express();
+
+    return new_node;
+}
+
+/// Links an existing (unlinked) node into the list. The node keeps its
+/// level; if it came from a taller list, this list grows to accommodate it.
+/// Returns the node, or (if the list does not allow duplicates and already
+/// holds an equivalent value) that equivalent node, leaving node unlinked.
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+typename sl_impl<T,C,A,LG,AllowDuplicates,L>::node_type*
+sl_impl<T,C,A,LG,AllowDuplicates,L>::link(node_type *node, node_type *hint)
+{
+    assert_that(node && node->level <= num_levels);
+    if (deterministic && node->level) set_level(node, 0);
+    if (node->level >= levels) levels = node->level+1;
+
+    node_type *chain[num_levels+1];
+    node_type *prev = find_insert_chain(node->value, hint, chain);
+
+    if (!AllowDuplicates && prev->next[0] != tail
+        && detail::equivalent(prev->next[0]->value, node->value, less))
+    {
+        return prev->next[0];
+    }
+
+    link_after(node, chain);
+    if (deterministic) rebalance_after_link(chain);
+    refresh_express();
+
+    return node;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+bool
+sl_impl<T,C,A,LG,D,L>::erase(const value_type &value)
+{
+    return erase(value, concurrency());
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+bool
+sl_impl<T,C,A,LG,D,L>::erase(const value_type &value, sl_concurrency<false>)
+{
+    node_type *node = find(value);
+    if (is_valid(node) && detail::equivalent(node->value, value, less))
+    {
+        remove(node);
+        return true;
+    }
+    return false;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::remove(node_type *node)
+{
+    unlink(node);
+    locking.dispose(*this, node);
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::reclaim(node_type *node)
+{
+    alloc.destroy(&node->value);
+    deallocate(node);
+}
+
+/// Removes node from the list, without destroying it.
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+void
+sl_impl<T,C,A,LG,AllowDuplicates,L>::unlink(node_type *node)
+{
+    assert_that(is_valid(node));
     assert_that(node->next[0]);
+    express.changed(node);
+
+    if (deterministic)
+    {
+        unlink_balanced(node);
+        refresh_express();
+        return;
+    }
 
     node->next[0]->prev = node->prev;
 
@@ -1208,49 +1970,262 @@ sl_impl<T,C,A,LG,AllowDuplicates>::remove(node_type *node)
         }
     }
 
-    alloc.destroy(&node->value);
-    deallocate(node);
-
     item_count--;
+    refresh_express();
     
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG, bool D>
+/// Fills chain[l], for each level l of node's tower, with the node that
+/// precedes it at that level.
+///
+/// This walks back from node rather than searching from the head, so it
+/// does not rely on node's value being correctly ordered.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::find_tower_chain(const node_type *node, node_type **chain) const
+{
+    node_type *cur = node->prev;
+    for (unsigned l = 0; l <= node->level; ++l)
+    {
+        // head is taller than any node, so this always stops
+        while (cur->level < l) cur = cur->prev;
+        assert_that(cur->next[l] == node);
+        chain[l] = cur;
+    }
+}
+
+/// Removes node from the list, given its predecessors found by
+/// find_tower_chain. The inverse of link_after.
+template <class T, class C, class A, class LG, bool D, class L>
 inline
 void
-sl_impl<T,C,A,LG,D>::remove_all()
+sl_impl<T,C,A,LG,D,L>::unlink_after(node_type *node, node_type **chain)
 {
-    node_type *node = head->next[0];
-    while (node != tail)
+    express.changed(node);
+    for (unsigned l = 0; l <= node->level; ++l)
     {
-        node_type *next = node->next[0];
+        assert_that(chain[l]->next[l] == node);
+        chain[l]->next[l] = node->next[l];
+    }
+    node->next[0]->prev = chain[0];
+
+    item_count--;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+/// Removes and destroys node, locating it by position rather than by value.
+/// For use when node's value may no longer be correctly ordered.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::remove_unordered(node_type *node)
+{
+    assert_that(is_valid(node));
+
+    if (deterministic)
+    {
+        // unlink goes by position there
+        unlink(node);
+    }
+    else
+    {
+        node_type *chain[num_levels+1];
+        find_tower_chain(node, chain);
+        unlink_after(node, chain);
+        refresh_express();
+    }
+    alloc.destroy(&node->value);
+    deallocate(node);
+}
+
+/// Moves node, whose value has been changed in place, to the correct
+/// position for its new value.
+///
+/// If node is still ordered with respect to its neighbours, nothing is done.
+/// Otherwise it is unlinked and relinked (keeping its level) after a finger
+/// search from its old position:
+///   - moving forwards, the search climbs up the levels from the old
+///     position until it overshoots the new value, and then descends. This
+///     is O(log d) for a move of d places.
+///   - moving backwards, there are no backward links above level 0, so the
+///     search starts from the lowest of node's old predecessors that
+///     precedes the new value. If the move takes the node beyond the reach of
+///     its own tower we fall back to searching from the head.
+///
+/// Returns false if the list does not allow duplicates and the new value is
+/// equivalent to an existing one; the node is then destroyed.
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+bool
+sl_impl<T,C,A,LG,AllowDuplicates,L>::reposition(node_type *node)
+{
+    assert_that(is_valid(node));
+    express.changed(node);
+
+    const value_type &value  = node->value;
+    const node_type  *prev   = node->prev;
+    const node_type  *next   = node->next[0];
+
+    const bool after_prev  = prev == head
+        || (AllowDuplicates ? !less(value, prev->value) : less(prev->value, value));
+    const bool before_next = next == tail
+        || (AllowDuplicates ? !less(next->value, value) : less(value, next->value));
+
+    if (after_prev && before_next)
+    {
+        // The value has changed, if not the order
+        refresh_express();
+        return true;
+    }
+
+    if (deterministic)
+    {
+        // A deterministic list is rebalanced by unlinking by position and
+        // relinking by value; there are no towers to reuse
+        unlink(node);
+        if (link(node) == node) return true;
         alloc.destroy(&node->value);
         deallocate(node);
-        node = next;
+        return false;
+    }
+
+    node_type *chain[num_levels+1];
+    find_tower_chain(node, chain);
+    unlink_after(node, chain);
+
+    if (before_next)
+    {
+        // Moving backwards
+        unsigned l = 1;
+        while (l <= node->level && chain[l] != head && !less(chain[l]->value, value))
+        {
+            ++l;
+        }
+
+        if (l > node->level)
+        {
+            find_insert_chain(value, 0, chain);
+        }
+        else
+        {
+            // chain[l] and above are still correct; descend for the rest
+            node_type *cur = chain[l];
+            while (l)
+            {
+                --l;
+                while (cur->next[l] != tail && less(cur->next[l]->value, value))
+                {
+                    cur = cur->next[l];
+                }
+                chain[l] = cur;
+            }
+        }
     }
+    else
+    {
+        // Moving forwards: chain[l] for levels above the one we climb to are
+        // the last nodes of that height we pass on the way
+        node_type *cur = chain[0];
+        unsigned   l   = 0;
+        for (;;)
+        {
+            node_type *next = cur->next[l];
+            if (next == tail || !less(next->value, value)) break;
 
+            if (cur->level > l && l+1 < levels)
+            {
+                ++l;
+            }
+            else
+            {
+                cur = next;
+                const unsigned top = cur->level < node->level ? cur->level : node->level;
+                for (unsigned h = l+1; h <= top; ++h) chain[h] = cur;
+            }
+        }
+
+        chain[l] = cur;
+        while (l)
+        {
+            --l;
+            while (cur->next[l] != tail && less(cur->next[l]->value, value))
+            {
+                cur = cur->next[l];
+            }
+            chain[l] = cur;
+        }
+    }
+
+    node_type *after = chain[0]->next[0];
+    if (!AllowDuplicates && after != tail && detail::equivalent(after->value, value, less))
+    {
+        refresh_express();
+        alloc.destroy(&node->value);
+        deallocate(node);
+        return false;
+    }
+
+    link_after(node, chain);
+    refresh_express();
+    return true;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::remove_all()
+{
+    // Empty the list before disposing of the nodes, in case they outlive
+    // this (see single_writer)
+    node_type *node = head->next[0];
+    express.clear();
     for (unsigned l = 0; l < num_levels; ++l)
         head->next[l] = tail;
     tail->prev = head;
     item_count = 0;
+    if (deterministic) levels = 0;
+
+    while (node != tail)
+    {
+        node_type *next = node->next[0];
+        locking.dispose(*this, node);
+        node = next;
+    }
+    refresh_express();
         
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
 void 
-sl_impl<T,C,A,LG,D>::remove_between(node_type *first, node_type *last)
+sl_impl<T,C,A,LG,D,L>::remove_between(node_type *first, node_type *last)
 {
     assert_that(is_valid(first));
     assert_that(is_valid(last));
     assert_that(!D);
 
+    if (deterministic)
+    {
+        // Each erase keeps the list balanced
+        for (node_type *end = last->next[0]; first != end; )
+        {
+            node_type *next = first->next[0];
+            remove(first);
+            first = next;
+        }
+        return;
+    }
+
     node_type       * const prev         = first->prev;
     node_type       * const one_past_end = last->next[0];
     const value_type       &first_value  = first->value;
@@ -1284,20 +2259,454 @@ sl_impl<T,C,A,LG,D>::remove_between(node_type *first, node_type *last)
     while (first != one_past_end)
     {
         node_type *next = first->next[0];
-        alloc.destroy(&first->value);
-        deallocate(first);
+        express.changed(first);
+        locking.dispose(*this, first);
+        item_count--;
+        first = next;
+    }
+    refresh_express();
+    
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+/// Removes every node before last (which may be the tail). The nodes that
+/// stay are found by climbing from last rather than by a search, as the
+/// only links to change are the head's: each is relinked to the first node
+/// at or after last that is tall enough. So this costs O(levels), plus the
+/// nodes removed, and works as well with repeated values.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void
+sl_impl<T,C,A,LG,D,L>::remove_front(node_type *last)
+{
+    assert_that(last == tail || is_valid(last));
+
+    node_type *first = head->next[0];
+    if (first == last) return;
+
+    if (deterministic)
+    {
+        while (head->next[0] != last) remove(head->next[0]);
+        return;
+    }
+
+    node_type *cur = last;
+    for (unsigned l = 0; l < levels; ++l)
+    {
+        // tail is taller than any node, so this always stops
+        while (cur->level < l) cur = cur->next[cur->level];
+        head->next[l] = cur;
+    }
+    last->prev = head;
+
+    while (first != last)
+    {
+        node_type *next = first->next[0];
+        express.changed(first);
+        locking.dispose(*this, first);
         item_count--;
         first = next;
     }
+    refresh_express();
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+//==============================================================================
+#pragma mark linear-time building
+
+/// Prepares the list for a series of append() calls: empties the list, and
+/// sets up the chain (which must have room for num_levels+1 nodes).
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::start_append(node_type **chain)
+{
+    remove_all();
+    for (unsigned l = 0; l <= num_levels; ++l) chain[l] = head;
+}
+
+/// Links an existing node onto the end of the list described by chain.
+/// The node keeps its level. The caller must terminate the list with tail.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::link_back(node_type *node, node_type **chain)
+{
+    express.changed(node);
+    node->prev = chain[0];
+    for (unsigned l = 0; l <= node->level; ++l)
+    {
+        chain[l]->next[l] = node;
+        chain[l]          = node;
+    }
+}
+
+/// Appends a value to the end of the list in constant time, without
+/// searching. The value must not order before the current back() of the
+/// list. In a list without duplicates, a value equivalent to the back() is
+/// ignored and tail is returned.
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+typename sl_impl<T,C,A,LG,AllowDuplicates,L>::node_type *
+sl_impl<T,C,A,LG,AllowDuplicates,L>::append(const value_type &value, node_type **chain)
+{
+    node_type *back = chain[0];
+    assert_that(back == head || detail::less_or_equal(back->value, value, less));
+
+    if (!AllowDuplicates && back != head && !less(back->value, value))
+        return tail;
+
+    const unsigned old_levels = levels;
+    const unsigned level      = deterministic ? append_level() : new_level();
+    node_type *new_node       = allocate(level);
+    try
+    {
+        alloc.construct(&new_node->value, value);
+    }
+    catch (...)
+    {
+        deallocate(new_node);
+        levels = old_levels;
+        throw;
+    }
+
+    link_back(new_node, chain);
+    for (unsigned l = 0; l <= level; ++l) new_node->next[l] = tail;
+    tail->prev = new_node;
+
+    ++item_count;
+
+    return new_node;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+template <typename InputIterator>
+inline
+void sl_impl<T,C,A,LG,D,L>::assign_sorted(InputIterator first, InputIterator last)
+{
+    node_type *chain[num_levels+1];
+    start_append(chain);
+    std::copy(first, last, append_iterator(this, chain));
+    refresh_express();
     
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::assign_union(const sl_impl &lhs, const sl_impl &rhs)
+{
+    assert_that(&lhs != this && &rhs != this);
+    node_type *chain[num_levels+1];
+    start_append(chain);
+    std::set_union(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                   append_iterator(this, chain), less);
+    refresh_express();
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::assign_intersection(const sl_impl &lhs, const sl_impl &rhs)
+{
+    assert_that(&lhs != this && &rhs != this);
+    node_type *chain[num_levels+1];
+    start_append(chain);
+    std::set_intersection(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                          append_iterator(this, chain), less);
+    refresh_express();
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::assign_difference(const sl_impl &lhs, const sl_impl &rhs)
+{
+    assert_that(&lhs != this && &rhs != this);
+    node_type *chain[num_levels+1];
+    start_append(chain);
+    std::set_difference(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                        append_iterator(this, chain), less);
+    refresh_express();
+}
+
+/// Relinks every node of both lists in a single sorted sweep. Nodes keep
+/// their levels, so the towers are rebuilt without allocating.
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+void sl_impl<T,C,A,LG,AllowDuplicates,L>::merge(sl_impl &other)
+{
+    assert_that(alloc == other.alloc);
+    if (&other == this) return;
+
+    express.clear();
+    other.express.clear();
+
+    node_type *chain[num_levels+1];
+    node_type *other_chain[num_levels+1];
+    for (unsigned l = 0; l <= num_levels; ++l)
+    {
+        chain[l]       = head;
+        other_chain[l] = other.head;
+    }
+
+    node_type *a     = head->next[0];
+    node_type *b     = other.head->next[0];
+    size_type  moved = 0;
+
+    while (a != tail || b != other.tail)
+    {
+        if (b == other.tail || (a != tail && !less(b->value, a->value)))
+        {
+            // Equivalent values: ours goes first. Without duplicates, theirs
+            // stays put.
+            if (!AllowDuplicates && b != other.tail && !less(a->value, b->value))
+            {
+                node_type *next = b->next[0];
+                other.link_back(b, other_chain);
+                b = next;
+            }
+            node_type *next = a->next[0];
+            link_back(a, chain);
+            a = next;
+        }
+        else
+        {
+            node_type *next = b->next[0];
+            link_back(b, chain);
+            b = next;
+            ++moved;
+        }
+    }
+
+    for (unsigned l = 0; l <= num_levels; ++l)
+    {
+        chain[l]->next[l]       = tail;
+        other_chain[l]->next[l] = other.tail;
+    }
+    tail->prev       = chain[0];
+    other.tail->prev = other_chain[0];
+
+    item_count       += moved;
+    other.item_count -= moved;
+    if (other.levels > levels) levels = other.levels;
+
+    if (deterministic)
+    {
+        rebalance_all();
+        other.rebalance_all();
+    }
+    refresh_express();
+    other.refresh_express();
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+    other.check();
+#endif
+}
+
+//==============================================================================
+#pragma mark splitting and joining
+
+/// Fills chain[l], for every level l, with the last node at that level (or
+/// head, if there is none).
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::find_last_chain(node_type **chain) const
+{
+    node_type *cur = head;
+    for (unsigned l = num_levels; l > levels; ) chain[--l] = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != tail) cur = cur->next[l];
+        chain[l] = cur;
+    }
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::split(const value_type &value, sl_impl &other)
+{
+    assert_that(&other != this);
+    assert_that(other.item_count == 0);
+    assert_that(alloc == other.alloc);
+
+    node_type *chain[num_levels+1];
+    node_type *last[num_levels+1];
+    find_insert_chain(value, 0, chain);
+    for (unsigned l = levels; l < num_levels; ++l) chain[l] = head;
+
+    node_type *first = chain[0]->next[0];
+    if (first == tail) return;
+
+    express.clear();
+    other.express.clear();
+
+    // Count whichever side of the cut is smaller
+    size_type kept  = 0;
+    size_type moved = 0;
+    for (node_type *a = head->next[0], *b = first; ; a = a->next[0], b = b->next[0])
+    {
+        if (a == first) { moved = item_count - kept; break; }
+        if (b == tail)  { break; }
+        ++kept;
+        ++moved;
+    }
+
+    // Each level that reaches past the cut is handed over from the cut to
+    // its last node
+    find_last_chain(last);
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        node_type *after = chain[l]->next[l];
+        if (after == tail) continue;
+        other.head->next[l] = after;
+        last[l]->next[l]    = other.tail;
+        chain[l]->next[l]   = tail;
+    }
+    other.tail->prev = tail->prev;
+    first->prev      = other.head;
+    tail->prev       = chain[0];
+
+    item_count       -= moved;
+    other.item_count  = moved;
+    other.levels      = levels;
+
+    if (deterministic)
+    {
+        rebalance_all();
+        other.rebalance_all();
+    }
+    refresh_express();
+    other.refresh_express();
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+    other.check();
+#endif
+}
+
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+void sl_impl<T,C,A,LG,AllowDuplicates,L>::join(sl_impl &other)
+{
+    assert_that(&other != this);
+    assert_that(alloc == other.alloc);
+    if (other.item_count == 0) return;
+
+    express.clear();
+    other.express.clear();
+
+    node_type *first = other.head->next[0];
+    assert_that(item_count == 0 || (AllowDuplicates
+        ? detail::less_or_equal(tail->prev->value, first->value, less)
+        : less(tail->prev->value, first->value)));
+
+    node_type *last[num_levels+1];
+    node_type *other_last[num_levels+1];
+    find_last_chain(last);
+    other.find_last_chain(other_last);
+    for (unsigned l = 0; l < num_levels; ++l)
+    {
+        node_type *after = other.head->next[l];
+        if (after == other.tail) continue;
+        last[l]->next[l]       = after;
+        other_last[l]->next[l] = tail;
+        other.head->next[l]    = other.tail;
+    }
+    first->prev      = last[0];
+    tail->prev       = other.tail->prev;
+    other.tail->prev = other.head;
+
+    item_count       += other.item_count;
+    other.item_count  = 0;
+    if (other.levels > levels) levels = other.levels;
+
+    if (deterministic) rebalance_all();
+    refresh_express();
+    other.refresh_express();
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+    other.check();
+#endif
+}
+
+/// Writes out the values of roughly count elements (between count and
+/// 4*count, if the list is big enough), evenly spread through the list,
+/// without visiting them all: it walks the level at which about that many
+/// nodes remain. Returns the number written; each stands for about
+/// size()/that many elements.
+template <class T, class C, class A, class LG, bool D, class L>
+template <typename OutputIterator>
 inline
-unsigned sl_impl<T,C,A,LG,D>::new_level()
+typename sl_impl<T,C,A,LG,D,L>::size_type
+sl_impl<T,C,A,LG,D,L>::sample(size_type count, OutputIterator out) const
+{
+    const unsigned l = sample_level(count);
+
+    size_type written = 0;
+    for (const node_type *node = head->next[l]; node != tail; node = node->next[l])
+    {
+        *out++ = node->value;
+        ++written;
+    }
+    return written;
+}
+
+/// The lowest level with no more than about 4*count nodes on it (or the
+/// top level, if none has so few).
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+unsigned sl_impl<T,C,A,LG,D,L>::sample_level(size_type count) const
+{
+    // Each level holds about half the nodes of the one below
+    unsigned l = 0;
+    for (size_type n = item_count; n/2 >= count*2 && l+1 < levels; n /= 2) ++l;
+    return l;
+}
+
+/// Fills bounds[0..k] with the nodes at which each of k ranges starts (and
+/// bounds[k] with the tail), picking evenly spaced nodes from a level
+/// chosen as for sample(), with about 16 nodes per range so that the
+/// ranges even out. Only that level is walked.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::partition(size_type k, node_type **bounds) const
+{
+    assert_that(k > 0);
+    const unsigned l = sample_level(k*4);
+
+    size_type m = 0;
+    for (const node_type *node = head->next[l]; node != tail; node = node->next[l]) ++m;
+
+    // Range n starts at the (n*m/k)th node of level l; when that is the
+    // first, it starts at the front, with all the ranges before it empty
+    node_type *node = head->next[l];
+    size_type  i    = 0;
+    bounds[0] = head->next[0];
+    for (size_type n = 1; n < k; ++n)
+    {
+        for (; i < n*m/k; ++i) node = node->next[l];
+        bounds[n] = i ? node : head->next[0];
+    }
+    bounds[k] = tail;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+unsigned sl_impl<T,C,A,LG,D,L>::new_level()
+{
+    return new_level(concurrency());
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+unsigned sl_impl<T,C,A,LG,D,L>::new_level(sl_concurrency<false>)
 {    
     unsigned level = generator.new_level();
     if (level >= levels)
@@ -1308,9 +2717,9 @@ unsigned sl_impl<T,C,A,LG,D>::new_level()
     return level;
 }
 
-template <class T, class C, class A, class LG, bool D>
+template <class T, class C, class A, class LG, bool D, class L>
 inline
-void sl_impl<T,C,A,LG,D>::swap(sl_impl &other)
+void sl_impl<T,C,A,LG,D,L>::swap(sl_impl &other)
 {
     using std::swap;
 
@@ -1322,16 +2731,22 @@ void sl_impl<T,C,A,LG,D>::swap(sl_impl &other)
     swap(tail,       other.tail);
     swap(item_count, other.item_count);
 
+    // Each list keeps its own express_levels
+    express.clear();
+    other.express.clear();
+    refresh_express();
+    other.refresh_express();
+
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
     check();
 #endif
 }
 
 // for diagnostics only
-template <class T, class C, class A, class LG, bool AllowDuplicates>
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
 template <class STREAM>
 inline
-void sl_impl<T,C,A,LG,AllowDuplicates>::dump(STREAM &s) const
+void sl_impl<T,C,A,LG,AllowDuplicates,L>::dump(STREAM &s) const
 {
     s << "skip_list(size="<<item_count<<",levels=" << levels << ")\n";
     for (unsigned l = 0; l < levels+1; ++l)
@@ -1378,9 +2793,9 @@ void sl_impl<T,C,A,LG,AllowDuplicates>::dump(STREAM &s) const
 
 #ifdef SKIP_LIST_IMPL_DIAGNOSTICS
 // for diagnostics only
-template <class T, class C, class A, class LG, bool AllowDuplicates>
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
 inline
-bool sl_impl<T,C,A,LG,AllowDuplicates>::check() const
+bool sl_impl<T,C,A,LG,AllowDuplicates,L>::check() const
 {
     for (unsigned l = 0; l < levels; ++l)
     {
@@ -1427,6 +2842,300 @@ bool sl_impl<T,C,A,LG,AllowDuplicates>::check() const
             return false;
         }
     }
+
+    if (express.is_current() && !express.matches(head->next[express.floor], tail, less))
+    {
+        assert_that(false && "express index error");
+        dump(std::cerr);
+        return false;
+    }
+    return true;
+}
+#endif
+
+//==============================================================================
+#pragma mark express index
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::set_express_levels(unsigned levels_)
+{
+    // Changes rebuild the index in place, so must not race with searches
+    static_assert_that(sl_single_threaded<L>::value);
+
+    express.clear();
+    express.levels = levels_ < num_levels ? levels_ : num_levels;
+    refresh_express();
+}
+
+/// Copies the nodes on the top express.levels levels in use into the
+/// index: they are all on the lowest of those levels, in order.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::rebuild_express()
+{
+    express.clear();
+
+    const unsigned floor = levels > express.levels ? levels - express.levels : 0;
+    for (node_type *node = head->next[floor]; node != tail; node = node->next[floor])
+    {
+        express.push_back(node->value, node);
+    }
+    express.floor = floor;
+}
+
+//==============================================================================
+#pragma mark deterministic balancing
+
+/// Fills chain[l], for every level l, with the last node on that level
+/// before node. This goes by node identity, with no comparisons, so works
+/// for a node whose value has been changed and among any number of
+/// equivalent values. Climbing forwards from node finds succ[l], the first
+/// node on level l after node's predecessor; then, descending from the
+/// top, chain[l] is the node on level l whose next is succ[l]. Each step
+/// crosses a gap of at most three nodes, so this is O(log N).
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::find_chain_before(const node_type *node, node_type **chain) const
+{
+    for (unsigned l = 0; l <= num_levels; ++l) chain[l] = head;
+
+    if (node->prev == head) return;
+
+    node_type *succ[num_levels];
+    succ[0] = const_cast<node_type*>(node);
+    for (unsigned l = 1; l < levels; ++l)
+    {
+        // tail is taller than any node, so this always stops
+        node_type *cur = succ[l-1];
+        while (cur->level < l) cur = cur->next[l-1];
+        succ[l] = cur;
+    }
+
+    node_type *cur = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        while (cur->next[l] != succ[l]) cur = cur->next[l];
+        chain[l] = cur;
+    }
+    assert_that(chain[0] == node->prev);
+}
+
+/// Restores a deterministic list's balance after a node has been linked in
+/// at level 0 after the predecessors in chain. Working up from the bottom,
+/// a gap that has grown to four nodes is split by raising its second node,
+/// which then joins the gap above; a split at the top adds a level. That
+/// is O(1) per level.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::rebalance_after_link(node_type **chain)
+{
+    for (unsigned l = levels; l <= num_levels; ++l) chain[l] = head;
+
+    for (unsigned l = 0; l+1 < num_levels; ++l)
+    {
+        // The gap on level l that gained a node lies between chain[l+1]
+        // and the next node of level l+1 or above
+        node_type *left  = chain[l+1];
+        node_type *right = left->next[l+1];
+        node_type *gap[4];
+        unsigned   size  = 0;
+        for (node_type *n = left->next[l]; n != right && size < 4; n = n->next[l])
+        {
+            gap[size++] = n;
+        }
+        if (size < 4) break;
+
+        raise(gap[1], left);
+        if (l+1 == levels) ++levels;
+    }
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check_balance();
+#endif
+}
+
+/// Restores a deterministic list's balance after a level 0 node has been
+/// unlinked from after the predecessors in chain. Working up from the
+/// bottom, a gap that has emptied takes a node from a neighbouring gap
+/// under the same parent (lowering the node between them, and raising the
+/// neighbour's end node in its place) if that has two or more; otherwise
+/// it merges with the neighbour, by lowering the node between them, and
+/// the parent gap has lost a node. That is O(1) per level.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::rebalance_after_unlink(node_type **chain)
+{
+    for (unsigned l = 0; l+1 < levels; ++l)
+    {
+        node_type *left  = chain[l+1];
+        node_type *right = left->next[l+1];
+
+        // Only the last gap on a level may be empty
+        if (left->next[l] != right || right == tail) break;
+
+        // The parent gap is not the last on its level, so is not empty:
+        // one of the nodes either side of this gap is in it
+        if (right->level == l+1)
+        {
+            node_type *first = right->next[l];
+            node_type *end   = right->next[l+1];
+            const bool take  = first != end && first->next[l] != end;
+
+            lower(right, left);
+            if (take)
+            {
+                raise(first, left);
+                break;
+            }
+        }
+        else
+        {
+            assert_that(left != head && left->level == l+1);
+
+            node_type *before = chain[l+2];
+            while (before->next[l+1] != left) before = before->next[l+1];
+            node_type *last = before;
+            while (last->next[l] != left) last = last->next[l];
+            assert_that(last != before);
+            const bool take = before->next[l] != last;
+
+            lower(left, before);
+            if (take)
+            {
+                raise(last, before);
+                break;
+            }
+        }
+    }
+
+    // A top level that has emptied is dropped
+    while (levels && head->next[levels-1] == tail) --levels;
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check_balance();
+#endif
+}
+
+/// Removes node from a deterministic list, without destroying it. A node
+/// with a tower hands it to its predecessor, which is always a level 0
+/// node, and leaves with the predecessor's: so, either way, a single level
+/// 0 node leaves its gap.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::unlink_balanced(node_type *node)
+{
+    node_type *chain[num_levels+1];
+    find_chain_before(node, chain);
+
+    node_type *prev = chain[0];
+    assert_that(prev == node->prev);
+    prev->next[0]       = node->next[0];
+    node->next[0]->prev = prev;
+
+    if (node->level)
+    {
+        assert_that(prev != head && prev->level == 0);
+        for (unsigned l = 1; l <= node->level; ++l)
+        {
+            assert_that(chain[l]->next[l] == node);
+            chain[l]->next[l] = prev;
+        }
+        std::swap(prev->next,  node->next);
+        std::swap(prev->level, node->level);
+    }
+
+    item_count--;
+    rebalance_after_unlink(chain);
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check();
+#endif
+}
+
+/// The level append gives a node in a deterministic list: the number of
+/// times two divides its position, so that every gap holds one node.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+unsigned sl_impl<T,C,A,LG,D,L>::append_level()
+{
+    unsigned level = 0;
+    for (size_type n = item_count+1; !(n & 1) && level+1 < num_levels; n >>= 1) ++level;
+    if (level >= levels) levels = level+1;
+    return level;
+}
+
+/// Gives every node of a deterministic list the level append would have,
+/// in one walk, after merge, split or join have cut and spliced its towers.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+void sl_impl<T,C,A,LG,D,L>::rebalance_all()
+{
+    node_type *chain[num_levels+1];
+    for (unsigned l = 0; l <= num_levels; ++l) chain[l] = head;
+
+    node_type *node  = head->next[0];
+#ifdef SKIP_LIST_DIAGNOSTICS
+    const size_type count = item_count;
+#endif
+    item_count = 0;
+    levels     = 0;
+
+    while (node != tail)
+    {
+        node_type *next = node->next[0];
+        const unsigned level = append_level();
+        if (node->level != level) set_level(node, level);
+        link_back(node, chain);
+        ++item_count;
+        node = next;
+    }
+#ifdef SKIP_LIST_DIAGNOSTICS
+    assert_that(item_count == count);
+#endif
+
+    for (unsigned l = 0; l <= num_levels; ++l) chain[l]->next[l] = tail;
+    tail->prev = chain[0];
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+    check_balance();
+#endif
+}
+
+#ifdef SKIP_LIST_IMPL_DIAGNOSTICS
+// for diagnostics only: a deterministic list's gaps hold between one and
+// three nodes (or none, the last on a level), all of the level below
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+bool sl_impl<T,C,A,LG,D,L>::check_balance() const
+{
+    for (unsigned l = 0; l < levels && l+1 < num_levels; ++l)
+    {
+        for (const node_type *left = head; left != tail; )
+        {
+            const node_type *right = left->next[l+1];
+            unsigned size  = 0;
+            bool     level = true;
+            for (const node_type *n = left->next[l]; n != right; n = n->next[l])
+            {
+                if (n->level != l) level = false;
+                ++size;
+            }
+            if (!level || size > 3 || (size == 0 && right != tail))
+            {
+                assert_that(false && "balance error");
+                dump(std::cerr);
+                return false;
+            }
+            left = right;
+        }
+    }
+    if (levels && head->next[levels-1] == tail)
+    {
+        assert_that(false && "empty top level");
+        return false;
+    }
     return true;
 }
 #endif
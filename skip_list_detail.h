@@ -7,6 +7,7 @@
 
 #include <cmath>      // for std::log
 #include <cstdlib>    // for std::rand
+#include <algorithm>  // for std::swap
 
 //==============================================================================
 
@@ -26,9 +27,28 @@ namespace detail
 {
     template <unsigned NumLevels>   class bit_based_skip_list_level_generator;
     template <unsigned NumLevels>   class skip_list_level_generator;
+    template <unsigned NumLevels>   class concurrent_level_generator;
+    template <unsigned NumLevels>   class deterministic_level_generator;
+
+    struct single_threaded;
 }
 }
 
+//==============================================================================
+#pragma mark - language support
+//==============================================================================
+
+// Operations that need move semantics (e.g. node handles) are only
+// provided when compiling as C++11 or later.
+#if __cplusplus >= 201103L || (defined(_MSC_VER) && _MSC_VER >= 1900)
+    #define SKIP_LIST_CPP11 1
+#endif
+
+#ifdef SKIP_LIST_CPP11
+    #include <atomic>     // for std::atomic
+    #include <cstdint>    // for std::uint32_t
+#endif
+
 //==============================================================================
 #pragma mark - diagnostics
 //==============================================================================
@@ -117,6 +137,150 @@ public:
     unsigned new_level();
 };
 
+#ifdef SKIP_LIST_CPP11
+
+/// As bit_based_skip_list_level_generator, but with a per-thread xorshift
+/// generator in place of std::rand, which is typically guarded by a lock.
+/// Safe to share between threads.
+template <unsigned NumLevels>
+class concurrent_level_generator
+{
+public:
+    static const unsigned num_levels = NumLevels;
+    unsigned new_level();
+};
+
+#endif
+
+/// Not a random generator at all: a skip_list or multi_skip_list given
+/// this generator is a deterministic 1-2-3 skip list (Munro, Papadakis and
+/// Sedgewick). Nodes are linked in at level 0, and towers are then raised
+/// and lowered so that between each pair of neighbouring nodes on a level
+/// there are between one and three nodes of the level below (only the last
+/// such gap on a level may be empty). So find, insert and erase are
+/// O(log N) in the worst case, whatever order the elements come in, where
+/// random levels only give O(log N) on average.
+///
+/// Each raise or lower reallocates a node's tower, though never the node,
+/// so iterators stay valid as usual. Erasing a range erases its elements
+/// one at a time, and merge, split and join rebuild the towers of the lists
+/// they change, in linear time.
+///
+/// Only skip_list and multi_skip_list support this, and only with the
+/// single_threaded locking policy.
+template <unsigned NumLevels>
+class deterministic_level_generator
+{
+public:
+    static const unsigned num_levels = NumLevels;
+    unsigned new_level();
+};
+
+/// Whether LevelGenerator makes a deterministic list.
+template <typename LevelGenerator>
+struct sl_deterministic
+{
+    static const bool value = false;
+};
+
+template <unsigned NumLevels>
+struct sl_deterministic<deterministic_level_generator<NumLevels> >
+{
+    static const bool value = true;
+};
+
+/// Whether lists with LevelGenerator may be built on several threads at
+/// once: its levels come from neither std::rand nor shared state. A
+/// deterministic list's levels come from its own size.
+template <typename LevelGenerator>
+struct sl_thread_safe_levels
+{
+    static const bool value = sl_deterministic<LevelGenerator>::value;
+};
+
+#ifdef SKIP_LIST_CPP11
+
+template <unsigned NumLevels>
+struct sl_thread_safe_levels<concurrent_level_generator<NumLevels> >
+{
+    static const bool value = true;
+};
+
+#endif
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - skip_list locking policies
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// Selects between the sequential and concurrent implementations of the
+/// skip_list operations that a locking policy makes thread safe.
+template <bool Concurrent> struct sl_concurrency {};
+
+/// The default skip_list locking policy: none. A list must not be modified
+/// while any other thread is using it.
+///
+/// A locking policy provides:
+///  - is_concurrent, selecting which implementation of insert, erase, find
+///    and contains the list uses;
+///  - node_state<NODE>, a base class for every node, holding any per-node
+///    data the policy needs (for locks and flags), and init_state() to set
+///    it up;
+///  - link<NODE>::type, the type of the links between nodes;
+///  - counter<N>::type, the type of counters shared between threads;
+///  - list_state<NODE,Reclaimer,Allocator>, a per-list member holding any
+///    shared data the policy needs. Its dispose(reclaimer, node) is handed
+///    each node that has been unlinked, to reclaim now or later; and its
+///    guard type is constructed from it by anything reading the list that
+///    needs those nodes to stay put (see skip_list::read_guard).
+///
+/// @see lazy_locking in skip_list_lazy.h
+/// @see single_writer in skip_list_rcu.h
+struct single_threaded
+{
+    static const bool is_concurrent = false;
+
+    template <typename NODE>
+    struct node_state
+    {
+        void init_state() {}
+    };
+
+    template <typename NODE> struct link    { typedef NODE *type; };
+    template <typename N>    struct counter { typedef N type; };
+
+    template <typename NODE, typename Reclaimer, typename Allocator>
+    struct list_state
+    {
+        list_state(Reclaimer &, const Allocator &) {}
+
+        void dispose(Reclaimer &reclaimer, NODE *node) { reclaimer.reclaim(node); }
+
+        struct guard
+        {
+            explicit guard(list_state &) {}
+        };
+    };
+};
+
+/// Whether LockingPolicy is single_threaded.
+template <typename LockingPolicy>
+struct sl_single_threaded
+{
+    static const bool value = false;
+};
+
+template <>
+struct sl_single_threaded<single_threaded>
+{
+    static const bool value = true;
+};
+
 } // namespace detail
 } // namespace goodliffe
 
@@ -161,6 +325,108 @@ bool less_or_equal(const T &lhs, const T &rhs, Compare &less)
 } // namespace detail
 } // namespace goodliffe
 
+//==============================================================================
+#pragma mark - node handles
+//==============================================================================
+
+#ifdef SKIP_LIST_CPP11
+
+namespace goodliffe {
+namespace detail {
+
+/// A C++17-style node handle. Owns a single node that has been extract()ed
+/// from a skip list container, including its tower of links. The node can be
+/// inserted into another container of the same type (or back into the same
+/// one, perhaps after changing its value) without any allocation or copying.
+///
+/// If the handle still owns a node when it is destroyed, the node's value is
+/// destroyed and its memory released.
+///
+/// NODE must have a matching deallocate_node(Allocator&, NODE*) overload.
+template <typename NODE, typename Allocator>
+class sl_node_handle
+{
+public:
+    typedef NODE                                    node_type;
+    typedef typename Allocator::value_type          value_type;
+    typedef Allocator                               allocator_type;
+
+    sl_node_handle() : node(0), alloc() {}
+    sl_node_handle(sl_node_handle &&other)
+        : node(other.node), alloc(other.alloc) { other.node = 0; }
+    ~sl_node_handle() { reset(); }
+
+    sl_node_handle &operator=(sl_node_handle &&other)
+    {
+        if (&other != this)
+        {
+            reset();
+            node  = other.node;
+            alloc = other.alloc;
+            other.node = 0;
+        }
+        return *this;
+    }
+
+    bool           empty() const            { return node == 0; }
+    explicit       operator bool() const    { return node != 0; }
+    allocator_type get_allocator() const    { return alloc; }
+
+    /// The held value. This may be modified, e.g. to change an element's key
+    /// before inserting it again.
+    value_type &value() const
+    {
+        assert_that(node);
+        return node->value;
+    }
+
+    void swap(sl_node_handle &other)
+    {
+        using std::swap;
+        swap(node,  other.node);
+        swap(alloc, other.alloc);
+    }
+
+    friend void swap(sl_node_handle &lhs, sl_node_handle &rhs) { lhs.swap(rhs); }
+
+    sl_node_handle(node_type *node_, const allocator_type &alloc_)
+        : node(node_), alloc(alloc_) {}                               ///< @internal
+    node_type *get_node() const { return node; }                      ///< @internal
+    node_type *release() { node_type *n = node; node = 0; return n; } ///< @internal
+
+private:
+    sl_node_handle(const sl_node_handle &);
+    sl_node_handle &operator=(const sl_node_handle &);
+
+    void reset()
+    {
+        if (node)
+        {
+            alloc.destroy(&node->value);
+            deallocate_node(alloc, node);
+            node = 0;
+        }
+    }
+
+    node_type      *node;
+    allocator_type  alloc;
+};
+
+/// The result of inserting a node handle into a unique container: as
+/// std::set::insert_return_type.
+template <typename Iterator, typename NodeHandle>
+struct sl_insert_return_type
+{
+    Iterator   position;
+    bool       inserted;
+    NodeHandle node;
+};
+
+} // namespace detail
+} // namespace goodliffe
+
+#endif // SKIP_LIST_CPP11
+
 //==============================================================================
 #pragma mark - skip_list_level_generator
 //==============================================================================
@@ -193,6 +459,40 @@ unsigned skip_list_level_generator<ML>::new_level()
     return level < num_levels ? level : num_levels;
 }
 
+#ifdef SKIP_LIST_CPP11
+
+template <unsigned NL>
+inline
+unsigned concurrent_level_generator<NL>::new_level()
+{
+    static std::atomic<std::uint32_t>     seed(0x9e3779b9u);
+    static thread_local std::uint32_t     state = 0;
+
+    // every thread gets a different, non-zero, starting state
+    while (!state) state = seed.fetch_add(0x9e3779b9u, std::memory_order_relaxed);
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+
+    unsigned level = 0;
+    for (std::uint32_t number = state; (number & 1) == 1; number >>= 1)
+    {
+        level++;
+    }
+    return level < num_levels ? level : num_levels;
+}
+
+#endif // SKIP_LIST_CPP11
+
+template <unsigned NL>
+inline
+unsigned deterministic_level_generator<NL>::new_level()
+{
+    // Every node starts at the bottom; the list raises it if need be
+    return 0;
+}
+
 } // namespace detail
 } // namespace goodliffe
 
@@ -0,0 +1,445 @@
+//==============================================================================
+// skip_list_epoch.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list_detail.h"
+
+#ifndef SKIP_LIST_CPP11
+#error "skip_list_epoch.h requires C++11 (for std::atomic)"
+#endif
+
+#include <atomic>     // for std::atomic
+#include <algorithm>  // for std::swap
+#include <new>        // for placement new
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - epoch_domain
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// Epoch-based memory reclamation, for the concurrent containers.
+///
+/// A node that has been unlinked from a lock-free structure may still be in
+/// use by a thread that reached it beforehand. So rather than being freed,
+/// it is retire()d, and freed only once every thread that might still see
+/// it has moved on.
+///
+/// Threads pin() the domain around each operation that follows links.
+/// There is a global epoch, and a pinned thread announces the epoch it saw
+/// when it pinned. The global epoch only advances when every pinned thread
+/// has seen the current one. A node retired when the global epoch was e
+/// can therefore only be seen by threads pinned at e or earlier, and is safe
+/// to free once the global epoch reaches e+2.
+///
+/// Each pin is held in a record. Records are pooled per domain, each
+/// thread remembering the last one it used, so in the common case pinning
+/// is one uncontended exchange plus a fence. A record keeps its retired
+/// nodes in three bags, one per recent epoch. Every advance_threshold pins
+/// or retirements it tries to advance the epoch, and bags that have expired
+/// are handed to Reclaimer::reclaim; when the epoch does advance, the bags
+/// of records not in use just then are collected too, so that nodes retired
+/// through a record that no thread is using any more are not stranded. So,
+/// as long as no thread stays pinned, at most a few bags' worth of nodes per
+/// record await reclamation. A thread that is descheduled while pinned
+/// holds up reclamation for every thread until it runs again, which is why
+/// pins should be short.
+///
+/// Records are allocated through Allocator, and live until the domain is
+/// destroyed; destroying the domain reclaims everything that is left. No
+/// thread may be pinned at that point.
+///
+/// NODE must have a "NODE *next_retired" member, for chaining nodes in bags.
+/// Reclaimer must have a "void reclaim(NODE*)" member.
+///
+/// @internal
+template <typename NODE, typename Reclaimer, typename Allocator>
+class epoch_domain
+{
+public:
+    typedef NODE                                node_type;
+    typedef typename Allocator::size_type       size_type;
+
+    static const unsigned advance_threshold = 64;
+
+    /// A thread's announcement of the epoch it is pinned at, and its bags
+    /// of retired nodes
+    struct record
+    {
+        struct bag
+        {
+            node_type     *head;
+            unsigned long  epoch;
+        };
+
+        std::atomic<unsigned long>  state;  ///< (epoch << 1) | pinned
+        std::atomic<bool>           in_use;
+        record                     *next;   ///< in the domain's list of records
+        bag                         bags[3];
+        unsigned                    ops_since_advance;
+        char                        padding[64]; ///< keep records on separate cache lines
+
+        unsigned long epoch() const { return state.load(std::memory_order_relaxed) >> 1; }
+    };
+
+    epoch_domain(Reclaimer &reclaimer, const Allocator &alloc);
+    ~epoch_domain();
+
+    /// Pins the calling thread at the current epoch
+    record *pin();
+
+    /// Pins the calling thread at the same epoch as an existing pin; used
+    /// when copying a pin that is protecting a node.
+    record *pin_at(const record *existing);
+
+    void    unpin(record *rec);
+
+    /// Hands over a node that has been unlinked, to be reclaimed once no
+    /// thread can be looking at it. The caller must be pinned in rec.
+    void    retire(record *rec, node_type *node);
+
+    /// Reclaims every retired node immediately. No thread may be pinned.
+    void    reclaim_all();
+
+    /// The number of retired nodes not yet reclaimed
+    size_type retired_size() const { return retired_count.load(std::memory_order_relaxed); }
+
+private:
+    typedef typename Allocator::template rebind<record>::other record_allocator;
+
+    epoch_domain(const epoch_domain &other);
+    epoch_domain &operator=(const epoch_domain &other);
+
+    record *acquire();
+    void    announce(record *rec, unsigned long epoch);
+    bool    try_advance();
+    void    collect(record *rec);
+    void    collect_idle();
+    void    reclaim_bag(typename record::bag &bag);
+
+    struct cache_entry
+    {
+        unsigned long  domain_id;
+        record        *rec;
+    };
+
+    static cache_entry &thread_cache()
+    {
+        static thread_local cache_entry cache = { 0, 0 };
+        return cache;
+    }
+
+    static unsigned long new_domain_id()
+    {
+        static std::atomic<unsigned long> next_id(1);
+        return next_id.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    Reclaimer                  &reclaimer;
+    Allocator                   alloc;
+    const unsigned long         domain_id;
+    std::atomic<unsigned long>  global_epoch;
+    std::atomic<record*>        records;
+    std::atomic<size_type>      retired_count;
+};
+
+template <class N, class R, class A>
+inline
+epoch_domain<N,R,A>::epoch_domain(R &reclaimer_, const A &alloc_)
+:   reclaimer(reclaimer_),
+    alloc(alloc_),
+    domain_id(new_domain_id()),
+    global_epoch(0),
+    records(0),
+    retired_count(0)
+{
+}
+
+template <class N, class R, class A>
+inline
+epoch_domain<N,R,A>::~epoch_domain()
+{
+    reclaim_all();
+
+    record *rec = records.load(std::memory_order_acquire);
+    while (rec)
+    {
+        assert_that(!rec->in_use.load());
+        record *next = rec->next;
+        record_allocator(alloc).deallocate(rec, 1);
+        rec = next;
+    }
+}
+
+/// Finds a free record: the one this thread used last if possible, then any
+/// free one, and otherwise makes a new one.
+template <class N, class R, class A>
+inline
+typename epoch_domain<N,R,A>::record *
+epoch_domain<N,R,A>::acquire()
+{
+    cache_entry &cache = thread_cache();
+    if (cache.domain_id == domain_id
+        && !cache.rec->in_use.exchange(true, std::memory_order_acquire))
+    {
+        return cache.rec;
+    }
+
+    record *rec = records.load(std::memory_order_acquire);
+    for (; rec; rec = rec->next)
+    {
+        if (!rec->in_use.load(std::memory_order_relaxed)
+            && !rec->in_use.exchange(true, std::memory_order_acquire))
+        {
+            break;
+        }
+    }
+
+    if (!rec)
+    {
+        rec = record_allocator(alloc).allocate(1, (void*)0);
+        new (&rec->state)  std::atomic<unsigned long>(0);
+        new (&rec->in_use) std::atomic<bool>(true);
+        for (unsigned n = 0; n < 3; ++n)
+        {
+            rec->bags[n].head  = 0;
+            rec->bags[n].epoch = 0;
+        }
+        rec->ops_since_advance = 0;
+
+        record *head = records.load(std::memory_order_relaxed);
+        do
+        {
+            rec->next = head;
+        }
+        while (!records.compare_exchange_weak(head, rec, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    cache.domain_id = domain_id;
+    cache.rec       = rec;
+    return rec;
+}
+
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::announce(record *rec, unsigned long epoch)
+{
+    rec->state.store((epoch << 1) | 1, std::memory_order_relaxed);
+    // The announcement must be visible before we read any links
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+template <class N, class R, class A>
+inline
+typename epoch_domain<N,R,A>::record *
+epoch_domain<N,R,A>::pin()
+{
+    record *rec = acquire();
+    announce(rec, global_epoch.load(std::memory_order_relaxed));
+    if (++rec->ops_since_advance >= advance_threshold)
+    {
+        rec->ops_since_advance = 0;
+        if (try_advance()) collect_idle();
+    }
+    collect(rec);
+    return rec;
+}
+
+template <class N, class R, class A>
+inline
+typename epoch_domain<N,R,A>::record *
+epoch_domain<N,R,A>::pin_at(const record *existing)
+{
+    // existing holds the global epoch at most one ahead of its own, so
+    // announcing the same epoch is safe
+    record *rec = acquire();
+    announce(rec, existing->epoch());
+    return rec;
+}
+
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::unpin(record *rec)
+{
+    rec->state.store(rec->epoch() << 1, std::memory_order_release);
+    rec->in_use.store(false, std::memory_order_release);
+}
+
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::retire(record *rec, node_type *node)
+{
+    // Tag with the global epoch as it is now that the node is unreachable,
+    // not the (possibly older) epoch we pinned at
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const unsigned long epoch = global_epoch.load(std::memory_order_relaxed);
+
+    typename record::bag &bag = rec->bags[epoch % 3];
+    if (bag.epoch != epoch)
+    {
+        // The bag is at least three epochs old
+        reclaim_bag(bag);
+        bag.epoch = epoch;
+    }
+    node->next_retired = bag.head;
+    bag.head           = node;
+    retired_count.fetch_add(1, std::memory_order_relaxed);
+
+    if (++rec->ops_since_advance >= advance_threshold)
+    {
+        rec->ops_since_advance = 0;
+        if (try_advance()) collect_idle();
+        collect(rec);
+    }
+}
+
+/// Moves the global epoch on, if every pinned thread has seen it
+template <class N, class R, class A>
+inline
+bool epoch_domain<N,R,A>::try_advance()
+{
+    unsigned long epoch = global_epoch.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+
+    for (record *rec = records.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        // Acquire: everything a thread did while pinned happens before we
+        // see it unpinned, or moved on
+        const unsigned long state = rec->state.load(std::memory_order_acquire);
+        if ((state & 1) && (state >> 1) != epoch) return false;
+    }
+
+    return global_epoch.compare_exchange_strong(epoch, epoch+1, std::memory_order_acq_rel, std::memory_order_relaxed);
+}
+
+/// Reclaims rec's expired bags. Only the thread holding rec may do this.
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::collect(record *rec)
+{
+    const unsigned long epoch = global_epoch.load(std::memory_order_acquire);
+    for (unsigned n = 0; n < 3; ++n)
+    {
+        if (rec->bags[n].head && rec->bags[n].epoch + 2 <= epoch)
+        {
+            reclaim_bag(rec->bags[n]);
+        }
+    }
+}
+
+/// Collects the expired bags of every record no thread holds at the moment
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::collect_idle()
+{
+    for (record *rec = records.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        if (!rec->in_use.load(std::memory_order_relaxed)
+            && !rec->in_use.exchange(true, std::memory_order_acquire))
+        {
+            collect(rec);
+            rec->in_use.store(false, std::memory_order_release);
+        }
+    }
+}
+
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::reclaim_bag(typename record::bag &bag)
+{
+    node_type *node = bag.head;
+    bag.head = 0;
+    while (node)
+    {
+        node_type *next = node->next_retired;
+        reclaimer.reclaim(node);
+        retired_count.fetch_sub(1, std::memory_order_relaxed);
+        node = next;
+    }
+}
+
+template <class N, class R, class A>
+inline
+void epoch_domain<N,R,A>::reclaim_all()
+{
+    for (record *rec = records.load(std::memory_order_acquire); rec; rec = rec->next)
+    {
+        assert_that(!(rec->state.load() & 1));
+        for (unsigned n = 0; n < 3; ++n)
+        {
+            reclaim_bag(rec->bags[n]);
+        }
+    }
+}
+
+//==============================================================================
+#pragma mark - epoch_pin
+//==============================================================================
+
+/// Holds a thread pinned in an epoch_domain for its lifetime. Copying a pin
+/// pins again, at the same epoch, so a copy continues to protect whatever
+/// the original did.
+///
+/// @internal
+template <typename DOMAIN>
+class epoch_pin
+{
+public:
+    typedef DOMAIN                          domain_type;
+    typedef typename domain_type::record    record;
+
+    epoch_pin()
+        : domain(0), rec(0) {}
+    explicit epoch_pin(domain_type &domain_)
+        : domain(&domain_), rec(domain_.pin()) {}
+    epoch_pin(const epoch_pin &other)
+        : domain(other.domain), rec(other.rec ? other.domain->pin_at(other.rec) : 0) {}
+    epoch_pin(epoch_pin &&other)
+        : domain(other.domain), rec(other.rec) { other.rec = 0; }
+    ~epoch_pin() { reset(); }
+
+    epoch_pin &operator=(epoch_pin other)
+    {
+        swap(other);
+        return *this;
+    }
+
+    void swap(epoch_pin &other)
+    {
+        std::swap(domain, other.domain);
+        std::swap(rec,    other.rec);
+    }
+
+    void reset()
+    {
+        if (rec) domain->unpin(rec);
+        rec = 0;
+    }
+
+    bool    is_pinned() const { return rec != 0; }
+    record *get() const       { return rec; }
+
+private:
+    domain_type *domain;
+    record      *rec;
+};
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,395 @@
+//==============================================================================
+// skip_list_lazy.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list.h"
+#include "skip_list_epoch.h"
+
+#ifndef SKIP_LIST_CPP11
+#error "skip_list_lazy.h requires C++11 (for std::atomic)"
+#endif
+
+#include <atomic>     // for std::atomic
+#include <thread>     // for std::this_thread::yield
+#include <new>        // for placement new
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - lazy_locking
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// A link between nodes that one thread may follow while another changes it.
+/// Reads acquire, and writes release, so a node is fully constructed before
+/// any thread can reach it.
+///
+/// @internal
+template <typename NODE>
+class lazy_link
+{
+public:
+    lazy_link() {}
+    lazy_link(NODE *node) : link(node) {}
+    lazy_link(const lazy_link &other) : link(other.load()) {}
+
+    lazy_link &operator=(const lazy_link &other) { store(other.load()); return *this; }
+    lazy_link &operator=(NODE *node)             { store(node); return *this; }
+
+    operator NODE*() const   { return load(); }
+    NODE *operator->() const { return load(); }
+
+    NODE *load() const       { return link.load(std::memory_order_acquire); }
+    void  store(NODE *node)  { link.store(node, std::memory_order_release); }
+
+private:
+    std::atomic<NODE*> link;
+};
+
+/// A count that many threads may update at once. Copying it (e.g. to swap
+/// two lists) is not atomic.
+///
+/// @internal
+template <typename N>
+class lazy_counter
+{
+public:
+    lazy_counter(N n = N()) : count(n) {}
+    lazy_counter(const lazy_counter &other) : count(N(other)) {}
+
+    lazy_counter &operator=(const lazy_counter &other) { count.store(N(other), std::memory_order_relaxed); return *this; }
+    lazy_counter &operator=(N n)                       { count.store(n, std::memory_order_relaxed); return *this; }
+
+    operator N() const { return count.load(std::memory_order_relaxed); }
+
+    lazy_counter &operator++()   { count.fetch_add(1, std::memory_order_relaxed); return *this; }
+    lazy_counter &operator--()   { count.fetch_sub(1, std::memory_order_relaxed); return *this; }
+    N             operator++(int) { return count.fetch_add(1, std::memory_order_relaxed); }
+    N             operator--(int) { return count.fetch_sub(1, std::memory_order_relaxed); }
+
+    bool compare_exchange(N &expected, N desired)
+        { return count.compare_exchange_weak(expected, desired, std::memory_order_relaxed); }
+
+private:
+    std::atomic<N> count;
+};
+
+/// A skip_list locking policy implementing the "lazy skip list" of Herlihy,
+/// Lev, Luchangco and Shavit (2006).
+///
+/// Each node has a spinlock, a "marked" flag set when it is (logically)
+/// erased, and a "fully linked" flag set once it is linked at every level
+/// of its tower. Searches take no locks at all; insert and erase search
+/// optimistically, then lock just the nodes they are about to change, check
+/// that nothing changed in the meantime, and start over if it did. So
+/// contains() is wait-free, and threads working on different parts of the
+/// list do not get in each other's way.
+///
+/// Erased nodes are reclaimed with an epoch_domain, once no search can
+/// still be looking at them.
+///
+/// With this policy insert(value), erase(value), count, contains and find
+/// are thread safe. Nothing else is: every other operation, including
+/// iteration, must not run at the same time as an erase. An iterator
+/// returned by insert or find may only be dereferenced while its element
+/// cannot be erased.
+struct lazy_locking
+{
+    static const bool is_concurrent = true;
+
+    template <typename NODE>
+    struct node_state
+    {
+        std::atomic<bool>   locked;
+        std::atomic<bool>   marked;       ///< erased; no longer in the list
+        std::atomic<bool>   fully_linked; ///< in the list, at every level
+        NODE               *next_retired; ///< for the epoch_domain
+
+        void init_state()
+        {
+            new (&locked)       std::atomic<bool>(false);
+            new (&marked)       std::atomic<bool>(false);
+            new (&fully_linked) std::atomic<bool>(true);
+            next_retired = 0;
+        }
+
+        void lock()
+        {
+            while (locked.exchange(true, std::memory_order_acquire))
+            {
+                while (locked.load(std::memory_order_relaxed)) std::this_thread::yield();
+            }
+        }
+
+        void unlock() { locked.store(false, std::memory_order_release); }
+
+        bool is_marked() const       { return marked.load(std::memory_order_acquire); }
+        bool is_fully_linked() const { return fully_linked.load(std::memory_order_acquire); }
+    };
+
+    template <typename NODE> struct link    { typedef lazy_link<NODE> type; };
+    template <typename N>    struct counter { typedef lazy_counter<N> type; };
+
+    template <typename NODE, typename Reclaimer, typename Allocator>
+    class list_state : public epoch_domain<NODE,Reclaimer,Allocator>
+    {
+    public:
+        typedef epoch_domain<NODE,Reclaimer,Allocator> domain_type;
+        typedef epoch_pin<domain_type>                 guard;
+
+        list_state(Reclaimer &reclaimer, const Allocator &alloc)
+            : domain_type(reclaimer, alloc) {}
+
+        // Only the operations that are not thread safe dispose of nodes
+        void dispose(Reclaimer &reclaimer, NODE *node) { reclaimer.reclaim(node); }
+    };
+};
+
+/// Unlocks the distinct nodes in preds[0..highest]. Equal predecessors are
+/// always adjacent, and were only locked once.
+template <typename NODE>
+inline
+void lazy_unlock(NODE **preds, int highest)
+{
+    for (int l = 0; l <= highest; ++l)
+    {
+        if (l == 0 || preds[l] != preds[l-1]) preds[l]->unlock();
+    }
+}
+
+} // namespace detail
+
+/// A skip_list that many threads can insert into, erase from and search at
+/// the same time; see lazy_locking for exactly what is thread safe.
+///
+/// For a list that is lock-free throughout, and can be iterated while it is
+/// changing, see concurrent_skip_list.
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+using lazy_skip_list = skip_list<T,Compare,Allocator,
+                                 detail::concurrent_level_generator<32>,
+                                 false,
+                                 detail::lazy_locking>;
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - sl_impl concurrent operations
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// As new_level, but the list may be growing in other threads too.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+unsigned sl_impl<T,C,A,LG,D,L>::new_level(sl_concurrency<true>)
+{
+    const unsigned level = generator.new_level();
+    unsigned current = levels;
+    while (level >= current)
+    {
+        // Grow by at most one level, as the sequential version does
+        if (levels.compare_exchange(current, current+1)) return current;
+    }
+    return level;
+}
+
+/// Fills preds and succs with the nodes either side of value at each level
+/// in use. Returns the highest level at which a node equivalent to value
+/// was found, or -1. Takes no locks; the caller must be pinned.
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+int
+sl_impl<T,C,A,LG,D,L>::find_lazy_chain(const value_type &value, node_type **preds, node_type **succs) const
+{
+    int found = -1;
+    node_type *pred = head;
+    for (unsigned l = levels; l; )
+    {
+        --l;
+        node_type *curr = pred->next[l];
+        while (curr != tail && less(curr->value, value))
+        {
+            pred = curr;
+            curr = pred->next[l];
+        }
+        if (found == -1 && curr != tail && !less(value, curr->value)) found = int(l);
+        preds[l] = pred;
+        succs[l] = curr;
+    }
+    return found;
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+typename sl_impl<T,C,A,LG,D,L>::node_type *
+sl_impl<T,C,A,LG,D,L>::find_equivalent(const value_type &value, sl_concurrency<true>) const
+{
+    typename locking_state::guard pin(locking);
+
+    node_type *preds[num_levels+1];
+    node_type *succs[num_levels+1];
+    const int found = find_lazy_chain(value, preds, succs);
+
+    // A node is only in the list once it is fully linked, until it is marked
+    return found != -1 && succs[found]->is_fully_linked() && !succs[found]->is_marked()
+        ? succs[found]
+        : tail;
+}
+
+template <class T, class C, class A, class LG, bool AllowDuplicates, class L>
+inline
+typename sl_impl<T,C,A,LG,AllowDuplicates,L>::node_type*
+sl_impl<T,C,A,LG,AllowDuplicates,L>::insert(const value_type &value, node_type *, sl_concurrency<true>)
+{
+    static_assert(!AllowDuplicates, "lazy_locking only supports unique lists");
+
+    typename locking_state::guard pin(locking);
+    const unsigned level = new_level();
+
+    node_type *preds[num_levels+1];
+    node_type *succs[num_levels+1];
+    node_type *new_node = 0;
+
+    for (;;)
+    {
+        const int found = find_lazy_chain(value, preds, succs);
+        if (found != -1)
+        {
+            node_type *existing = succs[found];
+            if (!existing->is_marked())
+            {
+                // It is already here, or about to be
+                while (!existing->is_fully_linked()) std::this_thread::yield();
+                if (new_node) reclaim(new_node);
+                return tail;
+            }
+            continue; // it is on its way out; look again
+        }
+
+        if (!new_node)
+        {
+            // Before taking any locks, in case the copy throws
+            new_node = allocate(level);
+            alloc.construct(&new_node->value, value);
+            new_node->fully_linked.store(false, std::memory_order_relaxed);
+        }
+
+        int  highest_locked = -1;
+        bool valid          = true;
+        for (unsigned l = 0; valid && l <= level; ++l)
+        {
+            node_type *pred = preds[l];
+            if (l == 0 || pred != preds[l-1]) pred->lock();
+            highest_locked = int(l);
+            valid = !pred->is_marked() && !succs[l]->is_marked() && pred->next[l] == succs[l];
+        }
+        if (!valid)
+        {
+            lazy_unlock(preds, highest_locked);
+            continue;
+        }
+
+        for (unsigned l = 0; l <= level; ++l) new_node->next[l] = succs[l];
+        new_node->prev = preds[0];
+
+        // succs[0]->prev must be set while preds[0] is still its
+        // predecessor: once new_node is linked in, a thread inserting after
+        // new_node sets it too, and must not be overwritten by us
+        succs[0]->prev = new_node;
+        for (unsigned l = 0; l <= level; ++l) preds[l]->next[l] = new_node;
+        ++item_count;
+
+        new_node->fully_linked.store(true, std::memory_order_release);
+        lazy_unlock(preds, highest_locked);
+        return new_node;
+    }
+}
+
+template <class T, class C, class A, class LG, bool D, class L>
+inline
+bool
+sl_impl<T,C,A,LG,D,L>::erase(const value_type &value, sl_concurrency<true>)
+{
+    typename locking_state::guard pin(locking);
+
+    node_type *preds[num_levels+1];
+    node_type *succs[num_levels+1];
+    node_type *victim = 0;
+
+    for (;;)
+    {
+        const int found = find_lazy_chain(value, preds, succs);
+        if (!victim)
+        {
+            // Only a fully linked node, found at the top of its tower, is
+            // really in the list
+            if (found == -1) return false;
+            node_type *candidate = succs[found];
+            if (!candidate->is_fully_linked() || candidate->level != unsigned(found)
+                || candidate->is_marked())
+            {
+                return false;
+            }
+
+            candidate->lock();
+            if (candidate->is_marked())
+            {
+                candidate->unlock(); // another thread got there first
+                return false;
+            }
+            candidate->marked.store(true, std::memory_order_release);
+            victim = candidate;
+        }
+
+        int  highest_locked = -1;
+        bool valid          = true;
+        for (unsigned l = 0; valid && l <= victim->level; ++l)
+        {
+            node_type *pred = preds[l];
+            if (l == 0 || pred != preds[l-1]) pred->lock();
+            highest_locked = int(l);
+            valid = !pred->is_marked() && pred->next[l] == victim;
+        }
+        if (!valid)
+        {
+            lazy_unlock(preds, highest_locked);
+            continue;
+        }
+
+        for (unsigned l = victim->level+1; l; )
+        {
+            --l;
+            preds[l]->next[l] = victim->next[l];
+        }
+        node_type *next = victim->next[0];
+        next->prev = preds[0];
+        --item_count;
+
+        victim->unlock();
+        lazy_unlock(preds, highest_locked);
+        locking.retire(pin.get(), victim);
+        return true;
+    }
+}
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
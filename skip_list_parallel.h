@@ -0,0 +1,218 @@
+//==============================================================================
+// skip_list_parallel.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list_detail.h"
+
+#ifndef SKIP_LIST_CPP11
+#error "skip_list_parallel.h requires C++11 (for std::thread)"
+#endif
+
+#include <iterator>   // for std::iterator_traits, std::back_inserter
+#include <algorithm>  // for std::for_each
+#include <vector>
+#include <thread>
+#include <exception>  // for std::exception_ptr
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - internal helpers
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// Below this many elements per thread, it is not worth starting threads
+const std::size_t parallel_min_chunk = 4096;
+
+/// Runs task(n) for each n in [0,count), each on a thread of its own (and
+/// task(0) on this one), and waits for them all to finish. If any of them
+/// throws, the first exception (by n) is then rethrown.
+///
+/// @internal
+template <typename Task>
+void parallel_run(std::size_t count, const Task &task)
+{
+    std::vector<std::exception_ptr> errors(count);
+    std::vector<std::thread>        workers;
+
+    auto run = [&task, &errors](std::size_t n)
+    {
+        try
+        {
+            task(n);
+        }
+        catch (...)
+        {
+            errors[n] = std::current_exception();
+        }
+    };
+
+    for (std::size_t n = 1; n < count; ++n)
+    {
+        try
+        {
+            workers.push_back(std::thread(run, n));
+        }
+        catch (...)
+        {
+            run(n); // couldn't start a thread: do it ourselves
+        }
+    }
+    if (count) run(0);
+    for (std::size_t n = 0; n < workers.size(); ++n) workers[n].join();
+
+    for (std::size_t n = 0; n < count; ++n)
+    {
+        if (errors[n]) std::rethrow_exception(errors[n]);
+    }
+}
+
+/// Moves mid forwards until it no longer splits a run of equivalent values,
+/// so that no two chunks hold equivalent values.
+///
+/// @internal
+template <typename RandomAccessIterator, typename Compare>
+inline
+RandomAccessIterator parallel_seam(RandomAccessIterator first, RandomAccessIterator mid,
+                                   RandomAccessIterator last, const Compare &less)
+{
+    while (mid != first && mid != last && !less(*(mid-1), *mid)) ++mid;
+    return mid;
+}
+
+} // namespace detail
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - parallel_assign_sorted
+//==============================================================================
+
+namespace goodliffe {
+
+/// Replaces the contents of list with the range [first,last), which must
+/// already be sorted, building it on several threads at once.
+///
+/// The range is cut into one chunk per thread, never between equivalent
+/// values. Each chunk is built into a list of its own with assign_sorted()
+/// (in linear time), concurrently, and the lists are then joined in order
+/// with join(), which relinks the top of each tower across the seam in
+/// O(log N); a random_access_skip_list fixes up its spans there too. The
+/// result is the same list, element for element, as list.assign_sorted()
+/// would build.
+///
+/// Works with skip_list, multi_skip_list and random_access_skip_list. Each
+/// chunk is built through a copy of list's allocator, with list's
+/// comparator, from a different thread, so the allocator must be safe to
+/// use like that. So must the level generator: the default ones call
+/// std::rand, which need not be, so list must use
+/// concurrent_level_generator (or be deterministic).
+///
+/// If building any chunk throws, list is left empty and the exception is
+/// rethrown.
+///
+/// @param threads The most threads to use, including the calling one. Small
+///                ranges use fewer.
+template <typename LIST, typename RandomAccessIterator>
+void parallel_assign_sorted(LIST &list,
+                            RandomAccessIterator first, RandomAccessIterator last,
+                            unsigned threads = std::thread::hardware_concurrency())
+{
+    typedef typename std::iterator_traits<RandomAccessIterator>::difference_type difference_type;
+
+    static_assert(detail::sl_thread_safe_levels<typename LIST::level_generator>::value,
+                  "parallel_assign_sorted needs a list with concurrent_level_generator");
+
+    const std::size_t size   = std::size_t(last - first);
+    std::size_t       chunks = size / detail::parallel_min_chunk;
+    if (chunks > threads) chunks = threads;
+    if (chunks < 2)
+    {
+        list.assign_sorted(first, last);
+        return;
+    }
+
+    const typename LIST::compare less = list.value_comp();
+    std::vector<RandomAccessIterator> bounds(1, first);
+    for (std::size_t n = 1; n < chunks; ++n)
+    {
+        RandomAccessIterator mid = first + difference_type(size * n / chunks);
+        if (mid < bounds.back()) mid = bounds.back();
+        bounds.push_back(detail::parallel_seam(first, mid, last, less));
+    }
+    bounds.push_back(last);
+
+    // Chunk 0 is built straight into list
+    std::vector<LIST> parts(chunks-1, LIST(less, list.get_allocator()));
+    try
+    {
+        detail::parallel_run(chunks, [&](std::size_t n)
+        {
+            LIST &part = n ? parts[n-1] : list;
+            part.assign_sorted(bounds[n], bounds[n+1]);
+        });
+    }
+    catch (...)
+    {
+        list.clear();
+        throw;
+    }
+
+    for (std::size_t n = 0; n < parts.size(); ++n) list.join(parts[n]);
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - parallel_for_each
+//==============================================================================
+
+namespace goodliffe {
+
+/// Calls f on every element of list, as std::for_each, but shares the work
+/// among several threads: list.partition() cuts the list into one range
+/// per thread, and each thread runs std::for_each over its range, with its
+/// own copy of f. So f is called concurrently, on different elements, in
+/// no particular order across the ranges.
+///
+/// Works with skip_list, multi_skip_list and random_access_skip_list.
+/// Nothing may change the list while this runs. If f throws, the first
+/// exception (by range) is rethrown once every thread has finished.
+///
+/// @param threads The most threads to use, including the calling one.
+template <typename LIST, typename Function>
+void parallel_for_each(const LIST &list, Function f,
+                       unsigned threads = std::thread::hardware_concurrency())
+{
+    std::size_t chunks = threads;
+    if (chunks > list.size()) chunks = list.size();
+    if (chunks < 2)
+    {
+        std::for_each(list.begin(), list.end(), f);
+        return;
+    }
+
+    std::vector<typename LIST::const_range> ranges;
+    list.partition(chunks, std::back_inserter(ranges));
+    detail::parallel_run(chunks, [&ranges, &f](std::size_t n)
+    {
+        std::for_each(ranges[n].first, ranges[n].second, Function(f));
+    });
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,119 @@
+//==============================================================================
+// skip_list_rcu.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list.h"
+#include "skip_list_epoch.h"
+#include "skip_list_lazy.h" // for lazy_link and lazy_counter
+
+#ifndef SKIP_LIST_CPP11
+#error "skip_list_rcu.h requires C++11 (for std::atomic)"
+#endif
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - single_writer
+//==============================================================================
+
+namespace goodliffe {
+namespace detail {
+
+/// A skip_list locking policy for read-mostly lists, in the style of RCU
+/// ("read-copy-update"): one writer thread changes the list while any
+/// number of reader threads search and iterate over it, with no locks.
+///
+/// The writer uses the ordinary sequential algorithms. Every link it
+/// writes is a release store, and it sets up each new node completely
+/// before linking it in, so a reader (whose loads acquire) either sees the
+/// node whole or not at all. Level 0 is always a consistent list, so
+/// iteration sees each element that is there throughout, in order, and
+/// may or may not see elements inserted or erased as it goes.
+///
+/// A reader must hold a skip_list::read_guard for as long as it is in the
+/// list: while it holds one, nothing erased is destroyed. Erased nodes are
+/// handed to an epoch_domain, and destroyed once every reader that might
+/// have reached them has released its guard. Guards should be short; a
+/// reader that holds one indefinitely holds up reclamation indefinitely.
+///
+/// With this policy:
+///  - one thread at a time may insert, erase (by value, iterator or
+///    range) and clear;
+///  - any number of other threads, each holding a read_guard, may call
+///    find, count, contains, front, back, size, empty and iterate, in
+///    either direction. (Step backwards with operator--: a reverse_iterator
+///    follows the link again each time it is dereferenced, so may see
+///    different elements each time.)
+/// Everything else (assignment, swap, merge, extract, modify) must not run
+/// at the same time as a reader.
+struct single_writer
+{
+    static const bool is_concurrent = false;
+
+    template <typename NODE>
+    struct node_state
+    {
+        NODE *next_retired; ///< for the epoch_domain
+
+        void init_state() { next_retired = 0; }
+    };
+
+    template <typename NODE> struct link    { typedef lazy_link<NODE> type; };
+    template <typename N>    struct counter { typedef lazy_counter<N> type; };
+
+    template <typename NODE, typename Reclaimer, typename Allocator>
+    class list_state : public epoch_domain<NODE,Reclaimer,Allocator>
+    {
+    public:
+        typedef epoch_domain<NODE,Reclaimer,Allocator> domain_type;
+        typedef epoch_pin<domain_type>                 guard;
+
+        list_state(Reclaimer &reclaimer, const Allocator &alloc)
+            : domain_type(reclaimer, alloc) {}
+
+        /// Readers may still be looking at node
+        void dispose(Reclaimer &, NODE *node)
+        {
+            typename domain_type::record *rec = this->pin();
+            this->retire(rec, node);
+            this->unpin(rec);
+        }
+    };
+};
+
+} // namespace detail
+
+/// A skip_list that one thread may change while many others read it; see
+/// single_writer for the details.
+///
+///     rcu_skip_list<int> list;
+///
+///     // in the writer
+///     list.insert(10);
+///
+///     // in a reader
+///     rcu_skip_list<int>::read_guard guard(list);
+///     for (auto i = list.begin(); i != list.end(); ++i) ...
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+using rcu_skip_list = skip_list<T,Compare,Allocator,
+                                detail::skip_list_level_generator<32>,
+                                false,
+                                detail::single_writer>;
+
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
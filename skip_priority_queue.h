@@ -0,0 +1,333 @@
+//==============================================================================
+// skip_priority_queue.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "skip_list.h"
+
+#ifdef SKIP_LIST_CPP11
+    #include "concurrent_skip_list.h"
+    #include <thread>     // for std::thread::hardware_concurrency
+#endif
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - skip_priority_queue
+//==============================================================================
+
+namespace goodliffe {
+
+/// A priority queue adaptor over a multi_skip_list, with the smallest
+/// element (by Compare) first. It has std::priority_queue's push, top and
+/// pop (though note that std::priority_queue, by default, puts the largest
+/// element first), with pop_min to do both at once.
+///
+/// Both push and pop are O(log N); the smallest element is always at the
+/// front of the list, so top is O(1) and pop needs no search. Unlike a
+/// binary heap, the queue can also be iterated over in priority order.
+///
+/// @param T              Template type for kind of object held in the
+///                       container.
+/// @param Compare        Template type describing the ordering comparator.
+/// @param Allocator      Template type for memory allocator for the contents
+///                       of the container.
+/// @param LevelGenerator Template type for the node height generator.
+///
+/// @see concurrent_priority_queue
+template <typename T,
+          typename Compare        = std::less<T>,
+          typename Allocator      = std::allocator<T>,
+          typename LevelGenerator = detail::skip_list_level_generator<32> >
+class skip_priority_queue
+{
+public:
+
+    //======================================================================
+    // types
+
+    typedef multi_skip_list<T,Compare,Allocator,LevelGenerator> container_type;
+    typedef typename container_type::value_type                 value_type;
+    typedef typename container_type::allocator_type             allocator_type;
+    typedef typename container_type::size_type                  size_type;
+    typedef typename container_type::reference                  reference;
+    typedef typename container_type::const_reference            const_reference;
+    typedef typename container_type::const_iterator             const_iterator;
+    typedef Compare                                             compare;
+
+    //======================================================================
+    // lifetime management
+
+    explicit skip_priority_queue(const Allocator &alloc = Allocator())
+        : list(alloc) {}
+
+    template <class InputIterator>
+    skip_priority_queue(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
+        : list(first, last, alloc) {}
+
+    allocator_type get_allocator() const { return list.get_allocator(); }
+
+    //======================================================================
+    // capacity
+
+    bool      empty() const         { return list.empty(); }
+    size_type size() const          { return list.size(); }
+
+    //======================================================================
+    // element access
+
+    /// The smallest element. The queue must not be empty.
+    const_reference top() const     { return list.front(); }
+
+    /// Iterates over the queue in priority order, smallest first
+    const_iterator begin() const    { return list.begin(); }
+    const_iterator end() const      { return list.end(); }
+
+    //======================================================================
+    // modifiers
+
+    void push(const value_type &value)  { list.insert(value); }
+
+    /// Removes the smallest element. The queue must not be empty.
+    void pop()                          { list.erase(list.begin()); }
+
+    /// Removes the smallest element, and puts it in value.
+    /// Returns false (leaving value alone) if the queue is empty.
+    bool pop_min(value_type &value)
+    {
+        if (list.empty()) return false;
+        value = list.front();
+        pop();
+        return true;
+    }
+
+    void clear()                            { list.clear(); }
+    void swap(skip_priority_queue &other)   { list.swap(other.list); }
+
+    const container_type &container() const { return list; }
+
+private:
+    container_type list;
+};
+
+} // namespace goodliffe
+
+//==============================================================================
+#pragma mark - concurrent_priority_queue
+//==============================================================================
+
+#ifdef SKIP_LIST_CPP11
+
+namespace goodliffe {
+namespace detail {
+
+/// An element of a concurrent_priority_queue. The ticket makes every entry
+/// unique, so that the underlying concurrent_skip_list can hold equal
+/// values.
+///
+/// @internal
+template <typename T>
+struct cpq_entry
+{
+    T             value;
+    std::uint64_t ticket;
+};
+
+/// Orders cpq_entries by value, and then by ticket.
+///
+/// @internal
+template <typename T, typename Compare>
+struct cpq_entry_less
+{
+    Compare less;
+
+    bool operator()(const cpq_entry<T> &lhs, const cpq_entry<T> &rhs) const
+    {
+        if (less(lhs.value, rhs.value)) return true;
+        if (less(rhs.value, lhs.value)) return false;
+        return lhs.ticket < rhs.ticket;
+    }
+};
+
+/// A ticket no other call (in any thread) returns: the thread's own number
+/// in the top bits, and a per-thread count below. Threads never contend
+/// for tickets.
+///
+/// @internal
+inline
+std::uint64_t cpq_new_ticket()
+{
+    static std::atomic<std::uint32_t>   threads(0);
+    static thread_local std::uint64_t   next = 0;
+
+    if (!next) next = std::uint64_t(threads.fetch_add(1, std::memory_order_relaxed) + 1) << 40;
+    return next++;
+}
+
+/// A per-thread xorshift random number source for the spray, as in
+/// concurrent_level_generator.
+///
+/// @internal
+inline
+std::uint32_t cpq_random()
+{
+    static std::atomic<std::uint32_t>   seed(0x9e3779b9u);
+    static thread_local std::uint32_t   state = 0;
+
+    while (!state) state = seed.fetch_add(0x9e3779b9u, std::memory_order_relaxed);
+
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // namespace detail
+
+/// A priority queue that many threads may push to and pop from at once,
+/// with no locks, built on the lock-free concurrent_skip_list.
+///
+/// A queue that always hands out the very smallest element makes every
+/// popping thread fight over the front of the list. This one uses the
+/// SprayList technique instead: pop_min takes a short random walk (a
+/// "spray") from the head, and removes whichever element it lands on.
+/// The walk is sized from the number of threads expected, so that the
+/// threads mostly land on different elements, all of them near the front.
+///
+/// This makes pop_min relaxed. It returns one of the O(P log P) smallest
+/// elements, for P threads, rather than always the smallest; though with
+/// one thread expected it is exact. Either way, each element pushed is
+/// popped exactly once. A schedule that processes work in roughly priority
+/// order (e.g. a parallel Dijkstra or discrete event simulation) loses
+/// little from this, and scales far better.
+///
+/// Elements that compare equal come out in no particular order.
+///
+/// push, pop_min, empty and size are thread safe; clear(), and
+/// destruction, are not.
+///
+/// @param T         Template type for kind of object held in the container.
+/// @param Compare   Template type describing the ordering comparator.
+/// @param Allocator Template type for memory allocator for the contents of
+///                  the container. Must be safe to call from several threads
+///                  at once, as std::allocator is.
+///
+/// @see skip_priority_queue
+/// @see concurrent_skip_list
+template <typename T,
+          typename Compare   = std::less<T>,
+          typename Allocator = std::allocator<T> >
+class concurrent_priority_queue
+{
+    typedef detail::cpq_entry<T>                                     entry_type;
+    typedef typename Allocator::template rebind<entry_type>::other   entry_allocator;
+    typedef detail::csl_impl<entry_type,
+                             detail::cpq_entry_less<T,Compare>,
+                             entry_allocator,
+                             detail::concurrent_level_generator<32> > impl_type;
+    typedef typename impl_type::node_type                            node_type;
+    typedef typename impl_type::pin_type                             pin_type;
+
+    /// Sprays that land on an element someone else took, before pop_min
+    /// falls back to the front of the list
+    static const unsigned max_sprays = 4;
+
+public:
+
+    //======================================================================
+    // types
+
+    typedef T                                   value_type;
+    typedef Allocator                           allocator_type;
+    typedef typename impl_type::size_type       size_type;
+    typedef Compare                             compare;
+
+    //======================================================================
+    // lifetime management
+
+    /// @param threads The number of threads expected to pop at once; the
+    ///                default is the number the hardware can run. The more
+    ///                threads, the further each spray reaches.
+    explicit concurrent_priority_queue(unsigned threads = std::thread::hardware_concurrency(),
+                                       const Allocator &alloc = Allocator())
+        : impl(entry_allocator(alloc)), spray_height(0)
+    {
+        while (threads > 1)
+        {
+            threads /= 2;
+            ++spray_height;
+        }
+    }
+
+    allocator_type get_allocator() const { return allocator_type(impl.get_allocator()); }
+
+    //======================================================================
+    // capacity
+
+    /// With concurrent updates, these give a snapshot that may already be
+    /// out of date.
+    bool      empty() const         { pin_type pin(impl.get_domain()); return impl.front() == 0; }
+    size_type size() const          { return impl.size(); }
+
+    //======================================================================
+    // modifiers
+
+    void push(const value_type &value)
+    {
+        const entry_type entry = { value, detail::cpq_new_ticket() };
+        pin_type pin(impl.get_domain());
+        impl.insert(entry, pin.get());
+    }
+
+    /// Removes one of the smallest elements, and puts it in value.
+    /// Returns false (leaving value alone) if the queue is empty.
+    bool pop_min(value_type &value)
+    {
+        pin_type pin(impl.get_domain());
+        for (unsigned attempt = 0; ; ++attempt)
+        {
+            node_type *node = attempt < max_sprays
+                ? impl.spray(spray_height, spray_height, detail::cpq_random)
+                : impl.front();
+            if (!node) return false;
+
+            // Only the thread whose erase succeeds has taken the element
+            entry_type entry(node->value);
+            if (impl.erase(entry, pin.get()))
+            {
+                value = std::move(entry.value);
+                return true;
+            }
+        }
+    }
+
+    /// Not thread safe.
+    void clear() { impl.remove_all(); }
+
+private:
+    concurrent_priority_queue(const concurrent_priority_queue &other);
+    concurrent_priority_queue &operator=(const concurrent_priority_queue &other);
+
+    impl_type impl;
+    unsigned  spray_height; ///< log2 of the threads expected; also the longest jump
+};
+
+} // namespace goodliffe
+
+#endif // SKIP_LIST_CPP11
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -278,6 +278,18 @@ void IndexManually(const CONTAINER *container)
         (void)*i;
     }
 }
+template <typename CONTAINER>
+void StepThrough(const CONTAINER *container)
+{
+    // Short hops with std::advance, then std::distance back to the start
+    typename CONTAINER::const_iterator i = container->begin();
+    for (size_t left = container->size(); left >= 3; left -= 3)
+    {
+        std::advance(i, 3);
+        (void)*i;
+    }
+    (void)std::distance(container->begin(), i);
+}
 
 
 //============================================================================
@@ -453,6 +465,31 @@ Benchmark Indexing(unsigned size)
     return benchmark;
 }
 
+Benchmark Stepping(unsigned size);
+Benchmark Stepping(unsigned size)
+{
+    std::vector<int> data;
+    FillWithOrderedData(size, data);
+
+    std::set<int>                std_set(data.begin(), data.end());
+    std::list<int>               std_list(std_set.begin(), std_set.end());   // use set to ensure order
+    std::vector<int>             std_vector(std_set.begin(), std_set.end()); // use set to ensure order
+    multi_index                  multi(std_set.begin(), std_set.end()); // use set to ensure order;
+    skip_list<int>               skip_list(data.begin(), data.end());
+    random_access_skip_list<int> ra_skip_list(data.begin(), data.end());
+
+    Benchmark benchmark("iterator steps");
+
+    benchmark.set           = TimeExecutionOf(boost::bind(&StepThrough<std::set<int> >, &std_set));
+    benchmark.list          = TimeExecutionOf(boost::bind(&StepThrough<std::list<int> >, &std_list));
+    benchmark.vector        = TimeExecutionOf(boost::bind(&StepThrough<std::vector<int> >, &std_vector));
+    benchmark.multi         = TimeExecutionOf(boost::bind(&StepThrough<multi_index>, &multi));
+    benchmark.skip_list     = TimeExecutionOf(boost::bind(&StepThrough<goodliffe::skip_list<int> >, &skip_list));
+    benchmark.ra_skip_list  = TimeExecutionOf(boost::bind(&StepThrough<goodliffe::random_access_skip_list<int> >, &ra_skip_list));
+
+    return benchmark;
+}
+
 typedef boost::multi_index_container
     <
         int,
@@ -675,6 +712,7 @@ void RunBenchmarks(unsigned size)
     benchmarks.push_back(IterateBackwards(size));           Progress();
     benchmarks.push_back(Find(size));                       Progress();
     benchmarks.push_back(Indexing(size));                   Progress();
+    benchmarks.push_back(Stepping(size));                   Progress();
     benchmarks.push_back(Allocation(size));                 Progress();
     benchmarks.push_back(RandomUse(unsigned(size*0.4)));    Progress();
     
@@ -0,0 +1,151 @@
+//============================================================================
+// benchmark_aggregate.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Range aggregates over a weighted random_access_skip_list: aggregate(lo,hi),
+// which combines the weights kept on the links, against finding lo and
+// combining the weights of every element up to hi. Sums and maxima are
+// timed, as a max cannot be found by subtracting prefix sums.
+
+#include "random_access_skip_list.h"
+
+#include "get_time.h"
+
+#include <functional>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+using goodliffe::random_access_skip_list;
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Weights
+
+/// Each element weighs its own value
+struct SumWeight : goodliffe::additive_weight<long>
+{
+    long operator()(int value) const { return value; }
+};
+
+/// The largest of the elements' values
+struct MaxWeight
+{
+    typedef long result_type;
+    static long identity()                                 { return -1; }
+    static long combine(const long &lhs, const long &rhs) { return std::max(lhs, rhs); }
+    long operator()(int value) const { return value; }
+};
+
+template <typename WEIGHT>
+struct WeightedList
+{
+    typedef random_access_skip_list<int, std::less<int>, std::allocator<int>,
+                                    goodliffe::detail::skip_list_level_generator<32>,
+                                    false, unsigned, WEIGHT> type;
+};
+
+//============================================================================
+#pragma mark Timings
+
+const unsigned queries = 2000;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+long benchmark_sink = 0;
+
+template <typename WEIGHT>
+void Fill(typename WeightedList<WEIGHT>::type &list, unsigned size)
+{
+    srand(0);
+    while (list.size() < size) list.insert(rand() % int(size*10));
+}
+
+/// Returns microseconds for all the queries, each over a range of about
+/// range_size elements
+template <typename WEIGHT>
+long TimeAggregate(const typename WeightedList<WEIGHT>::type &list, unsigned range_size)
+{
+    srand(1);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        const int lo = rand() % int(list.size()*10);
+        benchmark_sink += list.aggregate(lo, lo + int(range_size*10));
+    }
+    return get_time_us() - start;
+}
+
+template <typename WEIGHT>
+long TimeIteration(const typename WeightedList<WEIGHT>::type &list, unsigned range_size)
+{
+    typedef typename WeightedList<WEIGHT>::type list_type;
+    const WEIGHT weight;
+
+    srand(1);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        const int lo = rand() % int(list.size()*10);
+        const int hi = lo + int(range_size*10);
+        long total = WEIGHT::identity();
+        typename list_type::const_iterator i = list.begin() + long(list.count_less(lo));
+        for (; i != list.end() && *i < hi; ++i)
+        {
+            total = WEIGHT::combine(total, weight(*i));
+        }
+        benchmark_sink += total;
+    }
+    return get_time_us() - start;
+}
+
+template <typename WEIGHT>
+void PrintRows(const char *name, unsigned size)
+{
+    typename WeightedList<WEIGHT>::type list;
+    Fill<WEIGHT>(list, size);
+
+    for (unsigned range_size = 10; range_size <= size; range_size *= 10)
+    {
+        const long aggregate = TimeAggregate<WEIGHT>(list, range_size);
+        const long iteration = TimeIteration<WEIGHT>(list, range_size);
+        fprintf(stderr, "| %-6s | %10u | %13ld | %13ld | %8.1fx |\n",
+                name, range_size, aggregate, iteration,
+                aggregate ? double(iteration)/double(aggregate) : 0.0);
+    }
+}
+
+//============================================================================
+#pragma mark Results
+
+TEST_CASE( "random_access_skip_list/aggregate benchmarks", "" )
+{
+    const unsigned size = 100000;
+
+    fprintf(stderr, "\n%u range queries over %u elements, in us\n", queries, size);
+    fprintf(stderr, "+========+============+===============+===============+===========+\n");
+    fprintf(stderr, "| monoid | range size |   aggregate   |   iteration   |  speedup  |\n");
+    fprintf(stderr, "+========+============+===============+===============+===========+\n");
+    PrintRows<SumWeight>("sum", size);
+    PrintRows<MaxWeight>("max", size);
+    fprintf(stderr, "+========+============+===============+===============+===========+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,189 @@
+//============================================================================
+// benchmark_blocked.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Memory use and speed of a blocked_skip_list of ints against a skip_list:
+// the bytes each asks its allocator for, then the time to insert shuffled
+// values, find every value, and iterate over the lot. Then the Find case,
+// with the blocks searched with SIMD and without.
+
+#include "skip_list.h"
+#include "blocked_skip_list.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark CountingAllocator
+
+/// Bytes currently allocated through any CountingAllocator
+long allocated_bytes = 0;
+
+template <typename T>
+struct CountingAllocator : std::allocator<T>
+{
+    template <typename OTHER>
+    struct rebind { typedef CountingAllocator<OTHER> other; };
+
+    CountingAllocator() {}
+    template <typename OTHER>
+    CountingAllocator(const CountingAllocator<OTHER> &) {}
+
+    T *allocate(size_t n, const void * = 0)
+    {
+        allocated_bytes += long(n*sizeof(T));
+        return std::allocator<T>::allocate(n);
+    }
+    void deallocate(T *p, size_t n)
+    {
+        allocated_bytes -= long(n*sizeof(T));
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+typedef goodliffe::skip_list<int, std::less<int>, CountingAllocator<int> >                 List;
+typedef goodliffe::blocked_skip_list<int, std::less<int>, CountingAllocator<int> >         Blocked;
+typedef goodliffe::blocked_skip_list<int, std::less<int>, CountingAllocator<int>,
+                                     goodliffe::detail::skip_list_level_generator<32>, 64> Blocked64;
+
+/// An ordering that bsl_block_search doesn't recognise, so the blocks are
+/// searched with the (scalar) branchless binary search, not SIMD
+struct ScalarLess
+{
+    bool operator()(int lhs, int rhs) const { return lhs < rhs; }
+};
+
+typedef goodliffe::blocked_skip_list<int, ScalarLess, CountingAllocator<int> > BlockedScalar;
+
+//============================================================================
+#pragma mark Workload
+
+typedef std::chrono::steady_clock Clock;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+size_t benchmark_sink = 0;
+
+long Microseconds(Clock::time_point start)
+{
+    return long(std::chrono::duration_cast<std::chrono::microseconds>(Clock::now() - start).count());
+}
+
+struct Result
+{
+    long bytes, insert, find, iterate;
+};
+
+template <typename LIST>
+Result Time(const std::vector<int> &values)
+{
+    Result result;
+    const long before = allocated_bytes;
+    LIST list;
+
+    Clock::time_point start = Clock::now();
+    for (size_t n = 0; n < values.size(); ++n) list.insert(values[n]);
+    result.insert = Microseconds(start);
+    result.bytes  = allocated_bytes - before;
+
+    start = Clock::now();
+    for (int n = 0; n < int(values.size()); ++n) benchmark_sink += list.find(n) != list.end();
+    result.find = Microseconds(start);
+
+    start = Clock::now();
+    for (unsigned repeat = 0; repeat < 10; ++repeat)
+    {
+        for (typename LIST::const_iterator i = list.begin(); i != list.end(); ++i) benchmark_sink += size_t(*i);
+    }
+    result.iterate = Microseconds(start);
+    return result;
+}
+
+//============================================================================
+#pragma mark Results
+
+void Report(const char *list, const Result &result, size_t count)
+{
+    fprintf(stderr, "| %-12s | %10.1f | %9ld | %9ld | %9ld |\n",
+            list, double(result.bytes)/double(count),
+            result.insert, result.find, result.iterate);
+}
+
+TEST_CASE( "blocked_skip_list/benchmarks", "" )
+{
+    srand(0);
+    for (unsigned count = 1000; count <= 1000000; count *= 10)
+    {
+        std::vector<int> values;
+        for (unsigned n = 0; n < count; ++n) values.push_back(int(n));
+        std::random_shuffle(values.begin(), values.end());
+
+        fprintf(stderr, "\n%u shuffled ints; times in us (iterate is 10 passes)\n", count);
+        fprintf(stderr, "+==============+============+===========+===========+===========+\n");
+        fprintf(stderr, "| list         | bytes/item |  insert   |   find    |  iterate  |\n");
+        fprintf(stderr, "+==============+============+===========+===========+===========+\n");
+        Report("skip_list",   Time<List>(values),      count);
+        Report("blocked(32)", Time<Blocked>(values),   count);
+        Report("blocked(64)", Time<Blocked64>(values), count);
+        fprintf(stderr, "+==============+============+===========+===========+===========+\n");
+    }
+}
+
+/// As the Find case in benchmark.cpp: ordered data, then find every value
+template <typename LIST>
+long Find(unsigned count, unsigned repeats)
+{
+    LIST list;
+    for (unsigned n = 0; n < count; ++n) list.insert(int(n));
+
+    const Clock::time_point start = Clock::now();
+    for (unsigned repeat = 0; repeat < repeats; ++repeat)
+    {
+        for (int n = 0; n < int(count); ++n) benchmark_sink += list.find(n) != list.end();
+    }
+    return Microseconds(start);
+}
+
+TEST_CASE( "blocked_skip_list/benchmarks/find", "" )
+{
+#ifdef SKIP_LIST_AVX2
+    const char *simd = "AVX2";
+#else
+    const char *simd = "none (build with AVX2 to enable)";
+#endif
+    fprintf(stderr, "\nfind, ordered ints; block search SIMD: %s; times in us\n", simd);
+    fprintf(stderr, "+==========+=========+===========+===========+===========+\n");
+    fprintf(stderr, "|     size | repeats | skip_list |  blocked  |  scalar   |\n");
+    fprintf(stderr, "+==========+=========+===========+===========+===========+\n");
+    for (unsigned count = 10; count <= 1000000; count *= 10)
+    {
+        const unsigned repeats = 1000000/count;
+        fprintf(stderr, "| %8u | %7u | %9ld | %9ld | %9ld |\n",
+                count, repeats,
+                Find<List>(count, repeats), Find<Blocked>(count, repeats), Find<BlockedScalar>(count, repeats));
+    }
+    fprintf(stderr, "+==========+=========+===========+===========+===========+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
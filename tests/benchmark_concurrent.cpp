@@ -0,0 +1,415 @@
+//============================================================================
+// benchmark_concurrent.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Multi-threaded throughput of the concurrent_skip_list, the
+// lazy_skip_list and the sharded_skip_list, against a skip_list guarded by
+// a single mutex; and how much memory the concurrent_skip_list holds on to
+// while erased elements wait to be reclaimed. Also how building a list from
+// sorted data with parallel_assign_sorted, and visiting it with
+// parallel_for_each, scale with threads.
+
+#include "skip_list.h"
+#include "concurrent_skip_list.h"
+#include "skip_list_lazy.h"
+#include "sharded_skip_list.h"
+#include "random_access_skip_list.h"
+#include "skip_list_parallel.h"
+
+#include "get_time.h"
+
+#include <vector>
+#include <algorithm>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdio>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+using goodliffe::skip_list;
+using goodliffe::concurrent_skip_list;
+using goodliffe::lazy_skip_list;
+using goodliffe::sharded_skip_list;
+using goodliffe::random_access_skip_list;
+using goodliffe::parallel_assign_sorted;
+using goodliffe::parallel_for_each;
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Containers under test
+
+/// A skip_list behind one big lock: what you have to do without
+/// concurrent_skip_list.
+class LockedSkipList
+{
+public:
+    bool insert(int value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return list.insert(value).second;
+    }
+    bool erase(int value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return list.erase(value) != 0;
+    }
+    bool contains(int value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return list.contains(value);
+    }
+
+private:
+    std::mutex     mutex;
+    skip_list<int> list;
+};
+
+/// Bytes allocated through any CountingAllocator, now and at most
+std::atomic<long> live_bytes(0);
+std::atomic<long> peak_bytes(0);
+
+template <typename T>
+struct CountingAllocator : std::allocator<T>
+{
+    template <typename OTHER>
+    struct rebind { typedef CountingAllocator<OTHER> other; };
+
+    CountingAllocator() {}
+    template <typename OTHER>
+    CountingAllocator(const CountingAllocator<OTHER> &) {}
+
+    T *allocate(std::size_t n, const void * = 0)
+    {
+        const long live = live_bytes += long(n*sizeof(T));
+        long peak = peak_bytes.load(std::memory_order_relaxed);
+        while (live > peak && !peak_bytes.compare_exchange_weak(peak, live)) {}
+        return std::allocator<T>::allocate(n);
+    }
+    void deallocate(T *p, std::size_t n)
+    {
+        live_bytes -= long(n*sizeof(T));
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+template <typename Allocator = std::allocator<int> >
+class ConcurrentSkipList
+{
+public:
+    bool insert(int value)   { return list.insert(value).second; }
+    bool erase(int value)    { return list.erase(value) != 0; }
+    bool contains(int value) { return list.contains(value); }
+    size_t size() const      { return list.size(); }
+
+private:
+    concurrent_skip_list<int,std::less<int>,Allocator> list;
+};
+
+/// A skip_list with per-node locks, taken only by writers
+class LazySkipList
+{
+public:
+    bool insert(int value)   { return list.insert(value).second; }
+    bool erase(int value)    { return list.erase(value) != 0; }
+    bool contains(int value) { return list.contains(value); }
+
+private:
+    lazy_skip_list<int> list;
+};
+
+/// Eight skip_lists, each behind its own lock
+class ShardedSkipList
+{
+public:
+    bool insert(int value)   { return list.insert(value); }
+    bool erase(int value)    { return list.erase(value) != 0; }
+    bool contains(int value) { return list.contains(value); }
+
+private:
+    sharded_skip_list<int,8> list;
+};
+
+//============================================================================
+#pragma mark Workload
+
+struct Workload
+{
+    const char *name;
+    unsigned    find_percent;   ///< the rest are split evenly between insert and erase
+    int         key_range;
+    unsigned    ops_per_thread;
+};
+
+/// A cheap per-thread random number source; std::rand would serialise the
+/// threads on its own lock and swamp the measurement.
+struct FastRandom
+{
+    explicit FastRandom(unsigned seed) : state(seed*2654435761u + 1) {}
+    unsigned operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    unsigned state;
+};
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+std::atomic<unsigned> benchmark_sink(0);
+
+template <typename CONTAINER>
+void RunOperations(CONTAINER *container, const Workload *workload, unsigned seed)
+{
+    FastRandom random(seed);
+    unsigned   successes = 0;
+    for (unsigned n = 0; n < workload->ops_per_thread; ++n)
+    {
+        const unsigned op    = random() % 100;
+        const int      value = int(random() % unsigned(workload->key_range));
+
+        if (op < workload->find_percent)
+            successes += container->contains(value);
+        else if (op % 2)
+            successes += container->insert(value);
+        else
+            successes += container->erase(value);
+    }
+    benchmark_sink += successes;
+}
+
+template <typename CONTAINER>
+void RunThreads(CONTAINER &container, const Workload &workload, unsigned num_threads)
+{
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread(&RunOperations<CONTAINER>, &container, &workload, t+1));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+}
+
+/// Returns operations per millisecond
+template <typename CONTAINER>
+long TimeThreads(const Workload &workload, unsigned num_threads)
+{
+    CONTAINER container;
+
+    // Prefill to half full, so inserts and erases both usually do something
+    for (int n = 0; n < workload.key_range; n += 2) container.insert(n);
+
+    const long start = get_time_us();
+    RunThreads(container, workload, num_threads);
+    const long end = get_time_us();
+
+    const long total_ops = long(workload.ops_per_thread) * long(num_threads);
+    return end > start ? total_ops * 1000 / (end-start) : 0;
+}
+
+//============================================================================
+#pragma mark Results
+
+void RunBenchmarks(const Workload &workload);
+void RunBenchmarks(const Workload &workload)
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    fprintf(stderr, "\n%s (%u%% find, %d keys, %u ops/thread), in ops/ms\n",
+            workload.name, workload.find_percent, workload.key_range, workload.ops_per_thread);
+    fprintf(stderr, "+=========+==================+=================+=================+======================+=========+\n");
+    fprintf(stderr, "| threads | locked skip_list | lazy_skip_list  | sharded (8)     | concurrent_skip_list | speedup |\n");
+    fprintf(stderr, "+=========+==================+=================+=================+======================+=========+\n");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        const long locked     = TimeThreads<LockedSkipList>(workload, threads);
+        const long lazy       = TimeThreads<LazySkipList>(workload, threads);
+        const long sharded    = TimeThreads<ShardedSkipList>(workload, threads);
+        const long concurrent = TimeThreads<ConcurrentSkipList<> >(workload, threads);
+        long best = lazy > concurrent ? lazy : concurrent;
+        if (sharded > best) best = sharded;
+        fprintf(stderr, "| %7u | %16ld | %15ld | %15ld | %20ld | %6.2fx |\n",
+                threads, locked, lazy, sharded, concurrent, locked ? double(best)/double(locked) : 0.0);
+    }
+    fprintf(stderr, "+=========+==================+=================+=================+======================+=========+\n");
+}
+
+/// The most memory held while running workload, against what the elements
+/// left at the end need
+void RunMemoryBenchmarks(const Workload &workload);
+void RunMemoryBenchmarks(const Workload &workload)
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    fprintf(stderr, "\n%s (%u%% find, %d keys, %u ops/thread), memory high water mark in KB\n",
+            workload.name, workload.find_percent, workload.key_range, workload.ops_per_thread);
+    fprintf(stderr, "+=========+===========+===========+==========+\n");
+    fprintf(stderr, "| threads | peak (KB) | live (KB) | overhead |\n");
+    fprintf(stderr, "+=========+===========+===========+==========+\n");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        ConcurrentSkipList<CountingAllocator<int> > container;
+        for (int n = 0; n < workload.key_range; n += 2) container.insert(n);
+        peak_bytes = live_bytes.load();
+
+        RunThreads(container, workload, threads);
+
+        const long peak = peak_bytes.load();
+        const long live = live_bytes.load();
+        fprintf(stderr, "| %7u | %9ld | %9ld | %7.2fx |\n",
+                threads, peak/1024, live/1024, live ? double(peak)/double(live) : 0.0);
+    }
+    fprintf(stderr, "+=========+===========+===========+==========+\n");
+}
+
+TEST_CASE( "concurrent_skip_list/benchmarks", "" )
+{
+    const Workload workloads[] =
+    {
+        { "read mostly", 90, 100000, 200000 },
+        { "balanced",    50, 100000, 200000 },
+        { "write heavy", 10, 100000, 200000 },
+        { "hot spot",    50,    100, 200000 },
+    };
+
+    for (unsigned n = 0; n < sizeof(workloads)/sizeof(*workloads); ++n)
+    {
+        RunBenchmarks(workloads[n]);
+    }
+}
+
+TEST_CASE( "concurrent_skip_list/memory benchmarks", "" )
+{
+    const Workload workloads[] =
+    {
+        { "balanced",    50, 100000, 200000 },
+        { "write heavy", 10, 100000, 200000 },
+        { "hot spot",    50,    100, 200000 },
+    };
+
+    for (unsigned n = 0; n < sizeof(workloads)/sizeof(*workloads); ++n)
+    {
+        RunMemoryBenchmarks(workloads[n]);
+    }
+}
+
+/// Returns microseconds to build a LIST of data on the given threads
+template <typename LIST>
+long TimeBuild(const std::vector<int> &data, unsigned num_threads)
+{
+    LIST list;
+    const long start = get_time_us();
+    parallel_assign_sorted(list, data.begin(), data.end(), num_threads);
+    const long end = get_time_us();
+    benchmark_sink += unsigned(list.size());
+    return end - start;
+}
+
+TEST_CASE( "parallel_assign_sorted/benchmarks", "" )
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    // parallel_assign_sorted needs levels that are safe to draw from many threads
+    typedef goodliffe::detail::concurrent_level_generator<32> Levels;
+    typedef skip_list<int,std::less<int>,std::allocator<int>,Levels> ParallelSkipList;
+    typedef random_access_skip_list<int,std::less<int>,std::allocator<int>,Levels> ParallelRasl;
+
+    std::vector<int> data;
+    for (int n = 0; n < 4000000; ++n) data.push_back(n);
+
+    fprintf(stderr, "\nbuilding from %u sorted values, in ms\n", unsigned(data.size()));
+    fprintf(stderr, "+=========+=================+=========================+\n");
+    fprintf(stderr, "| threads | skip_list       | random_access_skip_list |\n");
+    fprintf(stderr, "+=========+=================+=========================+\n");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        const long list = TimeBuild<ParallelSkipList>(data, threads);
+        const long rasl = TimeBuild<ParallelRasl>(data, threads);
+        fprintf(stderr, "| %7u | %15ld | %23ld |\n",
+                threads, list/1000, rasl/1000);
+    }
+    fprintf(stderr, "+=========+=================+=========================+\n");
+}
+
+/// Some arithmetic per element, so that there is work to share out
+struct Churn
+{
+    explicit Churn(std::atomic<unsigned> &total_) : total(total_), sum(0) {}
+    Churn(const Churn &other) : total(other.total), sum(0) {}
+    ~Churn() { total += sum; }
+
+    void operator()(int value)
+    {
+        unsigned x = unsigned(value);
+        for (unsigned n = 0; n < 32; ++n) x = x*1103515245u + 12345u;
+        sum += x;
+    }
+
+    std::atomic<unsigned> &total;
+    unsigned               sum;
+};
+
+/// Returns microseconds to visit every element of list on the given threads
+/// (with std::for_each for 0)
+template <typename LIST>
+long TimeForEach(const LIST &list, unsigned num_threads)
+{
+    const long start = get_time_us();
+    if (num_threads)
+        parallel_for_each(list, Churn(benchmark_sink), num_threads);
+    else
+        std::for_each(list.begin(), list.end(), Churn(benchmark_sink));
+    const long end = get_time_us();
+    return end - start;
+}
+
+TEST_CASE( "parallel_for_each/benchmarks", "" )
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    std::vector<int> data;
+    for (int n = 0; n < 2000000; ++n) data.push_back(n);
+    skip_list<int>               list;
+    random_access_skip_list<int> rasl;
+    list.assign_sorted(data.begin(), data.end());
+    rasl.assign_sorted(data.begin(), data.end());
+
+    fprintf(stderr, "\nvisiting %u elements, in ms (threads 0 is std::for_each)\n", unsigned(data.size()));
+    fprintf(stderr, "+=========+=================+=========================+\n");
+    fprintf(stderr, "| threads | skip_list       | random_access_skip_list |\n");
+    fprintf(stderr, "+=========+=================+=========================+\n");
+
+    for (unsigned threads = 0; threads <= max_threads; threads = threads ? threads*2 : 1)
+    {
+        const long plain  = TimeForEach(list, threads);
+        const long random = TimeForEach(rasl, threads);
+        fprintf(stderr, "| %7u | %15ld | %23ld |\n", threads, plain/1000, random/1000);
+    }
+    fprintf(stderr, "+=========+=================+=========================+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
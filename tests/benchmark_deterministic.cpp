@@ -0,0 +1,137 @@
+//============================================================================
+// benchmark_deterministic.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Latency of single finds, inserts and erases in a deterministic (1-2-3)
+// skip_list, against one with random levels: the median, and the tail
+// (99th and 99.9th percentiles, and the worst), as the mean hides the
+// occasional slow operation that the deterministic list is there to
+// prevent.
+
+#include "skip_list.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Workload
+
+typedef goodliffe::skip_list<int>               RandomList;
+typedef goodliffe::deterministic_skip_list<int> DeterministicList;
+
+typedef std::chrono::steady_clock Clock;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+size_t benchmark_sink = 0;
+
+std::vector<int> MakeValues(unsigned count, bool ascending)
+{
+    std::vector<int> values;
+    for (unsigned n = 0; n < count; ++n) values.push_back(int(n)*2);
+    if (!ascending) std::random_shuffle(values.begin(), values.end());
+    return values;
+}
+
+struct Latencies
+{
+    std::vector<long> insert, find, erase;
+};
+
+long Nanoseconds(Clock::time_point start)
+{
+    return long(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+}
+
+/// Times each insert, then a find of every value, then erasing every value
+template <typename LIST>
+Latencies Time(const std::vector<int> &values)
+{
+    Latencies latencies;
+    LIST list;
+    for (size_t n = 0; n < values.size(); ++n)
+    {
+        const Clock::time_point start = Clock::now();
+        list.insert(values[n]);
+        latencies.insert.push_back(Nanoseconds(start));
+    }
+    for (size_t n = 0; n < values.size(); ++n)
+    {
+        const Clock::time_point start = Clock::now();
+        benchmark_sink += list.find(values[n]) != list.end();
+        latencies.find.push_back(Nanoseconds(start));
+    }
+    for (size_t n = 0; n < values.size(); ++n)
+    {
+        const Clock::time_point start = Clock::now();
+        list.erase(values[n]);
+        latencies.erase.push_back(Nanoseconds(start));
+    }
+    return latencies;
+}
+
+long Percentile(std::vector<long> &latencies, double fraction)
+{
+    std::sort(latencies.begin(), latencies.end());
+    return latencies[size_t(fraction * double(latencies.size()-1))];
+}
+
+//============================================================================
+#pragma mark Results
+
+void Report(const char *list, const char *op, std::vector<long> &latencies)
+{
+    fprintf(stderr, "| %-13s | %-6s | %9ld | %9ld | %9ld | %9ld |\n",
+            list, op,
+            Percentile(latencies, 0.5), Percentile(latencies, 0.99),
+            Percentile(latencies, 0.999), Percentile(latencies, 1.0));
+}
+
+TEST_CASE( "deterministic_skip_list/benchmarks", "" )
+{
+    const unsigned count = 200000;
+    srand(0);
+
+    for (int ascending = 0; ascending < 2; ++ascending)
+    {
+        const std::vector<int> values = MakeValues(count, ascending != 0);
+
+        fprintf(stderr, "\n%u %s values, latency per operation in ns\n", count, ascending ? "ascending" : "shuffled");
+        fprintf(stderr, "+===============+========+===========+===========+===========+===========+\n");
+        fprintf(stderr, "| list          |   op   |  median   |   p99     |  p99.9    |   worst   |\n");
+        fprintf(stderr, "+===============+========+===========+===========+===========+===========+\n");
+
+        Latencies random        = Time<RandomList>(values);
+        Latencies deterministic = Time<DeterministicList>(values);
+        Report("random",        "insert", random.insert);
+        Report("deterministic", "insert", deterministic.insert);
+        Report("random",        "find",   random.find);
+        Report("deterministic", "find",   deterministic.find);
+        Report("random",        "erase",  random.erase);
+        Report("deterministic", "erase",  deterministic.erase);
+        fprintf(stderr, "+===============+========+===========+===========+===========+===========+\n");
+    }
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -0,0 +1,102 @@
+//============================================================================
+// benchmark_express.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Searches of a large skip_list of ints with and without an express index
+// over its top levels: find shuffled values, then the same again with every
+// find followed by an erase and reinsert, to show what rebuilding costs.
+
+#include "skip_list.h"
+
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Workload
+
+typedef goodliffe::skip_list<int>     List;
+typedef std::chrono::steady_clock     Clock;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+size_t benchmark_sink = 0;
+
+long Milliseconds(Clock::time_point start)
+{
+    return long(std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count());
+}
+
+/// Find each of the probes
+long Find(const List &list, const std::vector<int> &probes)
+{
+    const Clock::time_point start = Clock::now();
+    for (size_t n = 0; n < probes.size(); ++n) benchmark_sink += list.find(probes[n]) != list.end();
+    return Milliseconds(start);
+}
+
+/// Find each of the probes, then erase it and put it back
+long Churn(List &list, const std::vector<int> &probes)
+{
+    const Clock::time_point start = Clock::now();
+    for (size_t n = 0; n < probes.size(); ++n)
+    {
+        benchmark_sink += list.find(probes[n]) != list.end();
+        list.erase(probes[n]);
+        list.insert(probes[n]);
+    }
+    return Milliseconds(start);
+}
+
+//============================================================================
+#pragma mark Results
+
+TEST_CASE( "skip_list/benchmarks/express index", "" )
+{
+    const unsigned count  = 10000000;
+    const unsigned probes = 2000000;
+
+    srand(0);
+    List list;
+    for (unsigned n = 0; n < count; ++n) list.insert(int(n*2));
+
+    std::vector<int> values;
+    for (unsigned n = 0; n < probes; ++n) values.push_back(int((unsigned(rand()) * 7919u) % (count*2)));
+
+    fprintf(stderr, "\n%u ints, %u random finds; times in ms\n", count, probes);
+    fprintf(stderr, "+========+=========+=========+\n");
+    fprintf(stderr, "| levels |  find   |  churn  |\n");
+    fprintf(stderr, "+========+=========+=========+\n");
+    const unsigned levels[] = { 0, 4, 8, 12, 16 };
+    for (unsigned n = 0; n < sizeof(levels)/sizeof(*levels); ++n)
+    {
+        list.set_express_levels(levels[n]);
+        benchmark_sink += list.find(0) != list.end(); // build the index outside the timings
+        const long find  = Find(list, values);
+        const long churn = Churn(list, values);
+        fprintf(stderr, "| %6u | %7ld | %7ld |\n", levels[n], find, churn);
+    }
+    fprintf(stderr, "+========+=========+=========+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
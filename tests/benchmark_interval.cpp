@@ -0,0 +1,183 @@
+//============================================================================
+// benchmark_interval.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Stabbing and overlap queries on an interval_skip_list, against a
+// multi_skip_list of the same intervals ordered by start, which has to
+// scan every interval that starts before the point to find those that
+// hold it.
+
+#include "interval_skip_list.h"
+
+#include "get_time.h"
+
+#include <vector>
+#include <iterator>
+#include <cstdio>
+#include <cstdlib>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+using goodliffe::interval_skip_list;
+using goodliffe::multi_skip_list;
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Workload
+
+typedef goodliffe::interval<int>  Interval;
+typedef multi_skip_list<Interval> ScanList;
+
+const unsigned queries    = 2000;
+const int      max_length = 1000;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+size_t benchmark_sink = 0;
+
+std::vector<Interval> MakeIntervals(unsigned count)
+{
+    srand(0);
+    std::vector<Interval> intervals;
+    for (unsigned n = 0; n < count; ++n)
+    {
+        const int first = rand() % int(count*10);
+        intervals.push_back(Interval(first, first + rand() % max_length));
+    }
+    return intervals;
+}
+
+/// What we did before: walk the intervals that start at or before the
+/// point, keeping those that have not ended
+template <typename OutputIterator>
+void ScanStab(const ScanList &list, int point, OutputIterator out)
+{
+    for (ScanList::const_iterator i = list.begin(); i != list.end() && i->first <= point; ++i)
+    {
+        if (point <= i->second) *out++ = *i;
+    }
+}
+
+template <typename OutputIterator>
+void ScanOverlaps(const ScanList &list, int lo, int hi, OutputIterator out)
+{
+    for (ScanList::const_iterator i = list.begin(); i != list.end() && i->first <= hi; ++i)
+    {
+        if (lo <= i->second) *out++ = *i;
+    }
+}
+
+//============================================================================
+#pragma mark Timings
+
+/// Each returns microseconds for all the queries
+
+long TimeStab(const interval_skip_list<int> &list, unsigned count)
+{
+    std::vector<Interval> found;
+    srand(1);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        found.clear();
+        list.stab(rand() % int(count*10), std::back_inserter(found));
+        benchmark_sink += found.size();
+    }
+    return get_time_us() - start;
+}
+
+long TimeScanStab(const ScanList &list, unsigned count)
+{
+    std::vector<Interval> found;
+    srand(1);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        found.clear();
+        ScanStab(list, rand() % int(count*10), std::back_inserter(found));
+        benchmark_sink += found.size();
+    }
+    return get_time_us() - start;
+}
+
+long TimeOverlaps(const interval_skip_list<int> &list, unsigned count)
+{
+    std::vector<Interval> found;
+    srand(2);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        found.clear();
+        const int lo = rand() % int(count*10);
+        list.overlaps(lo, lo + max_length, std::back_inserter(found));
+        benchmark_sink += found.size();
+    }
+    return get_time_us() - start;
+}
+
+long TimeScanOverlaps(const ScanList &list, unsigned count)
+{
+    std::vector<Interval> found;
+    srand(2);
+    const long start = get_time_us();
+    for (unsigned n = 0; n < queries; ++n)
+    {
+        found.clear();
+        const int lo = rand() % int(count*10);
+        ScanOverlaps(list, lo, lo + max_length, std::back_inserter(found));
+        benchmark_sink += found.size();
+    }
+    return get_time_us() - start;
+}
+
+//============================================================================
+#pragma mark Results
+
+TEST_CASE( "interval_skip_list/benchmarks", "" )
+{
+    fprintf(stderr, "\n%u queries, intervals up to %d long, in us\n", queries, max_length);
+    fprintf(stderr, "+===========+===========+===========+===========+===========+===========+===========+===========+\n");
+    fprintf(stderr, "| intervals |  build    | build isl |   scan    | isl stab  |  speedup  |   scan    |isl overlap|\n");
+    fprintf(stderr, "|           |  scan     |           |   stab    |           |           | overlaps  |           |\n");
+    fprintf(stderr, "+===========+===========+===========+===========+===========+===========+===========+===========+\n");
+
+    for (unsigned count = 1000; count <= 100000; count *= 10)
+    {
+        const std::vector<Interval> intervals = MakeIntervals(count);
+
+        long start = get_time_us();
+        ScanList scan(intervals.begin(), intervals.end());
+        const long build_scan = get_time_us() - start;
+
+        start = get_time_us();
+        interval_skip_list<int> isl(intervals.begin(), intervals.end());
+        const long build_isl = get_time_us() - start;
+
+        const long scan_stab     = TimeScanStab(scan, count);
+        const long isl_stab      = TimeStab(isl, count);
+        const long scan_overlaps = TimeScanOverlaps(scan, count);
+        const long isl_overlaps  = TimeOverlaps(isl, count);
+        fprintf(stderr, "| %9u | %9ld | %9ld | %9ld | %9ld | %8.1fx | %9ld | %9ld |\n",
+                count, build_scan, build_isl, scan_stab, isl_stab,
+                isl_stab ? double(scan_stab)/double(isl_stab) : 0.0,
+                scan_overlaps, isl_overlaps);
+    }
+    fprintf(stderr, "+===========+===========+===========+===========+===========+===========+===========+===========+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
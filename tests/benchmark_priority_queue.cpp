@@ -0,0 +1,204 @@
+//============================================================================
+// benchmark_priority_queue.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+// Multi-threaded throughput of the concurrent_priority_queue, against a
+// std::priority_queue and a skip_priority_queue each behind a single
+// mutex, and against a concurrent_priority_queue whose pops are exact (so
+// every thread fights over the front of the list).
+
+#include "skip_priority_queue.h"
+
+#include "get_time.h"
+
+#include <queue>
+#include <vector>
+#include <functional>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <cstdio>
+
+#if BENCHMARK_WITH_MAIN
+#define CATCH_CONFIG_MAIN
+#endif
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION
+#include "catch.hpp"
+
+using goodliffe::skip_priority_queue;
+using goodliffe::concurrent_priority_queue;
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//============================================================================
+#pragma mark Containers under test
+
+/// A std::priority_queue behind one big lock
+class LockedStdQueue
+{
+public:
+    explicit LockedStdQueue(unsigned) {}
+    void push(int value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push(value);
+    }
+    bool pop_min(int &value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (queue.empty()) return false;
+        value = queue.top();
+        queue.pop();
+        return true;
+    }
+
+private:
+    std::mutex mutex;
+    std::priority_queue<int, std::vector<int>, std::greater<int> > queue;
+};
+
+/// A skip_priority_queue behind one big lock
+class LockedSkipQueue
+{
+public:
+    explicit LockedSkipQueue(unsigned) {}
+    void push(int value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        queue.push(value);
+    }
+    bool pop_min(int &value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return queue.pop_min(value);
+    }
+
+private:
+    std::mutex               mutex;
+    skip_priority_queue<int> queue;
+};
+
+/// Told to expect one thread, so pops always take the smallest element
+class ExactConcurrentQueue
+{
+public:
+    explicit ExactConcurrentQueue(unsigned) : queue(1) {}
+    void push(int value)            { queue.push(value); }
+    bool pop_min(int &value)        { return queue.pop_min(value); }
+
+private:
+    concurrent_priority_queue<int> queue;
+};
+
+/// Sprays sized for the number of threads running
+class SprayConcurrentQueue
+{
+public:
+    explicit SprayConcurrentQueue(unsigned threads) : queue(threads) {}
+    void push(int value)            { queue.push(value); }
+    bool pop_min(int &value)        { return queue.pop_min(value); }
+
+private:
+    concurrent_priority_queue<int> queue;
+};
+
+//============================================================================
+#pragma mark Workload
+
+/// A cheap per-thread random number source; std::rand would serialise the
+/// threads on its own lock and swamp the measurement.
+struct FastRandom
+{
+    explicit FastRandom(unsigned seed) : state(seed*2654435761u + 1) {}
+    unsigned operator()()
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        return state;
+    }
+    unsigned state;
+};
+
+const unsigned ops_per_thread = 200000;
+const unsigned prefill        = 100000;
+
+/// Somewhere to put results, so the compiler can't optimise the work away
+std::atomic<unsigned> benchmark_sink(0);
+
+/// Alternates pushes and pops, as a scheduler or a parallel search would:
+/// each pop is followed by a push of a slightly later priority
+template <typename QUEUE>
+void RunOperations(QUEUE *queue, unsigned seed)
+{
+    FastRandom random(seed);
+    unsigned   sum = 0;
+    for (unsigned n = 0; n < ops_per_thread/2; ++n)
+    {
+        int value = 0;
+        if (queue->pop_min(value)) sum += unsigned(value);
+        queue->push(value + int(random() % 1000));
+    }
+    benchmark_sink += sum;
+}
+
+/// Returns operations per millisecond
+template <typename QUEUE>
+long TimeThreads(unsigned num_threads)
+{
+    QUEUE queue(num_threads);
+
+    FastRandom random(0);
+    for (unsigned n = 0; n < prefill; ++n) queue.push(int(random() % (prefill*10)));
+
+    const long start = get_time_us();
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread(&RunOperations<QUEUE>, &queue, t+1));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+    const long end = get_time_us();
+
+    const long total_ops = long(ops_per_thread) * long(num_threads);
+    return end > start ? total_ops * 1000 / (end-start) : 0;
+}
+
+//============================================================================
+#pragma mark Results
+
+TEST_CASE( "concurrent_priority_queue/benchmarks", "" )
+{
+    unsigned max_threads = std::thread::hardware_concurrency();
+    if (max_threads < 4) max_threads = 4;
+
+    fprintf(stderr, "\npush/pop_min pairs (%u queued, %u ops/thread), in ops/ms\n", prefill, ops_per_thread);
+    fprintf(stderr, "+=========+=================+=================+=================+=================+=========+\n");
+    fprintf(stderr, "| threads | locked std::pq  | locked skip pq  | concurrent exact| concurrent spray| speedup |\n");
+    fprintf(stderr, "+=========+=================+=================+=================+=================+=========+\n");
+
+    for (unsigned threads = 1; threads <= max_threads; threads *= 2)
+    {
+        const long locked_std  = TimeThreads<LockedStdQueue>(threads);
+        const long locked_skip = TimeThreads<LockedSkipQueue>(threads);
+        const long exact       = TimeThreads<ExactConcurrentQueue>(threads);
+        const long spray       = TimeThreads<SprayConcurrentQueue>(threads);
+        fprintf(stderr, "| %7u | %15ld | %15ld | %15ld | %15ld | %6.2fx |\n",
+                threads, locked_std, locked_skip, exact, spray,
+                locked_std ? double(spray)/double(locked_std) : 0.0);
+    }
+    fprintf(stderr, "+=========+=================+=================+=================+=================+=========+\n");
+}
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif
@@ -1,5 +1,14 @@
 echo "Running unit tests..."
 g++ test.cpp -I. -I.. && ./a.out && echo "Tests passed"; rm a.out
 
+# The AVX2 block search is only compiled in for AVX2 targets, so build the
+# blocked_skip_list tests again for one, if this machine can run them
+echo "Running blocked_skip_list tests with AVX2..."
+if echo | g++ -march=native -dM -E - | grep -q __AVX2__; then
+    g++ -mavx2 test_skip_list.cpp test_blocked_skip_list.cpp -I. -I.. && ./a.out && echo "AVX2 tests passed"; rm a.out
+else
+    echo "No AVX2 on this machine: skipped"
+fi
+
 echo "Running benchmarks..."
 g++ benchmark.cpp -I.. -I. -DBENCHMARK_WITH_MAIN && ./a.out; rm a.out
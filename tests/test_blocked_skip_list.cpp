@@ -0,0 +1,242 @@
+//============================================================================
+// test_blocked_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "blocked_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <vector>
+#include <functional>
+
+using goodliffe::blocked_skip_list;
+
+namespace
+{
+    /// Small blocks, so that a few hundred elements split and merge often
+    typedef blocked_skip_list<int, std::less<int>, std::allocator<int>,
+                              goodliffe::detail::skip_list_level_generator<32>, 4> small_blocks;
+}
+
+TEST_CASE( "blocked_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "blocked_skip_list/can call basic methods", "" )
+{
+    blocked_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.begin() == list.end());
+    REQUIRE(list.find(10) == list.end());
+    REQUIRE(list.lower_bound(10) == list.end());
+
+    REQUIRE(list.insert(10).second);
+    REQUIRE(!list.insert(10).second);
+    REQUIRE(*list.insert(5).first == 5);
+    REQUIRE(list.size() == 2);
+    REQUIRE(list.front() == 5);
+    REQUIRE(list.back() == 10);
+    REQUIRE(list.contains(10));
+    REQUIRE(list.erase(10) == 1);
+    REQUIRE(list.erase(10) == 0);
+    REQUIRE(list.size() == 1);
+    list.clear();
+    REQUIRE(list.empty());
+    list.insert(1);
+    REQUIRE(list.count(1) == 1);
+}
+
+TEST_CASE( "blocked_skip_list/comparison with set", "" )
+{
+    small_blocks           small;
+    blocked_skip_list<int> list;
+    std::set<int>          set;
+    for (int n = 0; n < 20000; ++n)
+    {
+        const int value = rand() % 2000;
+        if (rand() % 3)
+        {
+            const bool inserted = set.insert(value).second;
+            REQUIRE(small.insert(value).second == inserted);
+            REQUIRE(list.insert(value).second == inserted);
+        }
+        else
+        {
+            const size_t erased = set.erase(value);
+            REQUIRE(small.erase(value) == erased);
+            REQUIRE(list.erase(value) == erased);
+        }
+    }
+    REQUIRE(CheckEquality(small, set));
+    REQUIRE(CheckEquality(list, set));
+
+    for (int value = -1; value <= 2001; ++value)
+    {
+        REQUIRE(small.count(value) == set.count(value));
+        REQUIRE(small.lower_bound(value) == std::lower_bound(small.begin(), small.end(), value));
+        REQUIRE(small.upper_bound(value) == std::upper_bound(small.begin(), small.end(), value));
+        REQUIRE(list.lower_bound(value) == std::lower_bound(list.begin(), list.end(), value));
+        REQUIRE(list.upper_bound(value) == std::upper_bound(list.begin(), list.end(), value));
+    }
+
+    while (!set.empty())
+    {
+        const int value = *set.begin();
+        REQUIRE(small.erase(value) == 1);
+        REQUIRE(list.erase(value) == 1);
+        set.erase(value);
+    }
+    REQUIRE(small.empty());
+    REQUIRE(list.empty());
+}
+
+TEST_CASE( "blocked_skip_list/erase by iterator returns the next element", "" )
+{
+    small_blocks list;
+    for (int n = 0; n < 500; ++n) list.insert(n);
+
+    // every other element, so blocks shrink and merge as we go
+    small_blocks::iterator i = list.begin();
+    int expected = 0;
+    while (i != list.end())
+    {
+        REQUIRE(*i == expected);
+        i = list.erase(i);
+        if (i == list.end()) break;
+        REQUIRE(*i == expected+1);
+        ++i;
+        expected += 2;
+    }
+    REQUIRE(list.size() == 250);
+    REQUIRE(list.front() == 1);
+    REQUIRE(list.back() == 499);
+
+    // and all of the rest, from the back
+    while (!list.empty())
+    {
+        REQUIRE(list.erase(--list.end()) == list.end());
+    }
+}
+
+TEST_CASE( "blocked_skip_list/assignment and comparison", "" )
+{
+    std::vector<int> data;
+    FillWithRandomData(1000, data);
+
+    small_blocks list(data.begin(), data.end());
+    SortVectorAndRemoveDuplicates(data);
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckForwardIteration(list));
+    REQUIRE(CheckBackwardIteration(list));
+
+    small_blocks copy(list);
+    REQUIRE(copy == list);
+    REQUIRE(!(copy < list));
+    copy.erase(copy.begin());
+    REQUIRE(copy != list);
+    REQUIRE(list < copy);
+
+    copy = list;
+    REQUIRE(copy == list);
+    copy.insert(-1);
+
+    small_blocks other;
+    other.assign_sorted(data.begin(), data.begin()+100);
+    REQUIRE(other.size() == 100);
+    other.swap(copy);
+    REQUIRE(other.size() == list.size()+1);
+    REQUIRE(copy.size() == 100);
+    std::swap(other, copy);
+    REQUIRE(copy.front() == -1);
+}
+
+namespace
+{
+    /// Searches every prefix of a sorted array of T for values around each
+    /// of its elements, with the block search blocked_skip_list uses for
+    /// std::less (vectorised, where the type allows), and compares the
+    /// results with std::lower_bound and std::upper_bound
+    template <typename T>
+    bool BlockSearchMatchesStd()
+    {
+        typedef goodliffe::detail::bsl_block_search<T, std::less<T> > search;
+
+        T keys[37];
+        for (unsigned n = 0; n < 37; ++n) keys[n] = T(int(n*3) - 50);
+
+        for (unsigned count = 0; count <= 37; ++count)
+        {
+            for (int value = -53; value < 62; ++value)
+            {
+                const T key = T(value);
+                if (search::lower_bound(keys, count, key, std::less<T>()) != std::lower_bound(keys, keys+count, key)
+                    || search::upper_bound(keys, count, key, std::less<T>()) != std::upper_bound(keys, keys+count, key))
+                {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+}
+
+TEST_CASE( "blocked_skip_list/block search", "" )
+{
+    REQUIRE(BlockSearchMatchesStd<int>());
+    REQUIRE(BlockSearchMatchesStd<long>());
+    REQUIRE(BlockSearchMatchesStd<long long>());
+    REQUIRE(BlockSearchMatchesStd<short>());
+    REQUIRE(BlockSearchMatchesStd<float>());
+    REQUIRE(BlockSearchMatchesStd<double>());
+#ifdef SKIP_LIST_AVX2
+    // Built with -mavx2 (as test.sh does), the checks above were vectorised
+    REQUIRE(goodliffe::detail::bsl_simd_count<int>::enabled);
+    REQUIRE(goodliffe::detail::bsl_simd_count<long long>::enabled);
+    REQUIRE(goodliffe::detail::bsl_simd_count<float>::enabled);
+    REQUIRE(goodliffe::detail::bsl_simd_count<double>::enabled);
+    REQUIRE_FALSE(goodliffe::detail::bsl_simd_count<short>::enabled);
+#endif
+
+    blocked_skip_list<double> list;
+    std::set<double>          set;
+    for (int n = 0; n < 5000; ++n)
+    {
+        const double value = (rand() % 1000) / 8.0;
+        REQUIRE(list.insert(value).second == set.insert(value).second);
+    }
+    REQUIRE(CheckEquality(list, set));
+    for (int n = 0; n < 1000; ++n)
+    {
+        const double value = (rand() % 1000) / 8.0 + 0.0625;
+        const std::set<double>::const_iterator expected = set.lower_bound(value);
+        if (expected == set.end())
+        {
+            REQUIRE(list.lower_bound(value) == list.end());
+        }
+        else
+        {
+            REQUIRE(*list.lower_bound(value) == *expected);
+        }
+        REQUIRE(list.count(value) == 0);
+    }
+}
+
+TEST_CASE( "blocked_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        blocked_skip_list<Counter, std::less<Counter>, std::allocator<Counter>,
+                          goodliffe::detail::skip_list_level_generator<32>, 8> list;
+        for (int n = 0; n < 200; ++n) list.insert(Counter(n));
+        for (int n = 0; n < 200; n += 2) list.erase(Counter(n));
+        REQUIRE(Counter::count == 100);
+        list.erase(list.begin());
+        REQUIRE(Counter::count == 99);
+    }
+    REQUIRE(Counter::count == 0);
+}
@@ -0,0 +1,269 @@
+//============================================================================
+// test_concurrent_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "concurrent_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <thread>
+#include <atomic>
+
+using goodliffe::concurrent_skip_list;
+
+TEST_CASE( "concurrent_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "concurrent_skip_list/can call basic methods", "" )
+{
+    const concurrent_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.get_allocator() == std::allocator<int>());
+    REQUIRE(list.find(10) == list.end());
+    REQUIRE(list.count(0) == 0);
+    REQUIRE(!list.contains(20));
+    REQUIRE(list.max_size() > 67890);
+    REQUIRE(list.begin() == list.end());
+}
+
+//============================================================================
+// single threaded
+
+TEST_CASE( "concurrent_skip_list/insert", "" )
+{
+    concurrent_skip_list<int> list;
+
+    concurrent_skip_list<int>::insert_by_value_result result = list.insert(10);
+    REQUIRE(result.second);
+    REQUIRE(*result.first == 10);
+
+    result = list.insert(10);
+    REQUIRE_FALSE(result.second);
+    REQUIRE(*result.first == 10);
+
+    list.insert(5);
+    list.insert(15);
+    REQUIRE(list.size() == 3);
+    REQUIRE(*list.begin() == 5);
+    REQUIRE(*list.find(15) == 15);
+    REQUIRE(list.find(12) == list.end());
+}
+
+TEST_CASE( "concurrent_skip_list/erase", "" )
+{
+    concurrent_skip_list<int> list;
+    for (int n = 0; n < 10; ++n) list.insert(n);
+
+    REQUIRE(list.erase(5) == 1);
+    REQUIRE(list.erase(5) == 0);
+    REQUIRE(list.erase(100) == 0);
+    REQUIRE(list.size() == 9);
+    REQUIRE_FALSE(list.contains(5));
+    REQUIRE(list.contains(6));
+
+    REQUIRE(list.erase(0) == 1);
+    REQUIRE(*list.begin() == 1);
+}
+
+TEST_CASE( "concurrent_skip_list/comparison with set", "" )
+{
+    std::set<int> set;
+    concurrent_skip_list<int> list;
+
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        int value = rand() % 1000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value).second == set.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == set.erase(value));
+        }
+    }
+
+    REQUIRE(list.size() == set.size());
+    REQUIRE(std::equal(set.begin(), set.end(), list.begin()));
+}
+
+TEST_CASE( "concurrent_skip_list/clear", "" )
+{
+    concurrent_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n);
+    for (int n = 0; n < 100; n += 2) list.erase(n);
+
+    list.clear();
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+
+    list.insert(3);
+    REQUIRE(list.size() == 1);
+    REQUIRE(*list.begin() == 3);
+}
+
+TEST_CASE( "concurrent_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        concurrent_skip_list<Counter> list;
+        for (int n = 0; n < 100; ++n) list.insert(n);
+        for (int n = 0; n < 100; n += 3) list.erase(n);
+        REQUIRE(list.size() == 66);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+//============================================================================
+// multi threaded
+
+TEST_CASE( "concurrent_skip_list/threads/insert disjoint values", "" )
+{
+    concurrent_skip_list<int> list;
+    const int per_thread = 2000;
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, t]
+        {
+            for (int n = 0; n < per_thread; ++n) list.insert(n*int(num_threads) + int(t));
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(list.size() == per_thread*num_threads);
+    REQUIRE(IsStrictlyIncreasing(list));
+    for (int n = 0; n < int(per_thread*num_threads); ++n)
+    {
+        REQUIRE(list.contains(n));
+    }
+}
+
+TEST_CASE( "concurrent_skip_list/threads/insert same values", "" )
+{
+    concurrent_skip_list<int> list;
+    std::atomic<int> inserted(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, &inserted]
+        {
+            for (int n = 0; n < 2000; ++n)
+                if (list.insert(n).second) ++inserted;
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(inserted.load() == 2000);
+    REQUIRE(list.size() == 2000);
+    REQUIRE(IsStrictlyIncreasing(list));
+}
+
+TEST_CASE( "concurrent_skip_list/threads/erase same values", "" )
+{
+    concurrent_skip_list<int> list;
+    for (int n = 0; n < 5000; ++n) list.insert(n);
+    std::atomic<int> erased(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, &erased]
+        {
+            for (int n = 0; n < 5000; n += 2)
+                erased += int(list.erase(n));
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(erased.load() == 2500);
+    REQUIRE(list.size() == 2500);
+    REQUIRE(IsStrictlyIncreasing(list));
+    for (int n = 0; n < 5000; ++n)
+    {
+        REQUIRE(list.contains(n) == (n % 2 == 1));
+    }
+}
+
+TEST_CASE( "concurrent_skip_list/threads/mixed insert and erase", "" )
+{
+    // Each thread owns the values congruent to it, so the final contents
+    // can be predicted; but all threads work in the same part of the list.
+    concurrent_skip_list<int> list;
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread([&list, t]
+            {
+                for (int round = 0; round < 10; ++round)
+                {
+                    for (int n = int(t); n < 4000; n += int(num_threads)) list.insert(n);
+                    for (int n = int(t); n < 4000; n += int(num_threads))
+                        if (n % 3) list.erase(n);
+                }
+            }));
+        }
+        for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+    }
+
+    int expected = 0;
+    for (int n = 0; n < 4000; ++n)
+    {
+        const bool present = n % 3 == 0;
+        REQUIRE(list.contains(n) == present);
+        expected += present;
+    }
+    REQUIRE(list.size() == unsigned(expected));
+    REQUIRE(IsStrictlyIncreasing(list));
+}
+
+TEST_CASE( "concurrent_skip_list/threads/iterate while modifying", "" )
+{
+    concurrent_skip_list<int> list;
+    for (int n = 0; n < 1000; n += 2) list.insert(n); // the even values stay put
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> ok(true);
+
+    std::thread writer([&list, &done]
+    {
+        for (int round = 0; round < 20; ++round)
+        {
+            for (int n = 1; n < 1000; n += 2) list.insert(n);
+            for (int n = 1; n < 1000; n += 2) list.erase(n);
+        }
+        done = true;
+    });
+
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < num_threads-1; ++t)
+    {
+        readers.push_back(std::thread([&list, &done, &ok]
+        {
+            while (!done)
+            {
+                int evens = 0;
+                if (!IsStrictlyIncreasing(list)) ok = false;
+                for (concurrent_skip_list<int>::const_iterator i = list.begin(); i != list.end(); ++i)
+                    if (*i % 2 == 0) ++evens;
+                if (evens != 500) ok = false;
+            }
+        }));
+    }
+
+    writer.join();
+    for (unsigned t = 0; t < readers.size(); ++t) readers[t].join();
+
+    REQUIRE(ok.load());
+    REQUIRE(list.size() == 500);
+}
@@ -0,0 +1,309 @@
+//============================================================================
+// test_deterministic_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <vector>
+#include <cmath>
+
+using goodliffe::deterministic_skip_list;
+using goodliffe::deterministic_multi_skip_list;
+
+namespace
+{
+    /// Counts every comparison made through it
+    struct CountingLess
+    {
+        static unsigned long count;
+        bool operator()(int lhs, int rhs) const { ++count; return lhs < rhs; }
+    };
+    unsigned long CountingLess::count = 0;
+
+    typedef deterministic_skip_list<int, CountingLess> counted_list;
+
+    /// The most comparisons any one find() makes, looking for each element
+    /// of list and each value between them
+    unsigned long WorstFind(const counted_list &list)
+    {
+        unsigned long worst = 0;
+        for (counted_list::const_iterator i = list.begin(); i != list.end(); ++i)
+        {
+            for (int delta = 0; delta < 2; ++delta)
+            {
+                CountingLess::count = 0;
+                (void)list.find(*i + delta);
+                if (CountingLess::count > worst) worst = CountingLess::count;
+            }
+        }
+        return worst;
+    }
+
+    /// What a 1-2-3 skip list guarantees: at most four steps across each of
+    /// about log2(N) levels, each of which is two comparisons at worst
+    unsigned long FindBound(size_t size)
+    {
+        return 2*4*(unsigned long)(std::log(double(size))/std::log(2.0) + 2);
+    }
+}
+
+TEST_CASE( "deterministic_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "deterministic_skip_list/can call basic methods", "" )
+{
+    deterministic_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.find(10) == list.end());
+
+    REQUIRE(list.insert(10).second);
+    REQUIRE(!list.insert(10).second);
+    REQUIRE(list.insert(5).second);
+    REQUIRE(list.size() == 2);
+    REQUIRE(list.front() == 5);
+    REQUIRE(list.back() == 10);
+    REQUIRE(list.erase(10) == 1);
+    REQUIRE(list.erase(10) == 0);
+    REQUIRE(list.size() == 1);
+    list.clear();
+    REQUIRE(list.empty());
+    list.insert(1);
+    REQUIRE(list.count(1) == 1);
+}
+
+TEST_CASE( "deterministic_skip_list/comparison with set", "" )
+{
+    deterministic_skip_list<int> list;
+    std::set<int> set;
+    for (int n = 0; n < 20000; ++n)
+    {
+        const int value = rand() % 2000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value).second == set.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == set.erase(value));
+        }
+    }
+    REQUIRE(CheckEquality(list, set));
+
+    while (!set.empty())
+    {
+        const int value = *set.begin();
+        REQUIRE(list.erase(value) == 1);
+        set.erase(value);
+    }
+    REQUIRE(list.empty());
+}
+
+TEST_CASE( "deterministic_skip_list/find is O(log N) in the worst case", "" )
+{
+    counted_list ascending;
+    for (int n = 0; n < 10000; ++n) ascending.insert(n*2);
+    REQUIRE(WorstFind(ascending) <= FindBound(ascending.size()));
+
+    counted_list descending;
+    for (int n = 10000; n; --n) descending.insert(n*2);
+    REQUIRE(WorstFind(descending) <= FindBound(descending.size()));
+
+    counted_list random;
+    for (int n = 0; n < 10000; ++n) random.insert((rand() % 1000000)*2);
+    REQUIRE(WorstFind(random) <= FindBound(random.size()));
+
+    // and after erasing most of it, from the front and at random
+    for (int n = 0; n < 4000; ++n) ascending.erase(ascending.begin());
+    for (int n = 0; n < 20000; n += 3) ascending.erase(n);
+    REQUIRE(WorstFind(ascending) <= FindBound(ascending.size()));
+}
+
+TEST_CASE( "deterministic_skip_list/multi with duplicates", "" )
+{
+    deterministic_multi_skip_list<int> list;
+    std::multiset<int> set;
+    for (int n = 0; n < 5000; ++n)
+    {
+        const int value = rand() % 100;
+        list.insert(value);
+        set.insert(value);
+    }
+    REQUIRE(CheckEquality(list, set));
+
+    for (int n = 0; n < 3000; ++n)
+    {
+        // erase one from the middle of a run of duplicates
+        const int value = rand() % 100;
+        deterministic_multi_skip_list<int>::iterator i = list.lower_bound(value);
+        if (i == list.end() || *i != value) continue;
+        for (size_t k = list.count(value)/2; k; --k) ++i;
+        list.erase(i);
+        set.erase(set.find(value));
+    }
+    REQUIRE(CheckEquality(list, set));
+
+    REQUIRE(list.erase(50) == set.erase(50));
+    REQUIRE(CheckEquality(list, set));
+}
+
+TEST_CASE( "deterministic_skip_list/range operations", "" )
+{
+    std::vector<int> data;
+    for (int n = 0; n < 1000; ++n) data.push_back(n);
+
+    deterministic_skip_list<int> list(data.begin(), data.end());
+    deterministic_skip_list<int> copy(list);
+    REQUIRE(copy == list);
+
+    list.erase(list.find(100), list.find(300));
+    list.erase(list.begin(), list.find(50));
+    std::vector<int> expected(data.begin()+50, data.begin()+100);
+    expected.insert(expected.end(), data.begin()+300, data.end());
+    REQUIRE(CheckEquality(list, expected));
+
+    deterministic_skip_list<int> other;
+    list.split(600, other);
+    REQUIRE(list.size() == 350);
+    REQUIRE(other.size() == 400);
+    REQUIRE(other.front() == 600);
+    list.join(other);
+    REQUIRE(other.empty());
+    REQUIRE(CheckEquality(list, expected));
+
+    deterministic_skip_list<int> odds;
+    for (int n = 1; n < 2000; n += 2) odds.insert(n);
+    list.merge(odds);
+    REQUIRE(list.size() == expected.size() + 1000 - 375);
+    REQUIRE(list.count(1001) == 1);
+
+    const deterministic_skip_list<int> both = set_intersection(list, copy);
+    REQUIRE(both.size() == list.size() - 500);
+}
+
+TEST_CASE( "deterministic_skip_list/modify and node handles", "" )
+{
+    deterministic_skip_list<int> list;
+    for (int n = 0; n < 500; ++n) list.insert(n*10);
+
+    for (int n = 0; n < 200; ++n)
+    {
+        deterministic_skip_list<int>::iterator i = list.find((rand() % 500) * 10);
+        if (i == list.end()) continue;
+        const int value = *i;
+        list.modify(i, [](int &v) { v = v % 2 ? v - 1 : v + 4999; });
+        REQUIRE(list.count(value) == 0);
+    }
+    REQUIRE(list.size() <= 500);
+    REQUIRE(std::adjacent_find(list.begin(), list.end(), std::greater_equal<int>()) == list.end());
+
+    for (int n = 0; n < 200; ++n)
+    {
+        deterministic_skip_list<int>::node_handle handle = list.extract(list.begin());
+        handle.value() += 100000;
+        REQUIRE(list.insert(std::move(handle)).inserted);
+    }
+    REQUIRE(std::adjacent_find(list.begin(), list.end(), std::greater_equal<int>()) == list.end());
+}
+
+TEST_CASE( "deterministic_skip_list/modify moves a node to the front", "" )
+{
+    deterministic_skip_list<int> list;
+    for (int n = 0; n < 16; ++n) list.insert(n*10);
+
+    REQUIRE(list.modify(list.find(150), [](int &v) { v = -5; }));
+    REQUIRE(list.size() == 16);
+    REQUIRE(list.front() == -5);
+    REQUIRE(list.back() == 140);
+    REQUIRE(CheckBackwardIteration(list));
+
+    // and every other node in turn, from the back
+    for (int n = 14; n >= 0; --n)
+    {
+        REQUIRE(list.modify(list.find(n*10), [n](int &v) { v = -100 + n; }));
+        REQUIRE(list.front() == -100 + n);
+        REQUIRE(std::adjacent_find(list.begin(), list.end(), std::greater_equal<int>()) == list.end());
+    }
+    REQUIRE(list.size() == 16);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "deterministic_skip_list/modify moves a node to the back", "" )
+{
+    deterministic_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n*10);
+
+    for (int n = 0; n < 50; ++n)
+    {
+        REQUIRE(list.modify(list.begin(), [n](int &v) { v = 10000 + n; }));
+        REQUIRE(list.back() == 10000 + n);
+    }
+    REQUIRE(list.size() == 100);
+    REQUIRE(list.front() == 500);
+    REQUIRE(std::adjacent_find(list.begin(), list.end(), std::greater_equal<int>()) == list.end());
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "deterministic_skip_list/throwing modifier erases element", "" )
+{
+    deterministic_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n*10);
+
+    // leaves the value out of order, so the node must be found by position
+    REQUIRE_THROWS(list.modify(list.find(990), [](int &v) { v = -1; throw 42; }));
+    REQUIRE_THROWS(list.modify(list.find(500), [](int &v) { v = 5000; throw 42; }));
+    REQUIRE(list.size() == 98);
+    REQUIRE(list.count(500) == 0);
+    REQUIRE(list.back() == 980);
+    REQUIRE(std::adjacent_find(list.begin(), list.end(), std::greater_equal<int>()) == list.end());
+    REQUIRE(CheckBackwardIteration(list));
+
+    list.insert(500);
+    list.insert(990);
+    REQUIRE(list.size() == 100);
+}
+
+TEST_CASE( "deterministic_skip_list/erasing a duplicate makes no comparisons", "" )
+{
+    typedef deterministic_multi_skip_list<int, CountingLess> counted_multi_list;
+    counted_multi_list list;
+    for (int n = 0; n < 2000; ++n) list.insert(n % 2 ? 1 : 2);
+    REQUIRE(list.count(1) == 1000);
+
+    for (size_t remaining = 1000; remaining > 1; --remaining)
+    {
+        // the middle of the run of 1s
+        counted_multi_list::iterator i = list.begin();
+        for (size_t k = remaining/2; k; --k) ++i;
+
+        CountingLess::count = 0;
+        list.erase(i);
+#ifndef SKIP_LIST_IMPL_DIAGNOSTICS
+        // (the diagnostic checks compare values of their own)
+        REQUIRE(CountingLess::count == 0);
+#endif
+    }
+    REQUIRE(list.size() == 1001);
+    REQUIRE(list.front() == 1);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "deterministic_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        goodliffe::skip_list<Counter, std::less<Counter>, std::allocator<Counter>,
+                             goodliffe::detail::deterministic_level_generator<32> > list;
+        for (int n = 0; n < 200; ++n) list.insert(Counter(n));
+        for (int n = 0; n < 200; n += 2) list.erase(Counter(n));
+        REQUIRE(Counter::count == 100);
+    }
+    REQUIRE(Counter::count == 0);
+}
@@ -0,0 +1,237 @@
+//============================================================================
+// test_epoch_reclamation.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_list_epoch.h"
+#include "concurrent_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <memory>
+#include <thread>
+#include <atomic>
+#include <vector>
+
+using goodliffe::concurrent_skip_list;
+
+namespace
+{
+    struct TestNode
+    {
+        TestNode() : next_retired(0) {}
+        TestNode *next_retired;
+    };
+
+    struct TestReclaimer
+    {
+        TestReclaimer() : reclaimed(0) {}
+        void reclaim(TestNode *node) { delete node; ++reclaimed; }
+        unsigned reclaimed;
+    };
+
+    typedef goodliffe::detail::epoch_domain<TestNode,TestReclaimer,std::allocator<TestNode> > Domain;
+    typedef goodliffe::detail::epoch_pin<Domain> Pin;
+
+    /// Retires count fresh nodes, each in its own short-lived pin
+    void RetireNodes(Domain &domain, unsigned count)
+    {
+        for (unsigned n = 0; n < count; ++n)
+        {
+            Pin pin(domain);
+            domain.retire(pin.get(), new TestNode);
+        }
+    }
+
+    /// Allocations outstanding through any CountingAllocator
+    std::atomic<long> live_allocations(0);
+
+    template <typename T>
+    struct CountingAllocator : std::allocator<T>
+    {
+        template <typename OTHER>
+        struct rebind { typedef CountingAllocator<OTHER> other; };
+
+        CountingAllocator() {}
+        template <typename OTHER>
+        CountingAllocator(const CountingAllocator<OTHER> &) {}
+
+        T *allocate(std::size_t n, const void * = 0)
+            { ++live_allocations; return std::allocator<T>::allocate(n); }
+        void deallocate(T *p, std::size_t n)
+            { --live_allocations; std::allocator<T>::deallocate(p, n); }
+    };
+}
+
+//============================================================================
+// epoch_domain
+
+TEST_CASE( "epoch_reclamation/nothing reclaimed while pinned", "" )
+{
+    TestReclaimer reclaimer;
+    Domain domain(reclaimer, std::allocator<TestNode>());
+    {
+        Pin reader(domain);
+        RetireNodes(domain, Domain::advance_threshold*10);
+        REQUIRE(reclaimer.reclaimed == 0);
+        REQUIRE(domain.retired_size() == Domain::advance_threshold*10);
+    }
+
+    // With the reader gone, the epoch can move on
+    RetireNodes(domain, Domain::advance_threshold*3);
+    REQUIRE(reclaimer.reclaimed > Domain::advance_threshold*10);
+    const unsigned accounted_for = reclaimer.reclaimed + unsigned(domain.retired_size());
+    REQUIRE(accounted_for == Domain::advance_threshold*13);
+}
+
+TEST_CASE( "epoch_reclamation/retired nodes stay bounded", "" )
+{
+    TestReclaimer reclaimer;
+    Domain domain(reclaimer, std::allocator<TestNode>());
+
+    for (unsigned n = 0; n < 100; ++n)
+    {
+        RetireNodes(domain, Domain::advance_threshold);
+        REQUIRE(domain.retired_size() <= Domain::advance_threshold*3);
+    }
+}
+
+TEST_CASE( "epoch_reclamation/copied pin protects", "" )
+{
+    TestReclaimer reclaimer;
+    Domain domain(reclaimer, std::allocator<TestNode>());
+    {
+        Pin copy;
+        {
+            Pin original(domain);
+            copy = original;
+            REQUIRE(copy.is_pinned());
+            REQUIRE(copy.get() != original.get());
+        }
+        RetireNodes(domain, Domain::advance_threshold*10);
+        REQUIRE(reclaimer.reclaimed == 0);
+
+        copy.reset();
+        REQUIRE_FALSE(copy.is_pinned());
+    }
+    RetireNodes(domain, Domain::advance_threshold*3);
+    REQUIRE(reclaimer.reclaimed > 0);
+}
+
+TEST_CASE( "epoch_reclamation/destruction reclaims everything", "" )
+{
+    TestReclaimer reclaimer;
+    {
+        Domain domain(reclaimer, std::allocator<TestNode>());
+        RetireNodes(domain, 10);
+        domain.reclaim_all();
+        REQUIRE(reclaimer.reclaimed == 10);
+        REQUIRE(domain.retired_size() == 0);
+        RetireNodes(domain, 5);
+    }
+    REQUIRE(reclaimer.reclaimed == 15);
+}
+
+//============================================================================
+// concurrent_skip_list
+
+TEST_CASE( "epoch_reclamation/list reclaims erased elements", "" )
+{
+    typedef concurrent_skip_list<int,std::less<int>,CountingAllocator<int> > List;
+    live_allocations = 0;
+    {
+        List list;
+        const long empty_list = live_allocations.load();
+
+        for (int round = 0; round < 20; ++round)
+        {
+            for (int n = 0; n < 1000; ++n) list.insert(n);
+            for (int n = 0; n < 1000; ++n) list.erase(n);
+        }
+        REQUIRE(list.empty());
+
+        // 20000 nodes were erased; all but the last few epochs' worth are gone
+        const long unreclaimed = live_allocations.load() - empty_list;
+        REQUIRE(unreclaimed < 1000);
+    }
+    REQUIRE(live_allocations.load() == 0);
+}
+
+TEST_CASE( "epoch_reclamation/iterator holds up reclamation", "" )
+{
+    typedef concurrent_skip_list<int,std::less<int>,CountingAllocator<int> > List;
+    live_allocations = 0;
+    {
+        List list;
+        for (int n = 0; n < 1000; ++n) list.insert(n);
+        const long full_list = live_allocations.load();
+
+        List::const_iterator i = list.find(10);
+        for (int n = 0; n < 1000; ++n)
+        {
+            if (n != 10) list.erase(n);
+        }
+        REQUIRE(live_allocations.load() >= full_list);
+        REQUIRE(*i == 10);
+
+        i = list.end();
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int n = 1000; n < 1100; ++n) list.insert(n);
+            for (int n = 1000; n < 1100; ++n) list.erase(n);
+        }
+        REQUIRE(live_allocations.load() < full_list);
+    }
+    REQUIRE(live_allocations.load() == 0);
+}
+
+TEST_CASE( "epoch_reclamation/threads/stress", "" )
+{
+    typedef concurrent_skip_list<int,std::less<int>,CountingAllocator<int> > List;
+    live_allocations = 0;
+    std::atomic<long> erased(0);
+    std::atomic<long> peak(0);
+    {
+        List list;
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread([&list, &erased, &peak, t]
+            {
+                unsigned state = t*2654435761u + 1;
+                for (int n = 0; n < 20000; ++n)
+                {
+                    state ^= state << 13; state ^= state >> 17; state ^= state << 5;
+                    const int value = int(state % 512);
+                    if (state & 0x10000)
+                        list.insert(value);
+                    else
+                        erased += long(list.erase(value));
+
+                    // A reader that keeps up with the writers
+                    if (n % 100 == 0)
+                    {
+                        long live = live_allocations.load();
+                        long seen = peak.load();
+                        while (live > seen && !peak.compare_exchange_weak(seen, live)) {}
+                        for (List::const_iterator i = list.begin(); i != list.end(); ++i) {}
+                    }
+                }
+            }));
+        }
+        for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+        REQUIRE(erased.load() > 10000);
+        REQUIRE(list.size() <= 512);
+        REQUIRE(IsStrictlyIncreasing(list));
+
+        // How far reclamation lags depends on scheduling (a thread pre-empted
+        // while pinned holds everyone up), but it must not fall behind
+        // altogether. Each node is two allocations.
+        REQUIRE(peak.load() < 2*erased.load());
+        REQUIRE(live_allocations.load() < 2*erased.load());
+    }
+    REQUIRE(live_allocations.load() == 0);
+}
@@ -0,0 +1,235 @@
+//============================================================================
+// test_interval_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "interval_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+
+using goodliffe::interval_skip_list;
+
+namespace
+{
+    typedef goodliffe::interval<int> Interval;
+
+    Interval RandomInterval(int range, int max_length)
+    {
+        const int first = rand() % range;
+        return Interval(first, first + rand() % max_length);
+    }
+
+    std::vector<Interval> Sorted(std::vector<Interval> intervals)
+    {
+        std::sort(intervals.begin(), intervals.end());
+        return intervals;
+    }
+
+    std::vector<Interval> Stab(const interval_skip_list<int> &list, int point)
+    {
+        std::vector<Interval> found;
+        list.stab(point, std::back_inserter(found));
+        return Sorted(found);
+    }
+
+    std::vector<Interval> Overlaps(const interval_skip_list<int> &list, int lo, int hi)
+    {
+        std::vector<Interval> found;
+        list.overlaps(lo, hi, std::back_inserter(found));
+        return Sorted(found);
+    }
+
+    /// The intervals in data that overlap [lo,hi], by brute force
+    std::vector<Interval> Expected(const std::vector<Interval> &data, int lo, int hi)
+    {
+        std::vector<Interval> found;
+        for (size_t n = 0; n < data.size(); ++n)
+        {
+            if (data[n].first <= hi && lo <= data[n].second) found.push_back(data[n]);
+        }
+        return Sorted(found);
+    }
+
+    /// Checks stab() at every point in [lo,hi), and overlaps() over some
+    /// random ranges, against the brute force answer
+    bool QueriesAreRight(const interval_skip_list<int> &list, const std::vector<Interval> &data, int lo, int hi)
+    {
+        for (int point = lo; point < hi; ++point)
+        {
+            if (Stab(list, point) != Expected(data, point, point)) return false;
+        }
+        for (int n = 0; n < 100; ++n)
+        {
+            const int first = lo + rand() % (hi-lo);
+            const int last  = first + rand() % 50;
+            if (Overlaps(list, first, last) != Expected(data, first, last)) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE( "interval_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "interval_skip_list/can call basic methods", "" )
+{
+    const interval_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.begin() == list.end());
+    REQUIRE(Stab(list, 10).empty());
+    REQUIRE(Overlaps(list, 0, 100).empty());
+}
+
+TEST_CASE( "interval_skip_list/stab", "" )
+{
+    interval_skip_list<int> list;
+    list.insert(Interval(10, 20));
+    list.insert(Interval(15, 25));
+    list.insert(Interval(20, 20));
+    list.insert(Interval(30, 40));
+    REQUIRE(list.size() == 4);
+
+    REQUIRE(Stab(list, 5).empty());
+    REQUIRE(Stab(list, 10).size() == 1);
+    REQUIRE(Stab(list, 17).size() == 2);
+    REQUIRE(Stab(list, 20).size() == 3);
+    REQUIRE(Stab(list, 21).size() == 1);
+    REQUIRE(Stab(list, 21)[0] == Interval(15, 25));
+    REQUIRE(Stab(list, 27).empty());
+    REQUIRE(Stab(list, 40).size() == 1);
+    REQUIRE(Stab(list, 41).empty());
+}
+
+TEST_CASE( "interval_skip_list/overlaps", "" )
+{
+    interval_skip_list<int> list;
+    list.insert(Interval(10, 20));
+    list.insert(Interval(15, 25));
+    list.insert(Interval(30, 40));
+
+    REQUIRE(Overlaps(list, 0, 9).empty());
+    REQUIRE(Overlaps(list, 0, 10).size() == 1);
+    REQUIRE(Overlaps(list, 21, 29).size() == 1);
+    REQUIRE(Overlaps(list, 26, 29).empty());
+    REQUIRE(Overlaps(list, 22, 35).size() == 2);
+    REQUIRE(Overlaps(list, 0, 100).size() == 3);
+    REQUIRE(Overlaps(list, 40, 30).empty());
+}
+
+TEST_CASE( "interval_skip_list/queries match brute force", "" )
+{
+    interval_skip_list<int> list;
+    std::vector<Interval> data;
+    for (int n = 0; n < 500; ++n)
+    {
+        const Interval interval = RandomInterval(1000, 100);
+        list.insert(interval);
+        data.push_back(interval);
+    }
+    REQUIRE(list.size() == data.size());
+    REQUIRE(std::is_sorted(list.begin(), list.end(), goodliffe::detail::isl_interval_order<std::less<int> >()));
+    REQUIRE(QueriesAreRight(list, data, -10, 1110));
+}
+
+TEST_CASE( "interval_skip_list/erase keeps queries right", "" )
+{
+    interval_skip_list<int> list;
+    std::vector<Interval> data;
+    for (int n = 0; n < 500; ++n)
+    {
+        const Interval interval = RandomInterval(1000, 100);
+        list.insert(interval);
+        data.push_back(interval);
+    }
+
+    for (int n = 0; n < 400; ++n)
+    {
+        const size_t index = size_t(rand()) % data.size();
+        if (n % 2)
+        {
+            // erase one of the intervals equal to this
+            list.erase(list.find(data[index]));
+            data.erase(data.begin() + long(index));
+        }
+        else
+        {
+            const Interval interval = RandomInterval(1000, 100);
+            list.insert(interval);
+            data.push_back(interval);
+        }
+    }
+    REQUIRE(list.size() == data.size());
+    REQUIRE(QueriesAreRight(list, data, -10, 1110));
+
+    while (!data.empty())
+    {
+        const Interval interval = data.back();
+        const size_t   count    = size_t(std::count(data.begin(), data.end(), interval));
+        REQUIRE(list.count(interval) == count);
+        REQUIRE(list.erase(interval) == count);
+        data.erase(std::remove(data.begin(), data.end(), interval), data.end());
+    }
+    REQUIRE(list.empty());
+    REQUIRE(Stab(list, 500).empty());
+}
+
+TEST_CASE( "interval_skip_list/shared endpoints", "" )
+{
+    interval_skip_list<int> list;
+    std::vector<Interval> data;
+    for (int n = 0; n < 300; ++n)
+    {
+        // few distinct endpoints, so most are shared, and many repeated
+        const Interval interval = RandomInterval(20, 10);
+        list.insert(interval);
+        data.push_back(interval);
+    }
+    REQUIRE(QueriesAreRight(list, data, -2, 32));
+
+    for (int n = 0; n < 250; ++n)
+    {
+        const size_t index = size_t(rand()) % data.size();
+        list.erase(list.find(data[index]));
+        data.erase(data.begin() + long(index));
+    }
+    REQUIRE(QueriesAreRight(list, data, -2, 32));
+}
+
+TEST_CASE( "interval_skip_list/copy, swap and clear", "" )
+{
+    interval_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(RandomInterval(1000, 100));
+
+    interval_skip_list<int> copy(list);
+    REQUIRE(copy == list);
+    for (int point = 0; point < 1100; point += 7)
+    {
+        REQUIRE(Stab(copy, point) == Stab(list, point));
+    }
+
+    interval_skip_list<int> other;
+    other.insert(Interval(1, 2));
+    other.swap(copy);
+    REQUIRE(copy.size() == 1);
+    REQUIRE(other == list);
+    REQUIRE(Stab(other, 500) == Stab(list, 500));
+    REQUIRE(Stab(copy, 1).size() == 1);
+
+    copy = list;
+    REQUIRE(copy == list);
+
+    list.clear();
+    REQUIRE(list.empty());
+    REQUIRE(Stab(list, 500).empty());
+    list.insert(Interval(3, 4));
+    REQUIRE(Stab(list, 3).size() == 1);
+}
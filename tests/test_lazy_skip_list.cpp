@@ -0,0 +1,242 @@
+//============================================================================
+// test_lazy_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_list_lazy.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using goodliffe::lazy_skip_list;
+
+namespace
+{
+    /// Forward and backward iteration see the same elements
+    template <typename CONTAINER>
+    bool LinksAreConsistent(const CONTAINER &container)
+    {
+        std::vector<int> forward(container.begin(), container.end());
+        std::vector<int> backward(container.rbegin(), container.rend());
+        return forward.size() == container.size()
+            && std::equal(forward.rbegin(), forward.rend(), backward.begin());
+    }
+}
+
+TEST_CASE( "lazy_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "lazy_skip_list/can call basic methods", "" )
+{
+    const lazy_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.find(10) == list.end());
+    REQUIRE(list.count(0) == 0);
+    REQUIRE(!list.contains(20));
+    REQUIRE(list.begin() == list.end());
+}
+
+//============================================================================
+// single threaded: the usual skip_list API
+
+TEST_CASE( "lazy_skip_list/insert and erase", "" )
+{
+    lazy_skip_list<int> list;
+
+    REQUIRE(list.insert(10).second);
+    REQUIRE_FALSE(list.insert(10).second);
+    list.insert(5);
+    list.insert(15);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.front() == 5);
+    REQUIRE(list.back() == 15);
+    REQUIRE(*list.find(15) == 15);
+    REQUIRE(list.find(12) == list.end());
+
+    REQUIRE(list.erase(10) == 1);
+    REQUIRE(list.erase(10) == 0);
+    REQUIRE(list.size() == 2);
+    REQUIRE_FALSE(list.contains(10));
+    REQUIRE(LinksAreConsistent(list));
+}
+
+TEST_CASE( "lazy_skip_list/comparison with set", "" )
+{
+    std::set<int> set;
+    lazy_skip_list<int> list;
+
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        int value = rand() % 1000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value).second == set.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == set.erase(value));
+        }
+    }
+
+    REQUIRE(LinksAreConsistent(list));
+    REQUIRE(list.size() == set.size());
+    REQUIRE(std::equal(set.begin(), set.end(), list.begin()));
+    REQUIRE(std::equal(set.rbegin(), set.rend(), list.rbegin()));
+}
+
+TEST_CASE( "lazy_skip_list/sequential operations", "" )
+{
+    lazy_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n);
+
+    list.erase(list.begin());
+    REQUIRE(list.front() == 1);
+
+    lazy_skip_list<int> copy(list);
+    REQUIRE(copy == list);
+
+    lazy_skip_list<int> other;
+    other.insert(1000);
+    other.swap(copy);
+    REQUIRE(other == list);
+    REQUIRE(copy.size() == 1);
+
+    list.clear();
+    REQUIRE(list.empty());
+    list.insert(3);
+    REQUIRE(list.contains(3));
+}
+
+TEST_CASE( "lazy_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        lazy_skip_list<Counter> list;
+        for (int n = 0; n < 100; ++n) list.insert(n);
+        for (int n = 0; n < 100; n += 3) list.erase(n);
+        REQUIRE(list.size() == 66);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+//============================================================================
+// multi threaded
+
+TEST_CASE( "lazy_skip_list/threads/insert disjoint values", "" )
+{
+    lazy_skip_list<int> list;
+    const int per_thread = 2000;
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, t]
+        {
+            for (int n = 0; n < per_thread; ++n) list.insert(n*int(num_threads) + int(t));
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(list.size() == per_thread*num_threads);
+    REQUIRE(LinksAreConsistent(list));
+    REQUIRE(IsStrictlyIncreasing(list));
+    for (int n = 0; n < int(per_thread*num_threads); ++n)
+    {
+        REQUIRE(list.contains(n));
+    }
+}
+
+TEST_CASE( "lazy_skip_list/threads/insert same values", "" )
+{
+    lazy_skip_list<int> list;
+    std::atomic<int> inserted(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, &inserted]
+        {
+            for (int n = 0; n < 2000; ++n)
+                if (list.insert(n).second) ++inserted;
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(inserted.load() == 2000);
+    REQUIRE(list.size() == 2000);
+    REQUIRE(LinksAreConsistent(list));
+}
+
+TEST_CASE( "lazy_skip_list/threads/erase same values", "" )
+{
+    lazy_skip_list<int> list;
+    for (int n = 0; n < 5000; ++n) list.insert(n);
+    std::atomic<int> erased(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, &erased]
+        {
+            for (int n = 0; n < 5000; n += 2)
+                erased += int(list.erase(n));
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(erased.load() == 2500);
+    REQUIRE(list.size() == 2500);
+    REQUIRE(LinksAreConsistent(list));
+    for (int n = 0; n < 5000; ++n)
+    {
+        REQUIRE(list.contains(n) == (n % 2 == 1));
+    }
+}
+
+TEST_CASE( "lazy_skip_list/threads/mixed insert, erase and contains", "" )
+{
+    // Each thread owns the values congruent to it, so the final contents
+    // can be predicted; but all threads work in the same part of the list.
+    // The multiples of three are never erased, so must always be found.
+    lazy_skip_list<int> list;
+    std::atomic<bool> ok(true);
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread([&list, &ok, t]
+            {
+                for (int round = 0; round < 10; ++round)
+                {
+                    for (int n = int(t); n < 4000; n += int(num_threads)) list.insert(n);
+                    for (int n = int(t); n < 4000; n += int(num_threads))
+                        if (n % 3) list.erase(n);
+                    for (int n = int(t); n < 4000; n += int(num_threads))
+                        if (n % 3 == 0 && !list.contains(n)) ok = false;
+                }
+            }));
+        }
+        for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+    }
+
+    REQUIRE(ok.load());
+    int expected = 0;
+    for (int n = 0; n < 4000; ++n)
+    {
+        const bool present = n % 3 == 0;
+        REQUIRE(list.contains(n) == present);
+        expected += present;
+    }
+    REQUIRE(list.size() == unsigned(expected));
+    REQUIRE(LinksAreConsistent(list));
+    REQUIRE(IsStrictlyIncreasing(list));
+}
@@ -0,0 +1,162 @@
+//============================================================================
+// test_multi_random_access.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "random_access_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <vector>
+#include <algorithm>
+
+using goodliffe::multi_random_access_skip_list;
+
+namespace
+{
+    struct SetTo
+    {
+        SetTo(int v) : value(v) {}
+        void operator()(int &i) const { i = value; }
+        int value;
+    };
+}
+
+TEST_CASE( "multi_random_access_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "multi_random_access_skip_list/can call basic methods", "" )
+{
+    const multi_random_access_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.find(10) == list.end());
+    REQUIRE(list.count(0) == 0);
+    REQUIRE(!list.contains(20));
+    REQUIRE(list.lower_bound(5) == list.end());
+    REQUIRE(list.upper_bound(5) == list.end());
+}
+
+TEST_CASE( "multi_random_access_skip_list/holds duplicates in order", "" )
+{
+    multi_random_access_skip_list<int> list;
+    std::vector<int> data;
+    for (int n = 0; n < 3000; ++n)
+    {
+        const int value = rand() % 100;
+        REQUIRE(list.insert(value).second);
+        data.push_back(value);
+    }
+    std::sort(data.begin(), data.end());
+
+    REQUIRE(list.size() == data.size());
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+}
+
+TEST_CASE( "multi_random_access_skip_list/count and bounds", "" )
+{
+    multi_random_access_skip_list<int> list;
+    std::vector<int> data;
+    for (int n = 0; n < 3000; ++n)
+    {
+        const int value = rand() % 50 * 2; // only even values
+        list.insert(value);
+        data.push_back(value);
+    }
+    std::sort(data.begin(), data.end());
+
+    for (int value = -1; value <= 100; ++value)
+    {
+        const long lower = std::lower_bound(data.begin(), data.end(), value) - data.begin();
+        const long upper = std::upper_bound(data.begin(), data.end(), value) - data.begin();
+
+        REQUIRE(list.count(value) == size_t(upper - lower));
+        REQUIRE((list.lower_bound(value) - list.begin()) == lower);
+        REQUIRE((list.upper_bound(value) - list.begin()) == upper);
+        REQUIRE(list.index_of(list.lower_bound(value)) == size_t(lower));
+        REQUIRE(list.count_less(value) == size_t(lower));
+
+        std::pair<multi_random_access_skip_list<int>::const_iterator,
+                  multi_random_access_skip_list<int>::const_iterator> range
+            = static_cast<const multi_random_access_skip_list<int>&>(list).equal_range(value);
+        REQUIRE((range.second - range.first) == upper - lower);
+    }
+}
+
+TEST_CASE( "multi_random_access_skip_list/erase by value removes all", "" )
+{
+    multi_random_access_skip_list<int> list;
+    for (int n = 0; n < 10; ++n)
+        for (int copies = 0; copies < 100; ++copies)
+            list.insert(n);
+
+    REQUIRE(list.erase(4) == 100);
+    REQUIRE(list.erase(4) == 0);
+    REQUIRE(list.size() == 900);
+    REQUIRE(list.count(4) == 0);
+    REQUIRE(list[399] == 3);
+    REQUIRE(list[400] == 5);
+
+    REQUIRE(list.erase(0) == 100);
+    REQUIRE(list.erase(9) == 100);
+    REQUIRE(list.front() == 1);
+    REQUIRE(list.back() == 8);
+    REQUIRE(list.size() == 700);
+
+    list.erase(list.begin());
+    REQUIRE(list.count(1) == 99);
+}
+
+TEST_CASE( "multi_random_access_skip_list/copy and assign_sorted keep duplicates", "" )
+{
+    std::vector<int> data;
+    for (int n = 0; n < 1000; ++n) data.push_back(n / 10);
+
+    multi_random_access_skip_list<int> list;
+    list.assign_sorted(data.begin(), data.end());
+    REQUIRE(list.size() == 1000);
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+
+    multi_random_access_skip_list<int> copy(list);
+    REQUIRE(copy.size() == 1000);
+    REQUIRE(copy.count(50) == 10);
+    REQUIRE(copy == list);
+}
+
+TEST_CASE( "multi_random_access_skip_list/modify keeps equivalent elements", "" )
+{
+    multi_random_access_skip_list<int> list;
+    for (int n = 0; n < 10; ++n) list.insert(n);
+
+    REQUIRE(list.modify(list.iterator_at(8), SetTo(2)));
+    REQUIRE(list.size() == 10);
+    REQUIRE(list.count(2) == 2);
+    REQUIRE(list[2] == 2);
+    REQUIRE(list[3] == 2);
+    REQUIRE(list[9] == 9);
+}
+
+#ifdef SKIP_LIST_CPP11
+
+TEST_CASE( "multi_random_access_skip_list/node handles", "" )
+{
+    multi_random_access_skip_list<int> list;
+    for (int n = 0; n < 5; ++n) list.insert(n);
+    list.insert(3);
+
+    multi_random_access_skip_list<int>::node_handle handle = list.extract(3);
+    REQUIRE(handle.value() == 3);
+    REQUIRE(list.count(3) == 1);
+
+    multi_random_access_skip_list<int>::iterator i = list.insert(std::move(handle));
+    REQUIRE(*i == 3);
+    REQUIRE(list.count(3) == 2);
+    REQUIRE(list.size() == 6);
+}
+
+#endif
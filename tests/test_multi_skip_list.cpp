@@ -194,6 +194,38 @@ TEST_CASE( "multi_skip_list/erase over multiple item boundary", "" )
     REQUIRE(list.empty());
 }
 
+TEST_CASE( "multi_skip_list/erase a prefix", "" )
+{
+    multi_skip_list<int> list;
+    std::multiset<int>   set;
+    for (int n = 0; n < 2000; ++n)
+    {
+        const int value = rand() % 500;
+        list.insert(value);
+        set.insert(value);
+    }
+
+    // trim the front up to each bound in turn, as a time window would
+    for (int bound = 0; bound <= 500; bound += 7)
+    {
+        multi_skip_list<int>::iterator result = list.erase(list.begin(), list.lower_bound(bound));
+        set.erase(set.begin(), set.lower_bound(bound));
+        REQUIRE(result == list.begin());
+        REQUIRE(list.size() == set.size());
+        REQUIRE(std::equal(list.begin(), list.end(), set.begin()));
+
+        list.insert(bound + 500);
+        set.insert(bound + 500);
+    }
+
+    list.erase(list.begin(), list.begin());
+    REQUIRE(list.size() == set.size());
+    list.erase(list.begin(), list.end());
+    REQUIRE(list.empty());
+    list.insert(1);
+    REQUIRE(list.count(1) == 1);
+}
+
 //============================================================================
 // son of the mother of all tests
 
@@ -428,3 +460,218 @@ TEST_CASE( "multi_skip_list/equal_range/comparison with multiset", "" )
     REQUIRE(EqualRangeTest(20, clist));
     REQUIRE(EqualRangeTest(22, clist));
 }
+
+//============================================================================
+// merge
+
+TEST_CASE( "multi_skip_list/merge/moves every item", "" )
+{
+    multi_skip_list<int> l1, l2;
+    l1.insert(1); l1.insert(3); l1.insert(3);
+    l2.insert(2); l2.insert(3); l2.insert(4);
+
+    l1.merge(l2);
+    REQUIRE(l1.size() == 6);
+    REQUIRE(l2.empty());
+    REQUIRE(l1.count(3) == 3);
+    REQUIRE(l1.front() == 1);
+    REQUIRE(l1.back() == 4);
+}
+
+TEST_CASE( "multi_skip_list/split and join/equivalent values stay together", "" )
+{
+    multi_skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) { l1.insert(n); l1.insert(n); }
+
+    l1.split(40, l2);
+    REQUIRE(l1.size() == 80);
+    REQUIRE(l2.size() == 120);
+    REQUIRE(l1.count(40) == 0);
+    REQUIRE(l2.count(40) == 2);
+
+    l1.join(l2);
+    REQUIRE(l1.size() == 200);
+    REQUIRE(l1.count(40) == 2);
+    REQUIRE(l2.empty());
+}
+
+TEST_CASE( "multi_skip_list/merge/comparison with multiset", "" )
+{
+    std::multiset<int> set;
+    multi_skip_list<int> l1, l2;
+    for (unsigned n = 0; n < 500; ++n)
+    {
+        int v1 = rand() % 200, v2 = rand() % 200;
+        set.insert(v1); l1.insert(v1);
+        set.insert(v2); l2.insert(v2);
+    }
+
+    l1.merge(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(CheckEquality(set, l1));
+    for (int n = 0; n < 200; ++n)
+    {
+        REQUIRE(l1.count(n) == set.count(n));
+    }
+}
+
+//============================================================================
+// set algebra
+
+TEST_CASE( "multi_skip_list/set algebra/comparison with std algorithms", "" )
+{
+    std::multiset<int> s1, s2;
+    for (unsigned n = 0; n < 300; ++n)
+    {
+        s1.insert(rand() % 50);
+        s2.insert(rand() % 50);
+    }
+    multi_skip_list<int> l1(s1.begin(), s1.end()), l2(s2.begin(), s2.end());
+
+    std::vector<int> expected;
+    std::set_union(s1.begin(), s1.end(), s2.begin(), s2.end(), std::back_inserter(expected));
+    multi_skip_list<int> result = set_union(l1, l2);
+    REQUIRE(CheckEquality(expected, result));
+
+    expected.clear();
+    std::set_intersection(s1.begin(), s1.end(), s2.begin(), s2.end(), std::back_inserter(expected));
+    result = set_intersection(l1, l2);
+    REQUIRE(CheckEquality(expected, result));
+
+    expected.clear();
+    std::set_difference(s1.begin(), s1.end(), s2.begin(), s2.end(), std::back_inserter(expected));
+    result = set_difference(l1, l2);
+    REQUIRE(CheckEquality(expected, result));
+    REQUIRE(result.count(expected.front()) == size_t(std::count(expected.begin(), expected.end(), expected.front())));
+}
+
+//============================================================================
+// modify
+
+namespace
+{
+    struct AddTo
+    {
+        AddTo(int d) : delta(d) {}
+        void operator()(int &i) const { i += delta; }
+        int delta;
+    };
+}
+
+TEST_CASE( "multi_skip_list/modify/onto equivalent values", "" )
+{
+    multi_skip_list<int> list;
+    for (int n = 0; n < 5; ++n) list.insert(n);
+    for (int n = 0; n < 5; ++n) list.insert(n);
+
+    REQUIRE(list.modify(list.begin(), AddTo(2)));
+    REQUIRE(list.count(0) == 1);
+    REQUIRE(list.count(2) == 3);
+    REQUIRE(list.size() == 10);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "multi_skip_list/modify/comparison with multiset", "" )
+{
+    std::multiset<int> set;
+    multi_skip_list<int> list;
+    for (unsigned n = 0; n < 300; ++n)
+    {
+        int value = rand() % 100;
+        set.insert(value); list.insert(value);
+    }
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        int from  = rand() % 100;
+        int delta = rand() % 41 - 20;
+        multi_skip_list<int>::iterator i = list.find(from);
+        if (i == list.end()) continue;
+
+        REQUIRE(list.modify(i, AddTo(delta)));
+        set.erase(set.find(from));
+        set.insert(from + delta);
+    }
+    REQUIRE(CheckEquality(set, list));
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+//============================================================================
+// node handles
+
+TEST_CASE( "multi_skip_list/express index/comparison with multiset", "" )
+{
+    std::multiset<int>   set;
+    multi_skip_list<int> list;
+    list.set_express_levels(3);
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        const int value = rand() % 300;
+        if (rand() % 4)
+        {
+            set.insert(value);
+            list.insert(value);
+        }
+        else if (set.count(value))
+        {
+            set.erase(set.find(value));
+            list.erase(list.find(value));
+        }
+    }
+    REQUIRE(CheckEquality(set, list));
+    for (int value = -1; value <= 300; ++value)
+    {
+        REQUIRE(list.count(value) == set.count(value));
+        REQUIRE(std::distance(list.begin(), list.lower_bound(value))
+                == std::distance(set.begin(), set.lower_bound(value)));
+        REQUIRE(std::distance(list.begin(), list.upper_bound(value))
+                == std::distance(set.begin(), set.upper_bound(value)));
+    }
+}
+
+#ifdef SKIP_LIST_CPP11
+
+TEST_CASE( "multi_skip_list/insert node handle/equivalent values", "" )
+{
+    multi_skip_list<int> l1, l2;
+    for (int n = 0; n < 5; ++n) l1.insert(7);
+    l2.insert(7);
+
+    multi_skip_list<int>::node_handle handle = l1.extract(7);
+    REQUIRE(handle.value() == 7);
+    REQUIRE(l1.count(7) == 4);
+
+    multi_skip_list<int>::iterator i = l2.insert(std::move(handle));
+    REQUIRE(*i == 7);
+    REQUIRE(handle.empty());
+    REQUIRE(l2.count(7) == 2);
+
+    // round trip the rest
+    while (!l1.empty()) l2.insert(l1.extract(l1.begin()));
+    REQUIRE(l2.count(7) == 6);
+    REQUIRE(l2.size() == 6);
+}
+
+TEST_CASE( "multi_skip_list/insert node handle/changing the key", "" )
+{
+    std::multiset<int> set;
+    multi_skip_list<int> list;
+    for (unsigned n = 0; n < 200; ++n)
+    {
+        int value = rand() % 20;
+        set.insert(value); list.insert(value);
+    }
+    for (unsigned n = 0; n < 200; ++n)
+    {
+        int from = rand() % 20, to = rand() % 20;
+        if (!list.contains(from)) continue;
+
+        multi_skip_list<int>::node_handle handle = list.extract(from);
+        handle.value() = to;
+        list.insert(std::move(handle));
+        set.erase(set.find(from));
+        set.insert(to);
+    }
+    REQUIRE(CheckEquality(set, list));
+}
+
+#endif
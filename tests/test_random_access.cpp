@@ -9,6 +9,12 @@
 #include "catch.hpp"
 #include "test_types.h"
 
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+
 using goodliffe::random_access_skip_list;
 
 TEST_CASE( "random_access_skip_list/smoketest", "" )
@@ -335,6 +341,48 @@ TEST_CASE( "random_access_skip_list/iterators/subtraction", "" )
     REQUIRE(((clist.begin()+5)-(clist.begin()+2)) == 3)
 }
 
+TEST_CASE( "random_access_skip_list/iterators/jumps of every size", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 2000; ++n) list.insert(n);
+
+    random_access_skip_list<int>::const_iterator i = list.begin();
+    int index = 0;
+    for (int jump = 0; jump < 500; ++jump)
+    {
+        const int target = (index*7 + jump*13) % 2000;
+        i += target - index;
+        index = target;
+        REQUIRE(*i == index);
+        REQUIRE((i - list.begin()) == index);
+        REQUIRE(list.index_of(i) == unsigned(index));
+    }
+    i = list.begin() + 1990;
+    i += 10;
+    REQUIRE(i == list.end());
+}
+
+TEST_CASE( "random_access_skip_list/iterators/indexes follow changes to the list", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 100; n += 2) list.insert(n);
+
+    random_access_skip_list<int>::iterator i = list.begin() + 10;
+    REQUIRE(*i == 20);
+    REQUIRE((i - list.begin()) == 10);
+
+    list.insert(1);
+    list.insert(3);
+    REQUIRE((i - list.begin()) == 12);
+    REQUIRE(*(i+1) == 22);
+    REQUIRE(*(i-1) == 18);
+
+    list.erase(0);
+    ++i;
+    REQUIRE(*i == 22);
+    REQUIRE(list.index_of(i) == 12);
+}
+
 //============================================================================
 #pragma mark erase_at
 
@@ -487,6 +535,583 @@ TEST_CASE( "random_access_skip_list/index_of", "" )
     REQUIRE(list.index_of(list.end()) == 9);
 }
 
+namespace
+{
+    /// Counts how often it is called
+    struct CountingLess
+    {
+        static unsigned calls;
+        bool operator()(int lhs, int rhs) const { ++calls; return lhs < rhs; }
+    };
+    unsigned CountingLess::calls = 0;
+}
+
+TEST_CASE( "random_access_skip_list/index_of/compares no values", "" )
+{
+    random_access_skip_list<int, CountingLess> list;
+    for (int n = 0; n < 1000; ++n) list.insert(n);
+
+    std::vector<random_access_skip_list<int, CountingLess>::const_iterator> found;
+    for (int n = 0; n < 1000; n += 7) found.push_back(list.find(n));
+    list.insert(-1); // so that the iterators' own indexes are out of date
+
+    CountingLess::calls = 0;
+    for (size_t n = 0; n < found.size(); ++n)
+    {
+        REQUIRE(list.index_of(found[n]) == n*7 + 1);
+    }
+    REQUIRE(CountingLess::calls == 0);
+
+    list.erase(found[10]);
+#ifndef SKIP_LIST_IMPL_DIAGNOSTICS // check() compares them all
+    REQUIRE(CountingLess::calls == 0);
+#endif
+    REQUIRE(list[71] == 71);
+}
+
+//============================================================================
+#pragma mark order statistics
+
+TEST_CASE( "random_access_skip_list/count_less and rank", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 100; n += 2) list.insert(n);
+
+    REQUIRE(list.count_less(-5) == 0);
+    REQUIRE(list.count_less(0)  == 0);
+    REQUIRE(list.count_less(1)  == 1);
+    REQUIRE(list.count_less(2)  == 1);
+    REQUIRE(list.count_less(98) == 49);
+    REQUIRE(list.count_less(99) == 50);
+    REQUIRE(list.count_less(500) == 50);
+
+    for (int n = 0; n < 100; n += 2)
+    {
+        REQUIRE(list[list.rank(n)] == n);
+    }
+}
+
+TEST_CASE( "random_access_skip_list/count_between", "" )
+{
+    random_access_skip_list<int> list;
+    std::vector<int> data;
+    for (int n = 0; n < 2000; ++n)
+    {
+        const int value = rand() % 5000;
+        if (list.insert(value).second) data.push_back(value);
+    }
+    std::sort(data.begin(), data.end());
+
+    for (int n = 0; n < 500; ++n)
+    {
+        const int lo = rand() % 5200 - 100;
+        const int hi = lo + rand() % 1000;
+        const long expected = std::lower_bound(data.begin(), data.end(), hi)
+                            - std::lower_bound(data.begin(), data.end(), lo);
+        REQUIRE(list.count_between(lo, hi) == size_t(expected));
+        REQUIRE(list.count_between(hi, lo) == 0);
+    }
+    REQUIRE(list.count_between(-1, 5000) == list.size());
+    REQUIRE(list.count_between(data[10], data[10]) == 0);
+    REQUIRE(list.count_between(data[10], data[10]+1) == 1);
+
+    random_access_skip_list<int> empty;
+    REQUIRE(empty.count_between(0, 10) == 0);
+    REQUIRE(empty.count_less(0) == 0);
+}
+
+//============================================================================
+#pragma mark span type
+
+namespace
+{
+    typedef random_access_skip_list<int, std::less<int>, std::allocator<int>,
+                                    goodliffe::detail::skip_list_level_generator<32>,
+                                    false, unsigned short> short_span_list;
+}
+
+TEST_CASE( "random_access_skip_list/span type/limits max_size", "" )
+{
+    REQUIRE(random_access_skip_list<int>().max_size() >= 0xfffffffeu);
+    REQUIRE(short_span_list().max_size() == 65534);
+}
+
+TEST_CASE( "random_access_skip_list/span type/short spans keep indexes", "" )
+{
+    short_span_list list;
+    std::vector<int> data;
+    for (int n = 0; n < 60000; ++n)
+    {
+        const int value = rand() % 100000;
+        if (list.insert(value).second) data.push_back(value);
+    }
+    std::sort(data.begin(), data.end());
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+
+    // Erasing lengthens the spans over the gaps
+    list.erase(list.begin() + 10, list.end() - 10);
+    data.erase(data.begin() + 10, data.end() - 10);
+    REQUIRE(list.size() == 20);
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+    REQUIRE(list.index_of(list.find(data[15])) == 15);
+}
+
+TEST_CASE( "random_access_skip_list/span type/growing past max_size throws", "" )
+{
+    std::vector<int> data;
+    for (int n = 0; n < 65534; ++n) data.push_back(n*2);
+
+    short_span_list list;
+    list.assign_sorted(data.begin(), data.end());
+    REQUIRE(list.size() == list.max_size());
+
+    REQUIRE_THROWS_AS(list.insert(1), const std::length_error &);
+    REQUIRE(list.size() == 65534);
+    REQUIRE(list.count(1) == 0);
+
+    short_span_list other;
+    other.insert(200000);
+    REQUIRE_THROWS_AS(list.join(other), const std::length_error &);
+    REQUIRE(list.size() == 65534);
+    REQUIRE(other.size() == 1);
+
+#ifdef SKIP_LIST_CPP11
+    short_span_list::node_handle handle = other.extract(other.begin());
+    REQUIRE_THROWS_AS(list.insert(std::move(handle)), const std::length_error &);
+    REQUIRE_FALSE(handle.empty());
+#endif
+
+    data.push_back(200000);
+    REQUIRE_THROWS_AS(other.assign_sorted(data.begin(), data.end()), const std::length_error &);
+    REQUIRE(other.size() == 65534);
+
+    list.erase(list.begin());
+    REQUIRE(list.insert(1).second);
+    REQUIRE(list[0] == 1);
+    REQUIRE(CheckEqualityViaIndexing(other, std::vector<int>(data.begin(), data.end()-1)));
+}
+
+//============================================================================
+#pragma mark weights
+
+namespace
+{
+    /// A price level in an order book, ordered by price
+    struct Level
+    {
+        Level(int price_, long volume_) : price(price_), volume(volume_) {}
+        bool operator<(const Level &other) const { return price < other.price; }
+        int  price;
+        long volume;
+    };
+
+    std::ostream &operator<<(std::ostream &s, const Level &level)
+        { return s << level.price << "x" << level.volume; }
+
+    struct Volume : goodliffe::additive_weight<long>
+    {
+        long operator()(const Level &level) const { return level.volume; }
+    };
+
+    typedef random_access_skip_list<Level, std::less<Level>, std::allocator<Level>,
+                                    goodliffe::detail::skip_list_level_generator<32>,
+                                    false, unsigned, Volume> order_book;
+
+    struct SetVolume
+    {
+        SetVolume(long v) : volume(v) {}
+        void operator()(Level &level) const { level.volume = volume; }
+        long volume;
+    };
+
+    /// Checks every prefix weight, and lower_bound_by_weight, by brute force
+    bool WeightsAreRight(const order_book &book)
+    {
+        long total = 0;
+        for (size_t n = 0; n < book.size(); ++n)
+        {
+            if (book.prefix_weight(n) != total) return false;
+            total += book[unsigned(n)].volume;
+            if (book[unsigned(n)].volume
+                && book.index_of(book.lower_bound_by_weight(total)) != n) return false;
+        }
+        return book.prefix_weight(book.size()) == total
+            && book.lower_bound_by_weight(total+1) == book.end();
+    }
+}
+
+TEST_CASE( "random_access_skip_list/weights/unit weights are indexes", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n*2);
+
+    REQUIRE(list.prefix_weight(0) == 0);
+    REQUIRE(list.prefix_weight(37) == 37);
+    REQUIRE(list.prefix_weight(100) == 100);
+    REQUIRE(*list.lower_bound_by_weight(5) == 8);
+    REQUIRE(list.lower_bound_by_weight(0) == list.begin());
+    REQUIRE(list.lower_bound_by_weight(101) == list.end());
+    REQUIRE(list.aggregate(10, 20) == 5);
+}
+
+TEST_CASE( "random_access_skip_list/weights/follow changes to the list", "" )
+{
+    order_book book;
+    for (int n = 0; n < 2000; ++n)
+    {
+        book.insert(Level(rand() % 10000, rand() % 100));
+    }
+    REQUIRE(WeightsAreRight(book));
+
+    for (int n = 0; n < 500; ++n)
+    {
+        book.erase_at(unsigned(rand()) % unsigned(book.size()));
+    }
+    REQUIRE(WeightsAreRight(book));
+
+    for (int n = 0; n < 500; ++n)
+    {
+        // new volumes in place, and new prices that move the level
+        order_book::iterator i = book.iterator_at(unsigned(rand()) % unsigned(book.size()));
+        book.modify(i, SetVolume(rand() % 100));
+    }
+    REQUIRE(WeightsAreRight(book));
+
+    book.erase(book.begin() + 100, book.begin() + 700);
+    REQUIRE(WeightsAreRight(book));
+
+    order_book copy(book);
+    REQUIRE(WeightsAreRight(copy));
+
+    order_book more;
+    for (int n = 0; n < 300; ++n) more.insert(Level(20000 + n, n));
+    book.join(more);
+    REQUIRE(WeightsAreRight(book));
+    REQUIRE(WeightsAreRight(more));
+
+    book.clear();
+    REQUIRE(WeightsAreRight(book));
+    REQUIRE(book.lower_bound_by_weight(1) == book.end());
+}
+
+TEST_CASE( "random_access_skip_list/weights/fill an order", "" )
+{
+    order_book book;
+    book.insert(Level(101, 50));
+    book.insert(Level(100, 20));
+    book.insert(Level(103, 5));
+    book.insert(Level(102, 30));
+
+    // Buying 60 takes all of 100 and 101, and reaches 102
+    REQUIRE(book.lower_bound_by_weight(60)->price == 101);
+    REQUIRE(book.lower_bound_by_weight(71)->price == 102);
+    REQUIRE(book.lower_bound_by_weight(105)->price == 103);
+    REQUIRE(book.lower_bound_by_weight(106) == book.end());
+
+    REQUIRE(book.aggregate(Level(101, 0), Level(103, 0)) == 80);
+    REQUIRE(book.aggregate(Level(103, 0), Level(101, 0)) == 0);
+    REQUIRE(book.prefix_weight(4) == 105);
+
+    // as dump() writes them, under SKIP_LIST_IMPL_DIAGNOSTICS
+    std::ostringstream s;
+    s << book.front();
+    REQUIRE(s.str() == "100x20");
+}
+
+namespace
+{
+    /// A keyed event, ordered by key
+    struct Event
+    {
+        Event(int key_, int time_) : key(key_), time(time_) {}
+        bool operator<(const Event &other) const { return key < other.key; }
+        int key;
+        int time;
+    };
+
+    std::ostream &operator<<(std::ostream &s, const Event &event)
+        { return s << event.key << "@" << event.time; }
+
+    /// Aggregates the latest time: a monoid with no inverse
+    struct Latest
+    {
+        typedef int result_type;
+        static int identity()                               { return -1; }
+        static int combine(const int &lhs, const int &rhs) { return std::max(lhs, rhs); }
+        int operator()(const Event &event) const { return event.time; }
+    };
+
+    typedef random_access_skip_list<Event, std::less<Event>, std::allocator<Event>,
+                                    goodliffe::detail::skip_list_level_generator<32>,
+                                    false, unsigned, Latest> latest_list;
+
+    /// Checks aggregate() over random ranges against a walk through them
+    bool AggregatesAreRight(const latest_list &list)
+    {
+        for (int n = 0; n < 200; ++n)
+        {
+            const size_t lo = size_t(rand()) % (list.size()+1);
+            const size_t hi = lo + size_t(rand()) % (list.size()+1-lo);
+            int expected = -1;
+            for (size_t i = lo; i < hi; ++i) expected = std::max(expected, list[unsigned(i)].time);
+            if (list.aggregate(list.begin() + long(lo), list.begin() + long(hi)) != expected) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE( "random_access_skip_list/weights/aggregate with any monoid", "" )
+{
+    latest_list list;
+    for (int n = 0; n < 2000; ++n)
+    {
+        list.insert(Event(n * 7919 % 10007, n));
+    }
+    REQUIRE(AggregatesAreRight(list));
+    REQUIRE(list.aggregate(list.begin(), list.end()) == 1999);
+    REQUIRE(list.aggregate(list.begin(), list.begin()) == -1);
+
+    for (int n = 0; n < 500; ++n)
+    {
+        list.erase_at(unsigned(rand()) % unsigned(list.size()));
+    }
+    REQUIRE(AggregatesAreRight(list));
+
+    list.erase(list.begin() + 100, list.begin() + 700);
+    REQUIRE(AggregatesAreRight(list));
+
+    int expected = -1;
+    for (unsigned i = 10; i < 50; ++i) expected = std::max(expected, list[i].time);
+    REQUIRE(list.aggregate(list[10], list[50]) == expected);
+    REQUIRE(list.aggregate(list[50], list[10]) == -1);
+
+    // as dump() writes them, under SKIP_LIST_IMPL_DIAGNOSTICS
+    std::ostringstream s;
+    s << Event(3, 4);
+    REQUIRE(s.str() == "3@4");
+}
+
+namespace
+{
+    /// A weight whose values are not trivial: each node's weights must be
+    /// constructed, and destroyed, not just allocated
+    struct Letters
+    {
+        typedef std::string result_type;
+
+        static std::string identity()                                    { return std::string(); }
+        static std::string combine(const std::string &lhs, const std::string &rhs) { return lhs + rhs; }
+
+        std::string operator()(int value) const { return std::string(1, char('a' + value % 26)); }
+    };
+
+    typedef random_access_skip_list<int, std::less<int>, std::allocator<int>,
+                                    goodliffe::detail::skip_list_level_generator<32>,
+                                    false, unsigned, Letters> letter_list;
+}
+
+TEST_CASE( "random_access_skip_list/weights/class type weights", "" )
+{
+    letter_list list;
+    for (int n = 25; n >= 0; --n) list.insert(n);
+
+    REQUIRE(list.aggregate(list.begin(), list.end()) == "abcdefghijklmnopqrstuvwxyz");
+    REQUIRE(list.aggregate(list[3], list[7]) == "defg");
+
+    list.erase(list.begin() + 10, list.begin() + 20);
+    REQUIRE(list.aggregate(list.begin(), list.end()) == "abcdefghijuvwxyz");
+
+    letter_list copy(list);
+    list.clear();
+    REQUIRE(copy.aggregate(copy.begin(), copy.end()) == "abcdefghijuvwxyz");
+}
+
+//============================================================================
+#pragma mark modify
+
+namespace
+{
+    struct AddTo
+    {
+        AddTo(int d) : delta(d) {}
+        void operator()(int &i) const { i += delta; }
+        int delta;
+    };
+}
+
+TEST_CASE( "random_access_skip_list/modify/maintains indexes", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 9; ++n) list.insert(n*10);
+
+    REQUIRE(list.modify(list.iterator_at(2), AddTo(3)));   // 20 -> 23, stays
+    REQUIRE(list[2] == 23);
+    REQUIRE(list.modify(list.iterator_at(2), AddTo(50)));  // 23 -> 73
+    REQUIRE(list[1] == 10); REQUIRE(list[2] == 30); REQUIRE(list[6] == 70);
+    REQUIRE(list[7] == 73); REQUIRE(list[8] == 80);
+    REQUIRE_FALSE(list.modify(list.iterator_at(0), AddTo(30))); // 0 -> 30, erased
+    REQUIRE(list.size() == 8);
+    REQUIRE(list[0] == 10);
+}
+
+TEST_CASE( "random_access_skip_list/modify/comparison with vector", "" )
+{
+    std::vector<int> data;
+    FillWithRandomData(500, data);
+    random_access_skip_list<int> list(data.begin(), data.end());
+    SortVectorAndRemoveDuplicates(data);
+
+    for (unsigned n = 0; n < 500; ++n)
+    {
+        unsigned index = unsigned(rand()) % unsigned(list.size());
+        int      delta = rand() % 2001 - 1000;
+        int      value = data[index] + delta;
+
+        const bool kept = list.modify(list.iterator_at(index), AddTo(delta));
+        const bool expected = delta == 0 || !std::binary_search(data.begin(), data.end(), value);
+        REQUIRE(kept == expected);
+
+        data.erase(data.begin()+index);
+        if (kept) data.insert(std::lower_bound(data.begin(), data.end(), value), value);
+    }
+
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+}
+
+//============================================================================
+#pragma mark node handles
+
+//============================================================================
+#pragma mark assign_sorted and join
+
+TEST_CASE( "random_access_skip_list/assign_sorted/builds indexes", "" )
+{
+    std::vector<int> data;
+    for (int n = 0; n < 1000; ++n) data.push_back(n*3);
+    data.push_back(data.back()); // equivalents are skipped
+
+    random_access_skip_list<int> list;
+    list.insert(7);
+    list.assign_sorted(data.begin(), data.end());
+    data.pop_back();
+
+    REQUIRE(list.size() == 1000);
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+    REQUIRE(list.index_of(list.find(300)) == 100);
+
+    // and still works as normal afterwards
+    list.insert(1);
+    list.erase(0);
+    REQUIRE(list[0] == 1);
+    REQUIRE(list[1] == 3);
+    REQUIRE(list.size() == 1000);
+}
+
+TEST_CASE( "random_access_skip_list/copy keeps indexes", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 500; ++n) list.insert(rand());
+    random_access_skip_list<int> copy(list);
+    REQUIRE(copy == list);
+    for (unsigned n = 0; n < copy.size(); ++n)
+    {
+        REQUIRE(copy[n] == list[n]);
+    }
+}
+
+TEST_CASE( "random_access_skip_list/join/fixes up the indexes", "" )
+{
+    std::vector<int> data;
+    random_access_skip_list<int> l1, l2;
+    for (int n = 0; n < 300; ++n) { l1.insert(n); data.push_back(n); }
+    for (int n = 300; n < 1000; ++n) { l2.insert(n); data.push_back(n); }
+
+    l1.join(l2);
+    REQUIRE(l2.empty());
+    REQUIRE(l2.begin() == l2.end());
+    REQUIRE(l1.size() == 1000);
+    REQUIRE(CheckEquality(l1, data));
+    REQUIRE(CheckEqualityViaIndexing(l1, data));
+    REQUIRE((l1.end() - l1.begin()) == 1000);
+
+    // Both lists are still usable
+    l1.erase_at(500);
+    REQUIRE(l1[500] == 501);
+    l2.insert(5);
+    REQUIRE(l2[0] == 5);
+}
+
+TEST_CASE( "random_access_skip_list/join/onto an empty list", "" )
+{
+    random_access_skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) l2.insert(n);
+    l1.join(l2);
+    l1.join(l2);
+    REQUIRE(l1.size() == 100);
+    REQUIRE(l1[99] == 99);
+    REQUIRE(l2.empty());
+}
+
+#ifdef SKIP_LIST_CPP11
+
+TEST_CASE( "random_access_skip_list/extract/maintains indexes", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 9; ++n) list.insert(n);
+
+    random_access_skip_list<int>::node_handle handle = list.extract(list.iterator_at(3));
+    REQUIRE(handle.value() == 3);
+    REQUIRE(list.size() == 8);
+    REQUIRE(list[2] == 2); REQUIRE(list[3] == 4); REQUIRE(list[7] == 8);
+
+    REQUIRE(list.extract(3).empty());
+}
+
+TEST_CASE( "random_access_skip_list/insert node handle/changing the key", "" )
+{
+    std::vector<int> data;
+    FillWithRandomData(500, data);
+    random_access_skip_list<int> list(data.begin(), data.end());
+    SortVectorAndRemoveDuplicates(data);
+
+    for (unsigned n = 0; n < 50; ++n)
+    {
+        unsigned index = unsigned(rand()) % unsigned(list.size());
+        random_access_skip_list<int>::node_handle handle = list.extract(list.iterator_at(index));
+        data.erase(data.begin()+index);
+
+        int value = rand();
+        handle.value() = value;
+        random_access_skip_list<int>::insert_return_type result = list.insert(std::move(handle));
+        if (result.inserted)
+        {
+            data.insert(std::lower_bound(data.begin(), data.end(), value), value);
+            REQUIRE(*result.position == value);
+            REQUIRE(list.index_of(result.position) == size_t(std::lower_bound(data.begin(), data.end(), value)-data.begin()));
+        }
+    }
+
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+}
+
+TEST_CASE( "random_access_skip_list/insert node handle/between lists", "" )
+{
+    random_access_skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) l1.insert(n);
+
+    while (l1.size() > 50) l2.insert(l1.extract(l1.iterator_at(l1.size()/2)));
+
+    REQUIRE(l2.size() == 50);
+    for (unsigned n = 1; n < l1.size(); ++n) { REQUIRE(l1[n-1] < l1[n]); }
+    for (unsigned n = 1; n < l2.size(); ++n) { REQUIRE(l2[n-1] < l2[n]); }
+    REQUIRE((l1.end() - l1.begin()) == 50);
+}
+
+#endif
+
 //============================================================================
 // TODO: allocation test
 
@@ -0,0 +1,263 @@
+//============================================================================
+// test_rcu_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_list_rcu.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using goodliffe::rcu_skip_list;
+
+namespace
+{
+    const unsigned num_readers = 6;
+
+    /// Allocations outstanding through any CountingAllocator
+    std::atomic<long> live_allocations(0);
+
+    template <typename T>
+    struct CountingAllocator : std::allocator<T>
+    {
+        template <typename OTHER>
+        struct rebind { typedef CountingAllocator<OTHER> other; };
+
+        CountingAllocator() {}
+        template <typename OTHER>
+        CountingAllocator(const CountingAllocator<OTHER> &) {}
+
+        T *allocate(std::size_t n, const void * = 0)
+            { ++live_allocations; return std::allocator<T>::allocate(n); }
+        void deallocate(T *p, std::size_t n)
+            { --live_allocations; std::allocator<T>::deallocate(p, n); }
+    };
+
+    typedef goodliffe::skip_list<int,std::less<int>,CountingAllocator<int>,
+                                 goodliffe::detail::skip_list_level_generator<32>,
+                                 false,
+                                 goodliffe::detail::single_writer> CountingList;
+}
+
+TEST_CASE( "rcu_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "rcu_skip_list/can call basic methods", "" )
+{
+    const rcu_skip_list<int> list;
+    rcu_skip_list<int>::read_guard guard(list);
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.find(10) == list.end());
+    REQUIRE(!list.contains(20));
+    REQUIRE(list.begin() == list.end());
+}
+
+TEST_CASE( "rcu_skip_list/read_guard compiles away for single_threaded", "" )
+{
+    goodliffe::skip_list<int> list;
+    list.insert(1);
+    goodliffe::skip_list<int>::read_guard guard(list);
+    REQUIRE(list.contains(1));
+}
+
+//============================================================================
+// single threaded: the usual skip_list API
+
+TEST_CASE( "rcu_skip_list/comparison with set", "" )
+{
+    std::set<int> set;
+    rcu_skip_list<int> list;
+
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        int value = rand() % 1000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value).second == set.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == set.erase(value));
+        }
+    }
+
+    REQUIRE(list.size() == set.size());
+    REQUIRE(std::equal(set.begin(), set.end(), list.begin()));
+    REQUIRE(std::equal(set.rbegin(), set.rend(), list.rbegin()));
+}
+
+TEST_CASE( "rcu_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        rcu_skip_list<Counter> list;
+        for (int n = 0; n < 100; ++n) list.insert(n);
+        for (int n = 0; n < 100; n += 3) list.erase(n);
+        list.erase(list.begin(), list.find(50));
+        REQUIRE(list.size() == 33);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+//============================================================================
+// deferred reclamation
+
+TEST_CASE( "rcu_skip_list/read_guard holds up reclamation", "" )
+{
+    live_allocations = 0;
+    {
+        CountingList list;
+        for (int n = 0; n < 1000; ++n) list.insert(n);
+        const long full_list = live_allocations.load();
+
+        CountingList::const_iterator i;
+        {
+            CountingList::read_guard guard(list);
+            i = list.find(10);
+            list.erase(list.begin(), list.find(500));
+            list.erase(600);
+            list.clear();
+            REQUIRE(list.empty());
+            REQUIRE(live_allocations.load() >= full_list);
+
+            // The erased element is still there to read
+            REQUIRE(*i == 10);
+            ++i;
+            REQUIRE(*i == 11);
+        }
+
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int n = 0; n < 100; ++n) list.insert(n);
+            for (int n = 0; n < 100; ++n) list.erase(n);
+        }
+        REQUIRE(live_allocations.load() < full_list);
+    }
+    REQUIRE(live_allocations.load() == 0);
+}
+
+//============================================================================
+// multi threaded
+
+TEST_CASE( "rcu_skip_list/threads/readers iterate while the writer works", "" )
+{
+    // The even values are always present; the writer inserts and erases
+    // the odd ones. Every reader must always see every even value, in order.
+    rcu_skip_list<int> list;
+    for (int n = 0; n < 2000; n += 2) list.insert(n);
+
+    std::atomic<bool> done(false);
+    std::atomic<bool> ok(true);
+    std::atomic<int>  reads(0);
+
+    std::vector<std::thread> readers;
+    for (unsigned t = 0; t < num_readers; ++t)
+    {
+        readers.push_back(std::thread([&list, &done, &ok, &reads, t]
+        {
+            while (!done.load())
+            {
+                rcu_skip_list<int>::read_guard guard(list);
+                if (t % 2)
+                {
+                    int expected_even = 0;
+                    int last          = -1;
+                    for (rcu_skip_list<int>::const_iterator i = list.begin(); i != list.end(); ++i)
+                    {
+                        if (*i <= last) ok = false;
+                        if (*i % 2 == 0)
+                        {
+                            if (*i != expected_even) ok = false;
+                            expected_even += 2;
+                        }
+                        last = *i;
+                    }
+                    if (expected_even != 2000) ok = false;
+                }
+                else
+                {
+                    // Backwards with operator--; a reverse_iterator follows
+                    // the link again each time it is dereferenced
+                    int last = 2000;
+                    for (rcu_skip_list<int>::const_iterator i = list.end(); i != list.begin(); )
+                    {
+                        --i;
+                        if (*i >= last) ok = false;
+                        last = *i;
+                    }
+                    for (int n = 0; n < 2000; n += 2)
+                        if (!list.contains(n)) ok = false;
+                }
+                ++reads;
+            }
+        }));
+    }
+
+    for (int round = 0; round < 20; ++round)
+    {
+        for (int n = 1; n < 2000; n += 2) list.insert(n);
+        for (int n = 1; n < 2000; n += 4) list.erase(n);
+        list.erase(list.find(3));
+        list.erase(list.find(7), list.find(8));
+        for (int n = 1; n < 2000; n += 2) list.erase(n);
+    }
+    while (reads.load() < int(num_readers)) std::this_thread::yield();
+    done = true;
+    for (unsigned t = 0; t < num_readers; ++t) readers[t].join();
+
+    REQUIRE(ok.load());
+    REQUIRE(list.size() == 1000);
+}
+
+TEST_CASE( "rcu_skip_list/threads/reclamation keeps up", "" )
+{
+    live_allocations = 0;
+    {
+        CountingList list;
+        for (int n = 0; n < 1000; ++n) list.insert(n*2);
+        const long full_list = live_allocations.load();
+
+        std::atomic<bool> done(false);
+        std::vector<std::thread> readers;
+        for (unsigned t = 0; t < num_readers; ++t)
+        {
+            readers.push_back(std::thread([&list, &done]
+            {
+                while (!done.load())
+                {
+                    CountingList::read_guard guard(list);
+                    for (int n = 0; n < 100; ++n) list.contains(n);
+                }
+            }));
+        }
+
+        for (int round = 0; round < 200; ++round)
+        {
+            for (int n = 1; n < 200; n += 2) list.insert(n);
+            for (int n = 1; n < 200; n += 2) list.erase(n);
+        }
+        done = true;
+        for (unsigned t = 0; t < num_readers; ++t) readers[t].join();
+
+        // How much was waiting depended on when the readers were scheduled
+        // (one pre-empted while holding its guard holds everything up), but
+        // once the readers have gone the backlog must clear
+        for (int round = 0; round < 10; ++round)
+        {
+            for (int n = 1; n < 200; n += 2) list.insert(n);
+            for (int n = 1; n < 200; n += 2) list.erase(n);
+        }
+        const long waiting = live_allocations.load() - full_list;
+        REQUIRE(waiting < 2000);
+    }
+    REQUIRE(live_allocations.load() == 0);
+}
@@ -0,0 +1,237 @@
+//============================================================================
+// test_sequence_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "sequence_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <vector>
+#include <string>
+#include <algorithm>
+
+using goodliffe::sequence_skip_list;
+
+namespace
+{
+    struct Length : goodliffe::additive_weight<size_t>
+    {
+        size_t operator()(const std::string &s) const { return s.size(); }
+    };
+
+    typedef sequence_skip_list<std::string, std::allocator<std::string>,
+                               goodliffe::detail::skip_list_level_generator<32>,
+                               unsigned, Length> rope;
+}
+
+TEST_CASE( "sequence_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "sequence_skip_list/can call basic methods", "" )
+{
+    const sequence_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.begin() == list.end());
+    REQUIRE(list.rbegin() == list.rend());
+    REQUIRE(list.max_size() > 67890);
+}
+
+TEST_CASE( "sequence_skip_list/keeps the order elements are put in", "" )
+{
+    sequence_skip_list<int> list;
+    list.push_back(5);
+    list.push_back(1);
+    list.push_front(9);
+    list.push_back(3);
+
+    const int expected[] = { 9, 5, 1, 3 };
+    REQUIRE(list.size() == 4);
+    REQUIRE(std::equal(list.begin(), list.end(), expected));
+    REQUIRE(list.front() == 9);
+    REQUIRE(list.back() == 3);
+
+    list.pop_front();
+    list.pop_back();
+    REQUIRE(list.size() == 2);
+    REQUIRE(list[0] == 5);
+    REQUIRE(list[1] == 1);
+}
+
+TEST_CASE( "sequence_skip_list/edits match a vector", "" )
+{
+    sequence_skip_list<int> list;
+    std::vector<int> data;
+    for (int n = 0; n < 5000; ++n)
+    {
+        const int choice = rand() % 4;
+        if (choice != 0 || data.empty())
+        {
+            const size_t index = size_t(rand()) % (data.size()+1);
+            sequence_skip_list<int>::iterator i = list.insert_at(index, n);
+            data.insert(data.begin() + long(index), n);
+            REQUIRE(*i == n);
+            REQUIRE(list.index_of(i) == index);
+        }
+        else
+        {
+            const size_t index = size_t(rand()) % data.size();
+            list.erase_at(index);
+            data.erase(data.begin() + long(index));
+        }
+    }
+    REQUIRE(list.size() == data.size());
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+}
+
+TEST_CASE( "sequence_skip_list/insert before an iterator", "" )
+{
+    sequence_skip_list<int> list;
+    for (int n = 0; n < 10; ++n) list.push_back(n);
+
+    sequence_skip_list<int>::iterator i = list.insert(list.iterator_at(3), 100);
+    REQUIRE(*i == 100);
+    REQUIRE(list[3] == 100);
+    REQUIRE(list[4] == 3);
+
+    const int more[] = { 7, 8, 9 };
+    list.insert(list.end(), more, more+3);
+    list.insert(list.begin(), more, more+3);
+    REQUIRE(list.size() == 17);
+    REQUIRE(list[0] == 7);
+    REQUIRE(list[2] == 9);
+    REQUIRE(list[3] == 0);
+    REQUIRE(list.back() == 9);
+}
+
+TEST_CASE( "sequence_skip_list/iterators and references stay valid", "" )
+{
+    sequence_skip_list<int> list;
+    for (int n = 0; n < 1000; ++n) list.push_back(n);
+
+    sequence_skip_list<int>::iterator i = list.iterator_at(500);
+    int &value = list[500];
+    for (int n = 0; n < 1000; ++n)
+    {
+        list.insert_at(size_t(rand()) % (list.size()+1), -1);
+    }
+    list.erase(list.begin(), list.begin() + 10);
+
+    REQUIRE(*i == 500);
+    REQUIRE(&value == &*i);
+    REQUIRE(list[list.index_of(i)] == 500);
+}
+
+TEST_CASE( "sequence_skip_list/values can be changed", "" )
+{
+    sequence_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.push_front(n);
+
+    list[0] = 1000;
+    *list.iterator_at(1) = 2000;
+    list.back() = -1;
+    REQUIRE(list[0] == 1000);
+    REQUIRE(list[1] == 2000);
+    REQUIRE(list[99] == -1);
+
+    std::sort(list.begin(), list.end());
+    REQUIRE(list.front() == -1);
+    REQUIRE(list[1] == 1);
+    REQUIRE(list.back() == 2000);
+}
+
+TEST_CASE( "sequence_skip_list/erase range", "" )
+{
+    std::vector<int> data;
+    for (int n = 0; n < 1000; ++n) data.push_back(rand() % 10);
+    sequence_skip_list<int> list(data.begin(), data.end());
+    REQUIRE(CheckEquality(list, data));
+
+    sequence_skip_list<int>::iterator i = list.erase(list.iterator_at(100), list.iterator_at(900));
+    data.erase(data.begin() + 100, data.begin() + 900);
+    REQUIRE(list.index_of(i) == 100);
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+}
+
+TEST_CASE( "sequence_skip_list/copy, compare and join", "" )
+{
+    sequence_skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.push_back(n % 7);
+
+    sequence_skip_list<int> copy(list);
+    REQUIRE(copy == list);
+    copy.push_back(0);
+    REQUIRE(copy != list);
+    REQUIRE(list < copy);
+
+    sequence_skip_list<int> tail(list);
+    list.join(tail);
+    REQUIRE(tail.empty());
+    REQUIRE(list.size() == 200);
+    for (size_t n = 0; n < 200; ++n)
+    {
+        REQUIRE(list[n] == int(n % 100 % 7));
+    }
+}
+
+TEST_CASE( "sequence_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        sequence_skip_list<Counter> list;
+        for (int n = 0; n < 100; ++n) list.insert_at(size_t(n/2), Counter(n));
+        list.erase_at(50);
+        list.pop_front();
+        list.erase(list.begin(), list.begin() + 10);
+        REQUIRE(list.size() == 88);
+        REQUIRE(Counter::count == 88);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "sequence_skip_list/weights make a rope", "" )
+{
+    rope text;
+    text.push_back("Hello");
+    text.push_back(", ");
+    text.push_back("world");
+    text.insert_at(2, "big ");
+    text.push_back("!");
+
+    REQUIRE(text.prefix_weight(text.size()) == 17);
+    REQUIRE(text.prefix_weight(2) == 7);
+
+    // The piece holding byte n is the first whose running length passes n
+    REQUIRE(*text.lower_bound_by_weight(1) == "Hello");
+    REQUIRE(*text.lower_bound_by_weight(5) == "Hello");
+    REQUIRE(*text.lower_bound_by_weight(6) == ", ");
+    REQUIRE(*text.lower_bound_by_weight(8) == "big ");
+    REQUIRE(*text.lower_bound_by_weight(17) == "!");
+    REQUIRE(text.lower_bound_by_weight(18) == text.end());
+
+    text.erase_at(2);
+    REQUIRE(text.prefix_weight(text.size()) == 13);
+    REQUIRE(*text.lower_bound_by_weight(8) == "world");
+
+    for (int n = 0; n < 2000; ++n)
+    {
+        const size_t index = size_t(rand()) % (text.size()+1);
+        const std::string piece(size_t(rand() % 20), 'x');
+        text.insert_at(index, piece);
+    }
+    size_t total = 0;
+    for (size_t n = 0; n < text.size(); ++n)
+    {
+        REQUIRE(text.prefix_weight(n) == total);
+        total += text[n].size();
+    }
+    REQUIRE(text.aggregate(text.begin(), text.end()) == total);
+    REQUIRE(text.aggregate(text.iterator_at(10), text.iterator_at(20))
+            == text.prefix_weight(20) - text.prefix_weight(10));
+}
@@ -0,0 +1,263 @@
+//============================================================================
+// test_sharded_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "sharded_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <set>
+#include <vector>
+#include <thread>
+#include <atomic>
+
+using goodliffe::sharded_skip_list;
+
+namespace
+{
+    /// No shard holds more than twice its share (plus a little slack)
+    template <typename CONTAINER>
+    bool IsBalanced(const CONTAINER &container)
+    {
+        const unsigned shards = CONTAINER::num_shards;
+        const size_t   limit  = 2 * container.size() / shards + 64;
+        for (unsigned n = 0; n < shards; ++n)
+        {
+            if (container.shard_size(n) > limit) return false;
+        }
+        return true;
+    }
+}
+
+TEST_CASE( "sharded_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "sharded_skip_list/can call basic methods", "" )
+{
+    const sharded_skip_list<int> list;
+    REQUIRE(list.empty());
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.count(0) == 0);
+    REQUIRE(!list.contains(20));
+    REQUIRE(list.begin() == list.end());
+}
+
+TEST_CASE( "sharded_skip_list/comparison with set", "" )
+{
+    std::set<int> set;
+    sharded_skip_list<int,4> list;
+
+    for (unsigned n = 0; n < 20000; ++n)
+    {
+        int value = rand() % 5000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value) == set.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == set.erase(value));
+        }
+        if (n % 5000 == 0) list.rebalance();
+    }
+
+    REQUIRE(list.size() == set.size());
+    REQUIRE(std::equal(set.begin(), set.end(), list.begin()));
+    REQUIRE(IsStrictlyIncreasing(list));
+}
+
+TEST_CASE( "sharded_skip_list/rebalance spreads the elements", "" )
+{
+    sharded_skip_list<int,8> list;
+    for (int n = 0; n < 10000; ++n) list.insert(n);
+
+    list.rebalance();
+    REQUIRE(list.size() == 10000);
+    REQUIRE(IsBalanced(list));
+    for (unsigned n = 0; n < 8; ++n)
+    {
+        REQUIRE(list.shard_size(n) > 0);
+    }
+    for (int n = 0; n < 10000; ++n)
+    {
+        REQUIRE(list.contains(n));
+    }
+}
+
+TEST_CASE( "sharded_skip_list/rebalance moves elements both ways", "" )
+{
+    sharded_skip_list<int,8> list;
+    for (int n = 0; n < 8000; ++n) list.insert(n);
+    list.rebalance();
+    REQUIRE(IsBalanced(list));
+
+    // Crowd the first shards, so their elements must move forwards
+    for (int n = -16000; n < 0; ++n) list.insert(n);
+    list.rebalance();
+    REQUIRE(IsBalanced(list));
+    REQUIRE(list.size() == 24000);
+
+    // Then empty them, so elements must come back from later shards
+    for (int n = -16000; n < 4000; ++n) list.erase(n);
+    list.rebalance();
+    REQUIRE(IsBalanced(list));
+    REQUIRE(list.size() == 4000);
+    REQUIRE(IsStrictlyIncreasing(list));
+    for (int n = 4000; n < 8000; ++n)
+    {
+        REQUIRE(list.contains(n));
+    }
+
+    // Too few elements to sample fill only some of the shards
+    for (int n = 4000; n < 7990; ++n) list.erase(n);
+    list.rebalance();
+    REQUIRE(list.size() == 10);
+    REQUIRE(IsStrictlyIncreasing(list));
+    REQUIRE(list.contains(7990));
+    REQUIRE(list.contains(7999));
+    list.insert(100000);
+    list.insert(-100000);
+    REQUIRE(list.size() == 12);
+    REQUIRE(IsStrictlyIncreasing(list));
+}
+
+TEST_CASE( "sharded_skip_list/rebalances itself as the data moves", "" )
+{
+    // Ascending inserts all land in the last shard, until it is rebalanced
+    sharded_skip_list<int,8> list;
+    for (int n = 0; n < 50000; ++n) list.insert(n);
+    REQUIRE(IsBalanced(list));
+
+    // Now empty most of it, and fill a different range
+    for (int n = 0; n < 45000; ++n) list.erase(n);
+    for (int n = 100000; n < 150000; ++n) list.insert(n);
+    REQUIRE(IsBalanced(list));
+    REQUIRE(list.size() == 55000);
+    REQUIRE(IsStrictlyIncreasing(list));
+}
+
+TEST_CASE( "sharded_skip_list/clear", "" )
+{
+    sharded_skip_list<int> list;
+    for (int n = 0; n < 5000; ++n) list.insert(n);
+    list.clear();
+    REQUIRE(list.empty());
+    REQUIRE(list.begin() == list.end());
+    list.insert(3);
+    REQUIRE(list.contains(3));
+}
+
+namespace
+{
+    /// Counts the allocations outstanding for each type it is rebound to
+    template <typename T>
+    struct CountingAllocator : std::allocator<T>
+    {
+        template <typename OTHER>
+        struct rebind { typedef CountingAllocator<OTHER> other; };
+
+        CountingAllocator() {}
+        template <typename OTHER>
+        CountingAllocator(const CountingAllocator<OTHER> &) {}
+
+        T *allocate(std::size_t n, const void * = 0)
+            { ++live; return std::allocator<T>::allocate(n); }
+        void deallocate(T *p, std::size_t n)
+            { --live; std::allocator<T>::deallocate(p, n); }
+
+        static long live;
+    };
+
+    template <typename T>
+    long CountingAllocator<T>::live = 0;
+}
+
+TEST_CASE( "sharded_skip_list/allocates through its allocator", "" )
+{
+    typedef CountingAllocator<int>                                                  Alloc;
+    typedef goodliffe::detail::sharded_list_shard<int,std::less<int>,Alloc>         Shard;
+    typedef goodliffe::detail::sharded_list_bounds<int,Alloc>                       Bounds;
+    {
+        sharded_skip_list<int,4,std::less<int>,Alloc> list;
+        REQUIRE(CountingAllocator<Shard>::live == 4);
+        REQUIRE(CountingAllocator<Bounds>::live == 1);
+
+        for (int n = 0; n < 5000; ++n) list.insert(n);
+        list.rebalance();
+        REQUIRE(list.size() == 5000);
+        REQUIRE(CountingAllocator<Bounds>::live >= 1); // old ones may await reclamation
+    }
+    REQUIRE(CountingAllocator<Shard>::live == 0);
+    REQUIRE(CountingAllocator<Bounds>::live == 0);
+}
+
+//============================================================================
+// multi threaded
+
+TEST_CASE( "sharded_skip_list/threads/insert disjoint values", "" )
+{
+    sharded_skip_list<int> list;
+    const int per_thread = 5000;
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&list, t]
+        {
+            for (int n = 0; n < per_thread; ++n) list.insert(n*int(num_threads) + int(t));
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(list.size() == per_thread*num_threads);
+    REQUIRE(IsStrictlyIncreasing(list));
+    REQUIRE(IsBalanced(list));
+    for (int n = 0; n < int(per_thread*num_threads); ++n)
+    {
+        REQUIRE(list.contains(n));
+    }
+}
+
+TEST_CASE( "sharded_skip_list/threads/mixed operations with rebalancing", "" )
+{
+    // Each thread owns the values congruent to it; multiples of three are
+    // never erased, so must always be found, whatever rebalancing goes on.
+    sharded_skip_list<int> list;
+    std::atomic<bool> ok(true);
+    {
+        std::vector<std::thread> threads;
+        for (unsigned t = 0; t < num_threads; ++t)
+        {
+            threads.push_back(std::thread([&list, &ok, t]
+            {
+                for (int round = 0; round < 5; ++round)
+                {
+                    const int base = round * 4000;
+                    for (int n = base + int(t); n < base + 4000; n += int(num_threads)) list.insert(n);
+                    for (int n = base + int(t); n < base + 4000; n += int(num_threads))
+                        if (n % 3) list.erase(n);
+                    for (int n = int(t); n < base + 4000; n += int(num_threads))
+                        if (n % 3 == 0 && !list.contains(n)) ok = false;
+                    if (t == 0) list.rebalance();
+                }
+            }));
+        }
+        for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+    }
+
+    REQUIRE(ok.load());
+    int expected = 0;
+    for (int n = 0; n < 20000; ++n)
+    {
+        const bool present = n % 3 == 0;
+        REQUIRE(list.contains(n) == present);
+        expected += present;
+    }
+    REQUIRE(list.size() == unsigned(expected));
+    REQUIRE(IsStrictlyIncreasing(list));
+}
@@ -15,6 +15,13 @@
 #include "catch.hpp"
 #include "test_types.h"
 
+#include <set>
+#include <vector>
+
+#ifdef SKIP_LIST_CPP11
+#include <thread>
+#endif
+
 using goodliffe::skip_list;
 using goodliffe::detail::sl_impl;
 
@@ -1108,6 +1115,688 @@ TEST_CASE( "skip_list/clear/several item list", "" )
     REQUIRE(list.begin() == list.end());
 }
 
+//============================================================================
+// assign_sorted
+
+TEST_CASE( "skip_list/assign_sorted/empty range", "" )
+{
+    skip_list<int> list;
+    list.insert(1);
+    list.assign_sorted(assign_source_data, assign_source_data);
+    REQUIRE(list.empty());
+}
+
+TEST_CASE( "skip_list/assign_sorted/builds same list as assign", "" )
+{
+    std::vector<int> data;
+    FillWithRandomData(1000, data);
+    SortVectorAndRemoveDuplicates(data);
+
+    skip_list<int> list;
+    list.insert(-1);
+    list.assign_sorted(data.begin(), data.end());
+
+    REQUIRE(list.size() == data.size());
+    REQUIRE(CheckEquality(list, data));
+
+    // the list must still work normally after a bulk build
+    list.insert(-5);
+    REQUIRE(list.front() == -5);
+    REQUIRE(list.erase(data[500]) == 1);
+    REQUIRE(list.size() == data.size());
+}
+
+TEST_CASE( "skip_list/assign_sorted/skips repeated values", "" )
+{
+    const int data[] = { 1, 2, 2, 2, 3, 5, 5 };
+    skip_list<int> list;
+    list.assign_sorted(data, data+7);
+    REQUIRE(list.size() == 4);
+    REQUIRE(list.count(2) == 1);
+    REQUIRE(list.back() == 5);
+}
+
+//============================================================================
+// merge
+
+TEST_CASE( "skip_list/merge/into empty list", "" )
+{
+    skip_list<int> l1, l2;
+    l2.assign(assign_source_data, assign_source_data_end);
+
+    l1.merge(l2);
+    REQUIRE(l1.size() == 4);
+    REQUIRE(l2.empty());
+    REQUIRE(l2.begin() == l2.end());
+    REQUIRE(l1.front() == 12);
+    REQUIRE(l1.back() == 67);
+}
+
+TEST_CASE( "skip_list/merge/from empty list", "" )
+{
+    skip_list<int> l1, l2;
+    l1.assign(assign_source_data, assign_source_data_end);
+
+    l1.merge(l2);
+    REQUIRE(l1.size() == 4);
+    REQUIRE(l2.empty());
+}
+
+TEST_CASE( "skip_list/merge/with itself does nothing", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end);
+    list.merge(list);
+    REQUIRE(list.size() == 4);
+}
+
+TEST_CASE( "skip_list/merge/leaves equivalent items in other list", "" )
+{
+    skip_list<int> l1, l2;
+    l1.insert(1); l1.insert(3); l1.insert(5);
+    l2.insert(2); l2.insert(3); l2.insert(6);
+
+    l1.merge(l2);
+    REQUIRE(l1.size() == 5);
+    REQUIRE(l2.size() == 1);
+    REQUIRE(l2.front() == 3);
+
+    skip_list<int>::iterator i = l1.begin();
+    REQUIRE(*i++ == 1); REQUIRE(*i++ == 2); REQUIRE(*i++ == 3);
+    REQUIRE(*i++ == 5); REQUIRE(*i++ == 6); REQUIRE(i == l1.end());
+}
+
+TEST_CASE( "skip_list/merge/does not copy or reallocate items", "" )
+{
+    Counter::count = 0;
+    {
+        skip_list<Counter> l1, l2;
+        for (int n = 0; n < 10; ++n) l1.insert(n*2);
+        for (int n = 0; n < 10; ++n) l2.insert(n*2+1);
+        skip_list<Counter>::iterator moved = l2.find(7);
+        REQUIRE(Counter::count == 20);
+
+        l1.merge(l2);
+        REQUIRE(Counter::count == 20);
+        REQUIRE(l1.size() == 20);
+        REQUIRE(l2.empty());
+        REQUIRE(*moved == 7);
+        REQUIRE(*++moved == 8);
+        REQUIRE(moved == l1.find(8));
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "skip_list/merge/comparison with set", "" )
+{
+    std::set<int> s1, s2;
+    skip_list<int> l1, l2;
+    for (unsigned n = 0; n < 500; ++n)
+    {
+        int v1 = rand() % 2000, v2 = rand() % 2000;
+        s1.insert(v1); l1.insert(v1);
+        s2.insert(v2); l2.insert(v2);
+    }
+
+    std::set<int> leftover;
+    std::set_intersection(s1.begin(), s1.end(), s2.begin(), s2.end(),
+                          std::inserter(leftover, leftover.end()));
+    s1.insert(s2.begin(), s2.end());
+
+    l1.merge(l2);
+    REQUIRE(CheckEquality(s1, l1));
+    REQUIRE(CheckEquality(leftover, l2));
+
+    // both lists' towers are still searchable
+    for (std::set<int>::iterator i = s1.begin(); i != s1.end(); ++i)
+    {
+        REQUIRE(l1.contains(*i));
+    }
+    for (std::set<int>::iterator i = leftover.begin(); i != leftover.end(); ++i)
+    {
+        REQUIRE(l2.contains(*i));
+    }
+}
+
+//============================================================================
+// node handles
+
+#ifdef SKIP_LIST_CPP11
+
+TEST_CASE( "skip_list/extract/iterator", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end);
+
+    skip_list<int>::node_handle handle = list.extract(list.find(34));
+    REQUIRE_FALSE(handle.empty());
+    REQUIRE(bool(handle));
+    REQUIRE(handle.value() == 34);
+    REQUIRE(list.size() == 3);
+    REQUIRE_FALSE(list.contains(34));
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "skip_list/extract/value", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end);
+
+    REQUIRE(list.extract(1000).empty());
+    REQUIRE(list.size() == 4);
+
+    skip_list<int>::node_handle handle = list.extract(67);
+    REQUIRE(handle.value() == 67);
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.back() == 45);
+}
+
+TEST_CASE( "skip_list/extract/unused handle destroys element", "" )
+{
+    Counter::count = 0;
+    {
+        skip_list<Counter> list;
+        for (int n = 0; n < 5; ++n) list.insert(n);
+        {
+            skip_list<Counter>::node_handle handle = list.extract(2);
+            REQUIRE(Counter::count == 5);
+        }
+        REQUIRE(Counter::count == 4);
+        REQUIRE(list.size() == 4);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "skip_list/insert node handle/empty handle", "" )
+{
+    skip_list<int> list;
+    skip_list<int>::insert_return_type result = list.insert(skip_list<int>::node_handle());
+    REQUIRE_FALSE(result.inserted);
+    REQUIRE(result.position == list.end());
+    REQUIRE(result.node.empty());
+}
+
+TEST_CASE( "skip_list/insert node handle/changing the key", "" )
+{
+    Counter::count = 0;
+    {
+        skip_list<Counter> list;
+        for (int n = 0; n < 10; ++n) list.insert(n);
+
+        skip_list<Counter>::node_handle handle = list.extract(3);
+        const Counter *address = &handle.value();
+        handle.value().value = 30;
+
+        skip_list<Counter>::insert_return_type result = list.insert(std::move(handle));
+        REQUIRE(result.inserted);
+        REQUIRE(handle.empty());
+        REQUIRE(result.node.empty());
+        REQUIRE(&*result.position == address);
+        REQUIRE(list.back() == 30);
+        REQUIRE(list.size() == 10);
+        REQUIRE(Counter::count == 10); // no copies were made
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "skip_list/insert node handle/equivalent value already present", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end);
+
+    skip_list<int>::node_handle handle = list.extract(12);
+    handle.value() = 45;
+    skip_list<int>::insert_return_type result = list.insert(std::move(handle));
+    REQUIRE_FALSE(result.inserted);
+    REQUIRE(result.position == list.find(45));
+    REQUIRE(result.node.value() == 45);
+    REQUIRE(list.size() == 3);
+}
+
+TEST_CASE( "skip_list/insert node handle/between lists", "" )
+{
+    skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) l1.insert(n);
+
+    for (int n = 0; n < 100; n += 2)
+    {
+        l2.insert(l1.extract(n));
+    }
+    REQUIRE(l1.size() == 50);
+    REQUIRE(l2.size() == 50);
+    for (int n = 0; n < 100; ++n)
+    {
+        REQUIRE(l1.contains(n) == (n % 2 == 1));
+        REQUIRE(l2.contains(n) == (n % 2 == 0));
+    }
+    REQUIRE(CheckBackwardIteration(l1));
+    REQUIRE(CheckBackwardIteration(l2));
+}
+
+TEST_CASE( "skip_list/insert node handle/with hint", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end);
+
+    skip_list<int>::node_handle handle = list.extract(list.begin());
+    handle.value() = 100;
+    skip_list<int>::iterator i = list.insert(list.find(67), std::move(handle));
+    REQUIRE(*i == 100);
+    REQUIRE(list.size() == 4);
+    REQUIRE(list.back() == 100);
+}
+
+#endif
+
+//============================================================================
+// modify
+
+namespace
+{
+    struct SetTo
+    {
+        SetTo(int v) : value(v) {}
+        void operator()(int &i) const       { i = value; }
+        void operator()(Counter &c) const   { c.value = value; }
+        int value;
+    };
+
+    struct ThrowAfterChanging
+    {
+        void operator()(int &i) const { i = -1; throw 42; }
+    };
+}
+
+TEST_CASE( "skip_list/modify/value stays in place", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end); // 12, 34, 45, 67
+
+    skip_list<int>::iterator i = list.find(34);
+    REQUIRE(list.modify(i, SetTo(40)));
+    REQUIRE(*i == 40);
+    REQUIRE(list.size() == 4);
+    REQUIRE(list.contains(40));
+    REQUIRE_FALSE(list.contains(34));
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "skip_list/modify/value moves forwards and backwards", "" )
+{
+    skip_list<int> list;
+    for (int n = 0; n < 100; ++n) list.insert(n*10);
+
+    skip_list<int>::iterator i = list.find(200);
+    REQUIRE(list.modify(i, SetTo(755)));
+    REQUIRE(*i == 755);
+    REQUIRE(*--skip_list<int>::iterator(i) == 750);
+    REQUIRE(*++skip_list<int>::iterator(i) == 760);
+
+    REQUIRE(list.modify(i, SetTo(5)));
+    REQUIRE(list.front() == 0);
+    REQUIRE(*++list.begin() == 5);
+
+    REQUIRE(list.modify(list.begin(), SetTo(10000)));
+    REQUIRE(list.back() == 10000);
+    REQUIRE(list.front() == 5);
+
+    REQUIRE(list.size() == 100);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "skip_list/modify/equivalent value erases element", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end); // 12, 34, 45, 67
+
+    REQUIRE_FALSE(list.modify(list.find(12), SetTo(34)));
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.front() == 34);
+
+    REQUIRE_FALSE(list.modify(list.find(34), SetTo(67)));
+    REQUIRE(list.size() == 2);
+    REQUIRE(list.front() == 45);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "skip_list/modify/throwing modifier erases element", "" )
+{
+    skip_list<int> list;
+    list.assign(assign_source_data, assign_source_data_end); // 12, 34, 45, 67
+
+    REQUIRE_THROWS(list.modify(list.find(34), ThrowAfterChanging()));
+    REQUIRE(list.size() == 3);
+    REQUIRE(list.front() == 12);
+    REQUIRE(*++list.begin() == 45);
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+TEST_CASE( "skip_list/modify/does not copy or reallocate items", "" )
+{
+    Counter::count = 0;
+    {
+        skip_list<Counter> list;
+        for (int n = 0; n < 50; ++n) list.insert(n);
+
+        skip_list<Counter>::iterator i = list.find(10);
+        const Counter *address = &*i;
+        REQUIRE(list.modify(i, SetTo(1000)));
+        REQUIRE(&list.back() == address);
+        REQUIRE(list.modify(i, SetTo(-1)));
+        REQUIRE(&list.front() == address);
+        REQUIRE(Counter::count == 50);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "skip_list/modify/comparison with set", "" )
+{
+    std::set<int> set;
+    skip_list<int> list;
+    for (int n = 0; n < 500; ++n)
+    {
+        int value = rand() % 2000;
+        set.insert(value); list.insert(value);
+    }
+
+    for (unsigned n = 0; n < 1000; ++n)
+    {
+        int from = rand() % 2000;
+        // mostly small moves, with the occasional long one
+        int to   = n % 10 ? from + rand() % 21 - 10 : rand() % 2000;
+
+        skip_list<int>::iterator i = list.find(from);
+        if (i == list.end()) continue;
+
+        const bool kept     = list.modify(i, SetTo(to));
+        const bool expected = from == to || set.count(to) == 0;
+        REQUIRE(kept == expected);
+        set.erase(from);
+        set.insert(to);
+    }
+
+    REQUIRE(CheckEquality(set, list));
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+//============================================================================
+// split and join
+
+TEST_CASE( "skip_list/split/moves the tail of the list", "" )
+{
+    skip_list<int> l1, l2;
+    for (int n = 0; n < 1000; ++n) l1.insert(n);
+
+    l1.split(600, l2);
+    REQUIRE(l1.size() == 600);
+    REQUIRE(l2.size() == 400);
+    REQUIRE(l1.back() == 599);
+    REQUIRE(l2.front() == 600);
+    REQUIRE(CheckBackwardIteration(l1));
+    REQUIRE(CheckBackwardIteration(l2));
+    for (int n = 0; n < 1000; ++n)
+    {
+        REQUIRE(l1.contains(n) == (n < 600));
+        REQUIRE(l2.contains(n) == (n >= 600));
+    }
+
+    // both lists still work normally afterwards
+    l1.insert(2000);
+    l2.insert(-1);
+    REQUIRE(l1.back() == 2000);
+    REQUIRE(l2.front() == -1);
+    REQUIRE(CheckBackwardIteration(l1));
+    REQUIRE(CheckBackwardIteration(l2));
+}
+
+TEST_CASE( "skip_list/split/at either end", "" )
+{
+    skip_list<int> l1, l2, l3;
+    for (int n = 0; n < 100; ++n) l1.insert(n);
+
+    l1.split(1000, l2);
+    REQUIRE(l1.size() == 100);
+    REQUIRE(l2.empty());
+
+    l1.split(-5, l3);
+    REQUIRE(l1.empty());
+    REQUIRE(l3.size() == 100);
+    REQUIRE(CheckBackwardIteration(l3));
+}
+
+TEST_CASE( "skip_list/split/does not copy items", "" )
+{
+    skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) l1.insert(n);
+    const int *fifty = &*l1.find(50);
+
+    l1.split(50, l2);
+    REQUIRE(&*l2.find(50) == fifty);
+}
+
+TEST_CASE( "skip_list/join/appends the other list", "" )
+{
+    skip_list<int> l1, l2;
+    for (int n = 0; n < 300; ++n)    l1.insert(n);
+    for (int n = 300; n < 1000; ++n) l2.insert(n);
+
+    l1.join(l2);
+    REQUIRE(l1.size() == 1000);
+    REQUIRE(l2.empty());
+    REQUIRE(l2.begin() == l2.end());
+    REQUIRE(CheckBackwardIteration(l1));
+    for (int n = 0; n < 1000; ++n)
+    {
+        REQUIRE(l1.contains(n));
+    }
+
+    l2.insert(5);
+    REQUIRE(l2.size() == 1);
+    REQUIRE(l1.erase(999) == 1);
+    REQUIRE(l1.back() == 998);
+}
+
+TEST_CASE( "skip_list/join/empty lists", "" )
+{
+    skip_list<int> l1, l2;
+    l1.join(l2);
+    REQUIRE(l1.empty());
+
+    l2.insert(1);
+    l1.join(l2);
+    REQUIRE(l1.size() == 1);
+    REQUIRE(l2.empty());
+    REQUIRE(CheckBackwardIteration(l1));
+}
+
+TEST_CASE( "skip_list/split and join/round trip", "" )
+{
+    std::vector<int> values;
+    skip_list<int> list;
+    for (unsigned n = 0; n < 2000; ++n)
+    {
+        int value = rand() % 5000;
+        list.insert(value);
+        values.push_back(value);
+    }
+    SortVectorAndRemoveDuplicates(values);
+
+    for (unsigned round = 0; round < 20; ++round)
+    {
+        skip_list<int> back;
+        list.split(rand() % 5000, back);
+        list.join(back);
+        REQUIRE(back.empty());
+    }
+    REQUIRE(CheckEquality(values, list));
+    REQUIRE(CheckBackwardIteration(list));
+}
+
+//============================================================================
+// set algebra
+
+TEST_CASE( "skip_list/set algebra/empty lists", "" )
+{
+    skip_list<int> l1, l2;
+    REQUIRE(set_union(l1, l2).empty());
+    REQUIRE(set_intersection(l1, l2).empty());
+    REQUIRE(set_difference(l1, l2).empty());
+}
+
+TEST_CASE( "skip_list/set algebra/comparison with std algorithms", "" )
+{
+    std::vector<int> d1, d2;
+    for (unsigned n = 0; n < 400; ++n)
+    {
+        d1.push_back(rand() % 1000);
+        d2.push_back(rand() % 1000);
+    }
+    skip_list<int> l1(d1.begin(), d1.end()), l2(d2.begin(), d2.end());
+    SortVectorAndRemoveDuplicates(d1);
+    SortVectorAndRemoveDuplicates(d2);
+
+    std::vector<int> expected;
+    std::set_union(d1.begin(), d1.end(), d2.begin(), d2.end(), std::back_inserter(expected));
+    REQUIRE(CheckEquality(expected, set_union(l1, l2)));
+
+    expected.clear();
+    std::set_intersection(d1.begin(), d1.end(), d2.begin(), d2.end(), std::back_inserter(expected));
+    REQUIRE(CheckEquality(expected, set_intersection(l1, l2)));
+
+    expected.clear();
+    std::set_difference(d1.begin(), d1.end(), d2.begin(), d2.end(), std::back_inserter(expected));
+    REQUIRE(CheckEquality(expected, set_difference(l1, l2)));
+
+    // the sources are untouched
+    REQUIRE(CheckEquality(d1, l1));
+    REQUIRE(CheckEquality(d2, l2));
+}
+
+TEST_CASE( "skip_list/set algebra/result is searchable", "" )
+{
+    skip_list<int> l1, l2;
+    for (int n = 0; n < 100; ++n) l1.insert(n);
+    for (int n = 50; n < 150; ++n) l2.insert(n);
+
+    skip_list<int> result = set_intersection(l1, l2);
+    REQUIRE(result.size() == 50);
+    for (int n = 0; n < 150; ++n)
+    {
+        REQUIRE(result.contains(n) == (n >= 50 && n < 100));
+    }
+}
+
+//============================================================================
+// express index
+
+namespace
+{
+    /// Every search of list gives the same answer as one of expected
+    bool SearchesMatch(const skip_list<int> &list, const std::set<int> &expected, int limit)
+    {
+        for (int value = -1; value <= limit; ++value)
+        {
+            skip_list<int>::const_iterator i = list.find(value);
+            if ((i != list.end()) != (expected.count(value) != 0)) return false;
+            if (i != list.end() && *i != value) return false;
+        }
+        return list.size() == expected.size();
+    }
+}
+
+TEST_CASE( "skip_list/express index/searches match std::set", "" )
+{
+    skip_list<int> list;
+    std::set<int>  expected;
+    list.set_express_levels(4);
+    REQUIRE(list.express_levels() == 4);
+    REQUIRE(list.find(1) == list.end());
+
+    for (int n = 0; n < 20000; ++n)
+    {
+        const int value = rand() % 5000;
+        if (rand() % 3)
+        {
+            REQUIRE(list.insert(value).second == expected.insert(value).second);
+        }
+        else
+        {
+            REQUIRE(list.erase(value) == expected.erase(value));
+        }
+        if (n % 500 == 0) REQUIRE(list.count(value) == expected.count(value));
+    }
+    REQUIRE(SearchesMatch(list, expected, 5000));
+
+    // changing values in place, and erasing ranges from the front and middle
+    for (int n = 0; n < 200; ++n)
+    {
+        skip_list<int>::iterator i = list.find(rand() % 5000);
+        if (i == list.end()) continue;
+        const int value = rand() % 5000;
+        expected.erase(*i);
+        if (list.modify(i, SetTo(value))) expected.insert(value);
+    }
+    REQUIRE(SearchesMatch(list, expected, 5000));
+
+    list.erase(list.begin(), list.find(*expected.lower_bound(500)));
+    expected.erase(expected.begin(), expected.lower_bound(500));
+    list.erase(list.find(*expected.lower_bound(1000)), list.find(*expected.lower_bound(2000)));
+    expected.erase(expected.lower_bound(1000), expected.lower_bound(2000));
+    REQUIRE(SearchesMatch(list, expected, 5000));
+
+    // and moving elements between lists
+    skip_list<int> other;
+    list.split(3000, other);
+    REQUIRE(list.find(3500) == list.end());
+    list.join(other);
+    skip_list<int> odds;
+    for (int n = 5001; n < 6000; n += 2) { odds.insert(n); expected.insert(n); }
+    list.merge(odds);
+    REQUIRE(SearchesMatch(list, expected, 6000));
+
+    list.swap(other);
+    REQUIRE(list.empty());
+    REQUIRE(list.find(3500) == list.end());
+    REQUIRE(SearchesMatch(other, expected, 6000));
+
+    list.set_express_levels(0);
+    other.set_express_levels(32);
+    REQUIRE(SearchesMatch(other, expected, 6000));
+    other.clear();
+    REQUIRE(other.find(3500) == other.end());
+}
+
+#ifdef SKIP_LIST_CPP11
+
+TEST_CASE( "skip_list/express index/threads may search at once", "" )
+{
+    skip_list<int> built;
+    std::set<int>  expected;
+    for (int n = 0; n < 20000; n += 2) { built.insert(n); expected.insert(n); }
+    for (int n = 0; n < 20000; n += 6) { built.erase(n);  expected.erase(n); }
+
+    // The swap throws away the old index, and builds the new one; the
+    // searches only read it
+    skip_list<int> list;
+    list.set_express_levels(4);
+    list.swap(built);
+    const skip_list<int> &searched = list;
+    bool matched[4] = { false, false, false, false };
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < 4; ++t)
+    {
+        threads.push_back(std::thread([&searched, &expected, &matched, t]
+            { matched[t] = SearchesMatch(searched, expected, 20000); }));
+    }
+    for (unsigned t = 0; t < 4; ++t) threads[t].join();
+    for (unsigned t = 0; t < 4; ++t)
+    {
+        REQUIRE(matched[t]);
+    }
+}
+
+#endif
+
 //============================================================================
 // list comparison
 
@@ -0,0 +1,363 @@
+//============================================================================
+// test_skip_list_parallel.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_list.h"
+#include "random_access_skip_list.h"
+#include "skip_list_parallel.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <vector>
+#include <stdexcept>
+#include <ostream>
+#include <sstream>
+#include <atomic>
+
+using goodliffe::skip_list;
+using goodliffe::multi_skip_list;
+using goodliffe::random_access_skip_list;
+using goodliffe::parallel_assign_sorted;
+using goodliffe::parallel_for_each;
+
+namespace
+{
+    // Building on several threads needs thread safe level generators
+    using goodliffe::detail::concurrent_level_generator;
+    typedef skip_list<int, std::less<int>, std::allocator<int>,
+                      concurrent_level_generator<32> >               parallel_list;
+    typedef multi_skip_list<int, std::less<int>, std::allocator<int>,
+                            concurrent_level_generator<32> >         parallel_multi_list;
+    typedef random_access_skip_list<int, std::less<int>, std::allocator<int>,
+                                    concurrent_level_generator<32> > parallel_rasl;
+
+    /// Orders ints either way, as chosen when it is made
+    struct Ordering
+    {
+        explicit Ordering(bool descending_ = false) : descending(descending_) {}
+        bool operator()(int lhs, int rhs) const { return descending ? rhs < lhs : lhs < rhs; }
+        bool descending;
+    };
+
+    /// Sorted, with runs of duplicates (some across where the chunks fall)
+    std::vector<int> SortedWithDuplicates(unsigned size)
+    {
+        std::vector<int> data;
+        for (unsigned n = 0; data.size() < size; ++n)
+        {
+            data.push_back(int(n));
+            if (n % 7 == 0) data.push_back(int(n));
+            if (n % 1000 == 0) data.insert(data.end(), 5000, int(n));
+        }
+        data.resize(size);
+        return data;
+    }
+
+    template <typename CONTAINER>
+    bool LinksAreConsistent(const CONTAINER &container)
+    {
+        std::vector<int> forward(container.begin(), container.end());
+        std::vector<int> backward(container.rbegin(), container.rend());
+        return forward.size() == container.size()
+            && std::equal(forward.rbegin(), forward.rend(), backward.begin());
+    }
+
+    /// Throws on the nth copy (made on any thread)
+    struct ThrowingValue
+    {
+        static std::atomic<int> copies_left;
+
+        ThrowingValue(int value_) : value(value_) {}
+        ThrowingValue(const ThrowingValue &other) : value(other.value)
+        {
+            if (copies_left-- == 0) throw std::runtime_error("copy");
+        }
+        bool operator<(const ThrowingValue &other) const { return value < other.value; }
+
+        int value;
+    };
+    std::atomic<int> ThrowingValue::copies_left(-1);
+
+    /// The ranges run, in order and without gaps, from begin() to end()
+    template <typename CONTAINER>
+    bool RangesCoverList(const CONTAINER &container,
+                         const std::vector<typename CONTAINER::const_range> &ranges)
+    {
+        typename CONTAINER::const_iterator i = container.begin();
+        for (size_t n = 0; n < ranges.size(); ++n)
+        {
+            if (ranges[n].first != i) return false;
+            i = ranges[n].second;
+        }
+        return i == container.end();
+    }
+
+    template <typename RANGE>
+    size_t RangeSize(const RANGE &range)
+    {
+        return size_t(std::distance(range.first, range.second));
+    }
+
+    std::ostream &operator<<(std::ostream &s, const ThrowingValue &value)
+        { return s << value.value; }
+}
+
+TEST_CASE( "parallel_assign_sorted/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "parallel_assign_sorted/skip_list", "" )
+{
+    const std::vector<int> data = SortedWithDuplicates(100000);
+
+    parallel_list expected;
+    expected.assign_sorted(data.begin(), data.end());
+
+    parallel_list list;
+    list.insert(-1);
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+
+    REQUIRE(list.size() == expected.size());
+    REQUIRE(list == expected);
+    REQUIRE(LinksAreConsistent(list));
+    for (int n = 0; n <= data.back(); n += 13)
+    {
+        REQUIRE(list.contains(n));
+    }
+    REQUIRE_FALSE(list.contains(-1));
+
+    // and still works as normal afterwards
+    list.erase(500);
+    list.insert(-5);
+    REQUIRE(list.front() == -5);
+    REQUIRE(list.size() == expected.size());
+}
+
+TEST_CASE( "parallel_assign_sorted/multi_skip_list", "" )
+{
+    const std::vector<int> data = SortedWithDuplicates(100000);
+
+    parallel_multi_list list;
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+
+    REQUIRE(list.size() == data.size());
+    REQUIRE(std::equal(data.begin(), data.end(), list.begin()));
+    REQUIRE(LinksAreConsistent(list));
+    REQUIRE(list.count(1000) == 5001);
+}
+
+TEST_CASE( "parallel_assign_sorted/random_access_skip_list", "" )
+{
+    std::vector<int> data = SortedWithDuplicates(100000);
+
+    parallel_rasl list;
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+
+    data.erase(std::unique(data.begin(), data.end()), data.end());
+    REQUIRE(list.size() == data.size());
+    REQUIRE(CheckEquality(list, data));
+    REQUIRE(CheckEqualityViaIndexing(list, data));
+    for (size_t n = 0; n < data.size(); n += 101)
+    {
+        REQUIRE(list.index_of(list.find(data[n])) == n);
+    }
+    REQUIRE((list.end() - list.begin()) == long(data.size()));
+}
+
+TEST_CASE( "parallel_assign_sorted/small and empty ranges", "" )
+{
+    const std::vector<int> data = SortedWithDuplicates(100);
+
+    parallel_list list;
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+    parallel_list expected(data.begin(), data.end());
+    REQUIRE(list == expected);
+
+    parallel_assign_sorted(list, data.begin(), data.begin(), 8);
+    REQUIRE(list.empty());
+
+    const std::vector<int> big = SortedWithDuplicates(50000);
+    parallel_assign_sorted(list, big.begin(), big.end(), 1);
+    expected.assign_sorted(big.begin(), big.end());
+    REQUIRE(list == expected);
+}
+
+TEST_CASE( "parallel_assign_sorted/one value throughout", "" )
+{
+    const std::vector<int> data(50000, 42);
+
+    parallel_list list;
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+    REQUIRE(list.size() == 1);
+    REQUIRE(list.front() == 42);
+
+    parallel_rasl rasl;
+    parallel_assign_sorted(rasl, data.begin(), data.end(), 8);
+    REQUIRE(rasl.size() == 1);
+    REQUIRE(rasl[0] == 42);
+}
+
+TEST_CASE( "parallel_assign_sorted/uses the list's comparator", "" )
+{
+    std::vector<int> data = SortedWithDuplicates(100000);
+    std::reverse(data.begin(), data.end());
+
+    typedef skip_list<int, Ordering, std::allocator<int>,
+                      concurrent_level_generator<32> > descending_list;
+    descending_list list((Ordering(true)));
+    parallel_assign_sorted(list, data.begin(), data.end(), 8);
+
+    data.erase(std::unique(data.begin(), data.end()), data.end());
+    REQUIRE(list.size() == data.size());
+    REQUIRE(std::equal(data.begin(), data.end(), list.begin()));
+    REQUIRE(LinksAreConsistent(list));
+    REQUIRE(list.value_comp().descending);
+
+    typedef random_access_skip_list<int, Ordering, std::allocator<int>,
+                                    concurrent_level_generator<32> > descending_rasl;
+    std::vector<int> all = SortedWithDuplicates(100000);
+    std::reverse(all.begin(), all.end());
+    descending_rasl rasl((Ordering(true)));
+    parallel_assign_sorted(rasl, all.begin(), all.end(), 8);
+    REQUIRE(CheckEqualityViaIndexing(rasl, data));
+}
+
+TEST_CASE( "parallel_assign_sorted/exception leaves the list empty", "" )
+{
+    std::vector<ThrowingValue> data;
+    for (int n = 0; n < 40000; ++n) data.push_back(ThrowingValue(n));
+
+    skip_list<ThrowingValue, std::less<ThrowingValue>, std::allocator<ThrowingValue>,
+              concurrent_level_generator<32> > list;
+    list.insert(ThrowingValue(-1));
+
+    ThrowingValue::copies_left = 30000;
+    REQUIRE_THROWS(parallel_assign_sorted(list, data.begin(), data.end(), 4));
+    ThrowingValue::copies_left = -1;
+    REQUIRE(list.empty());
+
+    // as dump() writes them, under SKIP_LIST_IMPL_DIAGNOSTICS
+    std::ostringstream s;
+    s << data.front();
+    REQUIRE(s.str() == "0");
+}
+
+//============================================================================
+// partition
+
+TEST_CASE( "skip_list/partition/covers the list in even ranges", "" )
+{
+    skip_list<int> list;
+    for (int n = 0; n < 100000; ++n) list.insert(n);
+
+    std::vector<skip_list<int>::const_range> ranges;
+    list.partition(8, std::back_inserter(ranges));
+
+    REQUIRE(ranges.size() == 8);
+    REQUIRE(RangesCoverList(list, ranges));
+    for (size_t n = 0; n < ranges.size(); ++n)
+    {
+        // Even to within what the towers allow
+        const size_t size = RangeSize(ranges[n]);
+        REQUIRE(size > 100000/8/3);
+        REQUIRE(size < 100000/8*3);
+    }
+}
+
+TEST_CASE( "skip_list/partition/small lists", "" )
+{
+    skip_list<int> list;
+    std::vector<skip_list<int>::const_range> ranges;
+    list.partition(4, std::back_inserter(ranges));
+    REQUIRE(ranges.size() == 4);
+    REQUIRE(RangesCoverList(list, ranges));
+
+    for (int n = 0; n < 3; ++n) list.insert(n);
+    ranges.clear();
+    list.partition(8, std::back_inserter(ranges));
+    REQUIRE(ranges.size() == 8);
+    REQUIRE(RangesCoverList(list, ranges));
+
+    ranges.clear();
+    list.partition(1, std::back_inserter(ranges));
+    REQUIRE(ranges.size() == 1);
+    REQUIRE(RangeSize(ranges[0]) == 3);
+
+    ranges.clear();
+    list.partition(0, std::back_inserter(ranges));
+    REQUIRE(ranges.empty());
+}
+
+TEST_CASE( "multi_skip_list/partition", "" )
+{
+    multi_skip_list<int> list;
+    for (int n = 0; n < 20000; ++n) list.insert(n % 100);
+
+    std::vector<multi_skip_list<int>::const_range> ranges;
+    list.partition(5, std::back_inserter(ranges));
+    REQUIRE(ranges.size() == 5);
+    REQUIRE(RangesCoverList(list, ranges));
+}
+
+TEST_CASE( "random_access_skip_list/partition is exact", "" )
+{
+    random_access_skip_list<int> list;
+    for (int n = 0; n < 1003; ++n) list.insert(n);
+
+    std::vector<random_access_skip_list<int>::const_range> ranges;
+    list.partition(7, std::back_inserter(ranges));
+    REQUIRE(ranges.size() == 7);
+    REQUIRE(RangesCoverList(list, ranges));
+    for (size_t n = 0; n < ranges.size(); ++n)
+    {
+        REQUIRE(*ranges[n].first == int(n*1003/7));
+        REQUIRE((ranges[n].second - ranges[n].first) == long((n+1)*1003/7 - n*1003/7));
+    }
+}
+
+//============================================================================
+// parallel_for_each
+
+TEST_CASE( "parallel_for_each/visits every element once", "" )
+{
+    skip_list<int> list;
+    for (int n = 0; n < 50000; ++n) list.insert(n);
+
+    std::vector<std::atomic<int> > visits(50000);
+    parallel_for_each(list, [&visits](int value) { ++visits[size_t(value)]; }, 8);
+
+    bool once = true;
+    for (size_t n = 0; n < visits.size(); ++n) once = once && visits[n].load() == 1;
+    REQUIRE(once);
+}
+
+TEST_CASE( "parallel_for_each/random_access_skip_list and small lists", "" )
+{
+    random_access_skip_list<int> list;
+    std::atomic<long> sum(0);
+    parallel_for_each(list, [&sum](int value) { sum += value; }, 4);
+    REQUIRE(sum.load() == 0);
+
+    for (int n = 1; n <= 3; ++n) list.insert(n);
+    parallel_for_each(list, [&sum](int value) { sum += value; }, 8);
+    REQUIRE(sum.load() == 6);
+
+    for (int n = 4; n <= 10000; ++n) list.insert(n);
+    sum = 0;
+    parallel_for_each(list, [&sum](int value) { sum += value; }, 8);
+    REQUIRE(sum.load() == 10000L*10001/2);
+}
+
+TEST_CASE( "parallel_for_each/rethrows", "" )
+{
+    skip_list<int> list;
+    for (int n = 0; n < 10000; ++n) list.insert(n);
+    REQUIRE_THROWS(parallel_for_each(list, [](int value)
+    {
+        if (value == 7777) throw std::runtime_error("7777");
+    }, 4));
+}
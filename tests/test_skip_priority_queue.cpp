@@ -0,0 +1,249 @@
+//============================================================================
+// test_skip_priority_queue.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "skip_priority_queue.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <queue>
+#include <set>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <thread>
+#include <atomic>
+
+using goodliffe::skip_priority_queue;
+using goodliffe::concurrent_priority_queue;
+
+TEST_CASE( "skip_priority_queue/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "skip_priority_queue/can call basic methods", "" )
+{
+    skip_priority_queue<int> queue;
+    REQUIRE(queue.empty());
+    REQUIRE(queue.size() == 0);
+    REQUIRE(queue.begin() == queue.end());
+
+    int value = 10;
+    REQUIRE_FALSE(queue.pop_min(value));
+    REQUIRE(value == 10);
+}
+
+TEST_CASE( "skip_priority_queue/pops in priority order", "" )
+{
+    skip_priority_queue<int> queue;
+    std::priority_queue<int, std::vector<int>, std::greater<int> > expected;
+
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        if (rand() % 3 || expected.empty())
+        {
+            const int value = rand() % 1000; // plenty of duplicates
+            queue.push(value);
+            expected.push(value);
+        }
+        else
+        {
+            REQUIRE(queue.top() == expected.top());
+            int value = -1;
+            REQUIRE(queue.pop_min(value));
+            REQUIRE(value == expected.top());
+            expected.pop();
+        }
+        REQUIRE(queue.size() == expected.size());
+    }
+
+    while (!expected.empty())
+    {
+        REQUIRE(queue.top() == expected.top());
+        queue.pop();
+        expected.pop();
+    }
+    REQUIRE(queue.empty());
+}
+
+TEST_CASE( "skip_priority_queue/iterates in priority order", "" )
+{
+    const int values[] = { 5, 1, 4, 1, 3 };
+    skip_priority_queue<int> queue(values, values+5);
+    const int sorted[] = { 1, 1, 3, 4, 5 };
+    REQUIRE(queue.size() == 5);
+    REQUIRE(std::equal(queue.begin(), queue.end(), sorted));
+}
+
+TEST_CASE( "skip_priority_queue/comparator orders the queue", "" )
+{
+    skip_priority_queue<int, std::greater<int> > queue;
+    for (int n = 0; n < 100; ++n) queue.push(n);
+    REQUIRE(queue.top() == 99);
+    queue.pop();
+    REQUIRE(queue.top() == 98);
+}
+
+TEST_CASE( "skip_priority_queue/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        skip_priority_queue<Counter> queue;
+        for (int n = 0; n < 100; ++n) queue.push(n);
+        for (int n = 0; n < 40; ++n) queue.pop();
+        REQUIRE(queue.size() == 60);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+//============================================================================
+// concurrent_priority_queue
+
+TEST_CASE( "concurrent_priority_queue/can call basic methods", "" )
+{
+    concurrent_priority_queue<int> queue;
+    REQUIRE(queue.empty());
+    REQUIRE(queue.size() == 0);
+
+    int value = 10;
+    REQUIRE_FALSE(queue.pop_min(value));
+    REQUIRE(value == 10);
+}
+
+TEST_CASE( "concurrent_priority_queue/one thread expected is exact", "" )
+{
+    concurrent_priority_queue<int> queue(1);
+    std::priority_queue<int, std::vector<int>, std::greater<int> > expected;
+
+    for (unsigned n = 0; n < 5000; ++n)
+    {
+        if (rand() % 3 || expected.empty())
+        {
+            const int value = rand() % 1000;
+            queue.push(value);
+            expected.push(value);
+        }
+        else
+        {
+            int value = -1;
+            REQUIRE(queue.pop_min(value));
+            REQUIRE(value == expected.top());
+            expected.pop();
+        }
+    }
+    REQUIRE(queue.size() == expected.size());
+}
+
+TEST_CASE( "concurrent_priority_queue/relaxed pops stay near the front", "" )
+{
+    concurrent_priority_queue<int> queue(num_threads);
+    std::multiset<int> remaining;
+    for (int n = 0; n < 10000; ++n)
+    {
+        const int value = rand() % 5000;
+        queue.push(value);
+        remaining.insert(value);
+    }
+
+    size_t worst_rank = 0;
+    for (unsigned n = 0; n < 2000; ++n)
+    {
+        int value = -1;
+        REQUIRE(queue.pop_min(value));
+        std::multiset<int>::iterator i = remaining.find(value);
+        REQUIRE(i != remaining.end());
+        const size_t rank = size_t(std::distance(remaining.begin(), remaining.lower_bound(value)));
+        worst_rank = std::max(worst_rank, rank);
+        remaining.erase(i);
+    }
+
+    // The spray reaches about 3 nodes along each of 4 levels
+    REQUIRE(worst_rank < 500);
+    REQUIRE(queue.size() == remaining.size());
+}
+
+TEST_CASE( "concurrent_priority_queue/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        concurrent_priority_queue<Counter> queue(4);
+        for (int n = 0; n < 100; ++n) queue.push(n);
+        Counter popped(0);
+        for (int n = 0; n < 40; ++n) queue.pop_min(popped);
+        REQUIRE(queue.size() == 60);
+    }
+    REQUIRE(Counter::count == 0);
+}
+
+TEST_CASE( "concurrent_priority_queue/threads/every element is popped once", "" )
+{
+    // Each thread pushes its own values, and pops as many as it pushes;
+    // between them they must pop every value exactly once.
+    concurrent_priority_queue<int> queue(num_threads);
+    const int per_thread = 5000;
+    std::vector<std::vector<int> > popped(num_threads);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&queue, &popped, t]
+        {
+            for (int n = 0; n < per_thread; ++n)
+            {
+                queue.push(n*int(num_threads) + int(t));
+                if (n % 2)
+                {
+                    int value;
+                    if (queue.pop_min(value)) popped[t].push_back(value);
+                }
+            }
+            int value;
+            while (queue.pop_min(value)) popped[t].push_back(value);
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    std::vector<int> all;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        all.insert(all.end(), popped[t].begin(), popped[t].end());
+    }
+    std::sort(all.begin(), all.end());
+
+    REQUIRE(queue.empty());
+    REQUIRE(all.size() == size_t(per_thread)*num_threads);
+    for (int n = 0; n < int(all.size()); ++n)
+    {
+        REQUIRE(all[size_t(n)] == n);
+    }
+}
+
+TEST_CASE( "concurrent_priority_queue/threads/duplicate values", "" )
+{
+    concurrent_priority_queue<int> queue(num_threads);
+    std::atomic<int> sum(0);
+    std::atomic<int> pops(0);
+
+    std::vector<std::thread> threads;
+    for (unsigned t = 0; t < num_threads; ++t)
+    {
+        threads.push_back(std::thread([&queue, &sum, &pops]
+        {
+            for (int n = 0; n < 2000; ++n) queue.push(n % 10);
+            int value;
+            while (queue.pop_min(value))
+            {
+                sum += value;
+                ++pops;
+            }
+        }));
+    }
+    for (unsigned t = 0; t < num_threads; ++t) threads[t].join();
+
+    REQUIRE(pops.load() == int(2000*num_threads));
+    REQUIRE(sum.load() == int(9000*num_threads));
+}
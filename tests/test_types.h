@@ -126,6 +126,21 @@ bool CheckBackwardIteration(const CONTAINER &container)
     return true;
 }
 
+/// Strictly increasing, as a set (with no duplicates) must be
+template <typename CONTAINER>
+bool IsStrictlyIncreasing(const CONTAINER &container)
+{
+    typename CONTAINER::const_iterator i = container.begin();
+    if (i == container.end()) return true;
+    int last_value = *i;
+    for (++i; i != container.end(); ++i)
+    {
+        if (!(last_value < *i)) return false;
+        last_value = *i;
+    }
+    return true;
+}
+
 template <typename C1, typename C2>
 inline
 bool CheckEquality(const C1 &c1, const C2 &c2)
@@ -149,6 +164,11 @@ bool CheckEqualityViaIndexing(const C1 &c1, const C2 &c2)
 }
 //============================================================================
 
+/// How many threads the concurrent tests run at once
+const unsigned num_threads = 8;
+
+//============================================================================
+
 inline
 void FillWithRandomData(size_t size, std::vector<int> &data)
 {
@@ -0,0 +1,140 @@
+//============================================================================
+// test_windowed_skip_list.cpp
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved
+//============================================================================
+
+#include "windowed_skip_list.h"
+
+#define CATCH_CONFIG_NO_STREAM_REDIRECTION 1
+#include "catch.hpp"
+#include "test_types.h"
+
+#include <vector>
+#include <algorithm>
+
+using goodliffe::windowed_skip_list;
+
+namespace
+{
+    /// Each event weighs its own value
+    struct Size : goodliffe::additive_weight<long>
+    {
+        long operator()(int value) const { return value; }
+    };
+
+    typedef windowed_skip_list<int, std::less<int>, std::allocator<int>,
+                               goodliffe::detail::skip_list_level_generator<32>,
+                               unsigned, Size> sized_window;
+}
+
+TEST_CASE( "windowed_skip_list/smoketest", "" )
+{
+    //REQUIRE(false);
+}
+
+TEST_CASE( "windowed_skip_list/can call basic methods", "" )
+{
+    windowed_skip_list<int> window;
+    REQUIRE(window.empty());
+    REQUIRE(window.expire_before(10) == 0);
+    REQUIRE(window.total_weight() == 0);
+
+    window.insert(5);
+    window.insert(3);
+    window.insert(5);
+    REQUIRE(window.size() == 3);
+    REQUIRE(window.median() == 5);
+    REQUIRE(window.quantile(0) == 3);
+    REQUIRE(window.quantile(1) == 5);
+    REQUIRE(window.total_weight() == 3);
+}
+
+TEST_CASE( "windowed_skip_list/expiry matches a sorted vector", "" )
+{
+    windowed_skip_list<int> window;
+    std::vector<int> data;
+
+    // events arrive roughly in order, a few late, with repeated times
+    for (int now = 0; now < 5000; ++now)
+    {
+        const int time = now - rand() % 20;
+        window.insert(time);
+        data.insert(std::upper_bound(data.begin(), data.end(), time), time);
+
+        if (now % 10 == 0)
+        {
+            const int bound = now - 300;
+            const std::vector<int>::iterator keep = std::lower_bound(data.begin(), data.end(), bound);
+            const size_t expected = size_t(keep - data.begin());
+            data.erase(data.begin(), keep);
+            REQUIRE(window.expire_before(bound) == expected);
+            REQUIRE(window.size() == data.size());
+            REQUIRE(window.front() == data.front());
+        }
+    }
+    REQUIRE(CheckEquality(window, data));
+    REQUIRE(CheckEqualityViaIndexing(window, data));
+
+    REQUIRE(window.expire_before(-1000) == 0);
+    REQUIRE(window.expire_before(10000) == data.size());
+    REQUIRE(window.empty());
+    window.insert(1);
+    REQUIRE(window[0] == 1);
+}
+
+TEST_CASE( "windowed_skip_list/expire_front", "" )
+{
+    windowed_skip_list<int> window;
+    for (int n = 0; n < 1000; ++n) window.insert(n/3);
+
+    window.expire_front(0);
+    REQUIRE(window.size() == 1000);
+    window.expire_front(10);
+    REQUIRE(window.size() == 990);
+    REQUIRE(window.front() == 3);
+    REQUIRE(window[1] == 3);
+    REQUIRE(window.index_of(window.lower_bound(100)) == 290);
+
+    window.expire_front(window.size());
+    REQUIRE(window.empty());
+}
+
+TEST_CASE( "windowed_skip_list/statistics follow the window", "" )
+{
+    sized_window window;
+    std::vector<int> data;
+    for (int now = 0; now < 3000; ++now)
+    {
+        const int value = now - rand() % 50;
+        window.insert(value);
+        data.insert(std::upper_bound(data.begin(), data.end(), value), value);
+
+        if (now % 25 == 0)
+        {
+            const int bound = now - 500;
+            window.expire_before(bound);
+            data.erase(data.begin(), std::lower_bound(data.begin(), data.end(), bound));
+
+            long total = 0;
+            for (size_t n = 0; n < data.size(); ++n) total += data[n];
+            REQUIRE(window.total_weight() == total);
+            REQUIRE(window.median() == data[(data.size()-1)/2]);
+            REQUIRE(window.quantile(0.0) == data.front());
+            REQUIRE(window.quantile(1.0) == data.back());
+            REQUIRE(window.quantile(0.9) == data[size_t(0.9*double(data.size()-1) + 0.5)]);
+        }
+    }
+}
+
+TEST_CASE( "windowed_skip_list/object lifetime", "" )
+{
+    Counter::count = 0;
+    {
+        windowed_skip_list<Counter> window;
+        for (int n = 0; n < 100; ++n) window.insert(Counter(n));
+        REQUIRE(window.expire_before(Counter(30)) == 30);
+        window.expire_front(20);
+        REQUIRE(Counter::count == 50);
+    }
+    REQUIRE(Counter::count == 0);
+}
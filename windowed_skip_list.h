@@ -0,0 +1,165 @@
+//==============================================================================
+// windowed_skip_list.h
+// Copyright (c) 2011 Pete Goodliffe. All rights reserved.
+//==============================================================================
+
+#pragma once
+
+#include "random_access_skip_list.h"
+
+#include <memory>     // for std::allocator
+#include <functional> // for std::less
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( push )
+#pragma warning (disable : 4068 ) /* disable unknown pragma warnings */
+#endif
+
+//==============================================================================
+#pragma mark - windowed_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+/// A windowed_skip_list holds a sliding window of elements, such as
+/// timestamped events, ordered by Compare: new elements are inserted
+/// anywhere (usually near the back), and old ones expire from the front.
+///
+/// It is a multi_random_access_skip_list, so it holds repeated elements,
+/// and its spans give the window's order statistics (median(), quantile())
+/// in O(log N). What it adds is expiry: expire_before(bound) finds and drops
+/// the elements ordered before bound with a search that climbs from the
+/// front only as far as it needs to, and then relinks only the head. So
+/// dropping K elements costs O(log K) plus the K frees, however many stay
+/// in the window (erase(begin(), lower_bound(bound)) searches from the top
+/// of the list, twice).
+///
+/// @param T              Template type for kind of object held in the
+///                       container.
+/// @param Compare        Template type describing the ordering comparator.
+/// @param Allocator      Template type for memory allocator for the contents
+///                       of the container.
+/// @param LevelGenerator Template type for the node height generator.
+/// @param SpanType       As for random_access_skip_list.
+/// @param Weight         As for random_access_skip_list: with, say, each
+///                       event's size as its weight, total_weight() is the
+///                       size of the whole window.
+///
+/// @see multi_random_access_skip_list
+template <typename T,
+          typename Compare        = std::less<T>,
+          typename Allocator      = std::allocator<T>,
+          typename LevelGenerator = detail::skip_list_level_generator<32>,
+          typename SpanType       = unsigned,
+          typename Weight         = detail::unit_weight>
+class windowed_skip_list :
+    public multi_random_access_skip_list<T,Compare,Allocator,LevelGenerator,SpanType,Weight>
+{
+protected:
+    typedef multi_random_access_skip_list<T,Compare,Allocator,LevelGenerator,SpanType,Weight> parent_type;
+    using typename parent_type::impl_type;
+    using parent_type::impl;
+
+public:
+
+    //======================================================================
+    // types
+
+    using typename parent_type::value_type;
+    using typename parent_type::allocator_type;
+    using typename parent_type::size_type;
+    using typename parent_type::const_reference;
+    using typename parent_type::weight_type;
+
+    //======================================================================
+    // lifetime management
+
+    explicit windowed_skip_list(const Allocator &alloc = Allocator())
+        : parent_type(alloc) {}
+    template <class InputIterator>
+    windowed_skip_list(InputIterator first, InputIterator last, const Allocator &alloc = Allocator())
+        : parent_type(first, last, alloc) {}
+    windowed_skip_list(const windowed_skip_list &other)
+        : parent_type(other) {}
+    windowed_skip_list(const windowed_skip_list &other, const Allocator &alloc)
+        : parent_type(other, alloc) {}
+
+    //======================================================================
+    // window
+
+    /// Drops every element ordered before bound (those that
+    /// lower_bound(bound) would pass over), and returns how many there
+    /// were. O(log K) for K dropped, plus the frees.
+    size_type expire_before(const value_type &bound);
+
+    /// Drops the first count elements, which there must be. O(log count),
+    /// plus the frees.
+    void expire_front(size_type count) { impl.remove_front(count); }
+
+    //======================================================================
+    // statistics
+
+    /// The element that a fraction q of the window is ordered before:
+    /// 0 gives the front, 1 the back. The window must not be empty.
+    /// O(log N).
+    const_reference quantile(double q) const;
+
+    /// The lower median of the window, which must not be empty. O(log N).
+    const_reference median() const { return impl.at((this->size()-1)/2)->value; }
+
+    /// The combined weight of the whole window (the count of its
+    /// elements, by default). O(log N).
+    weight_type total_weight() const { return impl.prefix_weight(this->size()); }
+};
+
+} // namespace goodliffe
+
+namespace std
+{
+    /// Override of std::swap for windowed_skip_list
+    template <class T, class C, class A, class LG, class S, class W>
+    void swap(goodliffe::windowed_skip_list<T,C,A,LG,S,W> &lhs,
+              goodliffe::windowed_skip_list<T,C,A,LG,S,W> &rhs)
+    {
+        lhs.swap(rhs);
+    }
+}
+
+//==============================================================================
+#pragma mark - windowed_skip_list
+//==============================================================================
+
+namespace goodliffe {
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename windowed_skip_list<T,C,A,LG,S,W>::size_type
+windowed_skip_list<T,C,A,LG,S,W>::expire_before(const value_type &bound)
+{
+    const size_type count = impl.count_less_near_front(bound);
+    impl.remove_front(count);
+    return count;
+}
+
+template <class T, class C, class A, class LG, class S, class W>
+inline
+typename windowed_skip_list<T,C,A,LG,S,W>::const_reference
+windowed_skip_list<T,C,A,LG,S,W>::quantile(double q) const
+{
+    assert_that(!this->empty());
+    assert_that(q >= 0 && q <= 1);
+    const size_type last = this->size()-1;
+    size_type index = size_type(q * double(last) + 0.5);
+    if (index > last) index = last;
+    return impl.at(index)->value;
+}
+
+} // namespace goodliffe
+
+//==============================================================================
+
+#ifdef _MSC_VER
+#pragma warning( pop )
+#endif